@@ -182,6 +182,8 @@ void EditMetadataCommon::cleanupAndClose(void)
 void EditMetadataCommon::saveToMetadata()
 {
     *m_sourceMetadata = *m_metadata;
+    if (gMusicData->all_music)
+        gMusicData->all_music->invalidateIndexes();
     emit metadataChanged();
     cleanupAndClose();
 }
@@ -194,6 +196,8 @@ void EditMetadataCommon::saveToDatabase()
 
     m_metadata->dumpToDatabase();
     *m_sourceMetadata = *m_metadata;
+    if (gMusicData->all_music)
+        gMusicData->all_music->invalidateIndexes();
 
     gPlayer->sendMetadataChangedEvent(m_sourceMetadata->ID());
 }
@@ -3,22 +3,141 @@
 
 // Qt headers
 #include <QApplication>
+#include <QWaitCondition>
+#include <QMutexLocker>
+#include <QAtomicInt>
+#include <QRunnable>
 #include <QDir>
 
 // MythTV headers
 #include <mythdate.h>
 #include <mythdb.h>
+#include <mythdirs.h>
 #include <mythcontext.h>
 #include <mythdialogs.h>
 #include <mythscreenstack.h>
 #include <mythprogressdialog.h>
+#include <mthreadpool.h>
 #include <musicmetadata.h>
 #include <metaio.h>
 
 // MythMusic headers
 #include "filescanner.h"
 
-FileScanner::FileScanner()
+/// Files whose tags are read at once, mostly this is waiting for the disk
+static const int kTagReadThreads = 4;
+/// How many tracks the tag readers may get ahead of the database updates
+static const int kTagReadAhead = 256;
+/// Most rows changed by one query
+static const int kDBBatchSize = 100;
+
+namespace
+{
+    /// Shares a list of tracks out between the tag reading threads
+    class TagReadQueue
+    {
+      public:
+        TagReadQueue(FileScanner::ScannedTrackList &tracks) :
+            m_tracks(tracks), m_next(0), m_consumed(0) {}
+
+        bool ReadNext(void);
+        bool WaitFor(uint index, unsigned long timeout);
+        void Release(uint index);
+
+      private:
+        FileScanner::ScannedTrackList &m_tracks;
+        QAtomicInt                     m_next;
+        int                            m_consumed;
+        QMutex                         m_lock;
+        QWaitCondition                 m_wait;
+    };
+
+    /// \brief Reads the tags of the next track in the list.
+    /// \return false once every track has been taken
+    bool TagReadQueue::ReadNext(void)
+    {
+        int i = m_next.fetchAndAddOrdered(1);
+        if (i >= (int)m_tracks.size())
+            return false;
+
+        {
+            QMutexLocker locker(&m_lock);
+            while (i >= m_consumed + kTagReadAhead)
+                m_wait.wait(&m_lock);
+        }
+
+        FileScanner::ScannedTrack &track = m_tracks[i];
+
+        LOG(VB_FILE, LOG_INFO,
+            QString("Reading metadata from %1").arg(track.filename));
+        MusicMetadata *data = MetaIO::readMetadata(track.filename);
+        AlbumArtList art;
+        if (data)
+        {
+            data->setFileSize((quint64)QFileInfo(track.filename).size());
+
+            // read any embedded images from the tag of new tracks
+            MetaIO *tagger = NULL;
+            if (!track.update)
+                tagger = MetaIO::createTagger(track.filename);
+            if (tagger)
+            {
+                if (tagger->supportsEmbeddedImages())
+                    art = tagger->getAlbumArtList(track.filename);
+                delete tagger;
+            }
+        }
+
+        QMutexLocker locker(&m_lock);
+        track.data = data;
+        track.art  = art;
+        track.read = true;
+        m_wait.wakeAll();
+        return true;
+    }
+
+    /// \brief Waits up to 'timeout' ms for the tags of a track to be read.
+    bool TagReadQueue::WaitFor(uint index, unsigned long timeout)
+    {
+        QMutexLocker locker(&m_lock);
+        if (!m_tracks[index].read)
+            m_wait.wait(&m_lock, timeout);
+        return m_tracks[index].read;
+    }
+
+    /// \brief Frees what was read for a track once it is in the database,
+    ///        letting the readers move on.
+    void TagReadQueue::Release(uint index)
+    {
+        FileScanner::ScannedTrack &track = m_tracks[index];
+        delete track.data;
+        track.data = NULL;
+        qDeleteAll(track.art);
+        track.art.clear();
+
+        QMutexLocker locker(&m_lock);
+        m_consumed = index + 1;
+        m_wait.wakeAll();
+    }
+
+    class TagReadRunnable : public QRunnable
+    {
+      public:
+        TagReadRunnable(TagReadQueue &queue) : m_queue(queue) {}
+
+        void run(void)
+        {
+            while (m_queue.ReadNext())
+                ;
+        }
+
+      private:
+        TagReadQueue &m_queue;
+    };
+}
+
+FileScanner::FileScanner() :
+    m_manifest(GetConfDir() + "/musicscan.manifest")
 {
     MSqlQuery query(MSqlQuery::InitCon());
 
@@ -72,6 +191,10 @@ FileScanner::~FileScanner ()
  * \brief Builds a list of all the files found descending recursively
  *        into the given directory
  *
+ *        Directories whose modification time has not changed since the
+ *        last scan are not listed again, their contents are taken from
+ *        the manifest.
+ *
  * \param directory Directory to begin search
  * \param music_files A pointer to the MusicLoadedMap to store the results
  * \param parentid The id of the parent directory in the music_directories
@@ -86,24 +209,37 @@ void FileScanner::BuildFileList(QString &directory, MusicLoadedMap &music_files,
     if (!d.exists())
         return;
 
-    d.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
-    QFileInfoList list = d.entryInfoList();
-    if (list.isEmpty())
-        return;
+    uint mtime = QFileInfo(directory).lastModified().toTime_t();
+    DirectoryManifest::EntryList entries;
 
-    QFileInfoList::const_iterator it = list.begin();
-    const QFileInfo *fi;
+    if (!m_manifest.Lookup(directory, mtime, entries))
+    {
+        uint listed = MythDate::current().toTime_t();
+
+        d.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+        QFileInfoList list = d.entryInfoList();
+
+        QFileInfoList::const_iterator it = list.begin();
+        for (; it != list.end(); ++it)
+        {
+            DirectoryManifest::Entry entry;
+            entry.name  = it->fileName();
+            entry.isDir = it->isDir();
+            entries.push_back(entry);
+        }
+
+        m_manifest.Update(directory, mtime, listed, entries);
+    }
 
     /* Recursively traverse directory, calling QApplication::processEvents()
        every now and then to ensure the UI updates */
     int update_interval = 0;
     int newparentid = 0;
-    while (it != list.end())
+    DirectoryManifest::EntryList::const_iterator it = entries.begin();
+    for (; it != entries.end(); ++it)
     {
-        fi = &(*it);
-        ++it;
-        QString filename = fi->absoluteFilePath();
-        if (fi->isDir())
+        QString filename = d.absoluteFilePath(it->name);
+        if (it->isDir)
         {
 
             QString dir(filename);
@@ -221,105 +357,194 @@ bool FileScanner::HasFileChanged(
 }
 
 /*!
- * \brief Insert file details into database.
- *        If it is an audio file, read the metadata and insert
- *        that information at the same time.
- *
- *        If it is an image file, just insert the filename and
- *        type.
+ * \brief Gets the directory of a file, relative to the base dir
  *
  * \param filename Full path to file.
  *
- * \returns Nothing.
+ * \returns Directory name as stored in the music_directories table
  */
-void FileScanner::AddFileToDB(const QString &filename)
+QString FileScanner::GetDirectory(const QString &filename) const
 {
-    QString extension = filename.section( '.', -1 ) ;
     QString directory = filename;
     directory.remove(0, m_startdir.length());
-    directory = directory.section( '/', 0, -2);
+    return directory.section( '/', 0, -2);
+}
 
-    QString nameFilter = gCoreContext->GetSetting("AlbumArtFilter", "*.png;*.jpg;*.jpeg;*.gif;*.bmp");
+/*!
+ * \brief Fills in the directory, artist, album and genre ids of a track
+ *        from the caches, so dumpToDatabase() need not look them up.
+ *
+ * \param data Track read from the file
+ * \param filename Full path to file.
+ *
+ * \returns Nothing.
+ */
+void FileScanner::SetCachedIds(MusicMetadata *data, const QString &filename)
+{
+    int did = m_directoryid[GetDirectory(filename)];
+    if (did > 0)
+        data->setDirectoryId(did);
 
-    // If this file is an image, insert the details into the music_albumart table
-    if (nameFilter.indexOf(extension.toLower()) > -1)
+    int aid = m_artistid[data->Artist().toLower()];
+    if (aid > 0)
     {
-        QString name = filename.section( '/', -1);
+        data->setArtistId(aid);
 
-        MSqlQuery query(MSqlQuery::InitCon());
-        query.prepare("INSERT INTO music_albumart SET filename = :FILE, "
-                      "directory_id = :DIRID, imagetype = :TYPE;");
-        query.bindValue(":FILE", name);
-        query.bindValue(":DIRID", m_directoryid[directory]);
-        query.bindValue(":TYPE", AlbumArtImages::guessImageType(name));
-
-        if (!query.exec() || query.numRowsAffected() <= 0)
+        // The album cache depends on the artist id, albums belong to the
+        // compilation artist so leave others for dumpToDatabase()
+        if (data->Artist() == data->CompilationArtist())
         {
-            MythDB::DBError("music insert artwork", query);
+            QString album_cache_string = QString::number(aid) + "#"
+                + data->Album().toLower();
+
+            if (m_albumid[album_cache_string] > 0)
+                data->setAlbumId(m_albumid[album_cache_string]);
         }
+    }
+
+    int gid = m_genreid[data->Genre().toLower()];
+    if (gid > 0)
+        data->setGenreId(gid);
+}
+
+/*!
+ * \brief Remembers the ids dumpToDatabase() found for a track.
+ *
+ * \param data Track that has just been saved
+ *
+ * \returns Nothing.
+ */
+void FileScanner::UpdateCache(MusicMetadata *data)
+{
+    m_artistid[data->Artist().toLower()] = data->getArtistId();
+
+    m_genreid[data->Genre().toLower()] = data->getGenreId();
+
+    if (data->Artist() == data->CompilationArtist())
+    {
+        QString album_cache_string = QString::number(data->getArtistId())
+            + "#" + data->Album().toLower();
+        m_albumid[album_cache_string] = data->getAlbumId();
+    }
+}
+
+/*!
+ * \brief Reads the tags of the tracks on several threads and adds
+ *        or updates them in the database as they become available.
+ *
+ * \param tracks New and changed music files
+ * \param progress Progress dialog to update, may be NULL
+ * \param counter Number of files processed so far, for the progress dialog
+ *
+ * \returns Nothing.
+ */
+void FileScanner::ReadTracks(ScannedTrackList &tracks,
+                             MythUIProgressDialog *progress, uint &counter)
+{
+    if (tracks.empty())
         return;
+
+    TagReadQueue queue(tracks);
+
+    MThreadPool pool("MusicTagRead");
+    pool.setMaxThreadCount(kTagReadThreads);
+    for (int i = 0; i < kTagReadThreads; ++i)
+    {
+        pool.start(new TagReadRunnable(queue),
+                   QString("MusicTagRead%1").arg(i));
     }
 
-    LOG(VB_FILE, LOG_INFO,
-        QString("Reading metadata from %1").arg(filename));
-    MusicMetadata *data = MetaIO::readMetadata(filename);
-    if (data)
+    // The database is only written from this thread, in file order
+    for (uint i = 0; i < tracks.size(); ++i)
     {
-        data->setFileSize((quint64)QFileInfo(filename).size());
+        while (!queue.WaitFor(i, 100))
+            qApp->processEvents();
 
-        QString album_cache_string;
+        if (tracks[i].update)
+            UpdateFileInDB(tracks[i]);
+        else
+            AddFileToDB(tracks[i]);
 
-        // Set values from cache
-        int did = m_directoryid[directory];
-        if (did > 0)
-            data->setDirectoryId(did);
+        queue.Release(i);
 
-        int aid = m_artistid[data->Artist().toLower()];
-        if (aid > 0)
+        ++counter;
+        if (progress && (counter % 100 == 0 || i + 1 == tracks.size()))
         {
-            data->setArtistId(aid);
+            progress->SetProgress(counter);
+            qApp->processEvents();
+        }
+    }
 
-            // The album cache depends on the artist id
-            album_cache_string = data->getArtistId() + "#"
-                + data->Album().toLower();
+    pool.waitForDone();
+}
 
-            if (m_albumid[album_cache_string] > 0)
-                data->setAlbumId(m_albumid[album_cache_string]);
-        }
+/*!
+ * \brief Insert a new track into the database, along with any images
+ *        embedded in its tags.
+ *
+ * \param track Track whose tags have been read
+ *
+ * \returns Nothing.
+ */
+void FileScanner::AddFileToDB(ScannedTrack &track)
+{
+    MusicMetadata *data = track.data;
+    if (!data)
+        return;
 
-        int gid = m_genreid[data->Genre().toLower()];
-        if (gid > 0)
-            data->setGenreId(gid);
+    SetCachedIds(data, track.filename);
 
-        // Commit track info to database
-        data->dumpToDatabase();
+    // Commit track info to database
+    data->dumpToDatabase();
 
-        // Update the cache
-        m_artistid[data->Artist().toLower()] =
-            data->getArtistId();
+    UpdateCache(data);
 
-        m_genreid[data->Genre().toLower()] =
-            data->getGenreId();
+    if (!track.art.isEmpty())
+    {
+        data->setEmbeddedAlbumArt(track.art);
+        data->getAlbumArtImages()->dumpToDatabase();
+    }
+}
 
-        album_cache_string = data->getArtistId() + "#"
-            + data->Album().toLower();
-        m_albumid[album_cache_string] = data->getAlbumId();
+/*!
+ * \brief Insert image files into the music_albumart table, a batch of
+ *        rows at a time.
+ *
+ * \param files Full paths to the images
+ *
+ * \returns Nothing.
+ */
+void FileScanner::AddArtworkToDB(const QStringList &files)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+
+    for (int start = 0; start < files.size(); start += kDBBatchSize)
+    {
+        int end = qMin(start + kDBBatchSize, files.size());
+
+        QStringList values;
+        for (int i = start; i < end; ++i)
+            values << QString("(:FILE%1, :DIRID%1, :TYPE%1)").arg(i - start);
 
-        // read any embedded images from the tag
-        MetaIO *tagger = MetaIO::createTagger(filename);
+        query.prepare("INSERT INTO music_albumart "
+                      "(filename, directory_id, imagetype) VALUES " +
+                      values.join(", ") + ";");
 
-        if (tagger)
+        for (int i = start; i < end; ++i)
         {
-            if (tagger->supportsEmbeddedImages())
-            {
-                AlbumArtList artList = tagger->getAlbumArtList(data->Filename());
-                data->setEmbeddedAlbumArt(artList);
-                data->getAlbumArtImages()->dumpToDatabase();
-            }
-            delete tagger;
+            QString name = files[i].section( '/', -1);
+            QString n = QString::number(i - start);
+            query.bindValue(":FILE" + n, name);
+            query.bindValue(":DIRID" + n,
+                            m_directoryid[GetDirectory(files[i])]);
+            query.bindValue(":TYPE" + n,
+                            AlbumArtImages::guessImageType(name));
         }
 
-        delete data;
+        if (!query.exec() || query.numRowsAffected() <= 0)
+        {
+            MythDB::DBError("music insert artwork", query);
+        }
     }
 }
 
@@ -351,74 +576,38 @@ void FileScanner::cleanDB()
 
     uint counter = 0;
 
+    // Each of these removes all the orphans in one statement
     MSqlQuery query(MSqlQuery::InitCon());
-    MSqlQuery deletequery(MSqlQuery::InitCon());
 
-    if (!query.exec("SELECT g.genre_id FROM music_genres g "
+    if (!query.exec("DELETE g FROM music_genres g "
                     "LEFT JOIN music_songs s ON g.genre_id=s.genre_id "
                     "WHERE s.genre_id IS NULL;"))
-        MythDB::DBError("FileScanner::cleanDB - select music_genres", query);
-    while (query.next())
-    {
-        int genreid = query.value(0).toInt();
-        deletequery.prepare("DELETE FROM music_genres WHERE genre_id=:GENREID");
-        deletequery.bindValue(":GENREID", genreid);
-        if (!deletequery.exec())
-            MythDB::DBError("FileScanner::cleanDB - delete music_genres",
-                            deletequery);
-    }
+        MythDB::DBError("FileScanner::cleanDB - delete music_genres", query);
 
     if (clean_progress)
         clean_progress->SetProgress(++counter);
 
-    if (!query.exec("SELECT a.album_id FROM music_albums a "
+    if (!query.exec("DELETE a FROM music_albums a "
                     "LEFT JOIN music_songs s ON a.album_id=s.album_id "
                     "WHERE s.album_id IS NULL;"))
-        MythDB::DBError("FileScanner::cleanDB - select music_albums", query);
-    while (query.next())
-    {
-        int albumid = query.value(0).toInt();
-        deletequery.prepare("DELETE FROM music_albums WHERE album_id=:ALBUMID");
-        deletequery.bindValue(":ALBUMID", albumid);
-        if (!deletequery.exec())
-            MythDB::DBError("FileScanner::cleanDB - delete music_albums",
-                            deletequery);
-    }
+        MythDB::DBError("FileScanner::cleanDB - delete music_albums", query);
 
     if (clean_progress)
         clean_progress->SetProgress(++counter);
 
-    if (!query.exec("SELECT a.artist_id FROM music_artists a "
+    if (!query.exec("DELETE a FROM music_artists a "
                     "LEFT JOIN music_songs s ON a.artist_id=s.artist_id "
                     "LEFT JOIN music_albums l ON a.artist_id=l.artist_id "
                     "WHERE s.artist_id IS NULL AND l.artist_id IS NULL"))
-        MythDB::DBError("FileScanner::cleanDB - select music_artists", query);
-    while (query.next())
-    {
-        int artistid = query.value(0).toInt();
-        deletequery.prepare("DELETE FROM music_artists WHERE artist_id=:ARTISTID");
-        deletequery.bindValue(":ARTISTID", artistid);
-        if (!deletequery.exec())
-            MythDB::DBError("FileScanner::cleanDB - delete music_artists",
-                            deletequery);
-    }
+        MythDB::DBError("FileScanner::cleanDB - delete music_artists", query);
 
     if (clean_progress)
         clean_progress->SetProgress(++counter);
 
-    if (!query.exec("SELECT a.albumart_id FROM music_albumart a LEFT JOIN "
+    if (!query.exec("DELETE a FROM music_albumart a LEFT JOIN "
                     "music_songs s ON a.song_id=s.song_id WHERE "
                     "embedded='1' AND s.song_id IS NULL;"))
-        MythDB::DBError("FileScanner::cleanDB - select music_albumart", query);
-    while (query.next())
-    {
-        int albumartid = query.value(0).toInt();
-        deletequery.prepare("DELETE FROM music_albumart WHERE albumart_id=:ALBUMARTID");
-        deletequery.bindValue(":ALBUMARTID", albumartid);
-        if (!deletequery.exec())
-            MythDB::DBError("FileScanner::cleanDB - delete music_albumart",
-                            deletequery);
-    }
+        MythDB::DBError("FileScanner::cleanDB - delete music_albumart", query);
 
     if (clean_progress)
     {
@@ -428,72 +617,75 @@ void FileScanner::cleanDB()
 }
 
 /*!
- * \brief Removes a file from the database.
+ * \brief Removes files from the database, a batch of rows at a time.
  *
- * \param filename Full path to file.
+ * \param table music_songs or music_albumart
+ * \param files Full paths to the files.
  *
  * \returns Nothing.
  */
-void FileScanner::RemoveFileFromDB (const QString &filename)
+void FileScanner::RemoveFilesFromDB(const QString &table,
+                                    const QStringList &files)
 {
-    QString sqlfilename(filename);
-    sqlfilename.remove(0, m_startdir.length());
-    // We know that the filename will not contain :// as the SQL limits this
-    QString directory = sqlfilename.section( '/', 0, -2 ) ;
-    sqlfilename = sqlfilename.section( '/', -1 ) ;
-
-    QString extension = sqlfilename.section( '.', -1 ) ;
+    // Files are stored by directory, so group them by that
+    QMap<int, QStringList> dirs;
+    QStringList::const_iterator it = files.begin();
+    for (; it != files.end(); ++it)
+    {
+        // We know that the filename will not contain :// as the SQL limits this
+        dirs[m_directoryid[GetDirectory(*it)]] << (*it).section( '/', -1);
+    }
 
-    QString nameFilter = gCoreContext->GetSetting("AlbumArtFilter",
-                                              "*.png;*.jpg;*.jpeg;*.gif;*.bmp");
+    MSqlQuery query(MSqlQuery::InitCon());
 
-    if (nameFilter.indexOf(extension) > -1)
+    QMap<int, QStringList>::const_iterator dit = dirs.begin();
+    for (; dit != dirs.end(); ++dit)
     {
-        MSqlQuery query(MSqlQuery::InitCon());
-        query.prepare("DELETE FROM music_albumart WHERE filename= :FILE AND "
-                      "directory_id= :DIRID;");
-        query.bindValue(":FILE", sqlfilename);
-        query.bindValue(":DIRID", m_directoryid[directory]);
-
-        if (!query.exec() || query.numRowsAffected() <= 0)
+        const QStringList &names = *dit;
+        for (int start = 0; start < names.size(); start += kDBBatchSize)
         {
-            MythDB::DBError("music delete artwork", query);
+            int end = qMin(start + kDBBatchSize, names.size());
+
+            QStringList params;
+            for (int i = start; i < end; ++i)
+                params << QString(":FILE%1").arg(i - start);
+
+            query.prepare(QString("DELETE FROM %1 WHERE directory_id = :DIRID "
+                                  "AND filename IN (%2);")
+                          .arg(table).arg(params.join(", ")));
+            query.bindValue(":DIRID", dit.key());
+            for (int i = start; i < end; ++i)
+                query.bindValue(params[i - start], names[i]);
+
+            if (!query.exec())
+                MythDB::DBError(QString("FileScanner::RemoveFilesFromDB - "
+                                        "deleting %1").arg(table), query);
         }
-        return;
     }
-
-    MSqlQuery query(MSqlQuery::InitCon());
-    query.prepare("DELETE FROM music_songs WHERE filename = :NAME ;");
-    query.bindValue(":NAME", sqlfilename);
-    if (!query.exec())
-        MythDB::DBError("FileScanner::RemoveFileFromDB - deleting music_songs",
-                        query);
 }
 
 /*!
- * \brief Updates a file in the database.
+ * \brief Updates a track in the database with the tags just read from it.
  *
- * \param filename Full path to file.
+ * \param track Track whose tags have been read
  *
  * \returns Nothing.
  */
-void FileScanner::UpdateFileInDB(const QString &filename)
+void FileScanner::UpdateFileInDB(ScannedTrack &track)
 {
-    QString directory = filename;
-    directory.remove(0, m_startdir.length());
-    directory = directory.section( '/', 0, -2);
+    MusicMetadata *disk_meta = track.data;
+    if (!disk_meta)
+        return;
 
-    MusicMetadata *db_meta   = MetaIO::getMetadata(filename);
-    MusicMetadata *disk_meta = MetaIO::readMetadata(filename);
+    MusicMetadata *db_meta = MusicMetadata::createFromFilename(track.filename);
 
-    if (db_meta && disk_meta)
+    if (db_meta)
     {
         if (db_meta->ID() <= 0)
         {
             LOG(VB_GENERAL, LOG_ERR, QString("Asked to update track with "
                                                 "invalid ID - %1")
                                             .arg(db_meta->ID()));
-            delete disk_meta;
             delete db_meta;
             return;
         }
@@ -503,50 +695,15 @@ void FileScanner::UpdateFileInDB(const QString &filename)
         if (db_meta->PlayCount() > disk_meta->PlayCount())
             disk_meta->setPlaycount(db_meta->Playcount());
 
-        QString album_cache_string;
-
-        // Set values from cache
-        int did = m_directoryid[directory];
-        if (did > 0)
-            disk_meta->setDirectoryId(did);
-
-        int aid = m_artistid[disk_meta->Artist().toLower()];
-        if (aid > 0)
-        {
-            disk_meta->setArtistId(aid);
-
-            // The album cache depends on the artist id
-            album_cache_string = disk_meta->getArtistId() + "#" +
-                disk_meta->Album().toLower();
-
-            if (m_albumid[album_cache_string] > 0)
-                disk_meta->setAlbumId(m_albumid[album_cache_string]);
-        }
-
-        int gid = m_genreid[disk_meta->Genre().toLower()];
-        if (gid > 0)
-            disk_meta->setGenreId(gid);
-
-        disk_meta->setFileSize((quint64)QFileInfo(filename).size());
+        SetCachedIds(disk_meta, track.filename);
 
         // Commit track info to database
         disk_meta->dumpToDatabase();
 
-        // Update the cache
-        m_artistid[disk_meta->Artist().toLower()]
-            = disk_meta->getArtistId();
-        m_genreid[disk_meta->Genre().toLower()]
-            = disk_meta->getGenreId();
-        album_cache_string = disk_meta->getArtistId() + "#" +
-            disk_meta->Album().toLower();
-        m_albumid[album_cache_string] = disk_meta->getAlbumId();
-    }
-
-    if (disk_meta)
-        delete disk_meta;
+        UpdateCache(disk_meta);
 
-    if (db_meta)
         delete db_meta;
+    }
 }
 
 /*!
@@ -578,6 +735,8 @@ void FileScanner::SearchDir(QString &directory)
     else
         busy = NULL;
 
+    m_manifest.Load();
+
     BuildFileList(m_startdir, music_files, 0);
 
     if (busy)
@@ -602,40 +761,61 @@ void FileScanner::SearchDir(QString &directory)
         file_checking = NULL;
     }
 
-     /*
-       This can be optimised quite a bit by consolidating all commands
-       via a lot of refactoring.
-
-       1) group all files of the same decoder type, and don't
-       create/delete a Decoder pr. AddFileToDB. Or make Decoders be
-       singletons, it should be a fairly simple change.
-
-       2) RemoveFileFromDB should group the remove into one big SQL.
+    QString nameFilter = gCoreContext->GetSetting("AlbumArtFilter",
+                                              "*.png;*.jpg;*.jpeg;*.gif;*.bmp");
 
-       3) UpdateFileInDB, same as 1.
-     */
+    QStringList new_artwork, old_artwork, old_music;
+    ScannedTrackList tracks;
 
-    uint counter = 0;
     for (iter = music_files.begin(); iter != music_files.end(); iter++)
     {
+        QString extension = iter.key().section( '.', -1 ).toLower();
+        bool isArtwork = nameFilter.indexOf(extension) > -1;
+
         if (*iter == FileScanner::kFileSystem)
-            AddFileToDB(iter.key());
+        {
+            if (isArtwork)
+                new_artwork << iter.key();
+            else
+                tracks.push_back(ScannedTrack(iter.key(), false));
+        }
         else if (*iter == FileScanner::kDatabase)
-            RemoveFileFromDB(iter.key ());
-        else if (*iter == FileScanner::kNeedUpdate)
-            UpdateFileInDB(iter.key());
-
-        if (file_checking)
         {
-            file_checking->SetProgress(++counter);
-            qApp->processEvents();
+            if (isArtwork)
+                old_artwork << iter.key();
+            else
+                old_music << iter.key();
         }
+        else if (*iter == FileScanner::kNeedUpdate)
+            tracks.push_back(ScannedTrack(iter.key(), true));
     }
+
+    RemoveFilesFromDB("music_songs", old_music);
+    RemoveFilesFromDB("music_albumart", old_artwork);
+    AddArtworkToDB(new_artwork);
+
+    uint counter = old_music.size() + old_artwork.size() + new_artwork.size();
+    if (file_checking)
+    {
+        file_checking->SetProgress(counter);
+        qApp->processEvents();
+    }
+
+    // Tags are read on several threads while the database is updated here
+    ReadTracks(tracks, file_checking, counter);
+
     if (file_checking)
         file_checking->Close();
 
+    m_manifest.Save();
+
     // Cleanup orphaned entries from the database
     cleanDB();
+
+    // Let the backend know, it serves the music over UPnP
+    if (!tracks.empty() || !old_music.isEmpty() || !old_artwork.isEmpty() ||
+        !new_artwork.isEmpty())
+        gCoreContext->SendMessage("MUSIC_LIST_CHANGE");
 }
 
 /*!
@@ -690,9 +870,9 @@ void FileScanner::ScanMusic(MusicLoadedMap &music_files)
                 {
                     if (music_files[name] == FileScanner::kDatabase)
                     {
-                        if (file_checking)
+                        if (file_checking && ++counter % 100 == 0)
                         {
-                            file_checking->SetProgress(++counter);
+                            file_checking->SetProgress(counter);
                             qApp->processEvents();
                         }
                         continue;
@@ -708,9 +888,9 @@ void FileScanner::ScanMusic(MusicLoadedMap &music_files)
                 }
             }
 
-            if (file_checking)
+            if (file_checking && ++counter % 100 == 0)
             {
-                file_checking->SetProgress(++counter);
+                file_checking->SetProgress(counter);
                 qApp->processEvents();
             }
         }
@@ -772,9 +952,9 @@ void FileScanner::ScanArtwork(MusicLoadedMap &music_files)
                 {
                     if (music_files[name] == FileScanner::kDatabase)
                     {
-                        if (file_checking)
+                        if (file_checking && ++counter % 100 == 0)
                         {
-                            file_checking->SetProgress(++counter);
+                            file_checking->SetProgress(counter);
                             qApp->processEvents();
                         }
                         continue;
@@ -787,9 +967,9 @@ void FileScanner::ScanArtwork(MusicLoadedMap &music_files)
                     music_files[name] = FileScanner::kDatabase;
                 }
             }
-            if (file_checking)
+            if (file_checking && ++counter % 100 == 0)
             {
-                file_checking->SetProgress(++counter);
+                file_checking->SetProgress(counter);
                 qApp->processEvents();
             }
         }
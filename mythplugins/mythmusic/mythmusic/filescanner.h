@@ -1,11 +1,21 @@
 #ifndef _FILESCANNER_H_
 #define _FILESCANNER_H_
 
+// C++ headers
+#include <vector>
+
 // Qt headers
 #include <QCoreApplication>
+#include <QStringList>
+
+// MythTV headers
+#include <musicmetadata.h>
+#include <dirmanifest.h>
 
 typedef QMap<QString, int> IdCache;
 
+class MythUIProgressDialog;
+
 class FileScanner
 {
     Q_DECLARE_TR_FUNCTIONS(FileScanner)
@@ -25,13 +35,33 @@ class FileScanner
 
         void SearchDir(QString &directory);
 
+        /// A track whose tags are read on the tag reading threads
+        struct ScannedTrack
+        {
+            ScannedTrack(const QString &f, bool u) :
+                filename(f), update(u), data(NULL), read(false) {}
+
+            QString        filename;
+            bool           update;  ///< already in the database
+            MusicMetadata *data;    ///< NULL if the tags could not be read
+            AlbumArtList   art;     ///< images embedded in the tags
+            bool           read;
+        };
+        typedef std::vector<ScannedTrack> ScannedTrackList;
+
     private:
         void BuildFileList(QString &directory, MusicLoadedMap &music_files, int parentid);
         int  GetDirectoryId(const QString &directory, const int &parentid);
         bool HasFileChanged(const QString &filename, const QString &date_modified);
-        void AddFileToDB(const QString &filename);
-        void RemoveFileFromDB (const QString &filename);
-        void UpdateFileInDB(const QString &filename);
+        void ReadTracks(ScannedTrackList &tracks,
+                        MythUIProgressDialog *progress, uint &counter);
+        void AddFileToDB(ScannedTrack &track);
+        void AddArtworkToDB(const QStringList &files);
+        void RemoveFilesFromDB(const QString &table, const QStringList &files);
+        void UpdateFileInDB(ScannedTrack &track);
+        void SetCachedIds(MusicMetadata *data, const QString &filename);
+        void UpdateCache(MusicMetadata *data);
+        QString GetDirectory(const QString &filename) const;
         void ScanMusic(MusicLoadedMap &music_files);
         void ScanArtwork(MusicLoadedMap &music_files);
         void cleanDB();
@@ -41,6 +71,8 @@ class FileScanner
         IdCache  m_artistid;
         IdCache  m_genreid;
         IdCache  m_albumid;
+
+        DirectoryManifest m_manifest;
 };
 
 #endif // _FILESCANNER_H_
@@ -967,6 +967,20 @@ void PlaylistEditorView::treeNodeChanged(MythGenericTree *node)
         filterTracks(mnode);
 }
 
+/// Fills 'map' with copies of the track lists in one of the AllMusic indexes
+void PlaylistEditorView::copyIndex(const AllMusic::MetadataIndex &index,
+                                   QMap<QString, MetadataPtrList*> &map)
+{
+    AllMusic::MetadataIndex::const_iterator it = index.constBegin();
+    for (; it != index.constEnd(); ++it)
+    {
+        // QList is implicitly shared, so this does not copy the tracks
+        MetadataPtrList *filteredTracks = new MetadataPtrList(*it);
+        m_deleteList.append(filteredTracks);
+        map.insert(it.key(), filteredTracks);
+    }
+}
+
 void PlaylistEditorView::filterTracks(MusicGenericTree *node)
 {
     MetadataPtrList *tracks = qVariantValue<MetadataPtrList*> (node->GetData());
@@ -1020,22 +1034,27 @@ void PlaylistEditorView::filterTracks(MusicGenericTree *node)
     {
         QMap<QString, MetadataPtrList*> map;
 
-        for (int x = 0; x < tracks->count(); x++)
+        if (tracks == gMusicData->all_music->getAllMetadata())
+            copyIndex(gMusicData->all_music->getArtistIndex(), map);
+        else
         {
-            MusicMetadata *mdata = tracks->at(x);
-            if (mdata)
+            for (int x = 0; x < tracks->count(); x++)
             {
-                if (map.contains(mdata->Artist()))
-                {
-                    MetadataPtrList *filteredTracks = map.value(mdata->Artist());
-                    filteredTracks->append(mdata);
-                }
-                else
+                MusicMetadata *mdata = tracks->at(x);
+                if (mdata)
                 {
-                    MetadataPtrList *filteredTracks = new MetadataPtrList;
-                    m_deleteList.append(filteredTracks);
-                    filteredTracks->append(mdata);
-                    map.insert(mdata->Artist(), filteredTracks);
+                    if (map.contains(mdata->Artist()))
+                    {
+                        MetadataPtrList *filteredTracks = map.value(mdata->Artist());
+                        filteredTracks->append(mdata);
+                    }
+                    else
+                    {
+                        MetadataPtrList *filteredTracks = new MetadataPtrList;
+                        m_deleteList.append(filteredTracks);
+                        filteredTracks->append(mdata);
+                        map.insert(mdata->Artist(), filteredTracks);
+                    }
                 }
             }
         }
@@ -1091,22 +1110,27 @@ void PlaylistEditorView::filterTracks(MusicGenericTree *node)
     {
         QMap<QString, MetadataPtrList*> map;
 
-        for (int x = 0; x < tracks->count(); x++)
+        if (tracks == gMusicData->all_music->getAllMetadata())
+            copyIndex(gMusicData->all_music->getAlbumIndex(), map);
+        else
         {
-            MusicMetadata *mdata = tracks->at(x);
-            if (mdata)
+            for (int x = 0; x < tracks->count(); x++)
             {
-                if (map.contains(mdata->Album()))
-                {
-                    MetadataPtrList *filteredTracks = map.value(mdata->Album());
-                    filteredTracks->append(mdata);
-                }
-                else
+                MusicMetadata *mdata = tracks->at(x);
+                if (mdata)
                 {
-                    MetadataPtrList *filteredTracks = new MetadataPtrList;
-                    m_deleteList.append(filteredTracks);
-                    filteredTracks->append(mdata);
-                    map.insert(mdata->Album(), filteredTracks);
+                    if (map.contains(mdata->Album()))
+                    {
+                        MetadataPtrList *filteredTracks = map.value(mdata->Album());
+                        filteredTracks->append(mdata);
+                    }
+                    else
+                    {
+                        MetadataPtrList *filteredTracks = new MetadataPtrList;
+                        m_deleteList.append(filteredTracks);
+                        filteredTracks->append(mdata);
+                        map.insert(mdata->Album(), filteredTracks);
+                    }
                 }
             }
         }
@@ -1125,22 +1149,27 @@ void PlaylistEditorView::filterTracks(MusicGenericTree *node)
     {
         QMap<QString, MetadataPtrList*> map;
 
-        for (int x = 0; x < tracks->count(); x++)
+        if (tracks == gMusicData->all_music->getAllMetadata())
+            copyIndex(gMusicData->all_music->getGenreIndex(), map);
+        else
         {
-            MusicMetadata *mdata = tracks->at(x);
-            if (mdata)
+            for (int x = 0; x < tracks->count(); x++)
             {
-                if (map.contains(mdata->Genre()))
-                {
-                    MetadataPtrList *filteredTracks = map.value(mdata->Genre());
-                    filteredTracks->append(mdata);
-                }
-                else
+                MusicMetadata *mdata = tracks->at(x);
+                if (mdata)
                 {
-                    MetadataPtrList *filteredTracks = new MetadataPtrList;
-                    m_deleteList.append(filteredTracks);
-                    filteredTracks->append(mdata);
-                    map.insert(mdata->Genre(), filteredTracks);
+                    if (map.contains(mdata->Genre()))
+                    {
+                        MetadataPtrList *filteredTracks = map.value(mdata->Genre());
+                        filteredTracks->append(mdata);
+                    }
+                    else
+                    {
+                        MetadataPtrList *filteredTracks = new MetadataPtrList;
+                        m_deleteList.append(filteredTracks);
+                        filteredTracks->append(mdata);
+                        map.insert(mdata->Genre(), filteredTracks);
+                    }
                 }
             }
         }
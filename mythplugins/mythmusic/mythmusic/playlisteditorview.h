@@ -86,6 +86,8 @@ class PlaylistEditorView : public MusicCommon
 
   private:
     void filterTracks(MusicGenericTree *node);
+    void copyIndex(const AllMusic::MetadataIndex &index,
+                   QMap<QString, MetadataPtrList*> &map);
 
     void getPlaylists(MusicGenericTree *node);
     void getPlaylistTracks(MusicGenericTree *node, int playlistID);
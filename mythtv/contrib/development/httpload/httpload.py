@@ -0,0 +1,169 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# httpload.py - a small wrk style load generator for the MythTV HTTP server
+#
+# Opens a number of keep-alive connections and sends requests down each of
+# them for a fixed time, optionally pipelining several at once, then reports
+# the request rate, transfer rate and latency percentiles.
+#
+#   httpload.py -c 64 -d 30 -p 4 http://backend:6544/Myth/GetHostName
+#
+# Licensed under the GPL v2 or later, see COPYING for details
+
+import optparse
+import socket
+import sys
+import threading
+import time
+
+try:
+    from urlparse import urlsplit
+except ImportError:
+    from urllib.parse import urlsplit
+
+
+class Stats(object):
+    def __init__(self):
+        self.lock      = threading.Lock()
+        self.requests  = 0
+        self.bytes     = 0
+        self.errors    = 0
+        self.latencies = []
+
+    def add(self, requests, nbytes, errors, latencies):
+        self.lock.acquire()
+        try:
+            self.requests += requests
+            self.bytes    += nbytes
+            self.errors   += errors
+            self.latencies.extend(latencies)
+        finally:
+            self.lock.release()
+
+
+def read_response(sock, buf):
+    """Reads one response, returns (body length, remaining buffer)."""
+    while b'\r\n\r\n' not in buf:
+        data = sock.recv(65536)
+        if not data:
+            raise IOError('connection closed')
+        buf += data
+
+    head, buf = buf.split(b'\r\n\r\n', 1)
+    lines  = head.decode('latin-1').split('\r\n')
+    status = int(lines[0].split()[1])
+    length = 0
+    for line in lines[1:]:
+        name, _, value = line.partition(':')
+        if name.strip().lower() == 'content-length':
+            length = int(value.strip())
+
+    while len(buf) < length:
+        data = sock.recv(65536)
+        if not data:
+            raise IOError('connection closed')
+        buf += data
+
+    if status >= 400:
+        raise IOError('status %d' % status)
+
+    return length, buf[length:]
+
+
+def worker(host, port, request, depth, deadline, stats):
+    requests = nbytes = errors = 0
+    latencies = []
+    sock = None
+    buf  = b''
+
+    while time.time() < deadline:
+        try:
+            if sock is None:
+                sock = socket.create_connection((host, port), 10)
+                sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+                buf  = b''
+
+            start = time.time()
+            sock.sendall(request * depth)
+            for i in range(depth):
+                length, buf = read_response(sock, buf)
+                latencies.append(time.time() - start)
+                requests += 1
+                nbytes   += length
+        except (IOError, socket.error):
+            errors += 1
+            if sock is not None:
+                sock.close()
+            sock = None
+
+    if sock is not None:
+        sock.close()
+
+    stats.add(requests, nbytes, errors, latencies)
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    return values[min(len(values) - 1, int(len(values) * fraction))]
+
+
+def main():
+    parser = optparse.OptionParser(usage='%prog [options] URL')
+    parser.add_option('-c', '--connections', type='int', default=32,
+                      help='connections to keep open [%default]')
+    parser.add_option('-d', '--duration', type='float', default=10,
+                      help='seconds to run for [%default]')
+    parser.add_option('-p', '--pipeline', type='int', default=1,
+                      help='requests sent at once on each connection '
+                           '[%default]')
+    opts, args = parser.parse_args()
+
+    if len(args) != 1:
+        parser.error('a URL is needed')
+
+    url  = urlsplit(args[0])
+    host = url.hostname
+    port = url.port or 80
+    path = url.path or '/'
+    if url.query:
+        path += '?' + url.query
+
+    request = ('GET %s HTTP/1.1\r\nHost: %s:%d\r\n'
+               'Connection: keep-alive\r\n\r\n' % (path, host, port))
+    request = request.encode('latin-1')
+
+    stats    = Stats()
+    deadline = time.time() + opts.duration
+    threads  = []
+
+    for i in range(opts.connections):
+        t = threading.Thread(target=worker,
+                             args=(host, port, request, opts.pipeline,
+                                   deadline, stats))
+        t.daemon = True
+        t.start()
+        threads.append(t)
+
+    started = time.time()
+    for t in threads:
+        t.join()
+    elapsed = time.time() - started
+
+    latencies = sorted(stats.latencies)
+
+    print('%d connections, pipeline depth %d, %.1f seconds' %
+          (opts.connections, opts.pipeline, elapsed))
+    print('  Requests/sec: %10.1f' % (stats.requests / elapsed))
+    print('  Transfer/sec: %10.2f MB' % (stats.bytes / elapsed / 1048576.0))
+    print('  Errors:       %10d' % stats.errors)
+    print('  Latency  50%%: %8.2f ms' % (percentile(latencies, 0.50) * 1000))
+    print('           90%%: %8.2f ms' % (percentile(latencies, 0.90) * 1000))
+    print('           99%%: %8.2f ms' % (percentile(latencies, 0.99) * 1000))
+
+    return 1 if stats.errors and not stats.requests else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
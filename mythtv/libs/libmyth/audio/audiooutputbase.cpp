@@ -32,6 +32,13 @@
 #define UPMIX_CHANNEL_MASK ((1<<1)|(1<<2)|(1<<5)|1<<7)
 #define IS_VALID_UPMIX_CHANNEL(ch) ((1 << (ch)) & UPMIX_CHANNEL_MASK)
 
+static int64_t wallclock_usecs(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
 const char *AudioOutputBase::quality_string(int q)
 {
     switch(q)
@@ -105,7 +112,8 @@ AudioOutputBase::AudioOutputBase(const AudioSettings &settings) :
     memory_corruption_test3(0xdeadbeef),
     m_configure_succeeded(false),m_length_last_data(0),
     m_spdifenc(NULL),           m_forcedprocessing(false),
-    m_previousbpf(0)
+    m_previousbpf(0),           m_dspThread(NULL),
+    m_dspStatsStart(0)
 {
     src_in = (float *)AOALIGN(src_in_buf);
     memset(&src_data,          0, sizeof(SRC_DATA));
@@ -842,6 +850,7 @@ void AudioOutputBase::Reconfigure(const AudioSettings &orig_settings)
     m_configure_succeeded = true;
 
     StartOutputThread();
+    StartDSPThread();
 
     VBAUDIO("Ending Reconfigure()");
 }
@@ -867,6 +876,39 @@ void AudioOutputBase::StopOutputThread(void)
     }
 }
 
+/**
+ * Start the DSP thread, unless disabled or the audio is passed through
+ *
+ * Caller must hold audio_buflock
+ */
+void AudioOutputBase::StartDSPThread(void)
+{
+    if (m_dspThread || passthru ||
+        !gCoreContext->GetNumSetting("AudioDSPThread", 1))
+        return;
+
+    m_dspQueue.Clear();
+    m_dspThread = new AudioDSPThread(this);
+    m_dspThread->start();
+}
+
+/**
+ * Stop the DSP thread, discarding any audio it has not processed yet
+ *
+ * killaudio must be set, and audio_buflock must not be held
+ */
+void AudioOutputBase::StopDSPThread(void)
+{
+    if (!m_dspThread)
+        return;
+
+    m_dspWait.wakeAll();
+    m_dspThread->wait();
+    delete m_dspThread;
+    m_dspThread = NULL;
+    m_dspQueue.Clear();
+}
+
 /**
  * Kill the output thread and cleanup
  */
@@ -876,6 +918,7 @@ void AudioOutputBase::KillAudio()
 
     VBAUDIO("Killing AudioOutputDSP");
     killaudio = true;
+    StopDSPThread();
     StopOutputThread();
     QMutexLocker lock(&audio_buflock);
 
@@ -949,6 +992,7 @@ void AudioOutputBase::Reset()
         waud = raud;        // empty ring buffer
     }
     reset_active.Ref();
+    m_dspQueue.Clear();
     current_seconds = -1;
     was_paused = !pauseaudio;
     // clear any state that could remember previous audio in any active filters
@@ -1316,11 +1360,8 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
                               int64_t timecode, int /*in_frames*/)
 {
     int frames   = in_len / source_bytes_per_frame;
-    void *buffer = in_buffer;
-    int bpf      = bytes_per_frame;
     int len      = in_len;
     bool music   = false;
-    int bdiff;
 
     if (!m_configure_succeeded)
     {
@@ -1338,12 +1379,11 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
         Pause(false);
     }
 
-    // Don't write new samples if we're resetting the buffer or reconfiguring
-    QMutexLocker lock(&audio_buflock);
-
-    uint org_waud = waud;
-    int  afree    = audiofree();
-    int  used     = kAudioRingBufferSize - afree;
+    /* When the DSP thread is running, the samples are only queued here.
+       Otherwise don't write new samples if we're resetting the buffer or
+       reconfiguring */
+    bool queue = m_dspThread && !passthru;
+    QMutexLocker lock(queue ? NULL : &audio_buflock);
 
     if (passthru && m_spdifenc)
     {
@@ -1363,7 +1403,7 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
         len = m_spdifenc->GetProcessedSize();
         if (len > 0)
         {
-            buffer = in_buffer = m_spdifenc->GetProcessedBuffer();
+            in_buffer = m_spdifenc->GetProcessedBuffer();
             m_spdifenc->Reset();
             frames = len / source_bytes_per_frame;
         }
@@ -1373,19 +1413,26 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
     m_length_last_data = (int64_t)
         ((double)(len * 1000) / (source_samplerate * source_bytes_per_frame));
 
-    VBAUDIOTS(QString("AddData frames=%1, bytes=%2, used=%3, free=%4, "
-                      "timecode=%5 needsupmix=%6")
-              .arg(frames).arg(len).arg(used).arg(afree).arg(timecode)
-              .arg(needs_upmix));
-
     // Mythmusic doesn't give us timestamps
     if (timecode < 0)
     {
         timecode = (frames_buffered * 1000) / source_samplerate;
-        frames_buffered += frames;
         music = true;
     }
 
+    if (queue)
+    {
+        if (!m_dspQueue.Push(in_buffer, len, timecode, music))
+        {
+            VBAUDIOTS("DSP queue is full, AddData returning false");
+            return false;
+        }
+        m_dspWait.wakeAll();
+    }
+
+    if (music)
+        frames_buffered += frames;
+
     if (hasVisual())
     {
         // Send original samples to any attached visualisations
@@ -1393,6 +1440,35 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
                        output_settings->FormatToBits(format));
     }
 
+    if (queue)
+        return true;
+
+    return ProcessData(in_buffer, len, timecode, music);
+}
+
+/**
+ * Run the samples through the processing chain into the audiobuffer
+ *
+ * Called from AddData() or the DSP thread with audio_buflock held.
+ * Returns false if there's not enough space right now
+ */
+bool AudioOutputBase::ProcessData(void *in_buffer, int in_len,
+                                  int64_t timecode, bool music)
+{
+    int frames    = in_len / source_bytes_per_frame;
+    void *buffer  = in_buffer;
+    int bpf       = bytes_per_frame;
+    int len       = in_len;
+    int bdiff;
+    uint org_waud = waud;
+    int  afree    = audiofree();
+    int  used     = kAudioRingBufferSize - afree;
+
+    VBAUDIOTS(QString("AddData frames=%1, bytes=%2, used=%3, free=%4, "
+                      "timecode=%5 needsupmix=%6")
+              .arg(frames).arg(len).arg(used).arg(afree).arg(timecode)
+              .arg(needs_upmix));
+
     // Calculate amount of free space required in ringbuffer
     if (processing)
     {
@@ -1438,6 +1514,7 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
     int frames_final = 0;
     int maxframes = (kAudioSRCInputSize / source_channels) & ~0xf;
     int offset = 0;
+    int64_t t = AudioDSPStats::ThreadTime();
 
     while(frames_remaining > 0)
     {
@@ -1465,6 +1542,7 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
                                                  configured_channels,
                                                  src_in, src_in, frames) < 0)
                 VBERROR("Error occurred while downmixing");
+        t = m_dspPending.Add(AudioDSPStats::kConvert, t);
 
         // Resample if necessary
         if (need_resampler && src_ctx)
@@ -1478,6 +1556,7 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
 
             buffer = src_out;
             frames = src_data.output_frames_gen;
+            t = m_dspPending.Add(AudioDSPStats::kResample, t);
         }
         else if (processing)
             buffer = src_in;
@@ -1487,7 +1566,9 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
            represent */
 
         // Copy samples into audiobuffer, with upmix if necessary
-        if ((len = CopyWithUpmix((char *)buffer, frames, org_waud)) <= 0)
+        len = CopyWithUpmix((char *)buffer, frames, org_waud);
+        t = m_dspPending.Add(AudioDSPStats::kUpmix, t);
+        if (len <= 0)
         {
             continue;
         }
@@ -1540,6 +1621,7 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
                                                         nFrames);
 
             org_waud = (org_waud + nFrames * bpf) % kAudioRingBufferSize;
+            t = m_dspPending.Add(AudioDSPStats::kStretch, t);
         }
 
         if (internal_vol && SWVolume())
@@ -1558,6 +1640,7 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
                 AudioOutputUtil::AdjustVolume(WPOS, num, volume,
                                               music, needs_upmix && upmixer);
             org_waud = (org_waud + num) % kAudioRingBufferSize;
+            t = m_dspPending.Add(AudioDSPStats::kVolume, t);
         }
 
         if (encoder)
@@ -1587,18 +1670,62 @@ bool AudioOutputBase::AddData(void *in_buffer, int in_len,
                 encoder->GetFrames(WPOS, to_get);
 
             org_waud = (org_waud + to_get) % kAudioRingBufferSize;
+            t = m_dspPending.Add(AudioDSPStats::kEncode, t);
         }
 
         waud = org_waud;
     }
 
+    m_dspStats.Commit(m_dspPending);
     SetAudiotime(frames_final, timecode);
 
     return true;
 }
 
 /**
- * Report status via an OutputEvent
+ * Run in the DSP thread, move queued samples through the processing chain
+ * into the audiobuffer as space becomes available
+ */
+void AudioOutputBase::DSPLoop(void)
+{
+    while (!killaudio)
+    {
+        bool done = false;
+        bool full = false;
+        {
+            QMutexLocker lock(&audio_buflock);
+            AudioDSPChunk *chunk = m_dspQueue.Front();
+            if (chunk)
+            {
+                full = !ProcessData(chunk->buf, chunk->len, chunk->timecode,
+                                    chunk->music);
+                if (!full)
+                    m_dspQueue.Pop();
+                done = !full;
+            }
+        }
+
+        if (done)
+            continue;
+
+        if (full)
+        {
+            // wait for the output thread to make room
+            usleep(5000);
+            continue;
+        }
+
+        /* AddData() wakes us without taking the lock so that it never
+           blocks, so a wakeup can be missed; the timeout bounds the delay */
+        QMutexLocker lock(&m_dspWaitLock);
+        if (m_dspQueue.IsEmpty() && !killaudio)
+            m_dspWait.wait(&m_dspWaitLock, 5);
+    }
+}
+
+/**
+ * Report status via an OutputEvent, and log the CPU time spent in each
+ * processing stage over the last second
  */
 void AudioOutputBase::Status()
 {
@@ -1617,6 +1744,17 @@ void AudioOutputBase::Status()
         OutputEvent e(current_seconds, ct, source_bitrate, source_samplerate,
                       output_settings->FormatToBits(format), source_channels);
         dispatch(e);
+
+        int64_t now = wallclock_usecs();
+        if (m_dspStatsStart && VERBOSE_LEVEL_CHECK(VB_AUDIO, LOG_INFO))
+        {
+            VBAUDIO(QString("DSP CPU (%1): %2")
+                    .arg(m_dspThread ? "DSP thread" : "decoder thread")
+                    .arg(m_dspStats.TakeSummary(now - m_dspStatsStart)));
+        }
+        else
+            m_dspStats.Clear();
+        m_dspStatsStart = now;
     }
 }
 
@@ -1813,6 +1951,8 @@ int AudioOutputBase::GetAudioData(uchar *buffer, int size, bool full_buffer,
  */
 void AudioOutputBase::Drain()
 {
+    while (m_dspThread && !m_dspQueue.IsEmpty())
+        usleep(1000);
     while (audioready() > fragment_size)
         usleep(1000);
 }
@@ -20,6 +20,7 @@ using namespace std;
 
 #include "mythlogging.h"
 #include "mthread.h"
+#include "audiooutputdsp.h"
 
 #define VBAUDIO(str)   LOG(VB_AUDIO, LOG_INFO, LOC + str)
 #define VBAUDIOTS(str) LOG(VB_AUDIO | VB_TIMESTAMP, LOG_INFO, LOC + str)
@@ -53,6 +54,8 @@ class SPDIFEncoder;
 
 class AudioOutputBase : public AudioOutput, public MThread
 {
+    friend class AudioDSPThread;
+
  public:
     const char *quality_string(int q);
     AudioOutputBase(const AudioSettings &settings);
@@ -152,6 +155,7 @@ class AudioOutputBase : public AudioOutput, public MThread
                      volatile uint *local_raud = NULL);
 
     void OutputAudioLoop(void);
+    void DSPLoop(void);
 
     virtual void run();
 
@@ -211,6 +215,10 @@ class AudioOutputBase : public AudioOutput, public MThread
                           int &samplerate_tmp, int &channels_tmp);
     AudioOutputSettings* OutputSettings(bool digital = true);
     int CopyWithUpmix(char *buffer, int frames, uint &org_waud);
+    bool ProcessData(void *in_buffer, int in_len, int64_t timecode,
+                     bool music);
+    void StartDSPThread(void);
+    void StopDSPThread(void);
     void SetAudiotime(int frames, int64_t timecode);
     AudioOutputSettings *output_settingsraw;
     AudioOutputSettings *output_settings;
@@ -295,6 +303,20 @@ class AudioOutputBase : public AudioOutput, public MThread
     // Flag indicating if SetStretchFactor enabled audio float processing
     bool m_forcedprocessing;
     int m_previousbpf;
+
+    /**
+     *  Time stretch, upmix and AC-3 encoding run on this thread, fed
+     *  through m_dspQueue, so that they overlap with decoding
+     */
+    AudioDSPThread *m_dspThread;
+    AudioDSPQueue   m_dspQueue;
+    QMutex          m_dspWaitLock;
+    QWaitCondition  m_dspWait;
+
+    /// CPU time per processing stage, reported by Status()
+    AudioDSPStats   m_dspStats;
+    AudioDSPStats   m_dspPending;
+    int64_t         m_dspStatsStart;
 };
 
 #endif
@@ -0,0 +1,147 @@
+// Std C headers
+#include <cstring>
+#include <ctime>
+
+// POSIX headers
+#include <sys/time.h>
+
+// MythTV headers
+#include "audiooutputdsp.h"
+#include "audiooutputbase.h"
+
+#define LOC QString("AODSP: ")
+
+/**
+ * Copy a block of audio into the queue
+ *
+ * Returns false if the queue is full. Only the decoder thread may call this.
+ */
+bool AudioDSPQueue::Push(const void *buffer, int len, int64_t timecode,
+                         bool music)
+{
+    int head = m_head.fetchAndAddOrdered(0);
+    int next = (head + 1) % kSlots;
+
+    if (next == m_tail.fetchAndAddOrdered(0))
+        return false;
+
+    // The consumer never touches the slot at m_head, so it is ours to fill
+    AudioDSPChunk &chunk = m_chunks[head];
+    if (chunk.size < len)
+    {
+        delete[] chunk.buf;
+        chunk.buf  = new unsigned char[len];
+        chunk.size = len;
+    }
+    memcpy(chunk.buf, buffer, len);
+    chunk.len      = len;
+    chunk.timecode = timecode;
+    chunk.music    = music;
+
+    m_head.fetchAndStoreRelease(next);
+    return true;
+}
+
+/**
+ * Oldest queued block, or NULL if the queue is empty
+ */
+AudioDSPChunk *AudioDSPQueue::Front(void)
+{
+    int tail = m_tail.fetchAndAddOrdered(0);
+    if (tail == m_head.fetchAndAddOrdered(0))
+        return NULL;
+    return &m_chunks[tail];
+}
+
+void AudioDSPQueue::Pop(void)
+{
+    int tail = m_tail.fetchAndAddOrdered(0);
+    if (tail != m_head.fetchAndAddOrdered(0))
+        m_tail.fetchAndStoreRelease((tail + 1) % kSlots);
+}
+
+/**
+ * Discard all queued blocks
+ */
+void AudioDSPQueue::Clear(void)
+{
+    m_tail.fetchAndStoreRelease(m_head.fetchAndAddOrdered(0));
+}
+
+bool AudioDSPQueue::IsEmpty(void) const
+{
+    return const_cast<QAtomicInt&>(m_tail).fetchAndAddOrdered(0) ==
+           const_cast<QAtomicInt&>(m_head).fetchAndAddOrdered(0);
+}
+
+/**
+ * CPU time used by the calling thread in microseconds, or wall clock time
+ * where per thread CPU clocks are not available
+ */
+int64_t AudioDSPStats::ThreadTime(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void AudioDSPStats::Clear(void)
+{
+    QMutexLocker locker(&m_lock);
+    memset(m_usecs, 0, sizeof(m_usecs));
+}
+
+/**
+ * Move the times collected in 'pending' into these totals
+ */
+void AudioDSPStats::Commit(AudioDSPStats &pending)
+{
+    QMutexLocker locker(&m_lock);
+    for (int i = 0; i < kStageCount; i++)
+        m_usecs[i] += pending.m_usecs[i];
+    memset(pending.m_usecs, 0, sizeof(pending.m_usecs));
+}
+
+/**
+ * Describe the time spent in each stage as a percentage of one CPU over
+ * 'elapsed_usecs', and restart the totals
+ */
+QString AudioDSPStats::TakeSummary(int64_t elapsed_usecs)
+{
+    static const char *names[kStageCount] =
+        { "convert", "resample", "upmix", "stretch", "volume", "encode" };
+
+    QMutexLocker locker(&m_lock);
+
+    if (elapsed_usecs <= 0)
+        elapsed_usecs = 1;
+
+    QString summary;
+    int64_t total = 0;
+    for (int i = 0; i < kStageCount; i++)
+    {
+        total += m_usecs[i];
+        summary += QString("%1 %2% ").arg(names[i])
+            .arg(100.0 * m_usecs[i] / elapsed_usecs, 0, 'f', 1);
+    }
+    summary += QString("total %1%")
+        .arg(100.0 * total / elapsed_usecs, 0, 'f', 1);
+
+    memset(m_usecs, 0, sizeof(m_usecs));
+    return summary;
+}
+
+void AudioDSPThread::run(void)
+{
+    RunProlog();
+    LOG(VB_AUDIO, LOG_INFO, LOC + "DSP thread starting");
+    if (m_parent)
+        m_parent->DSPLoop();
+    LOG(VB_AUDIO, LOG_INFO, LOC + "DSP thread exiting");
+    RunEpilog();
+}
@@ -0,0 +1,117 @@
+#ifndef AUDIOOUTPUTDSP
+#define AUDIOOUTPUTDSP
+
+// C++ headers
+#include <stdint.h>
+
+// Qt headers
+#include <QAtomicInt>
+#include <QMutex>
+#include <QString>
+
+// MythTV headers
+#include "mthread.h"
+
+class AudioOutputBase;
+
+/**
+ * One block of decoded audio waiting for the DSP thread
+ */
+class AudioDSPChunk
+{
+  public:
+    AudioDSPChunk() : buf(NULL), size(0), len(0), timecode(0), music(false) {}
+    ~AudioDSPChunk() { delete[] buf; }
+
+    unsigned char *buf;
+    int            size;     ///< allocated size of buf
+    int            len;      ///< bytes of audio in buf
+    int64_t        timecode;
+    bool           music;
+};
+
+/**
+ * Single producer, single consumer queue of audio blocks between the
+ * decoder thread (AudioOutputBase::AddData) and the DSP thread.
+ *
+ * Push() never blocks, so the decoder is not held up while the DSP thread
+ * is busy time stretching, upmixing or encoding. The consumer side
+ * (Front(), Pop() and Clear()) must be called with the audio buffer lock
+ * held, which also serialises it against AudioOutputBase::Reset().
+ */
+class AudioDSPQueue
+{
+  public:
+    AudioDSPQueue() : m_head(0), m_tail(0) {}
+
+    bool Push(const void *buffer, int len, int64_t timecode, bool music);
+    AudioDSPChunk *Front(void);
+    void Pop(void);
+    void Clear(void);
+    bool IsEmpty(void) const;
+
+    /// Number of blocks that can be queued; about a second of audio
+    static const int kSlots = 32;
+
+  private:
+    AudioDSPChunk m_chunks[kSlots];
+    QAtomicInt    m_head;        ///< next slot the producer fills
+    QAtomicInt    m_tail;        ///< next slot the consumer reads
+};
+
+/**
+ * Accumulates the CPU time spent in each audio processing stage
+ */
+class AudioDSPStats
+{
+  public:
+    enum Stage
+    {
+        kConvert = 0,            ///< float conversion and downmix
+        kResample,
+        kUpmix,
+        kStretch,
+        kVolume,
+        kEncode,
+        kStageCount
+    };
+
+    AudioDSPStats() { Clear(); }
+
+    static int64_t ThreadTime(void);
+
+    /// Adds the time since 'since' to 'stage', and returns the current time
+    int64_t Add(Stage stage, int64_t since)
+    {
+        int64_t now = ThreadTime();
+        m_usecs[stage] += now - since;
+        return now;
+    }
+
+    void Clear(void);
+    void Commit(AudioDSPStats &pending);
+    QString TakeSummary(int64_t elapsed_usecs);
+
+  private:
+    QMutex  m_lock;
+    int64_t m_usecs[kStageCount];
+};
+
+/**
+ * Runs the audio processing chain of an AudioOutputBase
+ */
+class AudioDSPThread : public MThread
+{
+  public:
+    AudioDSPThread(AudioOutputBase *parent)
+      : MThread("AudioDSP"), m_parent(parent) { }
+    ~AudioDSPThread() { wait(); }
+
+  protected:
+    virtual void run(void);
+
+  private:
+    AudioOutputBase *m_parent;
+};
+
+#endif
@@ -31,7 +31,7 @@ HEADERS += audio/audiooutpututil.h audio/audiooutputdownmix.h
 HEADERS += audio/audioconvert.h
 HEADERS += audio/audiooutputdigitalencoder.h audio/spdifencoder.h
 HEADERS += audio/audiosettings.h audio/audiooutputsettings.h audio/pink.h
-HEADERS += audio/volumebase.h audio/eldutils.h
+HEADERS += audio/volumebase.h audio/eldutils.h audio/audiooutputdsp.h
 HEADERS += backendselect.h dbsettings.h dialogbox.h
 HEADERS += langsettings.h
 HEADERS += mythconfigdialogs.h mythconfiggroups.h
@@ -58,7 +58,7 @@ SOURCES += audio/audiooutputnull.cpp
 SOURCES += audio/audiooutpututil.cpp audio/audiooutputdownmix.cpp
 SOURCES += audio/audioconvert.cpp
 SOURCES += audio/audiosettings.cpp audio/audiooutputsettings.cpp audio/pink.c
-SOURCES += audio/volumebase.cpp audio/eldutils.cpp
+SOURCES += audio/volumebase.cpp audio/eldutils.cpp audio/audiooutputdsp.cpp
 
 SOURCES += backendselect.cpp dbsettings.cpp dialogbox.cpp
 SOURCES += langsettings.cpp
@@ -3560,47 +3560,7 @@ void ProgramInfo::SavePositionMap(
     if (!query.exec())
         MythDB::DBError("position map clear", query);
 
-    if (IsVideo())
-    {
-        query.prepare(
-            "INSERT INTO "
-            "filemarkup (filename, mark, type, offset) "
-            "VALUES ( :PATH , :MARK , :TYPE , :OFFSET )");
-        query.bindValue(":PATH", videoPath);
-    }
-    else // if (IsRecording())
-    {
-        query.prepare(
-            "INSERT INTO "
-            "recordedseek (chanid, starttime, mark, type, offset) "
-            " VALUES ( :CHANID , :STARTTIME , :MARK , :TYPE , :OFFSET )");
-        query.bindValue(":CHANID",    chanid);
-        query.bindValue(":STARTTIME", recstartts);
-    }
-    query.bindValue(":TYPE", type);
-
-    frm_pos_map_t::iterator it;
-    for (it = posMap.begin(); it != posMap.end(); ++it)
-    {
-        uint64_t frame = it.key();
-
-        if ((min_frame >= 0) && (frame < (uint64_t)min_frame))
-            continue;
-
-        if ((max_frame >= 0) && (frame > (uint64_t)max_frame))
-            continue;
-
-        uint64_t offset = *it;
-
-        query.bindValue(":MARK",   (quint64)frame);
-        query.bindValue(":OFFSET", (quint64)offset);
-
-        if (!query.exec())
-        {
-            MythDB::DBError("position map insert", query);
-            break;
-        }
-    }
+    InsertPositionMap(posMap, type, min_frame, max_frame);
 }
 
 void ProgramInfo::SavePositionMapDelta(
@@ -3618,43 +3578,81 @@ void ProgramInfo::SavePositionMapDelta(
         return;
     }
 
-    MSqlQuery query(MSqlQuery::InitCon());
+    InsertPositionMap(posMap, type);
+}
+
+/** \brief Inserts the entries of posMap from min_frame to max_frame,
+ *         many rows per query.
+ *
+ *  A rebuilt seek table can have hundreds of thousands of entries, and
+ *  inserting them one row at a time took longer than building them.
+ */
+void ProgramInfo::InsertPositionMap(
+    const frm_pos_map_t &posMap, MarkTypes type,
+    int64_t min_frame, int64_t max_frame) const
+{
+    static const int kMaxRows = 1000;
 
+    QString videoPath;
     if (IsVideo())
-    {
-        query.prepare(
-            "INSERT INTO "
-            "filemarkup (filename, mark, type, offset) "
-            "VALUES ( :PATH , :MARK , :TYPE , :OFFSET )");
-        query.bindValue(":PATH", StorageGroup::GetRelativePathname(pathname));
-    }
-    else if (IsRecording())
-    {
-        query.prepare(
-            "INSERT INTO "
-            "recordedseek (chanid, starttime, mark, type, offset) "
-            " VALUES ( :CHANID , :STARTTIME , :MARK , :TYPE , :OFFSET )");
-        query.bindValue(":CHANID",    chanid);
-        query.bindValue(":STARTTIME", recstartts);
-    }
-    else
-    {
+        videoPath = StorageGroup::GetRelativePathname(pathname);
+    else if (!IsRecording())
         return;
-    }
-    query.bindValue(":TYPE", type);
 
-    frm_pos_map_t::iterator it;
-    for (it = posMap.begin(); it != posMap.end(); ++it)
+    MSqlQuery query(MSqlQuery::InitCon());
+
+    frm_pos_map_t::const_iterator it = posMap.begin();
+    while (it != posMap.end())
     {
-        uint64_t frame  = it.key();
-        uint64_t offset = *it;
+        QList<frm_pos_map_t::const_iterator> rows;
+        for (; it != posMap.end() && rows.size() < kMaxRows; ++it)
+        {
+            uint64_t frame = it.key();
+            if ((min_frame >= 0) && (frame < (uint64_t)min_frame))
+                continue;
+            if ((max_frame >= 0) && (frame > (uint64_t)max_frame))
+                continue;
+            rows.push_back(it);
+        }
+
+        if (rows.isEmpty())
+            break;
+
+        QString sql = IsVideo() ?
+            "INSERT INTO filemarkup (filename, mark, type, offset) VALUES " :
+            "INSERT INTO recordedseek "
+            "(chanid, starttime, mark, type, offset) VALUES ";
+        for (int i = 0; i < rows.size(); i++)
+        {
+            if (i)
+                sql += ", ";
+            sql += QString(IsVideo() ?
+                           "(:PATH%1, :MARK%1, :TYPE%1, :OFFSET%1)" :
+                           "(:CHANID%1, :STARTTIME%1, :MARK%1, :TYPE%1, "
+                           ":OFFSET%1)").arg(i);
+        }
+        query.prepare(sql);
 
-        query.bindValue(":MARK",   (quint64)frame);
-        query.bindValue(":OFFSET", (quint64)offset);
+        for (int i = 0; i < rows.size(); i++)
+        {
+            QString n = QString::number(i);
+            if (IsVideo())
+            {
+                query.bindValue(":PATH" + n, videoPath);
+            }
+            else
+            {
+                query.bindValue(":CHANID" + n,    chanid);
+                query.bindValue(":STARTTIME" + n, recstartts);
+            }
+            query.bindValue(":MARK" + n,   (quint64)rows[i].key());
+            query.bindValue(":TYPE" + n,   type);
+            query.bindValue(":OFFSET" + n, (quint64)*rows[i]);
+        }
 
         if (!query.exec())
         {
-            MythDB::DBError("delta position map insert", query);
+            MythDB::DBError("position map insert", query);
             break;
         }
     }
@@ -4884,26 +4882,94 @@ bool LoadFromRecorded(
     const QMap<QString,bool> &isJobRunning,
     const QMap<QString, ProgramInfo*> &recMap,
     int sort)
+{
+    QString sql;
+    if (possiblyInProgressRecordingsOnly)
+        sql = "r.endtime >= NOW() AND r.starttime <= NOW()";
+
+    QString orderBy;
+    if (sort)
+        orderBy = "r.starttime";
+    if (sort < 0)
+        orderBy += " DESC";
+
+    uint count;
+    return LoadFromRecorded(destination, sql, MSqlBindings(), inUseMap,
+                            isJobRunning, recMap, orderBy, 0, 0, count);
+}
+
+/** \brief Load one page of a ProgramList from the recorded table.
+ *
+ *  Filtering, sorting and paging are all done by the database, so only
+ *  the rows that are returned are turned into ProgramInfo's.
+ *
+ *  \param destination     ProgramList to fill
+ *  \param sql             condition on the recorded table, which is
+ *                         aliased as "r", or empty for all recordings
+ *  \param bindings        values for the placeholders in sql
+ *  \param inUseMap        in-use programs map
+ *  \param isJobRunning    job map
+ *  \param recMap          recording map
+ *  \param orderBy         ORDER BY expression, or empty for unsorted
+ *  \param start           number of matching recordings to skip
+ *  \param limit           most recordings to return, 0 for all of them
+ *  \param count           set to the number of recordings that match sql
+ *  \return true if it succeeds, false if it fails.
+ */
+bool LoadFromRecorded(
+    ProgramList &destination,
+    const QString &sql,
+    const MSqlBindings &bindings,
+    const QMap<QString,uint32_t> &inUseMap,
+    const QMap<QString,bool> &isJobRunning,
+    const QMap<QString, ProgramInfo*> &recMap,
+    const QString &orderBy,
+    uint start,
+    uint limit,
+    uint &count)
 {
     destination.clear();
+    count = 0;
 
     QString     fs_db_name = "";
     QDateTime   rectime    = MythDate::current().addSecs(
         -gCoreContext->GetNumSetting("RecordOverTime"));
 
+    MSqlQuery query(MSqlQuery::InitCon());
+
     // ----------------------------------------------------------------------
 
-    QString thequery = ProgramInfo::kFromRecordedQuery;
-    if (possiblyInProgressRecordingsOnly)
-        thequery += "WHERE r.endtime >= NOW() AND r.starttime <= NOW() ";
+    QString where;
+    if (!sql.isEmpty())
+        where = "WHERE " + sql + " ";
 
-    if (sort)
-        thequery += "ORDER BY r.starttime ";
-    if (sort < 0)
-        thequery += "DESC ";
+    if (limit > 0)
+    {
+        // The filter only uses recorded, so no joins are needed to count
+        query.prepare("SELECT COUNT(*) FROM recorded AS r " + where);
+        query.bindValues(bindings);
+
+        if (!query.exec() || !query.next())
+        {
+            MythDB::DBError("ProgramList::FromRecorded count", query);
+            return false;
+        }
+        count = query.value(0).toUInt();
+
+        if (start >= count)
+            return true;
+    }
+
+    QString thequery = ProgramInfo::kFromRecordedQuery + where;
+
+    if (!orderBy.isEmpty())
+        thequery += "ORDER BY " + orderBy + " ";
+
+    if (limit > 0)
+        thequery += QString("LIMIT %1 OFFSET %2 ").arg(limit).arg(start);
 
-    MSqlQuery query(MSqlQuery::InitCon());
     query.prepare(thequery);
+    query.bindValues(bindings);
 
     if (!query.exec())
     {
@@ -5030,6 +5096,9 @@ bool LoadFromRecorded(
             destination.back()->SaveCommFlagged(COMM_FLAG_NOT_FLAGGED);
     }
 
+    if (limit == 0)
+        count = destination.size();
+
     return true;
 }
 
@@ -631,6 +631,8 @@ class MPUBLIC ProgramInfo
                        int64_t min_frm = -1, int64_t max_frm = -1) const;
     void ClearMarkupMap(MarkTypes type = MARK_ALL,
                         int64_t min_frm = -1, int64_t max_frm = -1) const;
+    void InsertPositionMap(const frm_pos_map_t &, MarkTypes type,
+                           int64_t min_frm = -1, int64_t max_frm = -1) const;
 
     // Creates a basename from the start and end times
     QString CreateRecordBasename(const QString &ext) const;
@@ -756,6 +758,18 @@ MPUBLIC bool LoadFromRecorded(
     const QMap<QString, ProgramInfo*> &recMap,
     int                 sort = 0);
 
+MPUBLIC bool LoadFromRecorded(
+    ProgramList        &destination,
+    const QString      &sql,
+    const MSqlBindings &bindings,
+    const QMap<QString,uint32_t> &inUseMap,
+    const QMap<QString,bool> &isJobRunning,
+    const QMap<QString, ProgramInfo*> &recMap,
+    const QString      &orderBy,
+    uint                start,
+    uint                limit,
+    uint               &count);
+
 template<typename TYPE>
 bool LoadFromScheduler(
     AutoDeleteDeque<TYPE*> &destination,
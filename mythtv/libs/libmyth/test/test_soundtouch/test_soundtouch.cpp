@@ -0,0 +1,3 @@
+#include "test_soundtouch.h"
+
+QTEST_APPLESS_MAIN(TestSoundTouch)
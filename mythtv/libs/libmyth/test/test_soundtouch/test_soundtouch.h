@@ -0,0 +1,177 @@
+/*
+ *  Class TestSoundTouch
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include "SoundTouch.h"
+#include "cpu_detect.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+#define MSKIP(MSG) QSKIP(MSG, SkipSingle)
+#else
+#define MSKIP(MSG) QSKIP(MSG)
+#endif
+
+using namespace soundtouch;
+
+class TestSoundTouch: public QObject
+{
+    Q_OBJECT
+
+    static const int kRate   = 48000;
+    static const int kBlock  = 1024;            ///< frames per putSamples()
+    static const int kBlocks = 500;             ///< ~10 seconds of audio
+
+    /// Fills 'buf' with a different tone plus a little noise per channel
+    static void MakeInput(QVector<float> &buf, int channels, int block)
+    {
+        buf.resize(kBlock * channels);
+        for (int i = 0; i < kBlock; i++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                float t = (float)(block * kBlock + i) / kRate;
+                buf[i * channels + c] =
+                    0.5f * sinf(2.0f * (float)M_PI * 220.0f * (c + 1) * t) +
+                    0.001f * ((i * 7919 + c * 104729) % 1000) / 1000.0f;
+            }
+        }
+    }
+
+    /// Runs kBlocks of input through a SoundTouch instance created with
+    /// the CPU extensions in 'disable' turned off. Returns the output in
+    /// 'out' (if not NULL), and the number of input frames per second.
+    static double Process(int channels, float tempo, float rate,
+                          uint disable, QVector<float> *out)
+    {
+        disableExtensions(disable);
+
+        SoundTouch st;
+        // the channel count must be set first, it sizes the overlap buffers
+        st.setChannels(channels);
+        st.setSampleRate(kRate);
+        st.setTempo(tempo);
+        st.setRate(rate);
+        st.setSetting(SETTING_USE_QUICKSEEK, 1);
+        st.setSetting(SETTING_USE_AA_FILTER, 1);
+
+        disableExtensions(0);
+
+        QVector<float> in;
+        QVector<float> buf(kBlock * 4 * channels);
+        qint64 elapsed = 0;
+        QElapsedTimer timer;
+
+        for (int b = 0; b < kBlocks; b++)
+        {
+            MakeInput(in, channels, b);
+            timer.start();
+            st.putSamples(in.constData(), kBlock);
+            uint got;
+            while ((got = st.receiveSamples(buf.data(), kBlock * 4)) > 0)
+            {
+                if (out)
+                    *out += buf.mid(0, got * channels);
+            }
+            elapsed += timer.nsecsElapsed();
+        }
+
+        if (elapsed <= 0)
+            elapsed = 1;
+        return (double)kBlocks * kBlock * 1e9 / elapsed;
+    }
+
+    static void AddRows(void)
+    {
+        QTest::addColumn<int>("channels");
+        QTest::addColumn<float>("tempo");
+        QTest::addColumn<float>("rate");
+
+        static const int   chans[]  = { 1, 2, 6, 8 };
+        static const float tempos[] = { 0.5f, 0.9f, 1.0f, 1.1f, 2.0f };
+
+        for (uint c = 0; c < sizeof(chans) / sizeof(chans[0]); c++)
+        {
+            for (uint t = 0; t < sizeof(tempos) / sizeof(tempos[0]); t++)
+            {
+                // pure rate change when the tempo is unchanged, so the
+                // anti-alias filter and transposer are exercised too
+                float rate = (tempos[t] == 1.0f) ? 1.1f : 1.0f;
+                QString name = QString("%1ch tempo %2 rate %3")
+                    .arg(chans[c]).arg(tempos[t]).arg(rate);
+                QTest::newRow(name.toLatin1().constData())
+                    << chans[c] << tempos[t] << rate;
+            }
+        }
+    }
+
+  private slots:
+    void SIMDMatchesC_data(void)
+    {
+        AddRows();
+    }
+
+    // the vectorized kernels must give the same output as the C versions
+    void SIMDMatchesC(void)
+    {
+        QFETCH(int, channels);
+        QFETCH(float, tempo);
+        QFETCH(float, rate);
+
+        if (!(detectCPUextensions() & (MM_AVX2 | MM_SSE2 | MM_SSE3)))
+            MSKIP("No SIMD support on this CPU");
+
+        QVector<float> simd, plain;
+        Process(channels, tempo, rate, 0, &simd);
+        Process(channels, tempo, rate, ~0U, &plain);
+
+        QCOMPARE(simd.size(), plain.size());
+        QVERIFY(simd.size() > 0);
+
+        float maxdiff = 0.0f;
+        for (int i = 0; i < simd.size(); i++)
+            maxdiff = qMax(maxdiff, fabsf(simd[i] - plain[i]));
+        QVERIFY2(maxdiff < 1e-3f,
+                 QString("max difference %1").arg(maxdiff).toLatin1());
+    }
+
+    void Throughput_data(void)
+    {
+        AddRows();
+    }
+
+    // reports input samples per second, per channel, with and without SIMD
+    void Throughput(void)
+    {
+        QFETCH(int, channels);
+        QFETCH(float, tempo);
+        QFETCH(float, rate);
+
+        double simd  = Process(channels, tempo, rate, 0, NULL);
+        double plain = Process(channels, tempo, rate, ~0U, NULL);
+
+        qDebug("%dch tempo %.1f rate %.1f: %.2f Msamples/s SIMD, "
+               "%.2f Msamples/s C (x%.2f)", channels, tempo, rate,
+               simd / 1e6, plain / 1e6, simd / plain);
+        QVERIFY(simd > 0 && plain > 0);
+    }
+};
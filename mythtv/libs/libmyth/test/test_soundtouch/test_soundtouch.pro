@@ -0,0 +1,22 @@
+include ( ../../../../settings.pro )
+
+contains(QT_VERSION, ^4\\.[0-9]\\..*) {
+CONFIG += qtestlib
+}
+contains(QT_VERSION, ^5\\.[0-9]\\..*) {
+QT += testlib
+}
+
+TEMPLATE = app
+TARGET = test_soundtouch
+DEPENDPATH += . ../../../libmythsoundtouch
+INCLUDEPATH += . ../../../libmythsoundtouch
+LIBS += -L../../../libmythsoundtouch -lmythsoundtouch-$$LIBVERSION
+
+# Input
+HEADERS += test_soundtouch.h
+SOURCES += test_soundtouch.cpp
+
+QMAKE_CLEAN += $(TARGET) $(TARGETA) $(TARGETD) $(TARGET0) $(TARGET1) $(TARGET2)
+
+LIBS += $$EXTRA_LIBS $$LATE_LIBS
@@ -3,8 +3,10 @@
 #include <QMutexLocker>
 #include <QWaitCondition>
 #include <QList>
-#include <QQueue>
 #include <QHash>
+#include <QVector>
+#include <QThreadStorage>
+#include <QtEndian>
 #include <QCoreApplication>
 #include <QFileInfo>
 #include <QStringList>
@@ -34,6 +36,7 @@ using namespace std;
 #include <syslog.h>
 #endif
 #include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -59,14 +62,17 @@ extern "C" {
 
 // nzmqt
 #include "nzmqt.hpp"
-// QJson
+// QJson, for messages from clients that predate the binary format
 #include "QJson/QObjectHelper"
-#include "QJson/Serializer"
 #include "QJson/Parser"
 
 static QMutex                  logQueueMutex;
-static QQueue<LoggingItem *>   logQueue;
-static QRegExp                 logRegExp = QRegExp("[%]{1,2}");
+
+static QMutex                  logRingMutex;
+static QList<LogRing *>        logRings;
+static QMutex                  logDrainMutex;
+static QAtomicInt              logRingSeq;
+static QAtomicInt              logThreadSleeping;
 
 static LoggerThread           *logThread = NULL;
 static QMutex                  logThreadMutex;
@@ -95,6 +101,15 @@ QStringList             logPropagateArgList;
 
 LogLevel_t logLevel = (LogLevel_t)LOG_INFO;
 
+int logRateLimit = 0;
+static QAtomicInt logRateSecond[64];
+static QAtomicInt logRateCount[64];
+static QAtomicInt logRateSuppressed[64];
+
+/// Wire format version, the first byte of each message to mythlogserver.
+/// JSON from older clients always starts with '{'.
+#define LOGGING_WIRE_VERSION 2
+
 bool verboseInitialized = false;
 VerboseMap verboseMap;
 QMutex verboseMapMutex;
@@ -137,6 +152,239 @@ void loggingGetTimeStamp(qlonglong *epoch, uint *usec)
 #endif
 }
 
+/// \brief Get the kernel's id for the calling thread
+/// \notes In different platforms, the actual value returned here will vary.
+///        The intention is to get a thread ID that will map well to what is
+///        shown in gdb.
+static int64_t loggingGetTid(void)
+{
+    int64_t tid = 0;
+
+#if defined(linux)
+    tid = (int64_t)syscall(SYS_gettid);
+#elif defined(__FreeBSD__)
+    long lwpid;
+    int dummy = thr_self( &lwpid );
+    (void)dummy;
+    tid = (int64_t)lwpid;
+#elif CONFIG_DARWIN
+    tid = (int64_t)mach_thread_self();
+#endif
+
+    return tid;
+}
+
+LogRing::LogRing(qulonglong threadId, int64_t tid) :
+    m_threadId(threadId), m_tid(tid), m_orphaned(0), m_dropped(0),
+    m_buf(new char[kSize]), m_head(0), m_tail(0), m_reserved(0)
+{
+}
+
+LogRing::~LogRing()
+{
+    delete[] m_buf;
+}
+
+/// \brief Find space for a record with a message of msglen bytes.  Only the
+///        owning thread may call this, and Commit() once the record is
+///        filled in.
+/// \return The record, or NULL if the ring is full
+LogRecord *LogRing::Reserve(int msglen)
+{
+    uint need   = (offsetof(LogRecord, message) + msglen + 1 + 7) & ~7;
+    uint head   = (uint)m_head.fetchAndAddOrdered(0);
+    uint tail   = (uint)m_tail.fetchAndAddOrdered(0);
+    uint offset = head & (kSize - 1);
+
+    // Records never wrap, skip to the start of the ring if need be
+    uint pad = (kSize - offset < need) ? kSize - offset : 0;
+
+    if (pad + need > kSize - (head - tail))
+        return NULL;
+
+    if (pad)
+    {
+        ((LogRecord *)(m_buf + offset))->size = 0;
+        head  += pad;
+        offset = 0;
+    }
+
+    LogRecord *rec = (LogRecord *)(m_buf + offset);
+    rec->size  = need;
+    m_reserved = head + need;
+    return rec;
+}
+
+/// \brief Make the record from Reserve() visible to the logging thread
+void LogRing::Commit(void)
+{
+    m_head.fetchAndStoreOrdered((int)m_reserved);
+}
+
+/// \brief Oldest record in the ring, or NULL if it is empty
+LogRecord *LogRing::Front(void)
+{
+    uint tail = (uint)m_tail.fetchAndAddOrdered(0);
+    if (tail == (uint)m_head.fetchAndAddOrdered(0))
+        return NULL;
+
+    uint offset = tail & (kSize - 1);
+    LogRecord *rec = (LogRecord *)(m_buf + offset);
+    if (rec->size)
+        return rec;
+
+    // Padding, the record was written at the start of the ring
+    m_tail.fetchAndStoreRelease((int)(tail + kSize - offset));
+    return (LogRecord *)m_buf;
+}
+
+void LogRing::Pop(void)
+{
+    LogRecord *rec = Front();
+    if (rec)
+    {
+        uint tail = (uint)m_tail.fetchAndAddOrdered(0);
+        m_tail.fetchAndStoreRelease((int)(tail + rec->size));
+    }
+}
+
+bool LogRing::IsEmpty(void) const
+{
+    return const_cast<QAtomicInt&>(m_tail).fetchAndAddOrdered(0) ==
+           const_cast<QAtomicInt&>(m_head).fetchAndAddOrdered(0);
+}
+
+/// \brief Hands a thread's LogRing back to the logging thread, to be freed
+///        once drained, when the thread exits
+class LogRingOwner
+{
+  public:
+    LogRingOwner(LogRing *ring) : m_ring(ring) {}
+    ~LogRingOwner() { m_ring->m_orphaned.fetchAndStoreRelease(1); }
+
+    LogRing *m_ring;
+};
+
+static QThreadStorage<LogRingOwner *> logRingOwner;
+
+/// \brief The calling thread's LogRing, created on its first message
+static LogRing *loggingGetRing(void)
+{
+    LogRingOwner *owner = logRingOwner.localData();
+    if (owner)
+        return owner->m_ring;
+
+    LogRing *ring = new LogRing((qulonglong)QThread::currentThreadId(),
+                                loggingGetTid());
+    logRingOwner.setLocalData(new LogRingOwner(ring));
+
+    QMutexLocker locker(&logRingMutex);
+    logRings.append(ring);
+    return ring;
+}
+
+/// \brief Whether every thread's messages have been handled
+bool loggingRingsEmpty(void)
+{
+    QMutexLocker locker(&logRingMutex);
+    QList<LogRing *>::const_iterator it = logRings.begin();
+    for (; it != logRings.end(); ++it)
+    {
+        if (!(*it)->IsEmpty())
+            return false;
+    }
+    return true;
+}
+
+/// \brief Hand every message waiting in the threads' rings to handler, in
+///        the order they were logged, and free the rings of threads that
+///        have exited.
+/// \param  handler    Called with each message, which it must not keep
+/// \param  opaque     Passed on to handler
+/// \return The number of messages handled
+int loggingDrainRings(LogItemHandler handler, void *opaque)
+{
+    QMutexLocker drainLock(&logDrainMutex);
+
+    logRingMutex.lock();
+    QList<LogRing *> rings = logRings;
+    logRingMutex.unlock();
+
+    QVector<LogRecord *> fronts(rings.size());
+    for (int i = 0; i < rings.size(); i++)
+        fronts[i] = rings[i]->Front();
+
+    int count = 0;
+    while (true)
+    {
+        int next = -1;
+        for (int i = 0; i < fronts.size(); i++)
+        {
+            if (fronts[i] && (next < 0 ||
+                              (int)(fronts[i]->seq - fronts[next]->seq) < 0))
+                next = i;
+        }
+        if (next < 0)
+            break;
+
+        LoggingItem *item = LoggingItem::create(rings[next], fronts[next]);
+        rings[next]->Pop();
+        fronts[next] = rings[next]->Front();
+
+        handler(item, opaque);
+        item->DecrRef();
+        count++;
+    }
+
+    QList<LogRing *> orphans;
+    for (int i = 0; i < rings.size(); i++)
+    {
+        LogRing *ring = rings[i];
+
+        int dropped = ring->m_dropped.fetchAndStoreOrdered(0);
+        if (dropped)
+        {
+            LoggingItem *item = LoggingItem::create(__FILE__, __FUNCTION__,
+                                                    __LINE__, LOG_WARNING,
+                                                    kMessage);
+            snprintf(item->m_message, LOGLINE_MAX,
+                     "Thread 0x%" PREFIX64 "X (%" PREFIX64 "d) dropped %d "
+                     "log messages", (long long unsigned int)ring->m_threadId,
+                     (long long int)ring->m_tid, dropped);
+            handler(item, opaque);
+            item->DecrRef();
+            count++;
+        }
+
+        if (ring->m_orphaned.fetchAndAddOrdered(0) && ring->IsEmpty())
+            orphans.append(ring);
+    }
+
+    if (!orphans.isEmpty())
+    {
+        logRingMutex.lock();
+        QList<LogRing *>::const_iterator it = orphans.begin();
+        for (; it != orphans.end(); ++it)
+            logRings.removeOne(*it);
+        logRingMutex.unlock();
+
+        qDeleteAll(orphans);
+    }
+
+    return count;
+}
+
+/// \brief Pass a message from the logging rings to the logging thread's
+///        handlers
+static void loggingHandleItem(LoggingItem *item, void *opaque)
+{
+    LoggerThread *thread = (LoggerThread *)opaque;
+
+    thread->fillItem(item);
+    thread->handleItem(item);
+    thread->logConsole(item);
+}
+
 LoggingItem::LoggingItem() :
         ReferenceCounter("LoggingItem", false),
         m_pid(-1), m_tid(-1), m_threadId(-1), m_usec(0), m_line(0),
@@ -184,15 +432,86 @@ LoggingItem::~LoggingItem()
         free((void *)m_logFile);
 }
 
-QByteArray LoggingItem::toByteArray(void)
+template <typename T>
+static inline void wireAppend(QByteArray &buf, T val)
 {
-    QVariantMap variant = QJson::QObjectHelper::qobject2qvariant(this);
-    QJson::Serializer serializer;
-    QByteArray json = serializer.serialize(variant);
+    val = qToLittleEndian(val);
+    buf.append((const char *)&val, sizeof(val));
+}
+
+static inline void wireAppendString(QByteArray &buf, const char *str)
+{
+    quint16 len = str ? (quint16)qMin(strlen(str), (size_t)0xffff) : 0;
+    wireAppend(buf, len);
+    if (len)
+        buf.append(str, len);
+}
+
+/// \brief Reads the fields of a message written by LoggingItem::toByteArray.
+///        Anything missing reads as 0 or an empty string.
+class WireReader
+{
+  public:
+    WireReader(const QByteArray &buf) :
+        m_data(buf.constData()), m_size(buf.size()),
+        m_pos((m_size && buf[0] == LOGGING_WIRE_VERSION) ? 1 : m_size) {}
 
-    //cout << json.constData() << endl;
+    template <typename T>
+    T read(void)
+    {
+        T val = 0;
+        if (m_pos + (int)sizeof(T) <= m_size)
+        {
+            memcpy(&val, m_data + m_pos, sizeof(T));
+            m_pos += sizeof(T);
+        }
+        return qFromLittleEndian(val);
+    }
 
-    return json;
+    /// \return A malloc()ed copy of the string
+    char *readString(void)
+    {
+        int len = qMin((int)read<quint16>(), m_size - m_pos);
+        char *str = (char *)malloc(len + 1);
+        memcpy(str, m_data + m_pos, len);
+        str[len] = '\0';
+        m_pos += len;
+        return str;
+    }
+
+  private:
+    const char *m_data;
+    int         m_size;
+    int         m_pos;
+};
+
+/// \brief Serialize the item for mythlogserver.  Fixed size fields in
+///        little endian order, then each string as a 16 bit length and
+///        its bytes.
+QByteArray LoggingItem::toByteArray(void)
+{
+    QByteArray buf;
+    buf.reserve(64 + strlen(m_message));
+
+    buf.append((char)LOGGING_WIRE_VERSION);
+    wireAppend(buf, (qint32)m_pid);
+    wireAppend(buf, (qint64)m_tid);
+    wireAppend(buf, (quint64)m_threadId);
+    wireAppend(buf, (quint32)m_usec);
+    wireAppend(buf, (qint32)m_line);
+    wireAppend(buf, (qint32)m_type);
+    wireAppend(buf, (qint32)m_level);
+    wireAppend(buf, (qint32)m_facility);
+    wireAppend(buf, (qint64)m_epoch);
+    wireAppendString(buf, m_file);
+    wireAppendString(buf, m_function);
+    wireAppendString(buf, m_threadName);
+    wireAppendString(buf, m_appName);
+    wireAppendString(buf, m_table);
+    wireAppendString(buf, m_logFile);
+    wireAppendString(buf, m_message);
+
+    return buf;
 }
 
 /// \brief Get the name of the thread that produced the LoggingItem
@@ -233,18 +552,7 @@ void LoggingItem::setThreadTid(void)
     m_tid = logThreadTidHash.value(m_threadId, -1);
     if (m_tid == -1)
     {
-        m_tid = 0;
-
-#if defined(linux)
-        m_tid = (int64_t)syscall(SYS_gettid);
-#elif defined(__FreeBSD__)
-        long lwpid;
-        int dummy = thr_self( &lwpid );
-        (void)dummy;
-        m_tid = (int64_t)lwpid;
-#elif CONFIG_DARWIN
-        m_tid = (int64_t)mach_thread_self();
-#endif
+        m_tid = loggingGetTid();
         logThreadTidHash[m_threadId] = m_tid;
     }
 }
@@ -364,29 +672,25 @@ void LoggerThread::run(void)
 
     QMutexLocker qLock(&logQueueMutex);
 
-    while (!m_aborted || !logQueue.isEmpty())
+    while (!m_aborted || !loggingRingsEmpty())
     {
         qLock.unlock();
         qApp->processEvents(QEventLoop::AllEvents, 10);
         qApp->sendPostedEvents(NULL, QEvent::DeferredDelete);
 
+        int count = loggingDrainRings(loggingHandleItem, this);
+
         qLock.relock();
-        if (logQueue.isEmpty())
+        if (!count)
         {
             m_waitEmpty->wakeAll();
-            m_waitNotEmpty->wait(qLock.mutex(), 100);
-            continue;
-        }
-
-        LoggingItem *item = logQueue.dequeue();
-        qLock.unlock();
-
-        fillItem(item);
-        handleItem(item);
-        logConsole(item);
-        item->DecrRef();
 
-        qLock.relock();
+            // LOG() only wakes us while this is set, see loggingQueue()
+            logThreadSleeping.fetchAndStoreOrdered(1);
+            if (!m_aborted && loggingRingsEmpty())
+                m_waitNotEmpty->wait(qLock.mutex(), 100);
+            logThreadSleeping.fetchAndStoreOrdered(0);
+        }
     }
 
     qLock.unlock();
@@ -447,6 +751,37 @@ void LoggerThread::initialTimeout(void)
     LOG(VB_GENERAL, LOG_INFO, "Added logging to mythlogserver at TCP:35327");
 }
 
+/// \brief  Log how many messages of each verbose flag the rate limit
+///         suppressed since the last call
+static void logRateReport(void)
+{
+    for (int bit = 0; bit < 64; bit++)
+    {
+        int suppressed = logRateSuppressed[bit].fetchAndStoreOrdered(0);
+        if (!suppressed)
+            continue;
+
+        uint64_t mask = 1ULL << bit;
+        QString name = QString("0x%1").arg(mask, 0, 16);
+        {
+            QMutexLocker locker(&verboseMapMutex);
+            VerboseMap::iterator it = verboseMap.begin();
+            for (; it != verboseMap.end(); ++it)
+            {
+                if ((*it)->mask == mask)
+                {
+                    name = it.key();
+                    break;
+                }
+            }
+        }
+
+        LOG(VB_GENERAL, LOG_WARNING,
+            QString("Rate limit suppressed %1 '%2' messages")
+                .arg(suppressed).arg(name));
+    }
+}
+
 /// \brief  Handles heartbeat checking once a second.  If the server is not
 ///         heard from for at least 5s, restart it
 void LoggerThread::checkHeartBeat(void)
@@ -454,6 +789,9 @@ void LoggerThread::checkHeartBeat(void)
     static bool launched = false;
     qlonglong epoch;
 
+    if (logRateLimit)
+        logRateReport();
+
     loggingGetTimeStamp(&epoch, NULL);
     qlonglong age = (epoch - m_epoch) % 30;
 
@@ -526,8 +864,6 @@ void LoggerThread::handleItem(LoggingItem *item)
 {
     if (item->m_type & kRegistering)
     {
-        item->m_tid = item->getThreadTid();
-
         QMutexLocker locker(&logThreadMutex);
         if (logThreadHash.contains(item->m_threadId))
         {
@@ -637,7 +973,7 @@ bool LoggerThread::logConsole(LoggingItem *item)
 
 
 /// \brief Stop the thread by setting the abort flag after waiting a second for
-///        the queue to be flushed.
+///        the rings to be flushed.
 void LoggerThread::stop(void)
 {
     QMutexLocker qLock(&logQueueMutex);
@@ -646,21 +982,33 @@ void LoggerThread::stop(void)
     m_waitNotEmpty->wakeAll();
 }
 
-/// \brief  Wait for the queue to be flushed (up to a timeout)
-/// \param  timeoutMS   The number of ms to wait for the queue to flush
-/// \return true if the queue is empty, false otherwise
+/// \brief  Wait for the rings to be flushed (up to a timeout).  The caller
+///         must hold logQueueMutex.
+/// \param  timeoutMS   The number of ms to wait for the rings to flush
+/// \return true if the rings are empty, false otherwise
 bool LoggerThread::flush(int timeoutMS)
 {
+    // Only the logging thread itself can empty the rings
+    if (QThread::currentThread() == qthread())
+        return loggingRingsEmpty();
+
     QTime t;
     t.start();
-    while (!m_aborted && logQueue.isEmpty() && t.elapsed() < timeoutMS)
+    while (!m_aborted && !loggingRingsEmpty() && t.elapsed() < timeoutMS)
     {
         m_waitNotEmpty->wakeAll();
         int left = timeoutMS - t.elapsed();
         if (left > 0)
             m_waitEmpty->wait(&logQueueMutex, left);
     }
-    return logQueue.isEmpty();
+    return loggingRingsEmpty();
+}
+
+/// \brief  Wake the logging thread if it is waiting for messages
+void LoggerThread::wakeUp(void)
+{
+    QMutexLocker qLock(&logQueueMutex);
+    m_waitNotEmpty->wakeAll();
 }
 
 void LoggerThread::fillItem(LoggingItem *item)
@@ -694,21 +1042,122 @@ LoggingItem *LoggingItem::create(const char *_file,
     return item;
 }
 
+/// \brief  Create a LoggingItem from a message received by mythlogserver
 LoggingItem *LoggingItem::create(QByteArray &buf)
 {
-    // Deserialize buffer
-    QJson::Parser parser;
-    QVariant variant = parser.parse(buf);
+    LoggingItem *item = new LoggingItem;
+
+    if (buf.startsWith('{'))
+    {
+        QJson::Parser parser;
+        QVariant variant = parser.parse(buf);
+        QJson::QObjectHelper::qvariant2qobject(variant.toMap(), item);
+        return item;
+    }
+
+    WireReader wire(buf);
+    item->m_pid        = wire.read<qint32>();
+    item->m_tid        = wire.read<qint64>();
+    item->m_threadId   = wire.read<quint64>();
+    item->m_usec       = wire.read<quint32>();
+    item->m_line       = wire.read<qint32>();
+    item->m_type       = (LoggingType)wire.read<qint32>();
+    item->m_level      = (LogLevel_t)wire.read<qint32>();
+    item->m_facility   = wire.read<qint32>();
+    item->m_epoch      = wire.read<qint64>();
+    item->m_file       = wire.readString();
+    item->m_function   = wire.readString();
+    item->m_threadName = wire.readString();
+    item->m_appName    = wire.readString();
+    item->m_table      = wire.readString();
+    item->m_logFile    = wire.readString();
+
+    char *message = wire.readString();
+    strncpy(item->m_message, message, LOGLINE_MAX);
+    free(message);
 
+    return item;
+}
+
+/// \brief  Create a LoggingItem from a record in a thread's LogRing
+LoggingItem *LoggingItem::create(const LogRing *ring, const LogRecord *rec)
+{
     LoggingItem *item = new LoggingItem;
-    QJson::QObjectHelper::qvariant2qobject(variant.toMap(), item);
+
+    item->m_tid      = ring->m_tid;
+    item->m_threadId = ring->m_threadId;
+    item->m_usec     = rec->usec;
+    item->m_line     = rec->line;
+    item->m_type     = (LoggingType)rec->type;
+    item->m_level    = (LogLevel_t)rec->level;
+    item->m_epoch    = rec->epoch;
+    item->m_file     = strdup(rec->file);
+    item->m_function = strdup(rec->function);
+
+    // A registration carries the thread's name in place of a message
+    if (rec->type & kRegistering)
+        item->m_threadName = strdup(rec->message);
+    else
+        strncpy(item->m_message, rec->message, LOGLINE_MAX);
 
     return item;
 }
 
+/// \brief  Put a message into the calling thread's LogRing, and wake the
+///         logging thread if it is waiting for one.
+static void loggingQueue(int type, LogLevel_t level, const char *file,
+                         int line, const char *function, const char *message)
+{
+    LogRing *ring = loggingGetRing();
+    int len = strnlen(message, LOGLINE_MAX - 1);
+
+    LogRecord *rec = ring->Reserve(len);
+
+    // Wait a little for room for errors and thread names, drop the rest
+    for (int i = 0; !rec && i < 100 && (level <= LOG_ERR || !(type & kMessage))
+                    && logThread && !logThreadFinished; i++)
+    {
+        logThread->wakeUp();
+        usleep(1000);
+        rec = ring->Reserve(len);
+    }
+
+    if (!rec)
+    {
+        ring->m_dropped.ref();
+        return;
+    }
+
+    rec->seq      = (uint32_t)logRingSeq.fetchAndAddOrdered(1);
+    rec->type     = type;
+    rec->level    = level;
+    rec->line     = line;
+    rec->file     = file;
+    rec->function = function;
+    loggingGetTimeStamp(&rec->epoch, &rec->usec);
+    memcpy(rec->message, message, len);
+    rec->message[len] = '\0';
+    ring->Commit();
+
+    if (logThread && logThreadFinished && !logThread->isRunning())
+    {
+        QMutexLocker qLock(&logQueueMutex);
+        loggingDrainRings(loggingHandleItem, logThread);
+    }
+    else if (logThread && !logThreadFinished && (type & kFlush))
+    {
+        QMutexLocker qLock(&logQueueMutex);
+        logThread->flush();
+    }
+    else if (logThreadSleeping.fetchAndAddOrdered(0) && logThread)
+    {
+        logThread->wakeUp();
+    }
+}
+
 
-/// \brief  Format and send a log message into the queue.  This is called from
-///         the LOG() macro.  The intention is minimal blocking of the caller.
+/// \brief  Format and put a log message into the calling thread's LogRing.
+///         This is called from the LOG() macro, and never blocks the caller.
 /// \param  mask    Verbosity mask of the message (VB_*)
 /// \param  level   Log level of this message (LOG_* - matching syslog levels)
 /// \param  file    Filename of source code logging the message
@@ -722,52 +1171,60 @@ void LogPrintLine( uint64_t mask, LogLevel_t level, const char *file, int line,
                    const char *function, int fromQString,
                    const char *format, ... )
 {
-    va_list         arguments;
-
     int type = kMessage;
     type |= (mask & VB_FLUSH) ? kFlush : 0;
     type |= (mask & VB_STDIO) ? kStandardIO : 0;
-    LoggingItem *item = LoggingItem::create(file, function, line, level,
-                                            (LoggingType)type);
-    if (!item)
-        return;
 
-    char *formatcopy = NULL;
-    if( fromQString && strchr(format, '%') )
+    // A message from a QString is complete already
+    if (fromQString)
     {
-        QString string(format);
-        format = strdup(string.replace(logRegExp, "%%").toLocal8Bit()
-                              .constData());
-        formatcopy = (char *)format;
+        loggingQueue(type, level, file, line, function, format);
+        return;
     }
 
+    va_list arguments;
+    char    message[LOGLINE_MAX];
+
     va_start(arguments, format);
-    vsnprintf(item->m_message, LOGLINE_MAX, format, arguments);
+    vsnprintf(message, LOGLINE_MAX, format, arguments);
     va_end(arguments);
 
-    if (formatcopy)
-        free(formatcopy);
+    loggingQueue(type, level, file, line, function, message);
+}
 
-    QMutexLocker qLock(&logQueueMutex);
+/// \brief  Decide whether a message gets past the rate limit, which allows
+///         logRateLimit messages less important than LOG_WARNING per second
+///         for each verbose flag.  Called from the LOG() macro, before the
+///         message is built.
+/// \param  mask    Verbosity mask of the message (VB_*), its lowest flag
+///                 is the one counted
+/// \param  level   Log level of the message
+/// \return non-zero if the message should be logged
+int logRateCheck(uint64_t mask, int level)
+{
+    if (level <= LOG_WARNING)
+        return 1;
 
-    logQueue.enqueue(item);
+    mask &= ~(uint64_t)(VB_FLUSH | VB_STDIO | VB_EXTRA);
+    if (!mask)
+        return 1;
 
-    if (logThread && logThreadFinished && !logThread->isRunning())
-    {
-        while (!logQueue.isEmpty())
-        {
-            item = logQueue.dequeue();
-            qLock.unlock();
-            logThread->handleItem(item);
-            logThread->logConsole(item);
-            item->DecrRef();
-            qLock.relock();
-        }
-    }
-    else if (logThread && !logThreadFinished && (type & kFlush))
+    int bit = 0;
+    while (!(mask & (1ULL << bit)))
+        bit++;
+
+    int now = (int)time(NULL);
+    if (logRateSecond[bit].fetchAndAddOrdered(0) != now)
     {
-        logThread->flush();
+        logRateSecond[bit].fetchAndStoreOrdered(now);
+        logRateCount[bit].fetchAndStoreOrdered(0);
     }
+
+    if (logRateCount[bit].fetchAndAddOrdered(1) < logRateLimit)
+        return 1;
+
+    logRateSuppressed[bit].ref();
+    return 0;
 }
 
 
@@ -850,6 +1307,15 @@ void logStart(QString logfile, int progress, int quiet, int facility,
     LOG(VB_GENERAL, LOG_NOTICE, QString("Setting Log Level to LOG_%1")
              .arg(logLevelGetName(logLevel).toUpper()));
 
+    char *ratelimit = getenv("VERBOSE_RATELIMIT");
+    if (ratelimit != NULL)
+    {
+        logRateLimit = qMax(atoi(ratelimit), 0);
+        LOG(VB_GENERAL, LOG_NOTICE,
+            QString("Limiting each verbose flag to %1 messages per second")
+                .arg(logRateLimit));
+    }
+
     logPropagateOpts.propagate = propagate;
     logPropagateOpts.quiet = quiet;
     logPropagateOpts.facility = facility;
@@ -893,16 +1359,8 @@ void loggingRegisterThread(const QString &name)
     if (logThreadFinished)
         return;
 
-    QMutexLocker qLock(&logQueueMutex);
-
-    LoggingItem *item = LoggingItem::create(__FILE__, __FUNCTION__,
-                                            __LINE__, (LogLevel_t)LOG_DEBUG,
-                                            kRegistering);
-    if (item)
-    {
-        item->setThreadName((char *)name.toLocal8Bit().constData());
-        logQueue.enqueue(item);
-    }
+    loggingQueue(kRegistering, (LogLevel_t)LOG_DEBUG, __FILE__, __LINE__,
+                 __FUNCTION__, name.toLocal8Bit().constData());
 }
 
 /// \brief  Deregister the current thread's name.  This is triggered by the 
@@ -912,13 +1370,8 @@ void loggingDeregisterThread(void)
     if (logThreadFinished)
         return;
 
-    QMutexLocker qLock(&logQueueMutex);
-
-    LoggingItem *item = LoggingItem::create(__FILE__, __FUNCTION__, __LINE__,
-                                            (LogLevel_t)LOG_DEBUG,
-                                            kDeregistering);
-    if (item)
-        logQueue.enqueue(item);
+    loggingQueue(kDeregistering, (LogLevel_t)LOG_DEBUG, __FILE__, __LINE__,
+                 __FUNCTION__, "");
 }
 
 
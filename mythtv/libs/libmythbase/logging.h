@@ -1,6 +1,7 @@
 #ifndef LOGGING_H_
 #define LOGGING_H_
 
+#include <QAtomicInt>
 #include <QMutexLocker>
 #include <QMutex>
 #include <QQueue>
@@ -43,6 +44,54 @@ class LoggerThread;
 
 typedef struct tm tmType;
 
+/// \brief A message as LOG() leaves it in the calling thread's LogRing.
+///        Everything that can wait (thread names, timestamps as text,
+///        serialization) is left to the logging thread.
+typedef struct {
+    uint32_t    size;       ///< bytes used in the ring, 0 pads to its end
+    uint32_t    seq;        ///< order of the message across all threads
+    int         type;       ///< LoggingType
+    int         level;      ///< LogLevel_t
+    int         line;
+    uint        usec;
+    qlonglong   epoch;
+    const char *file;       ///< __FILE__ and __FUNCTION__ of the caller,
+    const char *function;   ///  which are never freed
+    char        message[8]; ///< NUL terminated, runs on to size
+} LogRecord;
+
+/// \brief Single producer, single consumer ring of LogRecords.  Each thread
+///        that logs gets one, so LOG() never takes a lock.
+class LogRing
+{
+  public:
+    LogRing(qulonglong threadId, int64_t tid);
+    ~LogRing();
+
+    LogRecord *Reserve(int msglen);
+    void Commit(void);
+    LogRecord *Front(void);
+    void Pop(void);
+    bool IsEmpty(void) const;
+
+    qulonglong  m_threadId;
+    int64_t     m_tid;
+    QAtomicInt  m_orphaned;     ///< owning thread has exited
+    QAtomicInt  m_dropped;      ///< messages lost while the ring was full
+
+    static const uint kSize = 64 * 1024;
+
+  private:
+    char       *m_buf;
+    QAtomicInt  m_head;         ///< next byte the producer writes
+    QAtomicInt  m_tail;         ///< next byte the consumer reads
+    uint        m_reserved;     ///< head once the reserved record commits
+};
+
+typedef void (*LogItemHandler)(LoggingItem *item, void *opaque);
+int  loggingDrainRings(LogItemHandler handler, void *opaque);
+bool loggingRingsEmpty(void);
+
 /// \brief The logging items that are generated by LOG() and are sent to the
 ///        console and to mythlogserver via ZeroMQ
 class LoggingItem: public QObject, public ReferenceCounter
@@ -67,6 +116,7 @@ class LoggingItem: public QObject, public ReferenceCounter
     Q_PROPERTY(QString message READ message WRITE setMessage)
 
     friend class LoggerThread;
+    friend int loggingDrainRings(LogItemHandler, void *);
     friend void LogPrintLine(uint64_t, LogLevel_t, const char *, int,
                              const char *, int, const char *, ... );
 
@@ -77,6 +127,7 @@ class LoggingItem: public QObject, public ReferenceCounter
     static LoggingItem *create(const char *, const char *, int, LogLevel_t,
                                LoggingType);
     static LoggingItem *create(QByteArray &buf);
+    static LoggingItem *create(const LogRing *ring, const LogRecord *rec);
     QByteArray toByteArray(void);
 
     int                 pid() const         { return m_pid; };
@@ -171,14 +222,15 @@ class LoggerThread : public QObject, public MThread
     void run(void);
     void stop(void);
     bool flush(int timeoutMS = 200000);
+    void wakeUp(void);
     void handleItem(LoggingItem *item);
     void fillItem(LoggingItem *item);
   private:
     QWaitCondition *m_waitNotEmpty; ///< Condition variable for waiting
-                                    ///  for the queue to not be empty
+                                    ///  for the rings to not be empty
                                     ///  Protected by logQueueMutex
     QWaitCondition *m_waitEmpty;    ///< Condition variable for waiting
-                                    ///  for the queue to be empty
+                                    ///  for the rings to be empty
                                     ///  Protected by logQueueMutex
     bool m_aborted;                 ///< Flag to abort the thread.
                                     ///  Protected by logQueueMutex
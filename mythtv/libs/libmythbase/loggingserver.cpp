@@ -403,8 +403,6 @@ bool SyslogLogger::setupZMQSocket(void)
 
 #endif
 
-const int DatabaseLogger::kMinDisabledTime = 1000;
-
 /// \brief DatabaseLogger constructor
 /// \param table C-string of the database table to log to
 DatabaseLogger::DatabaseLogger(const char *table) :
@@ -415,8 +413,7 @@ DatabaseLogger::DatabaseLogger(const char *table) :
         "INSERT INTO %1 "
         "    (host, application, pid, tid, thread, filename, "
         "     line, function, msgtime, level, message) "
-        "VALUES (:HOST, :APP, :PID, :TID, :THREAD, :FILENAME, "
-        "        :LINE, :FUNCTION, :MSGTIME, :LEVEL, :MESSAGE)")
+        "VALUES ")
         .arg(m_handle);
 
     LOG(VB_GENERAL, LOG_INFO, QString("Added database logging to table %1")
@@ -426,7 +423,6 @@ DatabaseLogger::DatabaseLogger(const char *table) :
     m_thread->start();
 
     m_opened = true;
-    m_disabled = false;
 }
 
 /// \brief DatabaseLogger deconstructor
@@ -484,40 +480,13 @@ void DatabaseLogger::stopDatabaseAccess(void)
 
 /// \brief Process a log message, queuing it for logging to the database
 /// \param item LoggingItem containing the log message to process
+/// \return true if the item was queued, and now belongs to the queue
 bool DatabaseLogger::logmsg(LoggingItem *item)
 {
-    if (!m_thread)
+    if (!m_thread || !m_thread->isRunning())
         return false;
 
-    if (!m_thread->isRunning())
-    {
-        m_disabled = true;
-        m_disabledTime.start();
-    }
-
-    if (!m_disabled && m_thread->queueFull())
-    {
-        m_disabled = true;
-        m_disabledTime.start();
-        LOG(VB_GENERAL, LOG_CRIT,
-            "Disabling DB Logging: too many messages queued");
-        return false;
-    }
-
-    if (m_disabled && m_disabledTime.elapsed() > kMinDisabledTime)
-    {
-        if (isDatabaseReady() && !m_thread->queueFull())
-        {
-            m_disabled = false;
-            LOG(VB_GENERAL, LOG_CRIT, "Reenabling DB Logging");
-        }
-    }
-
-    if (m_disabled)
-        return false;
-
-    m_thread->enqueue(item);
-    return true;
+    return m_thread->enqueue(item);
 }
 
 bool DatabaseLogger::setupZMQSocket(void)
@@ -543,30 +512,46 @@ bool DatabaseLogger::setupZMQSocket(void)
 }
 
 
-/// \brief Actually insert a log message from the queue into the database
-/// \param query    The database insert query to use
-/// \param item     LoggingItem containing the log message to insert
-bool DatabaseLogger::logqmsg(MSqlQuery &query, LoggingItem *item)
+/// \brief Actually insert a batch of log messages from the queue into the
+///        database, with a single multi-row insert
+/// \param query    The database query to use
+/// \param batch    The log messages to insert
+bool DatabaseLogger::logqmsg(MSqlQuery &query, const DBLogBatch &batch)
 {
     char        timestamp[TIMESTAMP_MAX];
+    QString     host = gCoreContext->GetHostName();
 
-    time_t epoch = item->epoch();
-    struct tm tm;
-    localtime_r(&epoch, &tm);
-
-    strftime(timestamp, TIMESTAMP_MAX-8, "%Y-%m-%d %H:%M:%S",
-             (const struct tm *)&tm);
+    prepare(query, batch.size());
 
-    query.bindValue(":TID",         item->tid());
-    query.bindValue(":THREAD",      item->threadName());
-    query.bindValue(":FILENAME",    item->file());
-    query.bindValue(":LINE",        item->line());
-    query.bindValue(":FUNCTION",    item->function());
-    query.bindValue(":MSGTIME",     timestamp);
-    query.bindValue(":LEVEL",       item->level());
-    query.bindValue(":MESSAGE",     item->message());
-    query.bindValue(":APP",         item->appName());
-    query.bindValue(":PID",         item->pid());
+    for (int i = 0; i < batch.size(); i++)
+    {
+        LoggingItem *item = batch[i].item;
+        QString n = QString::number(i);
+
+        time_t epoch = item->epoch();
+        struct tm tm;
+        localtime_r(&epoch, &tm);
+
+        strftime(timestamp, TIMESTAMP_MAX-8, "%Y-%m-%d %H:%M:%S",
+                 (const struct tm *)&tm);
+
+        QString message = item->message();
+        if (batch[i].repeats)
+            message += QString(" (repeated %1 more times)")
+                .arg(batch[i].repeats);
+
+        query.bindValue(":HOST" + n,        host);
+        query.bindValue(":TID" + n,         item->tid());
+        query.bindValue(":THREAD" + n,      item->threadName());
+        query.bindValue(":FILENAME" + n,    item->file());
+        query.bindValue(":LINE" + n,        item->line());
+        query.bindValue(":FUNCTION" + n,    item->function());
+        query.bindValue(":MSGTIME" + n,     timestamp);
+        query.bindValue(":LEVEL" + n,       item->level());
+        query.bindValue(":MESSAGE" + n,     message);
+        query.bindValue(":APP" + n,         item->appName());
+        query.bindValue(":PID" + n,         item->pid());
+    }
 
     if (!query.exec())
     {
@@ -587,12 +572,19 @@ bool DatabaseLogger::logqmsg(MSqlQuery &query, LoggingItem *item)
     return true;
 }
 
-/// \brief Prepare the database query for use, and bind constant values to it.
+/// \brief Prepare the database query to insert a number of rows
 /// \param query    The database query to prepare
-void DatabaseLogger::prepare(MSqlQuery &query)
+/// \param rows     The number of log messages it will insert
+void DatabaseLogger::prepare(MSqlQuery &query, int rows)
 {
-    query.prepare(m_query);
-    query.bindValue(":HOST", gCoreContext->GetHostName());
+    QString sql = m_query;
+    for (int i = 0; i < rows; i++)
+    {
+        sql += QString("%1(:HOST%2, :APP%2, :PID%2, :TID%2, :THREAD%2, "
+                       ":FILENAME%2, :LINE%2, :FUNCTION%2, :MSGTIME%2, "
+                       ":LEVEL%2, :MESSAGE%2)").arg(i ? ", " : "").arg(i);
+    }
+    query.prepare(sql);
 }
 
 /// \brief Check if the database is ready for use
@@ -647,7 +639,8 @@ bool DatabaseLogger::tableExists(const QString &table)
 /// \param logger DatabaseLogger instance that this thread belongs to
 DBLoggerThread::DBLoggerThread(DatabaseLogger *logger) :
     MThread("DBLogger"), m_logger(logger),
-    m_queue(new QQueue<LoggingItem *>),
+    m_queue(new QQueue<DBLogEntry>), m_dropped(0), m_coalesced(0),
+    m_reportedDropped(0), m_reportedCoalesced(0),
     m_wait(new QWaitCondition()), m_aborted(false)
 {
 }
@@ -661,7 +654,7 @@ DBLoggerThread::~DBLoggerThread()
 
     QMutexLocker qLock(&m_queueMutex);
     while (!m_queue->empty())
-        m_queue->dequeue()->DecrRef();
+        m_queue->dequeue().item->DecrRef();
     delete m_queue;
     delete m_wait;
     m_queue = NULL;
@@ -691,39 +684,53 @@ void DBLoggerThread::run(void)
         // shutdown occurs correctly as otherwise the connection appears still
         // in use, and we get a qWarning on shutdown.
         MSqlQuery *query = new MSqlQuery(MSqlQuery::InitCon());
-        m_logger->prepare(*query);
+        m_reportTime.start();
 
         QMutexLocker qLock(&m_queueMutex);
         while (!m_aborted || !m_queue->isEmpty())
         {
-            if (m_queue->isEmpty())
-            {
+            // Let a batch build up unless the queue is filling quickly
+            if (m_queue->size() < kMaxBatch && !m_aborted)
                 m_wait->wait(qLock.mutex(), 100);
+
+            if (m_queue->isEmpty())
                 continue;
+
+            DBLogBatch batch;
+            while (!m_queue->isEmpty() && batch.size() < kMaxBatch)
+            {
+                DBLogEntry entry = m_queue->dequeue();
+                if (entry.item->rawMessage()[0] != '\0')
+                    batch.append(entry);
+                else
+                    entry.item->DecrRef();
             }
 
-            LoggingItem *item = m_queue->dequeue();
-            if (!item)
+            if (batch.isEmpty())
                 continue;
 
-            if (item->message()[0] != '\0')
-            {
-                qLock.unlock();
-                bool logged = m_logger->logqmsg(*query, item);
-                qLock.relock();
+            qLock.unlock();
+            bool logged = m_logger->logqmsg(*query, batch);
+            qLock.relock();
 
-                if (!logged)
-                {
-                    m_queue->prepend(item);
-                    m_wait->wait(qLock.mutex(), 100);
-                    delete query;
-                    query = new MSqlQuery(MSqlQuery::InitCon());
-                    m_logger->prepare(*query);
-                    continue;
-                }
+            if (!logged && !m_aborted)
+            {
+                // Put the batch back in order, and retry it on a new
+                // connection.  New messages are dropped meanwhile once
+                // the queue fills.
+                for (int i = batch.size() - 1; i >= 0; i--)
+                    m_queue->prepend(batch[i]);
+                m_wait->wait(qLock.mutex(), 100);
+                delete query;
+                query = new MSqlQuery(MSqlQuery::InitCon());
+                continue;
             }
 
-            item->DecrRef();
+            DBLogBatch::const_iterator it = batch.begin();
+            for (; it != batch.end(); ++it)
+                it->item->DecrRef();
+
+            reportCounts();
         }
 
         delete query;
@@ -732,6 +739,74 @@ void DBLoggerThread::run(void)
     RunEpilog();
 }
 
+static inline bool sameString(const char *a, const char *b)
+{
+    return (a && b) ? !strcmp(a, b) : (a == b);
+}
+
+/// \brief Queue a message for the database.  Repeats of a message that is
+///        still queued are counted against it instead, and less important
+///        messages are dropped once the queue holds MAX_QUEUE_LEN.  Errors
+///        may use up to twice that.
+/// \param item The message to queue
+/// \return true if the item was queued, and now belongs to the queue
+bool DBLoggerThread::enqueue(LoggingItem *item)
+{
+    QMutexLocker qLock(&m_queueMutex);
+    if (m_aborted)
+        return false;
+
+    int size = m_queue->size();
+    for (int i = size - 1; i >= 0 && i >= size - kCoalesceDepth; i--)
+    {
+        DBLogEntry &entry = (*m_queue)[i];
+        LoggingItem *queued = entry.item;
+        if (queued->level() == item->level() &&
+            queued->line()  == item->line()  &&
+            queued->pid()   == item->pid()   &&
+            queued->tid()   == item->tid()   &&
+            sameString(queued->rawMessage(), item->rawMessage()) &&
+            sameString(queued->rawFile(), item->rawFile()))
+        {
+            entry.repeats++;
+            m_coalesced++;
+            return false;
+        }
+    }
+
+    int limit = (item->level() <= LOG_ERR) ? 2 * MAX_QUEUE_LEN : MAX_QUEUE_LEN;
+    if (size >= limit)
+    {
+        m_dropped++;
+        return false;
+    }
+
+    DBLogEntry entry = { item, 0 };
+    m_queue->enqueue(entry);
+
+    if (m_queue->size() == kMaxBatch)
+        m_wait->wakeAll();
+
+    return true;
+}
+
+/// \brief Log the dropped and coalesced counts, at most once a minute
+///         and only when they have changed.  Called with m_queueMutex held.
+void DBLoggerThread::reportCounts(void)
+{
+    if (m_reportTime.elapsed() < 60000 ||
+        (m_dropped == m_reportedDropped && m_coalesced == m_reportedCoalesced))
+        return;
+
+    LOG(VB_GENERAL, (m_dropped != m_reportedDropped) ? LOG_WARNING : LOG_INFO,
+        QString("DB Logging: %1 messages dropped, %2 coalesced so far")
+            .arg(m_dropped).arg(m_coalesced));
+
+    m_reportedDropped   = m_dropped;
+    m_reportedCoalesced = m_coalesced;
+    m_reportTime.restart();
+}
+
 /// \brief Tell the thread to stop by setting the m_aborted flag.
 void DBLoggerThread::stop(void)
 {
@@ -1012,8 +1087,8 @@ void FileLogger::receivedMessage(const QList<QByteArray> &msg)
             return;
     }
 
-    QByteArray json     = msg.at(1);
-    LoggingItem *item = LoggingItem::create(json);
+    QByteArray buf      = msg.at(1);
+    LoggingItem *item = LoggingItem::create(buf);
     logmsg(item);
     item->DecrRef();
 }
@@ -1033,8 +1108,8 @@ void SyslogLogger::receivedMessage(const QList<QByteArray> &msg)
             return;
     }
 
-    QByteArray json     = msg.at(1);
-    LoggingItem *item = LoggingItem::create(json);
+    QByteArray buf      = msg.at(1);
+    LoggingItem *item = LoggingItem::create(buf);
     logmsg(item);
     item->DecrRef();
 }
@@ -1064,8 +1139,8 @@ void DatabaseLogger::receivedMessage(const QList<QByteArray> &msg)
             return;
     }
 
-    QByteArray json     = msg.at(1);
-    LoggingItem *item = LoggingItem::create(json);
+    QByteArray buf      = msg.at(1);
+    LoggingItem *item = LoggingItem::create(buf);
     if (!logmsg(item))
         item->DecrRef();
 }
@@ -1276,9 +1351,9 @@ void LogForwardThread::forwardMessage(LogMessage *msg)
     QByteArray clientBa = msg->first();
     QString clientId = QString(clientBa.toHex());
 
-    QByteArray json     = msg->at(1);
+    QByteArray buf      = msg->at(1);
 
-    if (json.size() == 0)
+    if (buf.size() == 0)
     {
         // This is either a ping response or a first gasp
         logClientMapMutex.lock();
@@ -1307,7 +1382,7 @@ void LogForwardThread::forwardMessage(LogMessage *msg)
     }
     else
     {
-        LoggingItem *item = LoggingItem::create(json);
+        LoggingItem *item = LoggingItem::create(buf);
 
         logClientCount.ref();
         LOG(VB_GENERAL, LOG_INFO, QString("New Client: %1 (#%2)")
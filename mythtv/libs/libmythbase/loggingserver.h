@@ -93,6 +93,14 @@ class SyslogLogger : public LoggerBase
 
 class DBLoggerThread;
 
+/// \brief A message waiting to be written to the database, with the number
+///        of identical messages that were folded into it
+typedef struct {
+    LoggingItem *item;
+    int          repeats;
+} DBLogEntry;
+typedef QList<DBLogEntry> DBLogBatch;
+
 /// \brief Database logger - logs to the MythTV database
 class DatabaseLogger : public LoggerBase
 {
@@ -109,21 +117,18 @@ class DatabaseLogger : public LoggerBase
   protected:
     bool setupZMQSocket(void);
   protected:
-    bool logqmsg(MSqlQuery &query, LoggingItem *item);
-    void prepare(MSqlQuery &query);
+    bool logqmsg(MSqlQuery &query, const DBLogBatch &batch);
+    void prepare(MSqlQuery &query, int rows);
   private:
     bool isDatabaseReady(void);
     bool tableExists(const QString &table);
 
     DBLoggerThread *m_thread;   ///< The database queue handling thread
-    QString m_query;            ///< The database query to insert log messages
+    QString m_query;            ///< The start of the query to insert log
+                                ///  messages, without the VALUES
     bool m_opened;              ///< The database is opened
     bool m_loggingTableExists;  ///< The desired logging table exists
-    bool m_disabled;            ///< DB logging is temporarily disabled
-    QTime m_disabledTime;       ///< Time when the DB logging was disabled
     QTime m_errorLoggingTime;   ///< Time when DB error logging was last done
-    static const int kMinDisabledTime; ///< Minimum time to disable DB logging
-                                       ///  (in ms)
     nzmqt::ZMQSocket *m_zmqSock;  ///< ZeroMQ feeding socket
   protected slots:
     void receivedMessage(const QList<QByteArray>&);
@@ -200,10 +205,10 @@ class QWaitCondition;
 #define MAX_QUEUE_LEN 1000
 
 /// \brief Thread that manages the queueing of logging inserts for the database.
-///        The database logging gets throttled if it gets overwhelmed, and also
-///        during startup.  Having a second queue allows the rest of the
-///        logging to remain in sync and to allow for burstiness in the
-///        database due to things like scheduler runs.
+///        The queue is bounded, repeats of recent messages are folded into
+///        one row, and rows are inserted in batches.  Having a second queue
+///        allows the rest of the logging to remain in sync and to allow for
+///        burstiness in the database due to things like scheduler runs.
 class DBLoggerThread : public MThread
 {
   public:
@@ -211,27 +216,36 @@ class DBLoggerThread : public MThread
     ~DBLoggerThread();
     void run(void);
     void stop(void);
-    /// \brief Enqueues a LoggingItem onto the queue for the thread to 
-    ///        consume.
-    bool enqueue(LoggingItem *item) 
-    { 
-        QMutexLocker qLock(&m_queueMutex); 
-        if (!m_aborted)
-            m_queue->enqueue(item); 
-        return true; 
+    bool enqueue(LoggingItem *item);
+
+    /// \brief Messages lost because the queue was full
+    int droppedCount(void)
+    {
+        QMutexLocker qLock(&m_queueMutex);
+        return m_dropped;
     }
 
-    /// \brief Indicates when the queue is full
-    /// \return true when the queue is full
-    bool queueFull(void)
+    /// \brief Messages folded into an identical one still in the queue
+    int coalescedCount(void)
     {
-        QMutexLocker qLock(&m_queueMutex); 
-        return (m_queue->size() >= MAX_QUEUE_LEN);
+        QMutexLocker qLock(&m_queueMutex);
+        return m_coalesced;
     }
+
+    static const int kMaxBatch = 100;      ///< Most rows in one INSERT
+    static const int kCoalesceDepth = 16;  ///< Queued messages a new one is
+                                           ///  compared to
   private:
+    void reportCounts(void);
+
     DatabaseLogger *m_logger;       ///< The associated logger instance
     QMutex m_queueMutex;            ///< Mutex for protecting the queue
-    QQueue<LoggingItem *> *m_queue; ///< Queue of LoggingItems to insert
+    QQueue<DBLogEntry> *m_queue;    ///< Queue of messages to insert
+    int m_dropped;                  ///< Protected by m_queueMutex
+    int m_coalesced;                ///< Protected by m_queueMutex
+    int m_reportedDropped;          ///< Counts when last logged
+    int m_reportedCoalesced;
+    QTime m_reportTime;             ///< When the counts were last logged
     QWaitCondition *m_wait;         ///< Wait condition used for waiting
                                     ///  for the queue to not be full.
                                     ///  Protected by m_queueMutex
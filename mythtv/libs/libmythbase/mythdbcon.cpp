@@ -1,8 +1,21 @@
 #include <unistd.h>
+#include <sys/time.h>
 
 // ANSI C
 #include <cstdlib>
 
+#if defined(__GNUC__) && !defined(USING_MINGW)
+#include <dlfcn.h>
+#include <cxxabi.h>
+#define HAVE_CALLER_NAMES 1
+#endif
+
+#ifdef __GNUC__
+#define CALLER_ADDRESS __builtin_return_address(0)
+#else
+#define CALLER_ADDRESS NULL
+#endif
+
 // Qt
 #include <QVector>
 #include <QSqlDriver>
@@ -10,6 +23,8 @@
 #include <QSqlError>
 #include <QSqlField>
 #include <QSqlRecord>
+#include <QElapsedTimer>
+#include <QThreadStorage>
 
 // MythTV
 #include "compat.h"
@@ -21,6 +36,7 @@
 #include "exitcodes.h"
 #include "mthread.h"
 #include "mythdate.h"
+#include "mythmetrics.h"
 
 #define DEBUG_RECONNECT 0
 #if DEBUG_RECONNECT
@@ -28,6 +44,10 @@
 #endif
 
 static const uint kPurgeTimeout = 60 * 60;
+/// Idle connections are looked for at most this often, in seconds
+static const uint kPurgeInterval = 60;
+/// Query times are logged at most this often, in seconds
+static const uint kStatsInterval = 10 * 60;
 
 bool TestDatabase(QString dbHostName,
                   QString dbUserName,
@@ -69,6 +89,7 @@ bool TestDatabase(QString dbHostName,
 }
 
 MSqlDatabase::MSqlDatabase(const QString &name)
+  : m_statementClock(0)
 {
     m_name = name;
     m_name.detach();
@@ -85,6 +106,8 @@ MSqlDatabase::MSqlDatabase(const QString &name)
 
 MSqlDatabase::~MSqlDatabase()
 {
+    ClearStatements();
+
     if (m_db.isOpen())
     {
         m_db.close();
@@ -119,6 +142,8 @@ bool MSqlDatabase::OpenDatabase(bool skipdb)
 
     if (!m_db.isOpen())
     {
+        ClearStatements();
+
         if (!skipdb)
             m_dbparms = GetMythDB()->GetDatabaseParams();
         m_db.setDatabaseName(m_dbparms.dbName);
@@ -225,13 +250,17 @@ bool MSqlDatabase::KickDatabase(void)
     m_lastDBKick = MythDate::current().addSecs(-60);
 
     if (!m_db.isOpen())
+    {
+        ClearStatements();
         m_db.open();
+    }
 
     return m_db.isOpen();
 }
 
 bool MSqlDatabase::Reconnect()
 {
+    ClearStatements();
     m_db.close();
     m_db.open();
 
@@ -253,15 +282,86 @@ void MSqlDatabase::InitSessionVars()
     m_db.exec("SET @@session.sql_mode=''");
 }
 
+/**
+ *  \brief Hands out the statement cached for 'query', if there is one and
+ *         no other MSqlQuery is using it.
+ *
+ *  The statement stays reserved until ReturnStatement() is called with
+ *  the same 'id'.
+ */
+QSqlQuery *MSqlDatabase::TakeStatement(const QString &query, uint &id)
+{
+    QHash<QString, PreparedStatement*>::iterator it = m_statements.find(query);
+    if (it == m_statements.end() || (*it)->inuse)
+        return NULL;
+
+    (*it)->inuse = true;
+    (*it)->lastUsed = ++m_statementClock;
+    id = (*it)->id;
+    return &(*it)->query;
+}
+
+/**
+ *  \brief Caches a freshly prepared statement, evicting the least recently
+ *         used idle one when the cache is full.
+ *
+ *  \return the id the statement is reserved under, or 0 if it wasn't cached
+ */
+uint MSqlDatabase::AddStatement(const QString &query, const QSqlQuery &prepared)
+{
+    if (m_statements.contains(query))
+        return 0;
+
+    if (m_statements.size() >= kMaxStatements)
+    {
+        QHash<QString, PreparedStatement*>::iterator it, oldest;
+        oldest = m_statements.end();
+        for (it = m_statements.begin(); it != m_statements.end(); ++it)
+        {
+            if (!(*it)->inuse && (oldest == m_statements.end() ||
+                                  (*it)->lastUsed < (*oldest)->lastUsed))
+                oldest = it;
+        }
+        if (oldest == m_statements.end())
+            return 0;
+        delete *oldest;
+        m_statements.erase(oldest);
+    }
+
+    PreparedStatement *stmt = new PreparedStatement;
+    stmt->query = prepared;
+    stmt->id = ++m_statementClock;
+    stmt->lastUsed = stmt->id;
+    stmt->inuse = true;
+    m_statements.insert(query, stmt);
+
+    return stmt->id;
+}
+
+void MSqlDatabase::ReturnStatement(const QString &query, uint id)
+{
+    QHash<QString, PreparedStatement*>::iterator it = m_statements.find(query);
+    if (it != m_statements.end() && (*it)->id == id)
+        (*it)->inuse = false;
+}
+
+/// Statements don't survive the connection, so this must be called
+/// whenever it is closed or reopened
+void MSqlDatabase::ClearStatements(void)
+{
+    QHash<QString, PreparedStatement*>::iterator it = m_statements.begin();
+    for (; it != m_statements.end(); ++it)
+        delete *it;
+    m_statements.clear();
+}
+
 // -----------------------------------------------------------------------
 
 
 
 MDBManager::MDBManager()
+  : m_nextConnID(0), m_connCount(0)
 {
-    m_nextConnID = 0;
-    m_connCount = 0;
-
     m_schedCon = NULL;
     m_DDCon = NULL;
 }
@@ -270,7 +370,7 @@ MDBManager::~MDBManager()
 {
     CloseDatabases();
 
-    if (m_connCount != 0 || m_schedCon || m_DDCon)
+    if (m_connCount.fetchAndAddOrdered(0) != 0 || m_schedCon || m_DDCon)
     {
         LOG(VB_GENERAL, LOG_CRIT,
             "MDBManager exiting with connections still open");
@@ -282,51 +382,64 @@ MDBManager::~MDBManager()
 #endif
 }
 
-MSqlDatabase *MDBManager::popConnection(bool reuse)
+MDBManager::ThreadConnections *MDBManager::localConnections(void)
 {
-    PurgeIdleConnections(true);
+    if (!m_pool.hasLocalData())
+    {
+        ThreadConnections *conns = new ThreadConnections;
+#if REUSE_CONNECTION
+        conns->inuse = NULL;
+        conns->inuse_count = 0;
+#endif
+        conns->lastPurge = time(NULL);
+        m_pool.setLocalData(conns);
+    }
+    return m_pool.localData();
+}
 
-    m_lock.lock();
+MSqlDatabase *MDBManager::newConnection(void)
+{
+    MSqlDatabase *db = new MSqlDatabase(
+        "DBManager" + QString::number(m_nextConnID.fetchAndAddOrdered(1)));
+    int count = m_connCount.fetchAndAddOrdered(1) + 1;
+    LOG(VB_DATABASE, LOG_INFO,
+            QString("New DB connection, total: %1").arg(count));
+    return db;
+}
 
+MSqlDatabase *MDBManager::popConnection(bool reuse)
+{
+    ThreadConnections *conns = localConnections();
     MSqlDatabase *db;
 
 #if REUSE_CONNECTION
-    if (reuse)
+    if (reuse && conns->inuse)
     {
-        db = m_inuse[QThread::currentThread()];
-        if (db != NULL)
-        {
-            m_inuse_count[QThread::currentThread()]++;
-            m_lock.unlock();
-            return db;
-        }
+        conns->inuse_count++;
+        return conns->inuse;
     }
 #endif
 
-    DBList &list = m_pool[QThread::currentThread()];
-    if (list.isEmpty())
+    PurgeIdleConnections(true);
+
+    if (conns->pool.isEmpty())
     {
-        db = new MSqlDatabase("DBManager" + QString::number(m_nextConnID++));
-        ++m_connCount;
-        LOG(VB_DATABASE, LOG_INFO,
-                QString("New DB connection, total: %1").arg(m_connCount));
+        db = newConnection();
     }
     else
     {
-        db = list.back();
-        list.pop_back();
+        db = conns->pool.back();
+        conns->pool.pop_back();
     }
 
 #if REUSE_CONNECTION
     if (reuse)
     {
-        m_inuse_count[QThread::currentThread()]=1;
-        m_inuse[QThread::currentThread()] = db;
+        conns->inuse_count = 1;
+        conns->inuse = db;
     }
 #endif
 
-    m_lock.unlock();
-
     db->OpenDatabase();
 
     return db;
@@ -334,40 +447,41 @@ MSqlDatabase *MDBManager::popConnection(bool reuse)
 
 void MDBManager::pushConnection(MSqlDatabase *db)
 {
-    m_lock.lock();
+    ThreadConnections *conns = localConnections();
 
 #if REUSE_CONNECTION
-    if (db == m_inuse[QThread::currentThread()])
+    if (db == conns->inuse)
     {
-        int cnt = --m_inuse_count[QThread::currentThread()];
-        if (cnt > 0)
-        {
-            m_lock.unlock();
+        if (--conns->inuse_count > 0)
             return;
-        }
-        m_inuse[QThread::currentThread()] = NULL;
+        conns->inuse = NULL;
     }
 #endif
 
     if (db)
     {
         db->m_lastDBKick = MythDate::current();
-        m_pool[QThread::currentThread()].push_front(db);
+        conns->pool.push_front(db);
     }
 
-    m_lock.unlock();
-
     PurgeIdleConnections(true);
 }
 
 void MDBManager::PurgeIdleConnections(bool leaveOne)
 {
-    QMutexLocker locker(&m_lock);
+    ThreadConnections *conns = localConnections();
+
+    // Connections idle for an hour are all we look for, so there is no
+    // point checking on every query
+    time_t nowsecs = time(NULL);
+    if (leaveOne && nowsecs - conns->lastPurge < (time_t)kPurgeInterval)
+        return;
+    conns->lastPurge = nowsecs;
 
     leaveOne = leaveOne || (gCoreContext && gCoreContext->IsUIThread());
 
     QDateTime now = MythDate::current();
-    DBList &list = m_pool[QThread::currentThread()];
+    DBList &list = conns->pool;
     DBList::iterator it = list.begin();
 
     uint purgedConnections = 0, totalConnections = 0;
@@ -385,7 +499,7 @@ void MDBManager::PurgeIdleConnections(bool leaveOne)
         // seconds close it.
         MSqlDatabase *entry = *it;
         it = list.erase(it);
-        --m_connCount;
+        m_connCount.fetchAndAddOrdered(-1);
         purgedConnections++;
 
         // Qt's MySQL driver apparently keeps track of the number of
@@ -402,11 +516,7 @@ void MDBManager::PurgeIdleConnections(bool leaveOne)
             purgedConnections > 0 &&
             totalConnections == purgedConnections)
         {
-            newDb = new MSqlDatabase("DBManager" +
-                                     QString::number(m_nextConnID++));
-            ++m_connCount;
-            LOG(VB_GENERAL, LOG_INFO,
-                    QString("New DB connection, total: %1").arg(m_connCount));
+            newDb = newConnection();
             newDb->m_lastDBKick = MythDate::current();
         }
 
@@ -456,18 +566,18 @@ MSqlDatabase *MDBManager::getDDCon()
 
 void MDBManager::CloseDatabases()
 {
-    m_lock.lock();
-    DBList list = m_pool[QThread::currentThread()];
-    m_pool[QThread::currentThread()].clear();
-    m_lock.unlock();
+    ThreadConnections *conns = localConnections();
+    DBList list = conns->pool;
+    conns->pool.clear();
 
     for (DBList::iterator it = list.begin(); it != list.end(); ++it)
     {
         LOG(VB_DATABASE, LOG_INFO,
             "Closing DB connection named '" + (*it)->m_name + "'");
+        (*it)->ClearStatements();
         (*it)->m_db.close();
         delete (*it);
-        m_connCount--;
+        m_connCount.fetchAndAddOrdered(-1);
     }
 
     m_lock.lock();
@@ -477,6 +587,7 @@ void MDBManager::CloseDatabases()
         MSqlDatabase *db = slist.takeFirst();
         LOG(VB_DATABASE, LOG_INFO,
             "Closing DB connection named '" + db->m_name + "'");
+        db->ClearStatements();
         db->m_db.close();
         delete db;
 
@@ -505,6 +616,7 @@ MSqlQuery::MSqlQuery(const MSqlQueryInfo &qi)
     m_isConnected = false;
     m_db = qi.db;
     m_returnConnection = qi.returnConnection;
+    m_statementId = 0;
 
     m_isConnected = m_db && m_db->isOpen();
 
@@ -515,6 +627,8 @@ MSqlQuery::MSqlQuery(const MSqlQueryInfo &qi)
 
 MSqlQuery::~MSqlQuery()
 {
+    ReleaseStatement();
+
     if (m_returnConnection)
     {
         MDBManager *dbmanager = GetMythDB()->GetDBManager();
@@ -626,6 +740,9 @@ bool MSqlQuery::exec()
         return false;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
     bool result = QSqlQuery::exec();
 
     // if the query failed with "MySQL server has gone away"
@@ -663,6 +780,9 @@ bool MSqlQuery::exec()
         }
     }
 
+    AddQueryTime(CALLER_ADDRESS, m_last_prepared_query,
+                 timer.nsecsElapsed() / 1000);
+
     if (VERBOSE_LEVEL_CHECK(VB_DATABASE, LOG_DEBUG))
     {
         QString str = lastQuery();
@@ -709,6 +829,12 @@ bool MSqlQuery::exec(const QString &query)
         return false;
     }
 
+    // Ad hoc SQL must not replace a cached statement's query
+    ReleaseStatement();
+
+    QElapsedTimer timer;
+    timer.start();
+
     bool result = QSqlQuery::exec(query);
 
     // if the query failed with "MySQL server has gone away"
@@ -717,6 +843,8 @@ bool MSqlQuery::exec(const QString &query)
     if (!result && QSqlQuery::lastError().number() == 2006 && Reconnect())
         result = QSqlQuery::exec(query);
 
+    AddQueryTime(CALLER_ADDRESS, query, timer.nsecsElapsed() / 1000);
+
     LOG(VB_DATABASE, LOG_DEBUG,
             QString("MSqlQuery::exec(%1) %2%3")
                     .arg(m_db->MSqlDatabase::GetConnectionName()).arg(query)
@@ -795,6 +923,7 @@ bool MSqlQuery::prepare(const QString& query)
         return false;
     }
 
+    ReleaseStatement();
     m_last_prepared_query = query;
 
 #ifdef DEBUG_QT4_PORT
@@ -823,6 +952,25 @@ bool MSqlQuery::prepare(const QString& query)
         return false;
     }
 
+    // Reuse the statement if this connection has already prepared it
+    QSqlQuery *cached = m_db->TakeStatement(query, m_statementId);
+    if (cached)
+    {
+        bool forwardOnly = QSqlQuery::isForwardOnly();
+        QSqlQuery::operator=(*cached);
+        QSqlQuery::setForwardOnly(forwardOnly);
+
+        // Placeholders the caller doesn't bind must be NULL, as they
+        // would be after a fresh prepare
+        QMapIterator<QString, QVariant> b(QSqlQuery::boundValues());
+        while (b.hasNext())
+        {
+            b.next();
+            QSqlQuery::bindValue(b.key(), QVariant(), QSql::In);
+        }
+        return true;
+    }
+
     bool ok = QSqlQuery::prepare(query);
 
     // if the prepare failed with "MySQL server has gone away"
@@ -831,6 +979,9 @@ bool MSqlQuery::prepare(const QString& query)
     if (!ok && QSqlQuery::lastError().number() == 2006 && Reconnect())
         ok = true;
 
+    if (ok && driver()->hasFeature(QSqlDriver::PreparedQueries))
+        m_statementId = m_db->AddStatement(query, *this);
+
     if (!ok && !(GetMythDB()->SuppressDBMessages()))
     {
         LOG(VB_GENERAL, LOG_ERR,
@@ -888,6 +1039,8 @@ QVariant MSqlQuery::lastInsertId()
 
 bool MSqlQuery::Reconnect(void)
 {
+    // Reconnecting drops the statement cache, so ours is now private
+    m_statementId = 0;
     if (!m_db->Reconnect())
         return false;
     if (!m_last_prepared_query.isEmpty())
@@ -900,6 +1053,250 @@ bool MSqlQuery::Reconnect(void)
     return true;
 }
 
+/**
+ *  \brief Gives the cached statement in use back to the connection.
+ *
+ *  The result set is freed and this query is detached from the statement,
+ *  so that preparing something else doesn't overwrite the cached copy.
+ */
+void MSqlQuery::ReleaseStatement(void)
+{
+    if (!m_statementId)
+        return;
+
+    QSqlQuery::finish();
+    m_db->ReturnStatement(m_last_prepared_query, m_statementId);
+    m_statementId = 0;
+
+    bool forwardOnly = QSqlQuery::isForwardOnly();
+    QSqlQuery::operator=(QSqlQuery(QString::null, m_db->db()));
+    QSqlQuery::setForwardOnly(forwardOnly);
+}
+
+/// \brief Query times from one thread.  Only that thread adds to them, so
+///        the lock is only contended while GetQueryStats() reads them.
+class MSqlThreadStats
+{
+  public:
+    MSqlThreadStats() : m_calls(0), m_usecs(0), m_orphaned(0) {}
+
+    QMutex                             m_lock;
+    QHash<const void*, MSqlQueryStats> m_stats;
+    quint64                            m_calls;
+    quint64                            m_usecs;
+    QAtomicInt                         m_orphaned; ///< thread has exited
+};
+
+/// \brief Marks a thread's MSqlThreadStats for merging when it exits
+class MSqlThreadStatsOwner
+{
+  public:
+    MSqlThreadStatsOwner(MSqlThreadStats *stats) : m_stats(stats) {}
+    ~MSqlThreadStatsOwner() { m_stats->m_orphaned.fetchAndStoreRelease(1); }
+
+    MSqlThreadStats *m_stats;
+};
+
+static QThreadStorage<MSqlThreadStatsOwner *> s_threadStatsOwner;
+
+/// Guards s_threadStats and s_exitedStats
+static QMutex s_queryStatsLock;
+static QList<MSqlThreadStats *> s_threadStats;
+/// Query times from threads that have exited
+static MSqlThreadStats s_exitedStats;
+static QAtomicInt s_queryStatsLogged(0);
+
+/// The calling thread's MSqlThreadStats, created on its first query
+static MSqlThreadStats *GetThreadStats(void)
+{
+    MSqlThreadStatsOwner *owner = s_threadStatsOwner.localData();
+    if (owner)
+        return owner->m_stats;
+
+    MSqlThreadStats *stats = new MSqlThreadStats();
+    s_threadStatsOwner.setLocalData(new MSqlThreadStatsOwner(stats));
+
+    QMutexLocker locker(&s_queryStatsLock);
+    s_threadStats.append(stats);
+    return stats;
+}
+
+static void MergeQueryStats(QHash<const void*, MSqlQueryStats> &to,
+                            const QHash<const void*, MSqlQueryStats> &from)
+{
+    QHash<const void*, MSqlQueryStats>::const_iterator it = from.begin();
+    for (; it != from.end(); ++it)
+    {
+        QHash<const void*, MSqlQueryStats>::iterator tit = to.find(it.key());
+        if (tit == to.end())
+        {
+            to.insert(it.key(), *it);
+            continue;
+        }
+        tit->query = it->query;
+        tit->calls += it->calls;
+        tit->usecs += it->usecs;
+        if (it->maxUsecs > tit->maxUsecs)
+            tit->maxUsecs = it->maxUsecs;
+    }
+}
+
+/// \brief Adds up the query times of all threads so far, and frees those
+///        of threads that have exited.
+static void CollectQueryStats(QHash<const void*, MSqlQueryStats> *stats,
+                              quint64 &calls, quint64 &usecs)
+{
+    QMutexLocker locker(&s_queryStatsLock);
+
+    QList<MSqlThreadStats *>::iterator it = s_threadStats.begin();
+    while (it != s_threadStats.end())
+    {
+        if ((*it)->m_orphaned.fetchAndAddAcquire(0))
+        {
+            // Its thread is gone, so nothing else touches it
+            MergeQueryStats(s_exitedStats.m_stats, (*it)->m_stats);
+            s_exitedStats.m_calls += (*it)->m_calls;
+            s_exitedStats.m_usecs += (*it)->m_usecs;
+            delete *it;
+            it = s_threadStats.erase(it);
+            continue;
+        }
+        ++it;
+    }
+
+    calls = s_exitedStats.m_calls;
+    usecs = s_exitedStats.m_usecs;
+    if (stats)
+        *stats = s_exitedStats.m_stats;
+
+    for (it = s_threadStats.begin(); it != s_threadStats.end(); ++it)
+    {
+        QMutexLocker tlocker(&(*it)->m_lock);
+        calls += (*it)->m_calls;
+        usecs += (*it)->m_usecs;
+        if (stats)
+            MergeQueryStats(*stats, (*it)->m_stats);
+    }
+}
+
+void MSqlQuery::AddQueryTime(const void *caller, const QString &query,
+                             quint64 usecs)
+{
+    MSqlThreadStats *tstats = GetThreadStats();
+    {
+        QMutexLocker locker(&tstats->m_lock);
+
+        MSqlQueryStats &stats = tstats->m_stats[caller];
+        stats.query = query;
+        stats.calls++;
+        stats.usecs += usecs;
+        if (usecs > stats.maxUsecs)
+            stats.maxUsecs = usecs;
+        tstats->m_calls++;
+        tstats->m_usecs += usecs;
+    }
+
+    // Only the thread that moves the time on logs the stats
+    int now = (int) time(NULL);
+    int logged = s_queryStatsLogged.fetchAndAddOrdered(0);
+    if (!logged)
+        s_queryStatsLogged.testAndSetOrdered(0, now);
+    else if ((now - logged >= (int)kStatsInterval) &&
+             s_queryStatsLogged.testAndSetOrdered(logged, now) &&
+             VERBOSE_LEVEL_CHECK(VB_DATABASE, LOG_INFO))
+    {
+        LogQueryStats();
+    }
+}
+
+/// Name of the function containing 'caller', or its address if the symbol
+/// can't be found
+static QString CallerName(const void *caller)
+{
+#if HAVE_CALLER_NAMES
+    Dl_info info;
+    if (caller && dladdr(caller, &info) && info.dli_sname)
+    {
+        int status = -1;
+        char *name = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+        QString str = QString("%1+0x%2")
+            .arg((status == 0 && name) ? name : info.dli_sname)
+            .arg((quintptr)caller - (quintptr)info.dli_saddr, 0, 16);
+        free(name);
+        return str;
+    }
+#endif
+    return QString("0x%1").arg((quintptr)caller, 0, 16);
+}
+
+static bool QueryStatsLessThan(const MSqlQueryStats &a,
+                               const MSqlQueryStats &b)
+{
+    return a.usecs > b.usecs;
+}
+
+/**
+ *  \brief Returns the 'count' places in the code that have spent the
+ *         most time executing queries since the program started.
+ */
+QList<MSqlQueryStats> MSqlQuery::GetQueryStats(int count)
+{
+    QHash<const void*, MSqlQueryStats> stats;
+    quint64 calls, usecs;
+    CollectQueryStats(&stats, calls, usecs);
+
+    QList<MSqlQueryStats> list = stats.values();
+    QList<const void*> callers = stats.keys();
+
+    for (int i = 0; i < list.size(); i++)
+        list[i].caller = CallerName(callers[i]);
+
+    qSort(list.begin(), list.end(), QueryStatsLessThan);
+    if (list.size() > count)
+        list.erase(list.begin() + count, list.end());
+
+    return list;
+}
+
+/**
+ *  \brief Publishes the number of queries and the time spent in them as
+ *         MythMetrics.
+ *
+ *  The totals are only added up here rather than on every exec(), so call
+ *  this just before the metrics are written out.
+ */
+void MSqlQuery::UpdateQueryMetrics(void)
+{
+    quint64 calls, usecs;
+    CollectQueryStats(NULL, calls, usecs);
+
+    MythMetrics::Describe("myth_db_queries_total", MythMetrics::kCounter,
+                          "Database queries executed.");
+    MythMetrics::Describe("myth_db_query_seconds_total",
+                          MythMetrics::kCounter,
+                          "Time spent executing database queries.");
+    MythMetrics::Set("myth_db_queries_total", calls);
+    MythMetrics::Set("myth_db_query_seconds_total", usecs / 1000000.0);
+}
+
+void MSqlQuery::LogQueryStats(int count)
+{
+    QList<MSqlQueryStats> list = GetQueryStats(count);
+
+    LOG(VB_DATABASE, LOG_INFO,
+        QString("Slowest %1 query callers by total time:").arg(list.size()));
+
+    QList<MSqlQueryStats>::const_iterator it = list.begin();
+    for (; it != list.end(); ++it)
+    {
+        LOG(VB_DATABASE, LOG_INFO,
+            QString("  %1 ms in %2 calls (max %3 ms) from %4: %5")
+                .arg(it->usecs / 1000).arg(it->calls)
+                .arg(it->maxUsecs / 1000).arg(it->caller)
+                .arg(it->query.simplified().left(200)));
+    }
+}
+
 void MSqlAddMoreBindings(MSqlBindings &output, MSqlBindings &addfrom)
 {
     MSqlBindings::Iterator it;
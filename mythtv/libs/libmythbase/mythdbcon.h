@@ -1,6 +1,8 @@
 #ifndef MYTHDBCON_H_
 #define MYTHDBCON_H_
 
+#include <ctime>
+
 #include <QSqlDatabase>
 #include <QSqlRecord>
 #include <QSqlError>
@@ -10,6 +12,9 @@
 #include <QDateTime>
 #include <QMutex>
 #include <QList>
+#include <QHash>
+#include <QAtomicInt>
+#include <QThreadStorage>
 
 #include "mythbaseexp.h"
 #include "mythdbparams.h"
@@ -42,11 +47,31 @@ class MSqlDatabase
     bool Reconnect(void);
     void InitSessionVars(void);
 
+    QSqlQuery *TakeStatement(const QString &query, uint &id);
+    uint AddStatement(const QString &query, const QSqlQuery &prepared);
+    void ReturnStatement(const QString &query, uint id);
+    void ClearStatements(void);
+
+    /// A query prepared on the server, kept for the next MSqlQuery that
+    /// prepares the same SQL on this connection
+    typedef struct
+    {
+        QSqlQuery query;
+        uint      id;
+        uint      lastUsed;
+        bool      inuse;
+    } PreparedStatement;
+
+    /// Number of prepared statements kept per connection
+    static const int kMaxStatements = 32;
+
   private:
     QString m_name;
     QSqlDatabase m_db;
     QDateTime m_lastDBKick;
     DatabaseParams m_dbparms;
+    QHash<QString, PreparedStatement*> m_statements;
+    uint m_statementClock;
 };
 
 /// \brief DB connection pool, used by MSqlQuery. Do not use directly.
@@ -69,17 +94,29 @@ class MBASE_PUBLIC MDBManager
 
   private:
     MSqlDatabase *getStaticCon(MSqlDatabase **dbcon, QString name);
+    MSqlDatabase *newConnection(void);
 
-    QMutex m_lock;
     typedef QList<MSqlDatabase*> DBList;
-    QHash<QThread*, DBList> m_pool; // protected by m_lock
-#if REUSE_CONNECTION 
-    QHash<QThread*, MSqlDatabase*> m_inuse; // protected by m_lock
-    QHash<QThread*, int> m_inuse_count; // protected by m_lock
+
+    /// Connections belonging to one thread. Only that thread ever touches
+    /// them, so taking and returning a connection needs no locking.
+    typedef struct
+    {
+        DBList pool;
+#if REUSE_CONNECTION
+        MSqlDatabase *inuse;
+        int inuse_count;
 #endif
+        time_t lastPurge;
+    } ThreadConnections;
+
+    ThreadConnections *localConnections(void);
 
-    int m_nextConnID;
-    int m_connCount;
+    QMutex m_lock; // protects the static connections
+    QThreadStorage<ThreadConnections*> m_pool;
+
+    QAtomicInt m_nextConnID;
+    QAtomicInt m_connCount;
 
     MSqlDatabase *m_schedCon;
     MSqlDatabase *m_DDCon;
@@ -94,6 +131,16 @@ typedef struct _MSqlQueryInfo
     bool returnConnection;
 } MSqlQueryInfo;
 
+/// \brief Time spent executing queries from one place in the code
+typedef struct
+{
+    QString  caller;     ///< function that called MSqlQuery::exec()
+    QString  query;      ///< the last SQL executed from there
+    quint64  calls;
+    quint64  usecs;      ///< total time spent in exec()
+    quint64  maxUsecs;   ///< slowest single call
+} MSqlQueryStats;
+
 /// \brief typedef for a map of string -> string bindings for generic queries.
 typedef QMap<QString, QVariant> MSqlBindings;
 
@@ -210,6 +257,15 @@ class MBASE_PUBLIC MSqlQuery : private QSqlQuery
     /// \brief Returns dedicated connection. (Required for using temporary SQL tables.)
     static MSqlQueryInfo DDCon();
 
+    /// \brief Returns the callers that have spent the most time in exec()
+    static QList<MSqlQueryStats> GetQueryStats(int count = 10);
+
+    /// \brief Logs the callers that have spent the most time in exec()
+    static void LogQueryStats(int count = 10);
+
+    /// \brief Sets the query count and time MythMetrics
+    static void UpdateQueryMetrics(void);
+
   private:
     // Only QSql::In is supported as a param type and only named params...
     void bindValue(const QString&, const QVariant&, QSql::ParamType);
@@ -219,10 +275,15 @@ class MBASE_PUBLIC MSqlQuery : private QSqlQuery
     bool seekDebug(const char *type, bool result,
                    int where, bool relative) const;
 
+    void ReleaseStatement(void);
+    static void AddQueryTime(const void *caller, const QString &query,
+                             quint64 usecs);
+
     MSqlDatabase *m_db;
     bool m_isConnected;
     bool m_returnConnection;
     QString m_last_prepared_query; // holds a copy of the last prepared query
+    uint m_statementId; // cached statement in use, or 0
 #ifdef DEBUG_QT4_PORT
     QRegExp m_testbindings;
 #endif
@@ -20,17 +20,22 @@ extern "C" {
 #define VERBOSE_LEVEL_CHECK(_MASK_, _LEVEL_) \
     (((verboseMask & (_MASK_)) == (_MASK_)) && logLevel >= (_LEVEL_))
 
+// Checked before the message is formatted, so a flood costs next to nothing
+#define VERBOSE_RATE_CHECK(_MASK_, _LEVEL_) \
+    (!logRateLimit || logRateCheck((_MASK_), (_LEVEL_)))
+
 #define VERBOSE please_use_LOG_instead_of_VERBOSE
 
 // There are two LOG macros now.  One for use with Qt/C++, one for use
 // without Qt.
 //
-// Neither of them will lock the calling thread other than momentarily to put
-// the log message onto a queue.
+// Neither of them will lock the calling thread, the message goes into a
+// ring buffer belonging to the calling thread.
 #ifdef __cplusplus
 #define LOG(_MASK_, _LEVEL_, _STRING_)                                  \
     do {                                                                \
-        if (VERBOSE_LEVEL_CHECK((_MASK_), (_LEVEL_)) && ((_LEVEL_)>=0)) \
+        if (VERBOSE_LEVEL_CHECK((_MASK_), (_LEVEL_)) && ((_LEVEL_)>=0) \
+            && VERBOSE_RATE_CHECK((_MASK_), (_LEVEL_)))                 \
         {                                                               \
             LogPrintLine(_MASK_, (LogLevel_t)_LEVEL_,                   \
                          __FILE__, __LINE__, __FUNCTION__, 1,           \
@@ -40,7 +45,8 @@ extern "C" {
 #else
 #define LOG(_MASK_, _LEVEL_, _FORMAT_, ...)                             \
     do {                                                                \
-        if (VERBOSE_LEVEL_CHECK((_MASK_), (_LEVEL_)) && ((_LEVEL_)>=0)) \
+        if (VERBOSE_LEVEL_CHECK((_MASK_), (_LEVEL_)) && ((_LEVEL_)>=0) \
+            && VERBOSE_RATE_CHECK((_MASK_), (_LEVEL_)))                 \
         {                                                               \
             LogPrintLine(_MASK_, (LogLevel_t)_LEVEL_,                   \
                          __FILE__, __LINE__, __FUNCTION__, 0,           \
@@ -55,8 +61,13 @@ MBASE_PUBLIC void LogPrintLine( uint64_t mask, LogLevel_t level,
                                 const char *function, int fromQString,
                                 const char *format, ... );
 
+/// Most messages per second for each verbose flag, below LOG_WARNING.
+/// 0 for no limit, set from the VERBOSE_RATELIMIT environment variable.
+MBASE_PUBLIC int logRateCheck(uint64_t mask, int level);
+
 extern MBASE_PUBLIC LogLevel_t logLevel;
 extern MBASE_PUBLIC uint64_t   verboseMask;
+extern MBASE_PUBLIC int        logRateLimit;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,131 @@
+#include <cmath>
+
+#include <QMutexLocker>
+#include <QMutex>
+#include <QMap>
+
+#include "mythmetrics.h"
+
+namespace
+{
+    struct Metric
+    {
+        Metric() : type(MythMetrics::kGauge), described(false) {}
+
+        MythMetrics::MetricType type;
+        bool                    described;
+        QString                 help;
+        QMap<QString, double>   series;   ///< value by label set
+    };
+}
+
+static QMutex                  s_metricsLock;
+static QMap<QString, Metric>   s_metrics;
+
+/**
+ *  \brief Sets the type and help text written out for the metric.
+ *
+ *  Metrics that are updated without being described are written out as
+ *  counters if they were created by Add() and gauges if by Set().
+ */
+void MythMetrics::Describe(const QString &name, MetricType type,
+                           const QString &help)
+{
+    QMutexLocker locker(&s_metricsLock);
+
+    Metric &metric = s_metrics[name];
+    metric.type      = type;
+    metric.help      = help;
+    metric.described = true;
+}
+
+/// Adds delta to the series, which starts from 0.
+void MythMetrics::Add(const QString &name, double delta,
+                      const QString &labels)
+{
+    QMutexLocker locker(&s_metricsLock);
+
+    Metric &metric = s_metrics[name];
+    if (!metric.described && metric.series.isEmpty())
+        metric.type = kCounter;
+    metric.series[labels] += delta;
+}
+
+void MythMetrics::Set(const QString &name, double value,
+                      const QString &labels)
+{
+    QMutexLocker locker(&s_metricsLock);
+
+    s_metrics[name].series[labels] = value;
+}
+
+/// Drops a series that no longer applies, e.g. for a removed capture card.
+void MythMetrics::Remove(const QString &name, const QString &labels)
+{
+    QMutexLocker locker(&s_metricsLock);
+
+    QMap<QString, Metric>::iterator it = s_metrics.find(name);
+    if (it != s_metrics.end())
+        it->series.remove(labels);
+}
+
+double MythMetrics::Value(const QString &name, const QString &labels)
+{
+    QMutexLocker locker(&s_metricsLock);
+
+    QMap<QString, Metric>::const_iterator it = s_metrics.find(name);
+    if (it == s_metrics.end())
+        return 0.0;
+
+    return it->series.value(labels, 0.0);
+}
+
+/// Formats one label, e.g. Label("host", "mybox") is host="mybox"
+QString MythMetrics::Label(const QString &name, const QString &value)
+{
+    QString escaped = value;
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    escaped.replace('\n', "\\n");
+
+    return QString("%1=\"%2\"").arg(name).arg(escaped);
+}
+
+static QString format_value(double value)
+{
+    if (value == floor(value) && fabs(value) < 1e15)
+        return QString::number((qlonglong)value);
+
+    return QString::number(value, 'g', 12);
+}
+
+/// All metrics in the Prometheus text exposition format (version 0.0.4)
+QString MythMetrics::ToText(void)
+{
+    QString text;
+
+    QMutexLocker locker(&s_metricsLock);
+
+    QMap<QString, Metric>::const_iterator it = s_metrics.begin();
+    for (; it != s_metrics.end(); ++it)
+    {
+        if (it->series.isEmpty())
+            continue;
+
+        if (!it->help.isEmpty())
+            text += QString("# HELP %1 %2\n").arg(it.key()).arg(it->help);
+        text += QString("# TYPE %1 %2\n").arg(it.key())
+            .arg((it->type == kCounter) ? "counter" : "gauge");
+
+        QMap<QString, double>::const_iterator sit = it->series.begin();
+        for (; sit != it->series.end(); ++sit)
+        {
+            text += it.key();
+            if (!sit.key().isEmpty())
+                text += '{' + sit.key() + '}';
+            text += ' ' + format_value(*sit) + '\n';
+        }
+    }
+
+    return text;
+}
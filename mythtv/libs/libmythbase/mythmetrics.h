@@ -0,0 +1,47 @@
+#ifndef MYTHMETRICS_H_
+#define MYTHMETRICS_H_
+
+#include <QString>
+
+#include "mythbaseexp.h"
+
+/** \class MythMetrics
+ *  \brief Process wide counters and gauges for monitoring.
+ *
+ *  Subsystems update their metrics as they go, which only costs a lock and
+ *  a map lookup, and ToText() writes all of them out in the Prometheus text
+ *  exposition format when something asks for them.  Nothing is computed at
+ *  that point, so scraping every few seconds is cheap.
+ *
+ *  Names follow the Prometheus conventions, e.g.
+ *  "mythbackend_recorder_bytes_total".  A metric may have one series per
+ *  label set, labels are passed already formatted, see Label().
+ *
+ *  This class is thread-safe.
+ */
+class MBASE_PUBLIC MythMetrics
+{
+  public:
+    typedef enum {
+        kCounter,   ///< only goes up, e.g. bytes written
+        kGauge,     ///< goes up and down, e.g. queue depth
+    } MetricType;
+
+    static void Describe(const QString &name, MetricType type,
+                         const QString &help);
+
+    static void Add(const QString &name, double delta,
+                    const QString &labels = QString());
+    static void Set(const QString &name, double value,
+                    const QString &labels = QString());
+    static void Remove(const QString &name,
+                       const QString &labels = QString());
+    static double Value(const QString &name,
+                        const QString &labels = QString());
+
+    static QString Label(const QString &name, const QString &value);
+
+    static QString ToText(void);
+};
+
+#endif
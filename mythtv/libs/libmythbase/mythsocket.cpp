@@ -16,8 +16,13 @@
 #include <stdio.h>
 #else
 #include <sys/socket.h>
+#include <poll.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
 #endif
 #include <unistd.h> // for usleep (and socket code on Q_OS_WIN)
+#include <cerrno>
 
 // MythTV
 #include "mythsocket.h"
@@ -34,6 +39,7 @@
 
 const uint MythSocket::kShortTimeout = kMythSocketShortTimeout;
 const uint MythSocket::kLongTimeout  = kMythSocketLongTimeout;
+const int  MythSocket::kSendFileUnsupported = -2;
 
 const int MythSocket::kSocketReceiveBufferSize = 128 * 1024;
 
@@ -503,6 +509,29 @@ int MythSocket::Write(const char *data, int size)
     return ret;
 }
 
+/** \brief Sends 'size' bytes of the file 'fd', starting at 'offset',
+ *         without copying them through user space.
+ *
+ *  Anything already queued with Write() is sent first.
+ *
+ *  \return bytes sent, which is short only at the end of the file,
+ *          -1 on error, or kSendFileUnsupported if nothing was sent
+ *          because the platform or file can't be used with sendfile().
+ */
+int MythSocket::SendFile(int fd, long long offset, int size)
+{
+    int ret = -1;
+    QMetaObject::invokeMethod(
+        this, "SendFileReal",
+        (QThread::currentThread() != m_thread->qthread()) ?
+        Qt::BlockingQueuedConnection : Qt::DirectConnection,
+        Q_ARG(int, fd),
+        Q_ARG(qlonglong, offset),
+        Q_ARG(int, size),
+        Q_ARG(int*, &ret));
+    return ret;
+}
+
 int MythSocket::Read(char *data, int size, int max_wait_ms)
 {
     int ret = -1;
@@ -913,6 +942,90 @@ void MythSocket::WriteReal(const char *data, int size, int *ret)
     *ret = m_tcpSocket->write(data, size);
 }
 
+void MythSocket::SendFileReal(int fd, qlonglong offset, int size, int *ret)
+{
+#ifdef __linux__
+    MythTimer t; t.start();
+
+    // QTcpSocket may still be holding data from an earlier Write()
+    while ((m_tcpSocket->state() == QAbstractSocket::ConnectedState) &&
+           (m_tcpSocket->bytesToWrite() > 0) &&
+           (t.elapsed() < (int)kLongTimeout))
+    {
+        m_tcpSocket->waitForBytesWritten(
+            max(2, (int)kLongTimeout - t.elapsed()));
+    }
+    if (m_tcpSocket->bytesToWrite() > 0)
+    {
+        *ret = -1;
+        return;
+    }
+
+    int sock = m_tcpSocket->socketDescriptor();
+    off_t off = offset;
+    int sent = 0;
+
+    while (sent < size)
+    {
+        ssize_t n = sendfile(sock, fd, &off, size - sent);
+        if (n > 0)
+        {
+            sent += n;
+            continue;
+        }
+        if (n == 0)
+            break; // end of file
+
+        if (errno == EINTR)
+            continue;
+
+        if (errno == EAGAIN)
+        {
+            // the socket is non-blocking, wait for room in the send buffer
+            struct pollfd pfd;
+            pfd.fd = sock;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            int wait_ms = (int)kLongTimeout - t.elapsed();
+            if (wait_ms > 0 && poll(&pfd, 1, wait_ms) > 0 &&
+                !(pfd.revents & (POLLERR | POLLHUP)))
+            {
+                continue;
+            }
+            LOG(VB_SOCKET, LOG_ERR, LOC +
+                QString("SendFile timed out after %1 of %2 bytes")
+                .arg(sent).arg(size));
+            *ret = -1;
+            return;
+        }
+
+        if (sent == 0 && (errno == EINVAL || errno == ENOSYS))
+        {
+            *ret = kSendFileUnsupported;
+            return;
+        }
+
+        LOG(VB_SOCKET, LOG_ERR, LOC + "SendFile failed" + ENO);
+        *ret = -1;
+        return;
+    }
+
+    if (t.elapsed() > 50)
+    {
+        LOG(VB_SOCKET, LOG_DEBUG, LOC +
+            QString("SendFile(%1, %2, %3) -> %4 took %5 ms")
+            .arg(fd).arg(offset).arg(size).arg(sent).arg(t.elapsed()));
+    }
+
+    *ret = sent;
+#else
+    (void) fd;
+    (void) offset;
+    (void) size;
+    *ret = kSendFileUnsupported;
+#endif
+}
+
 void MythSocket::ReadReal(char *data, int size, int max_wait_ms, int *ret)
 {
     MythTimer t; t.start();
@@ -65,11 +65,14 @@ class MBASE_PUBLIC MythSocket : public QObject, public ReferenceCounter
 
     // RemoteFile stuff
     int Write(const char*, int size);
+    int SendFile(int fd, long long offset, int size);
     int Read(char*, int size, int max_wait_ms);
     void Reset(void);
 
     static const uint kShortTimeout;
     static const uint kLongTimeout;
+    /// SendFile() return value when sendfile() can't be used
+    static const int  kSendFileUnsupported;
 
   signals:
     void CallReadyRead(void);
@@ -88,6 +91,7 @@ class MBASE_PUBLIC MythSocket : public QObject, public ReferenceCounter
     void DisconnectFromHostReal(void);
 
     void WriteReal(const char*, int size, int *ret);
+    void SendFileReal(int fd, qlonglong offset, int size, int *ret);
     void ReadReal(char*, int size, int max_wait_ms, int *ret);
     void ResetReal(void);
 
@@ -22,7 +22,12 @@ RemoteFile::RemoteFile(const QString &_path, bool write, bool useRA,
     lock(QMutex::NonRecursive),
     controlSock(NULL),    sock(NULL),
     query("QUERY_FILETRANSFER %1"),
-    writemode(write)
+    writemode(write),
+    pipeline(-1),         prefetchpos(0),
+    prefetcheof(false),   requests(0),
+    requested(0),         window(2 * kPipelineBlock),
+    minrtt(-1),           ratestart(0),
+    ratebytes(0),         bitrate(0.0)
 {
     if (writemode)
     {
@@ -244,6 +249,7 @@ void RemoteFile::Close(void)
     strlist << "DONE";
 
     lock.lock();
+    CancelRequests();
     if (!controlSock->SendReceiveStringList(
             strlist, 0, MythSocket::kShortTimeout))
     {
@@ -387,6 +393,7 @@ void RemoteFile::Reset(void)
         LOG(VB_NETWORK, LOG_ERR, "RemoteFile::Reset(): Called with no socket");
         return;
     }
+    CancelRequests();
     sock->Reset();
 }
 
@@ -405,6 +412,25 @@ long long RemoteFile::Seek(long long pos, int whence, long long curpos)
         return -1;
     }
 
+    if (pipeline > 0)
+    {
+        // Short forward seeks can be served from what is already here
+        long long target = -1;
+        if (whence == SEEK_SET)
+            target = pos;
+        else if (whence == SEEK_CUR &&
+                 (curpos <= 0 || curpos == readposition))
+            target = readposition + pos;
+
+        long long buffered = prefetch.size() - prefetchpos;
+        if (target >= readposition && target <= readposition + buffered)
+        {
+            prefetchpos += target - readposition;
+            readposition = target;
+            return target;
+        }
+    }
+
     QStringList strlist( QString(query).arg(recordernum) );
     strlist << "SEEK";
     strlist << QString::number(pos);
@@ -414,7 +440,23 @@ long long RemoteFile::Seek(long long pos, int whence, long long curpos)
     else
         strlist << QString::number(readposition);
 
-    bool ok = controlSock->SendReceiveStringList(strlist);
+    bool ok;
+    if (pipeline > 0 && (requests > 0 || requested > 0))
+    {
+        // Sending the SEEK first lets the backend answer the blocks still
+        // queued behind it with 0 bytes, so only the block it is already
+        // sending has to be drained.
+        ok = controlSock->WriteStringList(strlist);
+        CancelRequests();
+        strlist.clear();
+        ok = ok && controlSock->ReadStringList(strlist,
+                                               MythSocket::kLongTimeout);
+    }
+    else
+    {
+        CancelRequests();
+        ok = controlSock->SendReceiveStringList(strlist);
+    }
 
     if (ok && !strlist.empty())
     {
@@ -533,6 +575,9 @@ int RemoteFile::Read(void *data, int size)
     if (!sock->IsConnected() || !controlSock->IsConnected())
         return -1;
 
+    if (CanPipeline())
+        return ReadPipelined((char *)data, size);
+
     if (sock->IsDataAvailable())
     {
         LOG(VB_NETWORK, LOG_ERR,
@@ -611,6 +656,280 @@ int RemoteFile::Read(void *data, int size)
     return recv;
 }
 
+/**
+ * \brief Whether REQUEST_BLOCKs may be sent before the previous one has
+ *        been answered.
+ *
+ * Asked once per file. Backends that don't know CAN_PIPELINE answer "OK".
+ */
+bool RemoteFile::CanPipeline(void)
+{
+    if (pipeline >= 0)
+        return pipeline > 0;
+
+    pipeline = 0;
+    if (!usereadahead || writemode)
+        return false;
+
+    QStringList strlist( QString(query).arg(recordernum) );
+    strlist << "CAN_PIPELINE";
+
+    if (controlSock->SendReceiveStringList(strlist) &&
+        !strlist.empty() && strlist[0] == "1")
+    {
+        pipeline = 1;
+        prefetch.reserve((kMaxRequests + 1) * kPipelineBlock);
+        ratetimer.start();
+        rtttimer.start();
+    }
+
+    LOG(VB_FILE, LOG_INFO, QString("RemoteFile(%1): %2 pipelined reads")
+        .arg(path).arg(pipeline ? "using" : "not using"));
+
+    return pipeline > 0;
+}
+
+/**
+ * \brief Read() for backends that accept pipelined requests.
+ *
+ * Fixed size REQUEST_BLOCKs are kept in flight ahead of the reader, so
+ * the backend always has the next request queued when it finishes one,
+ * and throughput is no longer limited by the round trip time. How far
+ * ahead to run is set by UpdateWindow().
+ */
+int RemoteFile::ReadPipelined(char *data, int size)
+{
+    // A file that hit its end may have grown since
+    if (requests == 0)
+        prefetcheof = false;
+
+    int waitms = 10;
+    MythTimer mtimer;
+    mtimer.start();
+
+    while (prefetch.size() - prefetchpos < size)
+    {
+        UpdateWindow();
+
+        long long ahead = prefetch.size() - prefetchpos + requested;
+        while (!prefetcheof && requests < kMaxRequests &&
+               (requests == 0 || ahead < window))
+        {
+            if (!SendRequest())
+                return -1;
+            ahead += kPipelineBlock;
+        }
+
+        if (requests == 0 && requested <= 0)
+            break; // end of file
+
+        int ret = 0;
+        if (requested > 0)
+            ret = ReceiveData(size - (prefetch.size() - prefetchpos), waitms);
+
+        if (ret < 0 || !ReceiveReplies(requested <= 0))
+        {
+            CancelRequests();
+            return -1;
+        }
+
+        if (ret > 0)
+        {
+            mtimer.restart();
+            waitms = 10;
+        }
+        else if (mtimer.elapsed() > 10000)
+        {
+            LOG(VB_GENERAL, LOG_ERR, QString("RemoteFile::Read(): Timed out "
+                "waiting for %1 bytes").arg(requested));
+            CancelRequests();
+            return -1;
+        }
+        else
+        {
+            waitms += (waitms < 200) ? 20 : 0;
+        }
+    }
+
+    int count = min(size, prefetch.size() - prefetchpos);
+    memcpy(data, prefetch.constData() + prefetchpos, count);
+    prefetchpos += count;
+    readposition += count;
+
+    if (prefetchpos == prefetch.size())
+    {
+        prefetch.resize(0);
+        prefetchpos = 0;
+    }
+
+    LOG(VB_NETWORK, LOG_DEBUG,
+        QString("Read(): reqd=%1, rcvd=%2, inflight=%3 in %4, window=%5")
+            .arg(size).arg(count).arg(requested).arg(requests).arg(window));
+
+    return count;
+}
+
+bool RemoteFile::SendRequest(void)
+{
+    QStringList strlist( QString(query).arg(recordernum) );
+    strlist << "REQUEST_BLOCK";
+    strlist << QString::number(kPipelineBlock);
+
+    if (!controlSock->WriteStringList(strlist))
+    {
+        LOG(VB_NETWORK, LOG_ERR, "RemoteFile::Read(): Block request failed");
+        return false;
+    }
+
+    requests++;
+    requested += kPipelineBlock;
+    requesttimes.push_back(ratetimer.elapsed());
+    return true;
+}
+
+/// Handles the answers to pipelined requests that have arrived, or waits
+/// for one if 'wait' is set. Returns false on error.
+bool RemoteFile::ReceiveReplies(bool wait)
+{
+    while (requests > 0 && (wait || controlSock->IsDataAvailable()))
+    {
+        QStringList strlist;
+        if (!controlSock->ReadStringList(strlist, MythSocket::kShortTimeout) ||
+            strlist.empty())
+        {
+            LOG(VB_GENERAL, LOG_ERR,
+                "RemoteFile::Read(): No response from control socket.");
+            return false;
+        }
+        wait = false;
+
+        int sent = strlist[0].toInt(); // -1 on backend error
+        requests--;
+
+        int rtt = ratetimer.elapsed() - requesttimes.takeFirst();
+        if (minrtt < 0 || rtt < minrtt || rtttimer.elapsed() > 10000)
+        {
+            minrtt = rtt;
+            rtttimer.restart();
+        }
+
+        if (sent < 0)
+        {
+            LOG(VB_GENERAL, LOG_ERR, "RemoteFile::Read(): Backend error");
+            return false;
+        }
+
+        // The answers can arrive in any order, but as every request is
+        // the same size the shortfall is the same whichever this answers.
+        if (sent < kPipelineBlock)
+        {
+            requested -= kPipelineBlock - sent;
+            prefetcheof = true;
+        }
+    }
+
+    return true;
+}
+
+/// Appends whatever has arrived on the data socket to prefetch, waiting
+/// up to max_wait_ms if that is less than 'need' bytes. Returns the
+/// number of bytes received, or -1 on error.
+int RemoteFile::ReceiveData(int need, int max_wait_ms)
+{
+    if (prefetchpos > 0 && prefetchpos >= prefetch.size() / 2)
+    {
+        prefetch.remove(0, prefetchpos);
+        prefetchpos = 0;
+    }
+
+    int want = (int)min(requested, (long long)kMaxRequests * kPipelineBlock);
+    int old = prefetch.size();
+    prefetch.resize(old + want);
+
+    int ret = sock->Read(prefetch.data() + old, want, 0);
+    if (ret >= 0 && ret < need && ret < want)
+    {
+        int more = sock->Read(prefetch.data() + old + ret,
+                              min(need, want) - ret, max_wait_ms);
+        ret = (more < 0) ? -1 : ret + more;
+    }
+
+    prefetch.resize(old + max(ret, 0));
+    if (ret > 0)
+    {
+        requested -= ret;
+        ratebytes += ret;
+    }
+    return ret;
+}
+
+/**
+ * \brief Sizes the read ahead window from the measured bitrate and RTT.
+ *
+ * Twice the bandwidth delay product keeps the link busy while answers are
+ * on their way back. The measured rate can't be more than the window
+ * allows, so the window doubles until the link or the reader is the
+ * limit, and shrinks again when either slows down.
+ */
+void RemoteFile::UpdateWindow(void)
+{
+    int now = ratetimer.elapsed();
+    if (now - ratestart < 250)
+        return;
+
+    double rate = ratebytes * 1000.0 / (now - ratestart);
+    bitrate = (bitrate > 0.0) ? (0.75 * bitrate + 0.25 * rate) : rate;
+    ratestart = now;
+    ratebytes = 0;
+
+    if (minrtt < 0)
+        return;
+
+    long long bdp = (long long)(bitrate * max(minrtt, 1) / 1000.0);
+    window = (int)min(max(2 * bdp, (long long)2 * kPipelineBlock),
+                      (long long)kMaxRequests * kPipelineBlock);
+}
+
+/// Waits out any pipelined requests and throws away what they return, so
+/// the next command's answer isn't mistaken for one of theirs. Seek()
+/// sends its SEEK before calling this, which makes the backend skip the
+/// requests it hasn't started on.
+void RemoteFile::CancelRequests(void)
+{
+    if (pipeline <= 0)
+        return;
+
+    MythTimer mtimer;
+    mtimer.start();
+
+    while ((requests > 0 || requested > 0) && mtimer.elapsed() < 10000)
+    {
+        int ret = 0;
+        if (requested > 0)
+            ret = ReceiveData(1, 10);
+        prefetch.resize(prefetchpos);
+
+        if (ret < 0 || !ReceiveReplies(requested <= 0))
+            break;
+    }
+
+    if (requests > 0 || requested > 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, "RemoteFile: Unable to finish outstanding "
+            "requests, discarding");
+        sock->Reset();
+        while (controlSock->IsDataAvailable())
+            controlSock->Reset();
+    }
+
+    requests = 0;
+    requested = 0;
+    requesttimes.clear();
+    prefetch.resize(0);
+    prefetchpos = 0;
+    prefetcheof = false;
+}
+
 bool RemoteFile::SaveAs(QByteArray &data)
 {
     if (filesize < 0)
@@ -638,6 +957,8 @@ void RemoteFile::SetTimeout(bool fast)
     if (!sock->IsConnected() || !controlSock->IsConnected())
         return;
 
+    CancelRequests();
+
     QStringList strlist( QString(query).arg(recordernum) );
     strlist << "SET_TIMEOUT";
     strlist << QString::number((int)fast);
@@ -5,9 +5,12 @@
 
 #include <QDateTime>
 #include <QStringList>
+#include <QByteArray>
+#include <QList>
 #include <QMutex>
 
 #include "mythbaseexp.h"
+#include "mythtimer.h"
 
 class MythSocket;
 
@@ -53,6 +56,14 @@ class MBASE_PUBLIC RemoteFile
 
     MythSocket     *openSocket(bool control);
 
+    bool            CanPipeline(void);
+    int             ReadPipelined(char *data, int size);
+    bool            SendRequest(void);
+    bool            ReceiveReplies(bool wait);
+    int             ReceiveData(int need, int max_wait_ms);
+    void            UpdateWindow(void);
+    void            CancelRequests(void);
+
     QString         path;
     bool            usereadahead;
     int             timeout_ms;
@@ -70,6 +81,25 @@ class MBASE_PUBLIC RemoteFile
 
     QStringList     possibleauxfiles;
     QStringList     auxfiles;
+
+    // Pipelined reads, see ReadPipelined()
+    int             pipeline;       ///< -1 not asked yet, 0 no, 1 yes
+    QByteArray      prefetch;       ///< received, not yet returned by Read()
+    int             prefetchpos;    ///< start of unread data in prefetch
+    bool            prefetcheof;    ///< backend hit the end of the file
+    int             requests;       ///< REQUEST_BLOCKs not yet answered
+    long long       requested;      ///< bytes requested but not received
+    QList<int>      requesttimes;   ///< when each request was sent
+    int             window;         ///< bytes to keep prefetched/in flight
+    int             minrtt;         ///< shortest recent reply time (ms)
+    MythTimer       rtttimer;       ///< age of minrtt
+    MythTimer       ratetimer;      ///< clock for requesttimes and rate
+    int             ratestart;      ///< ratetimer value at last rate sample
+    long long       ratebytes;      ///< bytes received since ratestart
+    double          bitrate;        ///< smoothed bytes per second
+
+    static const int kPipelineBlock = 256 * 1024;
+    static const int kMaxRequests   = 8;
 };
 
 #endif
@@ -0,0 +1,337 @@
+/*
+ *  Class TestLogging
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include "mythlogging.h"
+#include "logging.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+#define MSKIP(MSG) QSKIP(MSG, SkipSingle)
+#else
+#define MSKIP(MSG) QSKIP(MSG)
+#endif
+
+/// What the drain handler does with each message, standing in for the
+/// work of the logging thread
+enum DrainMode
+{
+    kDrainDiscard = 0,
+    kDrainConsole,              ///< format it the way logConsole() does
+    kDrainRemote,               ///< serialize it for mythlogserver
+};
+
+struct DrainState
+{
+    DrainMode           mode;
+    long long           count;
+    long long           bytes;
+    QList<QByteArray>   messages;   ///< kept only in kDrainDiscard mode
+};
+
+static void drainHandler(LoggingItem *item, void *opaque)
+{
+    DrainState *state = (DrainState *)opaque;
+    state->count++;
+
+    if (state->mode == kDrainConsole)
+    {
+        char timestamp[32];
+        char line[LOGLINE_MAX + 120];
+        time_t epoch = item->epoch();
+        struct tm tm;
+        localtime_r(&epoch, &tm);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm);
+        state->bytes += snprintf(line, sizeof(line), "%s.%06u I  %s\n",
+                                 timestamp, item->usec(), item->rawMessage());
+    }
+    else if (state->mode == kDrainRemote)
+    {
+        state->bytes += item->toByteArray().size();
+    }
+    else if (item->type() & kMessage)
+    {
+        state->messages.append(QByteArray(item->rawMessage()));
+    }
+}
+
+static void keepHandler(LoggingItem *item, void *opaque)
+{
+    item->IncrRef();
+    *(LoggingItem **)opaque = item;
+}
+
+/// Empties the logging rings in the background, like LoggerThread
+class DrainThread : public QThread
+{
+  public:
+    DrainThread(DrainMode mode) : m_stop(false)
+    {
+        m_state.mode  = mode;
+        m_state.count = 0;
+        m_state.bytes = 0;
+    }
+
+    void stop(void) { m_stop = true; }
+    const DrainState &state(void) const { return m_state; }
+
+  protected:
+    void run(void)
+    {
+        while (!m_stop || !loggingRingsEmpty())
+        {
+            if (!loggingDrainRings(drainHandler, &m_state))
+                usleep(100);
+        }
+    }
+
+  private:
+    volatile bool m_stop;
+    DrainState    m_state;
+};
+
+/// Logs count numbered messages
+class LogThread : public QThread
+{
+  public:
+    LogThread(const QString &name, int count) : m_name(name), m_count(count) {}
+
+  protected:
+    void run(void)
+    {
+        for (int i = 0; i < m_count; i++)
+            LOG(VB_GENERAL, LOG_INFO, QString("%1 %2").arg(m_name).arg(i));
+    }
+
+  private:
+    QString m_name;
+    int     m_count;
+};
+
+class TestLogging: public QObject
+{
+    Q_OBJECT
+
+    static void Drain(DrainState &state)
+    {
+        state.mode  = kDrainDiscard;
+        state.count = 0;
+        state.bytes = 0;
+        state.messages.clear();
+        loggingDrainRings(drainHandler, &state);
+    }
+
+  private slots:
+    void initTestCase(void)
+    {
+        verboseMask = VB_GENERAL;
+        logLevel    = LOG_INFO;
+        logRateLimit = 0;
+    }
+
+    void init(void)
+    {
+        DrainState state;
+        Drain(state);
+    }
+
+    void WireRoundTrip(void)
+    {
+        LOG(VB_GENERAL, LOG_ERR, "wire % message");
+
+        LoggingItem *item = NULL;
+        QCOMPARE(loggingDrainRings(keepHandler, &item), 1);
+        QVERIFY(item);
+
+        item->setPid(1234);
+        item->setAppName("test_logging");
+        item->setThreadName("TestThread");
+        item->setLogFile("/tmp/test.log");
+        item->setFacility(3);
+
+        QByteArray buf = item->toByteArray();
+        QVERIFY(!buf.startsWith('{'));
+
+        LoggingItem *copy = LoggingItem::create(buf);
+        QCOMPARE(copy->pid(),        item->pid());
+        QCOMPARE(copy->tid(),        item->tid());
+        QCOMPARE(copy->threadId(),   item->threadId());
+        QCOMPARE(copy->usec(),       item->usec());
+        QCOMPARE(copy->line(),       item->line());
+        QCOMPARE(copy->type(),       item->type());
+        QCOMPARE(copy->level(),      (int)LOG_ERR);
+        QCOMPARE(copy->facility(),   3);
+        QCOMPARE(copy->epoch(),      item->epoch());
+        QCOMPARE(copy->file(),       item->file());
+        QCOMPARE(copy->function(),   item->function());
+        QCOMPARE(copy->threadName(), QString("TestThread"));
+        QCOMPARE(copy->appName(),    QString("test_logging"));
+        QCOMPARE(copy->table(),      QString(""));
+        QCOMPARE(copy->logFile(),    QString("/tmp/test.log"));
+        QCOMPARE(copy->message(),    QString("wire % message"));
+
+        copy->DecrRef();
+        item->DecrRef();
+    }
+
+    void WireTruncated(void)
+    {
+        QByteArray buf = QByteArray(1, 2) + QByteArray(10, 'x');
+        LoggingItem *item = LoggingItem::create(buf);
+        QCOMPARE(item->message(), QString(""));
+        QVERIFY(item->rawFile());
+        item->DecrRef();
+    }
+
+    void JsonFromOlderClients(void)
+    {
+        QByteArray buf("{\"pid\":42,\"level\":3,\"line\":7,"
+                       "\"file\":\"old.cpp\",\"message\":\"hello\"}");
+        LoggingItem *item = LoggingItem::create(buf);
+        QCOMPARE(item->pid(), 42);
+        QCOMPARE(item->level(), 3);
+        QCOMPARE(item->line(), 7);
+        QCOMPARE(item->file(), QString("old.cpp"));
+        QCOMPARE(item->message(), QString("hello"));
+        item->DecrRef();
+    }
+
+    void PrintfFormat(void)
+    {
+        LOG(VB_GENERAL, LOG_INFO, QString("100% done"));
+        LogPrintLine(VB_GENERAL, LOG_INFO, __FILE__, __LINE__, __FUNCTION__,
+                     0, "%d%% of %s", 50, "work");
+
+        DrainState state;
+        Drain(state);
+        QCOMPARE(state.messages.size(), 2);
+        QCOMPARE(state.messages[0], QByteArray("100% done"));
+        QCOMPARE(state.messages[1], QByteArray("50% of work"));
+    }
+
+    void OrderedAcrossThreads(void)
+    {
+        const int count = 500;
+        DrainThread drain(kDrainDiscard);
+        LogThread a("a", count), b("b", count);
+
+        drain.start();
+        a.start();
+        b.start();
+        a.wait();
+        b.wait();
+        drain.stop();
+        drain.wait();
+
+        int nexta = 0, nextb = 0;
+        QList<QByteArray>::const_iterator it = drain.state().messages.begin();
+        for (; it != drain.state().messages.end(); ++it)
+        {
+            QList<QByteArray> parts = it->split(' ');
+            if (parts[0] == "a")
+                QCOMPARE(parts[1].toInt(), nexta++);
+            else if (parts[0] == "b")
+                QCOMPARE(parts[1].toInt(), nextb++);
+        }
+        QCOMPARE(nexta, count);
+        QCOMPARE(nextb, count);
+    }
+
+    void FullRingDrops(void)
+    {
+        // Nothing drains the ring, so it fills and the rest are counted
+        int count = LogRing::kSize / 16;
+        for (int i = 0; i < count; i++)
+            LOG(VB_GENERAL, LOG_INFO, QString("fill %1").arg(i));
+
+        DrainState state;
+        Drain(state);
+        QVERIFY(state.messages.size() < count);
+        QVERIFY(state.messages.last().contains("dropped"));
+        QVERIFY(loggingRingsEmpty());
+    }
+
+    void RateLimit(void)
+    {
+        logRateLimit = 5;
+
+        // Start at the beginning of a second so the window doesn't move
+        time_t start = time(NULL);
+        while (time(NULL) == start)
+            usleep(1000);
+
+        int passed = 0;
+        for (int i = 0; i < 20; i++)
+            passed += logRateCheck(VB_RECORD, LOG_INFO) ? 1 : 0;
+        QCOMPARE(passed, 5);
+
+        // Other flags have their own count, warnings are never limited
+        QVERIFY(logRateCheck(VB_CHANNEL, LOG_INFO));
+        QVERIFY(logRateCheck(VB_RECORD | VB_EXTRA, LOG_WARNING));
+        QVERIFY(logRateCheck(VB_RECORD, LOG_ERR));
+
+        logRateLimit = 0;
+    }
+
+    void Throughput_data(void)
+    {
+        QTest::addColumn<bool>("enabled");
+        QTest::addColumn<int>("mode");
+        QTest::newRow("disabled") << false << (int)kDrainDiscard;
+        QTest::newRow("enabled-local") << true << (int)kDrainConsole;
+        QTest::newRow("enabled-remote") << true << (int)kDrainRemote;
+    }
+
+    void Throughput(void)
+    {
+        QFETCH(bool, enabled);
+        QFETCH(int, mode);
+        const int count = 200000;
+
+        verboseMask = enabled ? (VB_GENERAL | VB_RECORD) : VB_GENERAL;
+
+        DrainThread drain((DrainMode)mode);
+        drain.start();
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < count; i++)
+        {
+            LOG(VB_RECORD, LOG_INFO,
+                QString("Recording channel %1 at offset %2").arg(i).arg(i * 7));
+        }
+        qint64 nsecs = timer.nsecsElapsed();
+
+        drain.stop();
+        drain.wait();
+        verboseMask = VB_GENERAL;
+
+        qDebug("%s: %.1f ns/LOG, %lld of %d handled, %lld bytes out",
+               QTest::currentDataTag(), (double)nsecs / count,
+               drain.state().count, count, drain.state().bytes);
+        if (!enabled)
+            QCOMPARE(drain.state().count, 0LL);
+        else
+            QVERIFY(drain.state().count > 0);
+    }
+};
@@ -0,0 +1,76 @@
+/*
+ *  Class TestMythMetrics
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <QtTest/QtTest>
+
+#include "mythmetrics.h"
+
+class TestMythMetrics: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void CountersAdd(void)
+    {
+        MythMetrics::Add("test_add_total", 2);
+        MythMetrics::Add("test_add_total", 3.5);
+        QCOMPARE(MythMetrics::Value("test_add_total"), 5.5);
+        QCOMPARE(MythMetrics::Value("test_missing"), 0.0);
+    }
+
+    void SeriesByLabel(void)
+    {
+        QString card1 = MythMetrics::Label("cardid", "1");
+        QString card2 = MythMetrics::Label("cardid", "2");
+
+        MythMetrics::Set("test_series", 10, card1);
+        MythMetrics::Set("test_series", 20, card2);
+        MythMetrics::Set("test_series", 15, card1);
+
+        QCOMPARE(MythMetrics::Value("test_series", card1), 15.0);
+        QCOMPARE(MythMetrics::Value("test_series", card2), 20.0);
+
+        MythMetrics::Remove("test_series", card2);
+        QCOMPARE(MythMetrics::Value("test_series", card2), 0.0);
+        QVERIFY(!MythMetrics::ToText().contains("cardid=\"2\""));
+    }
+
+    void LabelEscaping(void)
+    {
+        QCOMPARE(MythMetrics::Label("fs", "a\"b\\c\nd"),
+                 QString("fs=\"a\\\"b\\\\c\\nd\""));
+    }
+
+    void TextFormat(void)
+    {
+        MythMetrics::Describe("test_format_bytes_total", MythMetrics::kCounter,
+                              "Bytes written.");
+        MythMetrics::Add("test_format_bytes_total", 4096,
+                         MythMetrics::Label("cardid", "3"));
+        MythMetrics::Set("test_format_ratio", 0.25);
+
+        QString text = MythMetrics::ToText();
+
+        QVERIFY(text.contains("# HELP test_format_bytes_total Bytes written.\n"
+                              "# TYPE test_format_bytes_total counter\n"
+                              "test_format_bytes_total{cardid=\"3\"} 4096\n"));
+        QVERIFY(text.contains("# TYPE test_format_ratio gauge\n"
+                              "test_format_ratio 0.25\n"));
+        QVERIFY(text.endsWith("\n"));
+    }
+};
@@ -0,0 +1,10 @@
+#include "test_mythsocket.h"
+
+// MythSocket runs its QTcpSocket on an event loop thread, which needs a
+// QCoreApplication; QTEST_MAIN would want a GUI under Qt4.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    TestMythSocket test;
+    return QTest::qExec(&test, argc, argv);
+}
@@ -0,0 +1,297 @@
+/*
+ *  Class TestMythSocket
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <vector>
+using namespace std;
+
+#include <QtTest/QtTest>
+#include <QTemporaryFile>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include "mythcorecontext.h"
+#include "mythsocket.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+#define MSKIP(MSG) QSKIP(MSG, SkipSingle)
+#else
+#define MSKIP(MSG) QSKIP(MSG)
+#endif
+
+/// Reads everything sent to a socket and checks it against the file it
+/// should have come from
+class SocketSink : public QThread
+{
+  public:
+    SocketSink(int fd, int filefd, long long offset, long long expect,
+               const QByteArray &header = QByteArray()) :
+        m_fd(fd), m_filefd(filefd), m_offset(offset), m_expect(expect),
+        m_header(header), m_received(0), m_matches(true) {}
+
+    long long Received(void) const { return m_received; }
+    bool Matches(void) const { return m_matches; }
+
+  protected:
+    void run(void)
+    {
+        vector<char> buf(256 * 1024);
+        vector<char> want(buf.size());
+        long long total = m_header.size() + m_expect;
+
+        while (m_received < total)
+        {
+            ssize_t n = recv(m_fd, &buf[0],
+                             min((long long)buf.size(), total - m_received),
+                             0);
+            if (n <= 0)
+                break;
+
+            if (m_matches)
+                m_matches = Check(&buf[0], n, want);
+            m_received += n;
+        }
+    }
+
+    bool Check(const char *data, int len, vector<char> &want) const
+    {
+        long long pos = m_received;
+        int hlen = m_header.size();
+        for (; len > 0 && pos < hlen; data++, len--, pos++)
+        {
+            if (*data != m_header[(int)pos])
+                return false;
+        }
+        if (len <= 0)
+            return true;
+
+        if (pread(m_filefd, &want[0], len, m_offset + pos - hlen) != len)
+            return false;
+        return memcmp(data, &want[0], len) == 0;
+    }
+
+  private:
+    int        m_fd;
+    int        m_filefd;
+    long long  m_offset;
+    long long  m_expect;
+    QByteArray m_header;
+    long long  m_received;
+    bool       m_matches;
+};
+
+class TestMythSocket: public QObject
+{
+    Q_OBJECT
+
+    static const int kFileSize  = 32 * 1024 * 1024;
+    static const int kBlockSize = 256 * 1024;   ///< largest REQUEST_BLOCK
+
+    QTemporaryFile m_file;
+    int            m_filefd;
+
+    /// Connects two TCP sockets over the loopback interface
+    static bool MakeSocketPair(int &a, int &b)
+    {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0)
+            return false;
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t len = sizeof(addr);
+
+        a = b = -1;
+        if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+            listen(listener, 1) == 0 &&
+            getsockname(listener, (struct sockaddr*)&addr, &len) == 0)
+        {
+            a = socket(AF_INET, SOCK_STREAM, 0);
+            if (a >= 0 &&
+                ::connect(a, (struct sockaddr*)&addr, sizeof(addr)) == 0)
+            {
+                b = accept(listener, NULL, NULL);
+            }
+        }
+        close(listener);
+
+        if (b < 0 && a >= 0)
+        {
+            close(a);
+            a = -1;
+        }
+        return b >= 0;
+    }
+
+  private slots:
+    // called at the beginning of these sets of tests
+    void initTestCase(void)
+    {
+        gCoreContext = new MythCoreContext("bin_version", NULL);
+
+        QVERIFY(m_file.open());
+        QByteArray block(1024 * 1024, 0);
+        for (int i = 0; i < kFileSize / block.size(); i++)
+        {
+            for (int j = 0; j < block.size(); j++)
+                block[j] = (char)((i * 131 + j * 7 + (j >> 9)) & 0xff);
+            QCOMPARE(m_file.write(block), (qint64)block.size());
+        }
+        m_file.flush();
+
+        m_filefd = open(m_file.fileName().toLocal8Bit().constData(),
+                        O_RDONLY);
+        QVERIFY(m_filefd >= 0);
+    }
+
+    // called at the end of these sets of tests
+    void cleanupTestCase(void)
+    {
+        close(m_filefd);
+    }
+
+    // data written before the file must arrive first, and the file
+    // contents must arrive intact from an unaligned offset
+    void SendFileAfterWrite(void)
+    {
+        int a, b;
+        QVERIFY(MakeSocketPair(a, b));
+
+        MythSocket *sock = new MythSocket(a);
+        QByteArray header("header before the file data");
+        long long offset = 4096 + 3;
+        int size = 3 * kBlockSize + 17;
+
+        SocketSink sink(b, m_filefd, offset, size, header);
+        sink.start();
+
+        QCOMPARE(sock->Write(header.constData(), header.size()),
+                 header.size());
+        int ret = sock->SendFile(m_filefd, offset, size);
+        if (ret == MythSocket::kSendFileUnsupported)
+        {
+            sink.terminate();
+            sink.wait();
+            sock->DecrRef();
+            close(b);
+            MSKIP("sendfile() not supported on this platform");
+        }
+        QCOMPARE(ret, size);
+
+        QVERIFY(sink.wait(10000));
+        QCOMPARE(sink.Received(), (long long)(header.size() + size));
+        QVERIFY(sink.Matches());
+
+        sock->DecrRef();
+        close(b);
+    }
+
+    // a request running past the end of the file is cut short
+    void SendFileStopsAtEOF(void)
+    {
+        int a, b;
+        QVERIFY(MakeSocketPair(a, b));
+
+        MythSocket *sock = new MythSocket(a);
+        long long offset = kFileSize - 1000;
+
+        SocketSink sink(b, m_filefd, offset, 1000);
+        sink.start();
+
+        int ret = sock->SendFile(m_filefd, offset, kBlockSize);
+        if (ret != MythSocket::kSendFileUnsupported)
+        {
+            QCOMPARE(ret, 1000);
+            QVERIFY(sink.wait(10000));
+            QVERIFY(sink.Matches());
+        }
+
+        sock->DecrRef();
+        if (!sink.wait(10000))
+            sink.terminate();
+        close(b);
+    }
+
+    void Throughput_data(void)
+    {
+        QTest::addColumn<bool>("useSendFile");
+        QTest::newRow("sendfile") << true;
+        QTest::newRow("read + Write") << false;
+    }
+
+    // streams the whole file in REQUEST_BLOCK sized pieces, the way
+    // FileTransfer::RequestBlock() does, and reports MB/s
+    void Throughput(void)
+    {
+        QFETCH(bool, useSendFile);
+
+        int a, b;
+        QVERIFY(MakeSocketPair(a, b));
+
+        MythSocket *sock = new MythSocket(a);
+        SocketSink sink(b, m_filefd, 0, kFileSize);
+        vector<char> buf(kBlockSize);
+
+        QElapsedTimer timer;
+        timer.start();
+        sink.start();
+
+        bool ok = true;
+        for (long long pos = 0; ok && pos < kFileSize; pos += kBlockSize)
+        {
+            if (useSendFile)
+            {
+                ok = sock->SendFile(m_filefd, pos, kBlockSize) == kBlockSize;
+            }
+            else
+            {
+                ok = (pread(m_filefd, &buf[0], kBlockSize, pos) ==
+                      kBlockSize) &&
+                    (sock->Write(&buf[0], kBlockSize) == kBlockSize);
+            }
+        }
+
+        if (!ok && useSendFile)
+        {
+            sock->DecrRef();
+            close(b);
+            sink.wait();
+            MSKIP("sendfile() not supported on this platform");
+        }
+        QVERIFY(ok);
+        QVERIFY(sink.wait(30000));
+        qint64 elapsed = qMax(timer.elapsed(), (qint64)1);
+
+        QCOMPARE(sink.Received(), (long long)kFileSize);
+        QVERIFY(sink.Matches());
+
+        qDebug("%s: %.1f MB/s", useSendFile ? "sendfile" : "read + Write",
+               (double)kFileSize / (1024 * 1024) * 1000 / elapsed);
+
+        sock->DecrRef();
+        close(b);
+    }
+};
@@ -2,6 +2,8 @@
 #include <vector>
 #include <map>
 
+#include <QStringList>
+
 #include "mythdb.h"
 #include "cleanup.h"
 #include "dbaccess.h"
@@ -378,6 +380,31 @@ class MultiValueImp
         }
     }
 
+    void remove(const QList<int> &ids)
+    {
+        QStringList idlist;
+        for (QList<int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+        {
+            id_map::iterator p = m_val_map.find(*it);
+            if (p != m_val_map.end())
+            {
+                idlist << QString::number(p->first);
+                m_val_map.erase(p);
+            }
+        }
+
+        if (idlist.isEmpty())
+            return;
+
+        MSqlQuery query(MSqlQuery::InitCon());
+        QString del_query = QString("DELETE FROM %1 WHERE %2 IN (%3)")
+                .arg(m_table_name).arg(m_id_name).arg(idlist.join(","));
+        if (!query.exec(del_query) || !query.isActive())
+        {
+            MythDB::DBError("multivalue remove", query);
+        }
+    }
+
     bool exists(int id, int value)
     {
         id_map::iterator p = m_val_map.find(id);
@@ -472,6 +499,12 @@ void MultiValue::remove(int id)
     m_imp->remove(id);
 }
 
+/// \brief Removes every value of several ids with a single query.
+void MultiValue::remove(const QList<int> &ids)
+{
+    m_imp->remove(ids);
+}
+
 bool MultiValue::exists(int id, int value)
 {
     return m_imp->exists(id, value);
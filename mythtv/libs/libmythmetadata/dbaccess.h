@@ -4,6 +4,8 @@
 #include <vector>
 #include <utility> // for std::pair
 
+#include <QList>
+
 #include "mythmetaexp.h"
 
 class SingleValueImp;
@@ -49,6 +51,7 @@ class META_PUBLIC MultiValue
     bool get(int id, entry &values);
     void remove(int id, int value);
     void remove(int id);
+    void remove(const QList<int> &ids);
     bool exists(int id, int value);
     bool exists(int id);
 
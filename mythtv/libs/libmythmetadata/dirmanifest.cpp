@@ -0,0 +1,199 @@
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QMutexLocker>
+#include <QFile>
+
+#include "mythdirs.h"
+#include "mythlogging.h"
+#include "dirmanifest.h"
+
+#define LOC QString("DirManifest: ")
+
+static const quint32 kManifestMagic   = 0x4d56534d; // "MVSM"
+static const qint32  kManifestVersion = 1;
+
+DirectoryManifest::DirectoryManifest(const QString &filename) :
+    m_filename(filename)
+{
+}
+
+/// Each program keeps its own, as they may scan different directories
+QString DirectoryManifest::DefaultFilename(void)
+{
+    return QString("%1/videoscan-%2.manifest")
+        .arg(GetConfDir()).arg(QCoreApplication::applicationName());
+}
+
+/// \brief Reads the manifest saved by the last scan, if there is one.
+bool DirectoryManifest::Load(void)
+{
+    QMutexLocker locker(&m_lock);
+    m_records.clear();
+
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic;
+    qint32 version;
+    in >> magic >> version;
+    if (magic != kManifestMagic || version != kManifestVersion)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            QString("Ignoring '%1', it is not a version %2 manifest")
+                .arg(m_filename).arg(kManifestVersion));
+        return false;
+    }
+
+    quint32 count;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+    {
+        QString dir;
+        quint32 entries;
+        Record record;
+        in >> dir >> record.mtime >> record.listed >> entries;
+        for (quint32 j = 0; j < entries && in.status() == QDataStream::Ok; ++j)
+        {
+            Entry entry;
+            in >> entry.name >> entry.isDir;
+            record.entries.push_back(entry);
+        }
+        record.seen = false;
+        m_records.insert(dir, record);
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        LOG(VB_GENERAL, LOG_WARNING, LOC +
+            QString("'%1' is truncated, rescanning everything")
+                .arg(m_filename));
+        m_records.clear();
+        return false;
+    }
+
+    LOG(VB_GENERAL, LOG_INFO, LOC +
+        QString("Loaded %1 directories").arg(m_records.size()));
+    return true;
+}
+
+/** \brief Writes out the directories seen by this scan.
+ *
+ *  Directories that were not seen have been removed, or are no longer
+ *  video directories, so they are dropped from the manifest. The file is
+ *  replaced only once it has been written in full, so a scan that dies
+ *  half way through does not leave a broken manifest behind.
+ */
+bool DirectoryManifest::Save(void)
+{
+    QMutexLocker locker(&m_lock);
+
+    QString tmpname = m_filename + ".tmp";
+    QFile file(tmpname);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to write '%1'").arg(tmpname) + ENO);
+        return false;
+    }
+
+    QMap<QString, Record>::iterator rit = m_records.begin();
+    while (rit != m_records.end())
+    {
+        if ((*rit).seen)
+            ++rit;
+        else
+            rit = m_records.erase(rit);
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << kManifestMagic << kManifestVersion << (quint32)m_records.size();
+
+    QMap<QString, Record>::const_iterator it = m_records.begin();
+    for (; it != m_records.end(); ++it)
+    {
+        out << it.key() << (*it).mtime << (*it).listed
+            << (quint32)(*it).entries.size();
+        EntryList::const_iterator eit = (*it).entries.begin();
+        for (; eit != (*it).entries.end(); ++eit)
+            out << (*eit).name << (*eit).isDir;
+    }
+
+    file.close();
+    if (out.status() != QDataStream::Ok || file.error() != QFile::NoError)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Error writing '%1'").arg(tmpname));
+        QFile::remove(tmpname);
+        return false;
+    }
+
+    QFile::remove(m_filename);
+    if (!QFile::rename(tmpname, m_filename))
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to rename '%1' to '%2'")
+                .arg(tmpname).arg(m_filename));
+        return false;
+    }
+
+    return true;
+}
+
+/** \brief Gets the recorded contents of a directory, if it has not changed
+ *         since they were read.
+ *
+ *  \param dir     path of the directory
+ *  \param mtime   its current modification time
+ *  \param entries filled in with the files and directories in it
+ *  \return false when the directory has to be listed again
+ */
+bool DirectoryManifest::Lookup(const QString &dir, uint mtime,
+                               EntryList &entries)
+{
+    QMutexLocker locker(&m_lock);
+
+    QMap<QString, Record>::iterator it = m_records.find(dir);
+    if (it == m_records.end())
+        return false;
+
+    (*it).seen = true;
+
+    // A change made in the same second as the listing would not move the
+    // modification time on, so only trust listings made after it
+    if ((*it).mtime != mtime || (*it).listed <= mtime + 1)
+        return false;
+
+    entries = (*it).entries;
+    return true;
+}
+
+/** \brief Records the contents of a directory.
+ *
+ *  \param dir     path of the directory
+ *  \param mtime   its modification time before it was listed
+ *  \param listed  when the listing was started
+ *  \param entries the files and directories in it
+ */
+void DirectoryManifest::Update(const QString &dir, uint mtime, uint listed,
+                               const EntryList &entries)
+{
+    QMutexLocker locker(&m_lock);
+
+    Record &record = m_records[dir];
+    record.mtime   = mtime;
+    record.listed  = listed;
+    record.seen    = true;
+    record.entries = entries;
+}
+
+/// \brief Directories in the manifest, for watching for changes.
+QStringList DirectoryManifest::GetDirs(void) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_records.keys();
+}
@@ -0,0 +1,60 @@
+#ifndef DIRMANIFEST_H_
+#define DIRMANIFEST_H_
+
+#include <QStringList>
+#include <QMutex>
+#include <QList>
+#include <QMap>
+
+#include "mythmetaexp.h"
+
+/** \class DirectoryManifest
+ *  \brief Remembers what was in each video directory at the last scan.
+ *
+ *   Adding, removing or renaming anything in a directory changes its
+ *   modification time, so as long as that time is the same as when the
+ *   directory was last listed, the recorded contents can be used instead
+ *   of listing it again. This turns a rescan of an unchanged library on a
+ *   network share into one stat() per directory.
+ *
+ *   The manifest is kept in a file in the configuration directory between
+ *   scans, and can be used by several scanning threads at once.
+ */
+class META_PUBLIC DirectoryManifest
+{
+  public:
+    struct Entry
+    {
+        QString name;
+        bool    isDir;
+    };
+    typedef QList<Entry> EntryList;
+
+    DirectoryManifest(const QString &filename = DefaultFilename());
+
+    bool Load(void);
+    bool Save(void);
+
+    bool Lookup(const QString &dir, uint mtime, EntryList &entries);
+    void Update(const QString &dir, uint mtime, uint listed,
+                const EntryList &entries);
+
+    QStringList GetDirs(void) const;
+
+    static QString DefaultFilename(void);
+
+  private:
+    struct Record
+    {
+        uint      mtime;    ///< modification time of the directory
+        uint      listed;   ///< when the entries were read
+        bool      seen;     ///< looked up or updated by this scan
+        EntryList entries;
+    };
+
+    mutable QMutex        m_lock;
+    QString               m_filename;
+    QMap<QString, Record> m_records;
+};
+
+#endif // DIRMANIFEST_H_
@@ -1,5 +1,10 @@
 #include <map>
 
+#include <QWaitCondition>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QAtomicInt>
+#include <QRunnable>
 #include <QDir>
 #include <QUrl>
 
@@ -11,6 +16,12 @@
 #include "mythlogging.h"
 #include "videoutils.h"
 #include "storagegroup.h"
+#include "mthreadpool.h"
+#include "dirmanifest.h"
+
+/// Threads listing directories at once, most of the time is spent waiting
+/// for the disk or the network
+static const int kScanThreads = 8;
 
 DirectoryHandler::~DirectoryHandler()
 {
@@ -114,9 +125,9 @@ namespace
         return true;
     }
 
-    bool scan_sg_dir(const QString &start_path, const QString &host,
-                     const QString &base_path, DirectoryHandler *handler,
-                     const ext_lookup &ext_settings, bool isMaster = false)
+    /// Path of a directory within its storage group, as used in the URLs
+    QString sg_relative_path(const QString &start_path,
+                             const QString &base_path)
     {
         QString path = start_path;
 
@@ -129,6 +140,61 @@ namespace
         if (path == "/")
             path = "";
 
+        return path;
+    }
+
+    bool is_disc_dir(const QString &fileName)
+    {
+        return fileName.endsWith("VIDEO_TS") || fileName.endsWith("BDMV");
+    }
+
+    /// Passes a file in a storage group directory on to the handler. A
+    /// VIDEO_TS or BDMV directory stands for the directory it is in.
+    void handle_sg_file(QString path, QString fileName, const QString &host,
+                        DirectoryHandler *handler)
+    {
+        QFileInfo fi(fileName);
+        QString suffix;
+        QString URL;
+
+        if (is_disc_dir(fileName))
+        {
+            if (path.startsWith("/"))
+                path = path.right(path.length() - 1);
+            if (path.endsWith("/"))
+                path = path.left(path.length() - 1);
+            QStringList upDirs = path.split("/");
+            if (upDirs.count() > 1)
+                fileName = upDirs.takeLast();
+            else
+                fileName = path;
+            suffix = "";
+            URL = path;
+        }
+        else
+        {
+            suffix = fi.suffix();
+            URL = QString("%1/%2").arg(path).arg(fileName);
+        }
+
+        URL.replace("//","/");
+
+        if (URL.startsWith("/"))
+            URL = URL.right(URL.length() - 1);
+#if 0
+        LOG(VB_GENERAL, LOG_GENERAL,
+            QString(" -- File Filename: %1 URL: %2 Suffix: %3 Host: %4")
+                .arg(fileName).arg(URL).arg(suffix).arg(QString(host)));
+#endif
+        handler->handleFile(fileName, URL, fi.suffix(), QString(host));
+    }
+
+    bool scan_sg_dir(const QString &start_path, const QString &host,
+                     const QString &base_path, DirectoryHandler *handler,
+                     const ext_lookup &ext_settings, bool isMaster = false)
+    {
+        QString path = sg_relative_path(start_path, base_path);
+
         QStringList list;
         bool ok = false;
 
@@ -166,9 +232,7 @@ namespace
             if ((type != "dir") &&
                 ext_settings.extension_ignored(fi.suffix())) continue;
 
-            if (type == "dir" &&
-                !fileName.endsWith("VIDEO_TS") &&
-                !fileName.endsWith("BDMV"))
+            if (type == "dir" && !is_disc_dir(fileName))
             {
 #if 0
                 LOG(VB_GENERAL, LOG_DEBUG,
@@ -187,44 +251,227 @@ namespace
             }
             else
             {
-                QString suffix;
-                QString URL;
+                handle_sg_file(path, fileName, host, handler);
+            }
+        }
+
+        return true;
+    }
+
+    /// A directory waiting to be scanned by ScanVideoDirectories()
+    struct ScanItem
+    {
+        QString path;       ///< local path, or path on the storage group host
+        QString base_path;  ///< storage group directory the path is in
+        QString host;       ///< storage group host, empty for a local path
+        bool    sg_scan;    ///< scan the whole storage group with scan_sg_dir
+        bool    is_master;  ///< the storage group is on this, the master host
+        int     start;      ///< index of the start path this is under
+        bool    top;        ///< the start path itself
+    };
+
+    /// Lists directories on several threads, passing the files to a handler
+    class ParallelScan
+    {
+      public:
+        ParallelScan(DirectoryHandler *handler, const ext_lookup &ext_settings,
+                     DirectoryManifest *manifest) :
+            m_handler(handler), m_ext_settings(ext_settings),
+            m_manifest(manifest), m_busy(0), m_listed(0), m_unchanged(0)
+        {
+        }
+
+        void Add(const ScanItem &item)
+        {
+            QMutexLocker locker(&m_lock);
+            m_queue.push_back(item);
+            m_wait.wakeOne();
+        }
+
+        /// Scans directories until there are none left to scan
+        void Run(void)
+        {
+            QMutexLocker locker(&m_lock);
+            while (true)
+            {
+                while (m_queue.empty() && m_busy > 0)
+                    m_wait.wait(locker.mutex());
+                if (m_queue.empty())
+                    break;
+
+                ScanItem item = m_queue.takeFirst();
+                m_busy++;
+                locker.unlock();
+
+                bool ok = Scan(item);
+
+                locker.relock();
+                m_busy--;
+                if (!ok && item.top)
+                    m_failed.push_back(item.start);
+                if (m_queue.empty() && m_busy == 0)
+                    m_wait.wakeAll();
+            }
+        }
+
+        QList<int> GetFailed(void) const { return m_failed; }
+        int GetListed(void) const { return m_listed; }
+        int GetUnchanged(void) const { return m_unchanged; }
+
+      private:
+        bool Scan(const ScanItem &item)
+        {
+            if (item.sg_scan)
+            {
+                return scan_sg_dir(item.path, item.host, item.base_path,
+                                   m_handler, m_ext_settings, item.is_master);
+            }
+
+            DirectoryManifest::EntryList entries;
+            if (!List(item.path, entries))
+                return false;
+
+            if (item.host.isEmpty())
+                HandleLocal(item, entries);
+            else
+                HandleStorageGroup(item, entries);
+
+            return true;
+        }
+
+        /// Reads a directory, or gets it from the manifest if unchanged
+        bool List(const QString &path, DirectoryManifest::EntryList &entries)
+        {
+            QFileInfo info(path);
+            if (!info.isDir())
+                return false;
+
+            uint mtime = info.lastModified().toTime_t();
+            if (m_manifest && m_manifest->Lookup(path, mtime, entries))
+            {
+                m_unchanged.ref();
+                return true;
+            }
+
+            uint listed = QDateTime::currentDateTime().toTime_t();
+
+            QDir d(path);
+            d.setFilter(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+            QFileInfoList list = d.entryInfoList();
+            for (QFileInfoList::iterator p = list.begin(); p != list.end(); ++p)
+            {
+                DirectoryManifest::Entry entry;
+                entry.name  = p->fileName();
+                entry.isDir = p->isDir();
+                entries.push_back(entry);
+            }
 
-                if (fileName.endsWith("VIDEO_TS") || fileName.endsWith("BDMV"))
+            if (m_manifest)
+                m_manifest->Update(path, mtime, listed, entries);
+            m_listed.ref();
+            return true;
+        }
+
+        /// Same as scan_dir(), but queues the subdirectories
+        void HandleLocal(const ScanItem &item,
+                         const DirectoryManifest::EntryList &entries)
+        {
+            DirectoryManifest::EntryList::const_iterator p;
+
+            // A directory holding a DVD or Blu-ray is a single video
+            if (!item.top)
+            {
+                for (p = entries.begin(); p != entries.end(); ++p)
                 {
-                    if (path.startsWith("/"))
-                        path = path.right(path.length() - 1);
-                    if (path.endsWith("/"))
-                        path = path.left(path.length() - 1);
-                    QStringList upDirs = path.split("/");
-                    if (upDirs.count() > 1)
-                        fileName = upDirs.takeLast();
-                    else
-                        fileName = path;
-                    suffix = "";
-                    URL = path;
+                    if (p->isDir &&
+                        (p->name == "VIDEO_TS" || p->name == "BDMV"))
+                    {
+                        QFileInfo fi(item.path);
+                        m_handler->handleFile(fi.fileName(), item.path,
+                                              fi.suffix(), "");
+                        return;
+                    }
                 }
-                else
+            }
+
+            QString prefix = item.path.endsWith("/") ?
+                item.path : item.path + "/";
+
+            for (p = entries.begin(); p != entries.end(); ++p)
+            {
+                if (p->name == "Thumbs.db")
+                    continue;
+
+                if (p->isDir)
                 {
-                    suffix = fi.suffix();
-                    URL = QString("%1/%2").arg(path).arg(fileName);
+                    ScanItem sub = item;
+                    sub.path = prefix + p->name;
+                    sub.top  = false;
+                    Add(sub);
+                    continue;
                 }
 
-                URL.replace("//","/");
+                QFileInfo fi(p->name);
+                if (m_ext_settings.extension_ignored(fi.suffix()))
+                    continue;
 
-                if (URL.startsWith("/"))
-                    URL = URL.right(URL.length() - 1);
-#if 0
-                LOG(VB_GENERAL, LOG_GENERAL,
-                    QString(" -- File Filename: %1 URL: %2 Suffix: %3 Host: %4")
-                        .arg(fileName).arg(URL).arg(suffix).arg(QString(host)));
-#endif
-                handler->handleFile(fileName, URL, fi.suffix(), QString(host));
+                m_handler->handleFile(p->name, prefix + p->name,
+                                      fi.suffix(), "");
             }
         }
 
-        return true;
-    }
+        /// Same as scan_sg_dir() on the master, but queues the subdirectories
+        void HandleStorageGroup(const ScanItem &item,
+                                const DirectoryManifest::EntryList &entries)
+        {
+            QString path = sg_relative_path(item.path, item.base_path);
+
+            DirectoryManifest::EntryList::const_iterator p;
+            for (p = entries.begin(); p != entries.end(); ++p)
+            {
+                if (p->name == "Thumbs.db")
+                    continue;
+
+                if (!p->isDir &&
+                    m_ext_settings.extension_ignored(QFileInfo(p->name).suffix()))
+                    continue;
+
+                if (p->isDir && !is_disc_dir(p->name))
+                {
+                    ScanItem sub = item;
+                    sub.path = item.path + "/" + p->name;
+                    sub.top  = false;
+                    Add(sub);
+                }
+                else
+                {
+                    handle_sg_file(path, p->name, item.host, m_handler);
+                }
+            }
+        }
+
+        DirectoryHandler   *m_handler;
+        const ext_lookup   &m_ext_settings;
+        DirectoryManifest  *m_manifest;
+
+        QMutex              m_lock;
+        QWaitCondition      m_wait;
+        QList<ScanItem>     m_queue;
+        int                 m_busy;     ///< threads scanning a directory
+        QList<int>          m_failed;   ///< start paths that failed
+        QAtomicInt          m_listed;
+        QAtomicInt          m_unchanged;
+    };
+
+    class ScanRunnable : public QRunnable
+    {
+      public:
+        ScanRunnable(ParallelScan &scan) : m_scan(scan) {}
+        void run(void) { m_scan.Run(); }
+
+      private:
+        ParallelScan &m_scan;
+    };
 }
 
 bool ScanVideoDirectory(const QString &start_path, DirectoryHandler *handler,
@@ -271,3 +518,92 @@ bool ScanVideoDirectory(const QString &start_path, DirectoryHandler *handler,
 
     return pathScanned;
 }
+
+/** \brief Scans several video directories at once.
+ *
+ *  Local directories, and storage group directories on this host when it
+ *  is the master, are walked by a pool of threads that each list one
+ *  subdirectory at a time, which keeps a network share busy. Storage groups
+ *  on other hosts are each scanned by one of the threads.
+ *
+ *  \param handler  receives the files, from several threads at once.
+ *                  newDir() is not called for the directories walked here.
+ *  \param manifest if not NULL, directories that have not changed since
+ *                  the last scan are not listed again, and the ones that
+ *                  have are recorded in it.
+ *  \param failed_paths filled in with the start paths that could not be
+ *                  scanned
+ */
+bool ScanVideoDirectories(const QStringList &start_paths,
+        DirectoryHandler *handler,
+        const FileAssociations::ext_ignore_list &ext_disposition,
+        bool list_unknown_extensions, DirectoryManifest *manifest,
+        QStringList &failed_paths)
+{
+    if (start_paths.isEmpty())
+        return true;
+
+    ext_lookup extlookup(ext_disposition, list_unknown_extensions);
+    ParallelScan scan(handler, extlookup, manifest);
+
+    for (int i = 0; i < start_paths.size(); ++i)
+    {
+        const QString &start_path = start_paths[i];
+
+        ScanItem item;
+        item.sg_scan   = false;
+        item.is_master = false;
+        item.start     = i;
+        item.top       = true;
+
+        if (!start_path.startsWith("myth://"))
+        {
+            LOG(VB_GENERAL, LOG_INFO,
+                QString("MythVideo::ScanVideoDirectories Scanning (%1)")
+                    .arg(start_path));
+            item.path = QDir::cleanPath(QDir(start_path).absolutePath());
+        }
+        else
+        {
+            LOG(VB_GENERAL, LOG_INFO,
+                QString("MythVideo::ScanVideoDirectories Scanning Group (%1)")
+                    .arg(start_path));
+            QUrl sgurl = start_path;
+            item.host      = sgurl.host();
+            item.path      = sgurl.path();
+            item.base_path = item.path;
+            item.is_master = gCoreContext->IsMasterHost(item.host) &&
+                (gCoreContext->GetHostName().toLower() ==
+                 item.host.toLower());
+            // The storage group directories of this host can be walked
+            // like local ones, unless the whole group was asked for
+            item.sg_scan   = !item.is_master ||
+                item.path.isEmpty() || item.path == "/";
+        }
+
+        scan.Add(item);
+    }
+
+    MThreadPool pool("VideoScan");
+    pool.setMaxThreadCount(kScanThreads);
+    for (int i = 0; i < kScanThreads; ++i)
+        pool.start(new ScanRunnable(scan), QString("VideoScan%1").arg(i));
+    pool.waitForDone();
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("MythVideo::ScanVideoDirectories Listed %1 directories, "
+                "%2 unchanged since the last scan")
+            .arg(scan.GetListed()).arg(scan.GetUnchanged()));
+
+    QList<int> failed = scan.GetFailed();
+    for (QList<int>::const_iterator it = failed.begin();
+         it != failed.end(); ++it)
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            QString("MythVideo::ScanVideoDirectories failed to scan %1")
+                .arg(start_paths[*it]));
+        failed_paths.push_back(start_paths[*it]);
+    }
+
+    return failed.isEmpty();
+}
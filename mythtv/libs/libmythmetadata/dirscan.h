@@ -1,8 +1,12 @@
 #ifndef DIRSCAN_H_
 #define DIRSCAN_H_
 
+#include <QStringList>
+
 #include "mythmetaexp.h"
 
+class DirectoryManifest;
+
 class META_PUBLIC DirectoryHandler
 {
   public:
@@ -19,4 +23,10 @@ META_PUBLIC bool ScanVideoDirectory(const QString &start_path, DirectoryHandler
         const FileAssociations::ext_ignore_list &ext_disposition,
         bool list_unknown_extensions);
 
+META_PUBLIC bool ScanVideoDirectories(const QStringList &start_paths,
+        DirectoryHandler *handler,
+        const FileAssociations::ext_ignore_list &ext_disposition,
+        bool list_unknown_extensions, DirectoryManifest *manifest,
+        QStringList &failed_paths);
+
 #endif // DIRSCAN_H_
@@ -17,7 +17,8 @@ QMAKE_CLEAN += version.cpp
 
 # Input
 
-HEADERS += cleanup.h  dbaccess.h  dirscan.h  globals.h  parentalcontrols.h
+HEADERS += cleanup.h  dbaccess.h  dirscan.h  dirmanifest.h  globals.h
+HEADERS += parentalcontrols.h
 HEADERS += videoscan.h  videoutils.h  videometadata.h  videometadatalistmanager.h
 HEADERS += quicksp.h metadatacommon.h metadatadownload.h metadataimagedownload.h
 HEADERS += bluraymetadata.h mythmetaexp.h metadatafactory.h mythuimetadataresults.h
@@ -26,7 +27,7 @@ HEADERS += musicmetadata.h musicutils.h metaio.h metaiotaglib.h
 HEADERS += metaioflacvorbis.h metaioavfcomment.h metaiomp4.h
 HEADERS += metaiowavpack.h metaioid3.h metaiooggvorbis.h
 
-SOURCES += cleanup.cpp  dbaccess.cpp  dirscan.cpp  globals.cpp
+SOURCES += cleanup.cpp  dbaccess.cpp  dirscan.cpp  dirmanifest.cpp  globals.cpp
 SOURCES += parentalcontrols.cpp  videoscan.cpp  videoutils.cpp
 SOURCES += videometadata.cpp  videometadatalistmanager.cpp
 SOURCES += metadatacommon.cpp metadatadownload.cpp metadataimagedownload.cpp
@@ -77,7 +78,8 @@ mingw {
 
 inc.path = $${PREFIX}/include/mythtv/metadata/
 
-inc.files = cleanup.h  dbaccess.h  dirscan.h  globals.h  parentalcontrols.h
+inc.files = cleanup.h  dbaccess.h  dirscan.h  dirmanifest.h  globals.h
+inc.files += parentalcontrols.h
 inc.files += videoscan.h  videoutils.h  videometadata.h  videometadatalistmanager.h
 inc.files += quicksp.h metadatacommon.h metadatadownload.h metadataimagedownload.h
 inc.files += bluraymetadata.h mythmetaexp.h metadatafactory.h mythuimetadataresults.h
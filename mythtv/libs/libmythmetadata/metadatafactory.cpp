@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <QTimer>
 #include <QList>
 #include <QUrl>
 
@@ -14,6 +15,7 @@
 
 // Needed for video scanning
 #include "videometadatalistmanager.h"
+#include "dirmanifest.h"
 #include "globals.h"
 
 // Input for a lookup
@@ -36,7 +38,7 @@ QEvent::Type MetadataFactoryVideoChanges::kEventType =
     (QEvent::Type) QEvent::registerEventType();
 
 MetadataFactory::MetadataFactory(QObject *parent) :
-    m_parent(parent), m_scanning(false),
+    m_parent(parent), m_scanning(false), m_watcher(NULL), m_rescan(false),
     m_returnList(), m_sync(false)
 {
     m_lookupthread = new MetadataDownload(this);
@@ -253,12 +255,64 @@ void MetadataFactory::VideoScan(QStringList hosts)
         return;
 
     m_scanning = true;
+    m_scanHosts = hosts;
 
     m_videoscanner->SetHosts(hosts);
     m_videoscanner->SetDirs(GetVideoDirs());
     m_videoscanner->start();
 }
 
+/** \brief Rescans the video directories whenever something in them
+ *         changes, as well as when asked to.
+ *
+ *  The directories of the last scan are watched right away, so this works
+ *  from startup once there has been one scan.
+ */
+void MetadataFactory::WatchVideoDirs(void)
+{
+    if (m_watcher)
+        return;
+
+    m_watcher = new VideoScanWatcher(this);
+    connect(m_watcher, SIGNAL(changed()), SLOT(VideoDirsChanged()));
+    connect(m_videoscanner->qthread(), SIGNAL(finished()),
+            SLOT(VideoScanFinished()));
+
+    DirectoryManifest manifest;
+    manifest.Load();
+    m_watcher->Watch(manifest.GetDirs());
+}
+
+void MetadataFactory::VideoScanFinished(void)
+{
+    m_watcher->Watch(m_videoscanner->GetWatchDirs());
+
+    if (m_rescan)
+    {
+        m_rescan = false;
+        VideoDirsChanged();
+    }
+}
+
+void MetadataFactory::VideoDirsChanged(void)
+{
+    if (IsRunning())
+    {
+        // Pick the change up once the scan or the lookups are done
+        if (!m_rescan && !m_videoscanner->isRunning())
+            QTimer::singleShot(60 * 1000, this, SLOT(VideoDirsChanged()));
+        m_rescan = true;
+        return;
+    }
+
+    m_rescan = false;
+
+    if (m_scanHosts.isEmpty())
+        VideoScan();
+    else
+        VideoScan(m_scanHosts);
+}
+
 void MetadataFactory::OnMultiResult(MetadataLookupList list)
 {
     if (list.isEmpty())
@@ -69,6 +69,7 @@ class META_PUBLIC MetadataFactoryVideoChanges : public QEvent
 
 class META_PUBLIC MetadataFactory : public QObject
 {
+    Q_OBJECT
 
   public:
 
@@ -94,6 +95,7 @@ class META_PUBLIC MetadataFactory : public QObject
 
     void VideoScan();
     void VideoScan(QStringList hosts);
+    void WatchVideoDirs(void);
 
     bool IsRunning() { return m_lookupthread->isRunning() ||
                               m_imagedownload->isRunning() ||
@@ -101,6 +103,10 @@ class META_PUBLIC MetadataFactory : public QObject
 
     bool VideoGrabbersFunctional();
 
+  private slots:
+    void VideoScanFinished(void);
+    void VideoDirsChanged(void);
+
   private:
 
     void customEvent(QEvent *levent);
@@ -120,6 +126,11 @@ class META_PUBLIC MetadataFactory : public QObject
     VideoMetadataListManager *m_mlm;
     bool m_scanning;
 
+    // Variables used when watching the video directories
+    VideoScanWatcher *m_watcher;
+    QStringList m_scanHosts;
+    bool m_rescan;
+
     // Variables used in synchronous mode
     MetadataLookupList m_returnList;
     bool m_sync;
@@ -50,8 +50,17 @@ MusicMetadata* MetaIOAVFComment::read(const QString &filename)
         return NULL;
     }
 
-    if (avformat_find_stream_info(p_context, NULL) < 0)
+    // Opens the decoders, the scanner reads several files at once
+    int ret;
+    {
+        QMutexLocker locker(avcodeclock);
+        ret = avformat_find_stream_info(p_context, NULL);
+    }
+    if (ret < 0)
+    {
+        avformat_close_input(&p_context);
         return NULL;
+    }
 
     AVDictionaryEntry *tag = av_dict_get(p_context->metadata, "title", NULL, 0);
     if (!tag)
@@ -115,8 +124,16 @@ int MetaIOAVFComment::getTrackLength(const QString &filename)
         return 0;
     }
 
-    if (avformat_find_stream_info(p_context, NULL) < 0)
+    int ret;
+    {
+        QMutexLocker locker(avcodeclock);
+        ret = avformat_find_stream_info(p_context, NULL);
+    }
+    if (ret < 0)
+    {
+        avformat_close_input(&p_context);
         return 0;
+    }
 
     int rv = getTrackLength(p_context);
 
@@ -1109,6 +1109,8 @@ void MetadataLoadingThread::run()
 AllMusic::AllMusic(void) :
     m_numPcs(0),
     m_numLoaded(0),
+    m_lastLoadedID(0),
+    m_indexesValid(false),
     m_metadata_loader(NULL),
     m_done_loading(false),
     m_last_listed(-1),
@@ -1184,8 +1186,29 @@ bool AllMusic::startLoading(void)
     return true;
 }
 
-// NOTE we don't clear the existing tracks just load any new ones found in the DB
-// maybe we should also check for any removed tracks?
+/// Tracks read from the database per query while loading
+static const int kLoadPageSize = 5000;
+
+/// Returns a copy of 'str' sharing its data with the other tracks
+static QString intern_string(QHash<QString, QString> &strings,
+                             const QString &str)
+{
+    QHash<QString, QString>::const_iterator it = strings.find(str);
+    if (it != strings.end())
+        return *it;
+
+    strings.insert(str, str);
+    return str;
+}
+
+/** \brief Loads any tracks added to the database since the last call.
+ *
+ *  Tracks are read in pages of kLoadPageSize, in song_id order, so that a
+ *  large collection is never held in one result set. A resync after a scan
+ *  or a rip only reads the tracks with a song_id above those already loaded.
+ *
+ *  \note Tracks that have been removed from the database are not dropped.
+ */
 void AllMusic::resync()
 {
     m_done_loading = false;
@@ -1204,44 +1227,61 @@ void AllMusic::resync()
                      "LEFT JOIN music_albums ON music_songs.album_id=music_albums.album_id "
                      "LEFT JOIN music_artists AS music_comp_artists ON music_albums.artist_id=music_comp_artists.artist_id "
                      "LEFT JOIN music_genres ON music_songs.genre_id=music_genres.genre_id "
-                     "ORDER BY music_songs.song_id;";
-
-    QString filename, artist, album, title, compartist;
+                     "WHERE music_songs.song_id > :LASTID "
+                     "ORDER BY music_songs.song_id "
+                     "LIMIT " + QString::number(kLoadPageSize) + ";";
 
     MSqlQuery query(MSqlQuery::InitCon());
-    if (!query.exec(aquery))
-        MythDB::DBError("AllMusic::resync", query);
 
-    m_numPcs = query.size() * 2;
-    m_numLoaded = 0;
+    query.prepare("SELECT COUNT(*) FROM music_songs WHERE song_id > :LASTID;");
+    query.bindValue(":LASTID", m_lastLoadedID);
+    if (!query.exec())
+        MythDB::DBError("AllMusic::resync - count", query);
+    else if (query.next())
+        m_numPcs = m_numLoaded + query.value(0).toInt();
 
-    if (query.isActive() && query.size() > 0)
+    // Most tracks share their artist, album and genre names with others
+    QHash<QString, QString> strings;
+    int added = 0;
+    int rows;
+
+    do
     {
+        rows = 0;
+
+        query.prepare(aquery);
+        query.bindValue(":LASTID", m_lastLoadedID);
+        if (!query.exec())
+        {
+            MythDB::DBError("AllMusic::resync", query);
+            break;
+        }
+
         while (query.next())
         {
             int id = query.value(0).toInt();
+            m_lastLoadedID = id;
+            rows++;
 
             if (!music_map.contains(id))
             {
-                filename = query.value(12).toString();
-
                 MusicMetadata *mdata = new MusicMetadata(
-                    filename,
-                    query.value(2).toString(),     // artist
-                    query.value(3).toString(),     // compilation artist
-                    query.value(5).toString(),     // album
+                    query.value(12).toString(),    // filename
+                    intern_string(strings, query.value(2).toString()), // artist
+                    intern_string(strings, query.value(3).toString()), // compilation artist
+                    intern_string(strings, query.value(5).toString()), // album
                     query.value(6).toString(),     // title
-                    query.value(7).toString(),     // genre
+                    intern_string(strings, query.value(7).toString()), // genre
                     query.value(8).toInt(),        // year
                     query.value(9).toInt(),        // track no.
                     query.value(10).toInt(),       // length
-                    query.value(0).toInt(),        // id
+                    id,                            // id
                     query.value(13).toInt(),       // rating
                     query.value(14).toInt(),       // playcount
                     query.value(15).toDateTime(),  // lastplay
                     query.value(16).toDateTime(),  // date_entered
                     (query.value(17).toInt() > 0), // compilation
-                    query.value(18).toString());   // format
+                    intern_string(strings, query.value(18).toString())); // format
 
                 mdata->setDirectoryId(query.value(11).toInt());
                 mdata->setArtistId(query.value(1).toInt());
@@ -1253,20 +1293,21 @@ void AllMusic::resync()
                 m_all_music.append(mdata);
 
                 music_map[id] = mdata;
+                added++;
             }
 
             // compute max/min playcount,lastplay for all music
-            if (query.at() == 0)
+            int playCount = query.value(14).toInt();
+            double lastPlay = query.value(15).toDateTime().toTime_t();
+
+            if (m_numLoaded == 0)
             {
                 // first song
-                m_playcountMin = m_playcountMax = query.value(13).toInt();
-                m_lastplayMin  = m_lastplayMax  = query.value(14).toDateTime().toTime_t();
+                m_playcountMin = m_playcountMax = playCount;
+                m_lastplayMin  = m_lastplayMax  = lastPlay;
             }
             else
             {
-                int playCount = query.value(13).toInt();
-                double lastPlay = query.value(14).toDateTime().toTime_t();
-
                 m_playcountMin = min(playCount, m_playcountMin);
                 m_playcountMax = max(playCount, m_playcountMax);
                 m_lastplayMin  = min(lastPlay,  m_lastplayMin);
@@ -1274,8 +1315,12 @@ void AllMusic::resync()
             }
             m_numLoaded++;
         }
-    }
-    else
+    } while (rows == kLoadPageSize);
+
+    if (added > 0)
+        m_indexesValid = false;
+
+    if (m_all_music.isEmpty())
     {
          LOG(VB_GENERAL, LOG_ERR, "MythMusic hasn't found any tracks! "
                                   "That's ok with me if it's ok with you.");
@@ -1305,12 +1350,57 @@ bool AllMusic::updateMetadata(int an_id, MusicMetadata *the_track)
         if (mdata)
         {
             *mdata = *the_track;
+            m_indexesValid = false;
             return true;
         }
     }
     return false;
 }
 
+const AllMusic::MetadataIndex &AllMusic::getArtistIndex(void)
+{
+    if (!m_indexesValid)
+        buildIndexes();
+    return m_artistIndex;
+}
+
+const AllMusic::MetadataIndex &AllMusic::getAlbumIndex(void)
+{
+    if (!m_indexesValid)
+        buildIndexes();
+    return m_albumIndex;
+}
+
+const AllMusic::MetadataIndex &AllMusic::getGenreIndex(void)
+{
+    if (!m_indexesValid)
+        buildIndexes();
+    return m_genreIndex;
+}
+
+/** \brief Groups all the tracks by artist, album and genre in one pass.
+ *
+ *  The indexes are kept until tracks are loaded or changed, so browsing the
+ *  whole collection by any of them does not walk every track again. Within
+ *  each group the tracks stay in the same order as getAllMetadata().
+ */
+void AllMusic::buildIndexes(void)
+{
+    m_artistIndex.clear();
+    m_albumIndex.clear();
+    m_genreIndex.clear();
+
+    MetadataPtrList::const_iterator it = m_all_music.begin();
+    for (; it != m_all_music.end(); ++it)
+    {
+        m_artistIndex[(*it)->Artist()].append(*it);
+        m_albumIndex[(*it)->Album()].append(*it);
+        m_genreIndex[(*it)->Genre()].append(*it);
+    }
+
+    m_indexesValid = true;
+}
+
 /// \brief Check each MusicMetadata entry and save those that have changed (ratings, etc.)
 void AllMusic::save(void)
 {
@@ -10,6 +10,7 @@ using namespace std;
 // qt
 #include <QStringList>
 #include <QMap>
+#include <QHash>
 #include <QDateTime>
 #include <QImage>
 #include <QMetaType>
@@ -382,17 +383,33 @@ class META_PUBLIC AllMusic
     MetadataPtrList *getAllMetadata(void) { return &m_all_music; }
     MetadataPtrList *getAllCDMetadata(void) { return &m_cdData; }
 
+    /// All the tracks grouped by artist, album or genre name
+    typedef QMap<QString, MetadataPtrList> MetadataIndex;
+    const MetadataIndex &getArtistIndex(void);
+    const MetadataIndex &getAlbumIndex(void);
+    const MetadataIndex &getGenreIndex(void);
+    /// Call after changing the artist, album or genre of a track
+    void invalidateIndexes(void) { m_indexesValid = false; }
+
     bool isValidID(int an_id);
 
   private:
+    void buildIndexes(void);
+
     MetadataPtrList     m_all_music;
 
     int m_numPcs;
     int m_numLoaded;
+    int m_lastLoadedID;   ///< highest song_id read from the database
 
-    typedef QMap<int, MusicMetadata*> MusicMap;
+    typedef QHash<int, MusicMetadata*> MusicMap;
     MusicMap music_map;
 
+    MetadataIndex m_artistIndex;
+    MetadataIndex m_albumIndex;
+    MetadataIndex m_genreIndex;
+    bool          m_indexesValid;
+
     // cd stuff
     MetadataPtrList m_cdData; //  More than one cd player?
     QString m_cdTitle;
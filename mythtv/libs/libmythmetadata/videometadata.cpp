@@ -4,6 +4,8 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QRegExp>
+#include <QStringList>
+#include <QMap>
 
 #include "mythcorecontext.h"
 #include "mythmiscutil.h"
@@ -87,6 +89,9 @@ void VideoMetadata::SortKey::Clear()
     m_sd = 0;
 }
 
+/// Rows written by each query when saving or deleting many videos
+static const int kDBBatchSize = 100;
+
 class VideoMetadataImp
 {
   public:
@@ -343,6 +348,8 @@ class VideoMetadataImp
     void SaveToDatabase();
     void UpdateDatabase();
     bool DeleteFromDatabase();
+    static void InsertIntoDatabase(const QList<VideoMetadataImp *> &items);
+    static void DeleteFromDatabase(const QList<VideoMetadataImp *> &items);
 
     bool DeleteFile();
 
@@ -359,6 +366,7 @@ class VideoMetadataImp
     void updateCast();
     bool removeDir(const QString &dirName);
     void fromDBRow(MSqlQuery &query);
+    void fillDefaults();
     void saveToDatabase();
 
   private:
@@ -608,7 +616,7 @@ void VideoMetadataImp::fromDBRow(MSqlQuery &query)
     fillCast();
 }
 
-void VideoMetadataImp::saveToDatabase()
+void VideoMetadataImp::fillDefaults()
 {
     if (m_title.isEmpty())
         m_title = VideoMetadata::FilenameToMeta(m_filename, 1);
@@ -647,6 +655,11 @@ void VideoMetadataImp::saveToDatabase()
         else
             m_contenttype = kContentMovie;
     }
+}
+
+void VideoMetadataImp::saveToDatabase()
+{
+    fillDefaults();
 
     bool inserting = m_id == 0;
 
@@ -758,6 +771,139 @@ void VideoMetadataImp::SaveToDatabase()
     saveToDatabase();
 }
 
+/** \brief Inserts new videos with a single query.
+ *
+ *  The ids are looked up afterwards by filename and host, as the rows of
+ *  one INSERT are not guaranteed consecutive ids. Videos with genres,
+ *  countries or cast are saved one at a time.
+ */
+void VideoMetadataImp::InsertIntoDatabase(const QList<VideoMetadataImp *> &items)
+{
+    QList<VideoMetadataImp *> batch;
+    QList<VideoMetadataImp *>::const_iterator it = items.begin();
+    for (; it != items.end(); ++it)
+    {
+        if ((*it)->m_id != 0 || !(*it)->m_genres.empty() ||
+            !(*it)->m_countries.empty() || !(*it)->m_cast.empty())
+        {
+            (*it)->saveToDatabase();
+            continue;
+        }
+
+        (*it)->fillDefaults();
+        (*it)->m_browse = 1;
+        (*it)->m_watched = 0;
+        batch.push_back(*it);
+    }
+
+    if (batch.isEmpty())
+        return;
+
+    QStringList rows;
+    for (int i = 0; i < batch.size(); ++i)
+    {
+        rows << QString("(:TITLE%1, :SUBTITLE%1, :TAGLINE%1, :DIRECTOR%1, "
+                        ":STUDIO%1, :PLOT%1, :RATING%1, :YEAR%1, "
+                        ":USERRATING%1, :LENGTH%1, :SEASON%1, :EPISODE%1, "
+                        ":FILENAME%1, :HASH%1, :SHOWLEVEL%1, :COVERFILE%1, "
+                        ":INETREF%1, :HOMEPAGE%1, :BROWSE%1, :WATCHED%1, "
+                        ":TRAILER%1, :SCREENSHOT%1, :BANNER%1, :FANART%1, "
+                        ":HOST%1, :PROCESSED%1, :CONTENTTYPE%1)").arg(i);
+    }
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare("INSERT INTO videometadata (title,subtitle,tagline,director,studio,plot,"
+                  "rating,year,userrating,length,season,episode,filename,hash,"
+                  "showlevel,coverfile,inetref,homepage,browse,watched,trailer,"
+                  "screenshot,banner,fanart,host,processed,contenttype) VALUES " +
+                  rows.join(", "));
+
+    for (int i = 0; i < batch.size(); ++i)
+    {
+        VideoMetadataImp *m = batch[i];
+        QString n = QString::number(i);
+        query.bindValue(":TITLE" + n, m->m_title.isNull() ? "" : m->m_title);
+        query.bindValue(":SUBTITLE" + n,
+                        m->m_subtitle.isNull() ? "" : m->m_subtitle);
+        query.bindValue(":TAGLINE" + n, m->m_tagline);
+        query.bindValue(":DIRECTOR" + n,
+                        m->m_director.isNull() ? "" : m->m_director);
+        query.bindValue(":STUDIO" + n, m->m_studio);
+        query.bindValue(":PLOT" + n, m->m_plot);
+        query.bindValue(":RATING" + n, m->m_rating.isNull() ? "" : m->m_rating);
+        query.bindValue(":YEAR" + n, m->m_year);
+        query.bindValue(":USERRATING" + n, m->m_userrating);
+        query.bindValue(":LENGTH" + n, m->m_length);
+        query.bindValue(":SEASON" + n, m->m_season);
+        query.bindValue(":EPISODE" + n, m->m_episode);
+        query.bindValue(":FILENAME" + n, m->m_filename);
+        query.bindValue(":HASH" + n, m->m_hash);
+        query.bindValue(":SHOWLEVEL" + n, m->m_showlevel);
+        query.bindValue(":COVERFILE" + n,
+                        m->m_coverfile.isNull() ? "" : m->m_coverfile);
+        query.bindValue(":INETREF" + n,
+                        m->m_inetref.isNull() ? "" : m->m_inetref);
+        query.bindValue(":HOMEPAGE" + n,
+                        m->m_homepage.isNull() ? "" : m->m_homepage);
+        query.bindValue(":BROWSE" + n, m->m_browse);
+        query.bindValue(":WATCHED" + n, m->m_watched);
+        query.bindValue(":TRAILER" + n,
+                        m->m_trailer.isNull() ? "" : m->m_trailer);
+        query.bindValue(":SCREENSHOT" + n,
+                        m->m_screenshot.isNull() ? "" : m->m_screenshot);
+        query.bindValue(":BANNER" + n, m->m_banner.isNull() ? "" : m->m_banner);
+        query.bindValue(":FANART" + n, m->m_fanart.isNull() ? "" : m->m_fanart);
+        query.bindValue(":HOST" + n, m->m_host);
+        query.bindValue(":PROCESSED" + n, m->m_processed);
+        query.bindValue(":CONTENTTYPE" + n,
+                        ContentTypeToString(m->m_contenttype));
+    }
+
+    if (!query.exec() || !query.isActive())
+    {
+        MythDB::DBError("video metadata batch insert", query);
+        return;
+    }
+
+    if (!query.exec("SELECT LAST_INSERT_ID()") || !query.next())
+    {
+        MythDB::DBError("metadata id get", query);
+        return;
+    }
+    uint first = query.value(0).toUInt();
+
+    query.prepare("SELECT intid, filename, host FROM videometadata "
+                  "WHERE intid >= :FIRST ORDER BY intid");
+    query.bindValue(":FIRST", first);
+    if (!query.exec())
+    {
+        MythDB::DBError("metadata batch id get", query);
+        return;
+    }
+
+    QMap<QString, VideoMetadataImp *> pending;
+    for (int i = 0; i < batch.size(); ++i)
+        pending[batch[i]->m_host + ':' + batch[i]->m_filename] = batch[i];
+
+    while (query.next() && !pending.isEmpty())
+    {
+        QString key = query.value(2).toString() + ':' +
+                      query.value(1).toString();
+        QMap<QString, VideoMetadataImp *>::iterator p = pending.find(key);
+        if (p == pending.end())
+            continue;
+        (*p)->m_id = query.value(0).toUInt();
+        pending.erase(p);
+    }
+
+    if (!pending.isEmpty())
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            QString("%1: Could not find the ids of %2 inserted videos.")
+                .arg(__FILE__).arg(pending.size()));
+    }
+}
+
 void VideoMetadataImp::UpdateDatabase()
 {
     saveToDatabase();
@@ -787,6 +933,43 @@ bool VideoMetadataImp::DeleteFromDatabase()
     return true;
 }
 
+/// \brief Deletes several videos with a single query per table.
+void VideoMetadataImp::DeleteFromDatabase(const QList<VideoMetadataImp *> &items)
+{
+    if (items.isEmpty())
+        return;
+
+    QList<int> ids;
+    QStringList idlist, files;
+    QList<VideoMetadataImp *>::const_iterator it = items.begin();
+    for (int i = 0; it != items.end(); ++it, ++i)
+    {
+        ids << (*it)->m_id;
+        idlist << QString::number((*it)->m_id);
+        files << QString(":FILENAME%1").arg(i);
+    }
+
+    VideoGenreMap::getGenreMap().remove(ids);
+    VideoCountryMap::getCountryMap().remove(ids);
+    VideoCastMap::getCastMap().remove(ids);
+
+    MSqlQuery query(MSqlQuery::InitCon());
+    if (!query.exec(QString("DELETE FROM videometadata WHERE intid IN (%1)")
+                        .arg(idlist.join(","))))
+    {
+        MythDB::DBError("batch delete from videometadata", query);
+    }
+
+    query.prepare(QString("DELETE FROM filemarkup WHERE filename IN (%1)")
+                      .arg(files.join(", ")));
+    for (int i = 0; i < items.size(); ++i)
+        query.bindValue(files[i], items[i]->m_filename);
+    if (!query.exec())
+    {
+        MythDB::DBError("batch delete from filemarkup", query);
+    }
+}
+
 void VideoMetadataImp::SetCategoryID(int id)
 {
     if (id == 0)
@@ -1764,6 +1947,44 @@ bool VideoMetadata::DeleteFromDatabase()
     return m_imp->DeleteFromDatabase();
 }
 
+/** \brief Saves new videos to the database, several to a query.
+ *
+ *  This is much faster than SaveToDatabase() when a scan finds many new
+ *  files. Videos that are already in the database are updated instead.
+ */
+void VideoMetadata::SaveToDatabase(const QList<VideoMetadata *> &items)
+{
+    QList<VideoMetadataImp *> batch;
+    QList<VideoMetadata *>::const_iterator it = items.begin();
+    for (; it != items.end(); ++it)
+    {
+        batch.push_back((*it)->m_imp);
+        if (batch.size() >= kDBBatchSize)
+        {
+            VideoMetadataImp::InsertIntoDatabase(batch);
+            batch.clear();
+        }
+    }
+    VideoMetadataImp::InsertIntoDatabase(batch);
+}
+
+/// \brief Drops several videos from the database, several to a query.
+void VideoMetadata::DeleteFromDatabase(const QList<VideoMetadata *> &items)
+{
+    QList<VideoMetadataImp *> batch;
+    QList<VideoMetadata *>::const_iterator it = items.begin();
+    for (; it != items.end(); ++it)
+    {
+        batch.push_back((*it)->m_imp);
+        if (batch.size() >= kDBBatchSize)
+        {
+            VideoMetadataImp::DeleteFromDatabase(batch);
+            batch.clear();
+        }
+    }
+    VideoMetadataImp::DeleteFromDatabase(batch);
+}
+
 #if 0
 bool VideoMetadata::fillDataFromID(const VideoMetadataListManager &cache)
 {
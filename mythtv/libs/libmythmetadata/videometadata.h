@@ -6,6 +6,7 @@
 
 #include <QString>
 #include <QDate>
+#include <QList>
 #include <QCoreApplication>
 
 #include "parentalcontrols.h"
@@ -238,6 +239,9 @@ class META_PUBLIC VideoMetadata
     // drops the metadata from the DB
     bool DeleteFromDatabase();
 
+    static void SaveToDatabase(const QList<VideoMetadata *> &items);
+    static void DeleteFromDatabase(const QList<VideoMetadata *> &items);
+
 //    bool fillDataFromID(const VideoMetadataListManager &cache);
     bool FillDataFromFilename(const VideoMetadataListManager &cache);
 
@@ -1,3 +1,4 @@
+#include <vector>
 #include <map>
 
 #include "mythdb.h"
@@ -65,6 +66,36 @@ class VideoMetadataListManagerImp
         return purge_entry(byID(db_id));
     }
 
+    void purgeByIDs(const QList<unsigned int> &db_ids)
+    {
+        QList<VideoMetadata *> purged;
+        std::vector<metadata_list::iterator> found;
+
+        QList<unsigned int>::const_iterator id = db_ids.begin();
+        for (; id != db_ids.end(); ++id)
+        {
+            int_to_meta::iterator im = m_id_map.find(*id);
+            if (im != m_id_map.end())
+            {
+                purged.push_back(im->second->get());
+                found.push_back(im->second);
+                m_id_map.erase(im);
+            }
+        }
+
+        VideoMetadata::DeleteFromDatabase(purged);
+
+        std::vector<metadata_list::iterator>::iterator p = found.begin();
+        for (; p != found.end(); ++p)
+        {
+            string_to_meta::iterator sm =
+                    m_file_map.find((**p)->GetFilename());
+            if (sm != m_file_map.end())
+                m_file_map.erase(sm);
+            m_meta_list.erase(*p);
+        }
+    }
+
   private:
     bool purge_entry(VideoMetadataPtr metadata)
     {
@@ -184,6 +215,12 @@ bool VideoMetadataListManager::purgeByID(unsigned int db_id)
     return m_imp->purgeByID(db_id);
 }
 
+/// \brief Drops several videos from the list and the database at once.
+void VideoMetadataListManager::purgeByIDs(const QList<unsigned int> &db_ids)
+{
+    m_imp->purgeByIDs(db_ids);
+}
+
 const QString meta_node::m_empty_path;
 
 const QString& meta_node::getPath() const
@@ -30,6 +30,7 @@ class META_PUBLIC VideoMetadataListManager
 
     bool purgeByFilename(const QString &file_name);
     bool purgeByID(unsigned int db_id);
+    void purgeByIDs(const QList<unsigned int> &db_ids);
 
   private:
     class VideoMetadataListManagerImp *m_imp;
@@ -1,5 +1,11 @@
+#include <QFileSystemWatcher>
 #include <QImageReader>
 #include <QApplication>
+#include <QMutexLocker>
+#include <QAtomicInt>
+#include <QRunnable>
+#include <QTimer>
+#include <QSet>
 #include <QUrl>
 
 #include "mythcontext.h"
@@ -9,6 +15,7 @@
 #include "globals.h"
 #include "dbaccess.h"
 #include "dirscan.h"
+#include "dirmanifest.h"
 #include "videometadatalistmanager.h"
 #include "videoscan.h"
 #include "videoutils.h"
@@ -16,6 +23,7 @@
 #include "remoteutil.h"
 #include "mythlogging.h"
 #include "mythdate.h"
+#include "mthreadpool.h"
 
 QEvent::Type VideoScanChanges::kEventType =
     (QEvent::Type) QEvent::registerEventType();
@@ -58,6 +66,7 @@ namespace
             (void) file_name;
             if (m_image_ext.find(extension.toLower()) == m_image_ext.end())
             {
+                QMutexLocker locker(&m_lock);
                 m_video_files[fq_file_name].check = false;
                 m_video_files[fq_file_name].host = host;
             }
@@ -66,10 +75,46 @@ namespace
       private:
         typedef std::set<QString> image_ext;
         image_ext m_image_ext;
+        QMutex m_lock;  // handleFile() is called from several threads
         DirListType &m_video_files;
     };
+
+    /// A file found by the scan that is not in the database yet
+    struct NewFile
+    {
+        NewFile(const QString &f, const QString &h) : filename(f), host(h) {}
+
+        QString filename;
+        QString host;
+        QString hash;
+    };
+
+    /// Hashes new files, several threads share the list
+    class HashRunnable : public QRunnable
+    {
+      public:
+        HashRunnable(std::vector<NewFile> &files, QAtomicInt &next) :
+            m_files(files), m_next(next) {}
+
+        void run(void)
+        {
+            int i;
+            while ((i = m_next.fetchAndAddOrdered(1)) < (int)m_files.size())
+            {
+                m_files[i].hash = VideoMetadata::VideoFileHash(
+                    m_files[i].filename, m_files[i].host);
+            }
+        }
+
+      private:
+        std::vector<NewFile> &m_files;
+        QAtomicInt           &m_next;
+    };
 }
 
+/// Files hashed at once, reading a little of each is mostly waiting
+static const int kHashThreads = 4;
+
 class VideoMetadataListManager;
 class MythUIProgressDialog;
 
@@ -169,27 +214,33 @@ void VideoScannerThread::run()
     if (m_HasGUI)
         SendProgressEvent(counter, (uint)m_directories.size(),
                           tr("Searching for video files"));
-    for (QStringList::const_iterator iter = m_directories.begin();
-         iter != m_directories.end(); ++iter)
+
+    DirectoryManifest manifest;
+    manifest.Load();
+
+    QStringList failed;
+    buildFileList(m_directories, imageExtensions, fs_files, manifest, failed);
+    for (QStringList::const_iterator iter = failed.begin();
+         iter != failed.end(); ++iter)
     {
-        if (!buildFileList(*iter, imageExtensions, fs_files))
+        if (iter->startsWith("myth://"))
         {
-            if (iter->startsWith("myth://"))
-            {
-                QUrl sgurl = *iter;
-                QString host = sgurl.host().toLower();
-                QString path = sgurl.path();
+            QUrl sgurl = *iter;
+            QString host = sgurl.host().toLower();
 
-                m_liveSGHosts.removeAll(host);
+            m_liveSGHosts.removeAll(host);
 
-                LOG(VB_GENERAL, LOG_ERR,
-                    QString("Failed to scan :%1:").arg(*iter));
-            }
+            LOG(VB_GENERAL, LOG_ERR,
+                QString("Failed to scan :%1:").arg(*iter));
         }
-        if (m_HasGUI)
-            SendProgressEvent(++counter);
     }
 
+    manifest.Save();
+    m_watchDirs = manifest.GetDirs();
+
+    if (m_HasGUI)
+        SendProgressEvent((uint)m_directories.size());
+
     PurgeList db_remove;
     verifyFiles(fs_files, db_remove);
     m_DBDataChanged = updateDB(fs_files, db_remove);
@@ -221,20 +272,16 @@ void VideoScannerThread::run()
 }
 
 
-void VideoScannerThread::removeOrphans(unsigned int id,
-                                       const QString &filename)
+void VideoScannerThread::removeOrphans(const QList<unsigned int> &ids)
 {
-    (void) filename;
-
-    // TODO: use single DB connection for all calls
-    if (m_RemoveAll)
-        m_dbmetadata->purgeByID(id);
+    if (ids.isEmpty())
+        return;
 
     if (!m_KeepAll && !m_RemoveAll)
-    {
         m_RemoveAll = true;
-        m_dbmetadata->purgeByID(id);
-    }
+
+    if (m_RemoveAll)
+        m_dbmetadata->purgeByIDs(ids);
 }
 
 void VideoScannerThread::verifyFiles(FileCheckList &files,
@@ -303,85 +350,147 @@ bool VideoScannerThread::updateDB(const FileCheckList &add, const PurgeList &rem
         SendProgressEvent(counter, (uint)(add.size() + remove.size()),
                           tr("Updating video database"));
 
+    std::vector<NewFile> files;
     for (FileCheckList::const_iterator p = add.begin(); p != add.end(); ++p)
     {
         // add files not already in the DB
         if (!p->second.check)
+            files.push_back(NewFile(p->first, p->second.host));
+        else
+            ++counter;
+    }
+
+    if (!files.empty())
+    {
+        QAtomicInt next(0);
+        MThreadPool pool("VideoScanHash");
+        pool.setMaxThreadCount(kHashThreads);
+        for (int i = 0; i < kHashThreads; ++i)
         {
-            int id = -1;
+            pool.start(new HashRunnable(files, next),
+                       QString("VideoScanHash%1").arg(i));
+        }
+        pool.waitForDone();
+    }
 
-            // Are we sure this needs adding?  Let's check our Hash list.
-            QString hash = VideoMetadata::VideoFileHash(p->first, p->second.host);
-            if (hash != "NULL" && !hash.isEmpty())
+    // Hashes of the videos we know about, to spot files that were moved
+    QSet<QString> db_hashes;
+    for (VideoMetadataListManager::metadata_list::const_iterator p =
+         m_dbmetadata->getList().begin();
+         p != m_dbmetadata->getList().end(); ++p)
+    {
+        db_hashes.insert((*p)->GetHash());
+    }
+
+    QList<VideoMetadata *> newFiles;
+    QMap<QString, VideoMetadata *> newHashes;
+
+    for (std::vector<NewFile>::const_iterator p = files.begin();
+         p != files.end(); ++p)
+    {
+        int id = -1;
+
+        // Are we sure this needs adding?  Let's check our Hash list.
+        const QString &hash = p->hash;
+        if (hash != "NULL" && !hash.isEmpty())
+        {
+            if (db_hashes.contains(hash))
+                id = VideoMetadata::UpdateHashedDBRecord(hash, p->filename,
+                                                         p->host);
+            if (id != -1)
             {
-                id = VideoMetadata::UpdateHashedDBRecord(hash, p->first, p->second.host);
-                if (id != -1)
-                {
-                    // Whew, that was close.  Let's remove that thing from
-                    // our purge list, too.
-                    LOG(VB_GENERAL, LOG_ERR,
-                        QString("Hash %1 already exists in the "
-                                "database, updating record %2 "
-                                "with new filename %3")
-                            .arg(hash).arg(id).arg(p->first));
-                    m_movList.append(id);
-                }
+                // Whew, that was close.  Let's remove that thing from
+                // our purge list, too.
+                LOG(VB_GENERAL, LOG_ERR,
+                    QString("Hash %1 already exists in the "
+                            "database, updating record %2 "
+                            "with new filename %3")
+                        .arg(hash).arg(id).arg(p->filename));
+                m_movList.append(id);
             }
-            if (id == -1)
+            else if (newHashes.contains(hash))
             {
-                VideoMetadata newFile(
-                    p->first, hash,
-                    VIDEO_TRAILER_DEFAULT,
-                    VIDEO_COVERFILE_DEFAULT,
-                    VIDEO_SCREENSHOT_DEFAULT,
-                    VIDEO_BANNER_DEFAULT,
-                    VIDEO_FANART_DEFAULT,
-                    VideoMetadata::FilenameToMeta(p->first, 1),
-                    VideoMetadata::FilenameToMeta(p->first, 4),
-                    QString(),
-                    VIDEO_YEAR_DEFAULT,
-                    QDate::fromString("0000-00-00","YYYY-MM-DD"),
-                    VIDEO_INETREF_DEFAULT, 0, QString(),
-                    VIDEO_DIRECTOR_DEFAULT, QString(), VIDEO_PLOT_DEFAULT,
-                    0.0, VIDEO_RATING_DEFAULT, 0, 0,
-                    VideoMetadata::FilenameToMeta(p->first, 2).toInt(),
-                    VideoMetadata::FilenameToMeta(p->first, 3).toInt(),
-                    MythDate::current().date(),
-                    0, ParentalLevel::plLowest);
-
-                LOG(VB_GENERAL, LOG_INFO, QString("Adding : %1 : %2 : %3")
-                        .arg(newFile.GetHost()).arg(newFile.GetFilename())
-                        .arg(hash));
-                newFile.SetHost(p->second.host);
-                newFile.SaveToDatabase();
-                m_addList << newFile.GetID();
+                // A copy of a file found earlier in this scan, which
+                // only gets one record, under the last name found
+                VideoMetadata *copy = newHashes[hash];
+                LOG(VB_GENERAL, LOG_ERR,
+                    QString("Hash %1 already exists in this scan, "
+                            "using new filename %2 instead of %3")
+                        .arg(hash).arg(p->filename)
+                        .arg(copy->GetFilename()));
+                copy->SetFilename(p->filename);
+                copy->SetHost(p->host);
+                id = 0;
             }
-            ret += 1;
         }
+        if (id == -1)
+        {
+            VideoMetadata *newFile = new VideoMetadata(
+                p->filename, hash,
+                VIDEO_TRAILER_DEFAULT,
+                VIDEO_COVERFILE_DEFAULT,
+                VIDEO_SCREENSHOT_DEFAULT,
+                VIDEO_BANNER_DEFAULT,
+                VIDEO_FANART_DEFAULT,
+                VideoMetadata::FilenameToMeta(p->filename, 1),
+                VideoMetadata::FilenameToMeta(p->filename, 4),
+                QString(),
+                VIDEO_YEAR_DEFAULT,
+                QDate::fromString("0000-00-00","YYYY-MM-DD"),
+                VIDEO_INETREF_DEFAULT, 0, QString(),
+                VIDEO_DIRECTOR_DEFAULT, QString(), VIDEO_PLOT_DEFAULT,
+                0.0, VIDEO_RATING_DEFAULT, 0, 0,
+                VideoMetadata::FilenameToMeta(p->filename, 2).toInt(),
+                VideoMetadata::FilenameToMeta(p->filename, 3).toInt(),
+                MythDate::current().date(),
+                0, ParentalLevel::plLowest);
+
+            LOG(VB_GENERAL, LOG_INFO, QString("Adding : %1 : %2 : %3")
+                    .arg(p->host).arg(newFile->GetFilename())
+                    .arg(hash));
+            newFile->SetHost(p->host);
+            newFiles.push_back(newFile);
+            if (hash != "NULL" && !hash.isEmpty())
+                newHashes[hash] = newFile;
+        }
+        ret += 1;
         if (m_HasGUI)
             SendProgressEvent(++counter);
     }
 
+    VideoMetadata::SaveToDatabase(newFiles);
+    while (!newFiles.isEmpty())
+    {
+        VideoMetadata *newFile = newFiles.takeFirst();
+        if (newFile->GetID())
+            m_addList << newFile->GetID();
+        delete newFile;
+    }
+
     // When prompting is restored, account for the answer here.
     ret += remove.size();
+    QList<unsigned int> orphans;
     for (PurgeList::const_iterator p = remove.begin(); p != remove.end();
             ++p)
     {
         if (!m_movList.contains(p->first))
         {
-            removeOrphans(p->first, p->second);
+            orphans << p->first;
             m_delList << p->first;
         }
         if (m_HasGUI)
             SendProgressEvent(++counter);
     }
+    removeOrphans(orphans);
 
     return ret;
 }
 
-bool VideoScannerThread::buildFileList(const QString &directory,
+bool VideoScannerThread::buildFileList(const QStringList &directories,
                                        const QStringList &imageExtensions,
-                                       FileCheckList &filelist)
+                                       FileCheckList &filelist,
+                                       DirectoryManifest &manifest,
+                                       QStringList &failed)
 {
     // TODO: FileCheckList is a std::map, keyed off the filename. In the event
     // multiple backends have access to shared storage, the potential exists
@@ -389,13 +498,14 @@ bool VideoScannerThread::buildFileList(const QString &directory,
     // the backend with the content stored in a storage group determined to be
     // local.
 
-    LOG(VB_GENERAL,LOG_INFO, QString("buildFileList directory = %1")
-                                 .arg(directory));
+    LOG(VB_GENERAL,LOG_INFO, QString("buildFileList directories = %1")
+                                 .arg(directories.join(", ")));
     FileAssociations::ext_ignore_list ext_list;
     FileAssociations::getFileAssociation().getExtensionIgnoreList(ext_list);
 
     dirhandler<FileCheckList> dh(filelist, imageExtensions);
-    return ScanVideoDirectory(directory, &dh, ext_list, m_ListUnknown);
+    return ScanVideoDirectories(directories, &dh, ext_list, m_ListUnknown,
+                                &manifest, failed);
 }
 
 void VideoScannerThread::SendProgressEvent(uint progress, uint total,
@@ -409,6 +519,47 @@ void VideoScannerThread::SendProgressEvent(uint progress, uint total,
     QApplication::postEvent(m_dialog, pue);
 }
 
+/// How long the directories have to be left alone before a rescan, in ms
+static const int kWatchSettleTime = 10 * 1000;
+
+VideoScanWatcher::VideoScanWatcher(QObject *parent) :
+    QObject(parent),
+    m_watcher(new QFileSystemWatcher(this)),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_watcher, SIGNAL(directoryChanged(const QString&)),
+            SLOT(directoryChanged(const QString&)));
+    connect(m_timer, SIGNAL(timeout()), SIGNAL(changed()));
+}
+
+/// \brief Watches just these directories from now on.
+void VideoScanWatcher::Watch(const QStringList &dirs)
+{
+    QSet<QString> wanted = dirs.toSet();
+    QSet<QString> watched = m_watcher->directories().toSet();
+
+    QStringList stale = (watched - wanted).toList();
+    QStringList added = (wanted - watched).toList();
+
+    if (!stale.isEmpty())
+        m_watcher->removePaths(stale);
+    if (!added.isEmpty())
+        m_watcher->addPaths(added);
+
+    LOG(VB_GENERAL, LOG_INFO,
+        QString("Watching %1 video directories for changes")
+            .arg(m_watcher->directories().size()));
+}
+
+void VideoScanWatcher::directoryChanged(const QString &path)
+{
+    LOG(VB_FILE, LOG_INFO,
+        QString("Video directory %1 changed, rescanning in %2 seconds")
+            .arg(path).arg(kWatchSettleTime / 1000));
+    m_timer->start(kWatchSettleTime);
+}
+
 VideoScanner::VideoScanner() : m_cancel(false)
 {
     m_scanThread = new VideoScannerThread(this);
@@ -18,6 +18,9 @@ class QStringList;
 class MythUIProgressDialog;
 
 class VideoMetadataListManager;
+class DirectoryManifest;
+class QFileSystemWatcher;
+class QTimer;
 
 class META_PUBLIC VideoScanner : public QObject
 {
@@ -41,6 +44,34 @@ class META_PUBLIC VideoScanner : public QObject
     bool                      m_cancel;
 };
 
+/** \class VideoScanWatcher
+ *  \brief Tells when something changes in the video directories.
+ *
+ *   The directories of the last scan are watched through inotify, or
+ *   whatever the platform offers. The changed() signal comes once things
+ *   have been quiet for a while, so copying in a whole series only causes
+ *   one rescan, and the directory manifest keeps that rescan short.
+ */
+class META_PUBLIC VideoScanWatcher : public QObject
+{
+    Q_OBJECT
+
+  public:
+    VideoScanWatcher(QObject *parent = NULL);
+
+    void Watch(const QStringList &dirs);
+
+  signals:
+    void changed(void);
+
+  private slots:
+    void directoryChanged(const QString &path);
+
+  private:
+    QFileSystemWatcher *m_watcher;
+    QTimer             *m_timer;
+};
+
 class META_PUBLIC VideoScanChanges : public QEvent
 {
   public:
@@ -70,6 +101,8 @@ class META_PUBLIC VideoScannerThread : public MThread
     void SetHosts(const QStringList &hosts);
     void SetProgressDialog(MythUIProgressDialog *dialog) { m_dialog = dialog; };
     QStringList GetOfflineSGHosts(void) { return m_offlineSGHosts; };
+    /// Local directories the last scan walked
+    QStringList GetWatchDirs(void) { return m_watchDirs; };
     bool getDataChanged() { return m_DBDataChanged; };
 
     void ResetCounts() { m_addList.clear(); m_movList.clear(); m_delList.clear(); };
@@ -85,13 +118,14 @@ class META_PUBLIC VideoScannerThread : public MThread
     typedef std::vector<std::pair<unsigned int, QString> > PurgeList;
     typedef std::map<QString, CheckStruct> FileCheckList;
 
-    void removeOrphans(unsigned int id, const QString &filename);
+    void removeOrphans(const QList<unsigned int> &ids);
 
     void verifyFiles(FileCheckList &files, PurgeList &remove);
     bool updateDB(const FileCheckList &add, const PurgeList &remove);
-    bool buildFileList(const QString &directory,
-                                        const QStringList &imageExtensions,
-                                        FileCheckList &filelist);
+    bool buildFileList(const QStringList &directories,
+                       const QStringList &imageExtensions,
+                       FileCheckList &filelist, DirectoryManifest &manifest,
+                       QStringList &failed);
 
     void SendProgressEvent(uint progress, uint total = 0,
             QString messsage = QString());
@@ -105,6 +139,7 @@ class META_PUBLIC VideoScannerThread : public MThread
     QStringList m_directories;
     QStringList m_liveSGHosts;
     QStringList m_offlineSGHosts;
+    QStringList m_watchDirs;
 
     VideoMetadataListManager *m_dbmetadata;
     MythUIProgressDialog *m_dialog;
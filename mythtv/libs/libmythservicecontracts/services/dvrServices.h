@@ -39,7 +39,7 @@
 class SERVICE_PUBLIC DvrServices : public Service  //, public QScriptable ???
 {
     Q_OBJECT
-    Q_CLASSINFO( "version"    , "1.9" );
+    Q_CLASSINFO( "version"    , "1.10" );
     Q_CLASSINFO( "RemoveRecordedItem_Method",                   "POST" )
     Q_CLASSINFO( "AddRecordSchedule_Method",                    "POST" )
     Q_CLASSINFO( "RemoveRecordSchedule_Method",                 "POST" )
@@ -70,7 +70,10 @@ class SERVICE_PUBLIC DvrServices : public Service  //, public QScriptable ???
                                                            int              Count,
                                                            const QString   &TitleRegEx,
                                                            const QString   &RecGroup,
-                                                           const QString   &StorageGroup ) = 0;
+                                                           const QString   &StorageGroup,
+                                                           const QDateTime &StartTime,
+                                                           const QDateTime &EndTime,
+                                                           const QString   &Sort ) = 0;
 
         virtual DTC::Program*      GetRecorded           ( int              ChanId,
                                                             const QDateTime &StartTime  ) = 0;
@@ -165,6 +165,52 @@ uint FIRFilter::evaluateFilterMono(SAMPLETYPE *dest, const SAMPLETYPE *src, uint
 }
 
 
+// Usual C-version of the filter routine for more than two channels
+uint FIRFilter::evaluateFilterMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels) const
+{
+    uint i, j, c, end;
+    LONG_SAMPLETYPE sums[MULTICHANNEL];
+#ifdef FLOAT_SAMPLES
+    // when using floating point samples, use a scaler instead of a divider
+    // because division is much slower operation than multiplying.
+    double dScaler = 1.0 / (double)resultDivider;
+#endif
+
+    assert(length != 0);
+    assert(numChannels <= MULTICHANNEL);
+
+    end = numChannels * (numSamples - length);
+
+    for (j = 0; j < end; j += numChannels) 
+    {
+        const SAMPLETYPE *ptr = src + j;
+
+        for (c = 0; c < numChannels; c++)
+            sums[c] = 0;
+
+        for (i = 0; i < length; i++) 
+        {
+            for (c = 0; c < numChannels; c++)
+                sums[c] += ptr[c] * filterCoeffs[i];
+            ptr += numChannels;
+        }
+
+        for (c = 0; c < numChannels; c++)
+        {
+#ifdef INTEGER_SAMPLES
+            sums[c] >>= resultDivFactor;
+            // saturate to 16 bit integer limits
+            sums[c] = (sums[c] < -32768) ? -32768 : (sums[c] > 32767) ? 32767 : sums[c];
+#else
+            sums[c] *= dScaler;
+#endif // INTEGER_SAMPLES
+            dest[j + c] = (SAMPLETYPE)sums[c];
+        }
+    }
+    return numSamples - length;
+}
+
+
 // Set filter coeffiecients and length.
 //
 // Throws an exception if filter length isn't divisible by 8
@@ -199,7 +245,11 @@ uint FIRFilter::getLength() const
 // smaller than the amount of input samples.
 uint FIRFilter::evaluate(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples, uint numChannels) const
 {
+#ifdef MULTICHANNEL
+    assert(numChannels >= 1 && numChannels <= MULTICHANNEL);
+#else
     assert(numChannels == 1 || numChannels == 2);
+#endif
 
     assert(length > 0);
     assert(lengthDiv8 * 8 == length);
@@ -208,8 +258,10 @@ uint FIRFilter::evaluate(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSample
     if (numChannels == 2) 
     {
         return evaluateFilterStereo(dest, src, numSamples);
-    } else {
+    } else if (numChannels == 1) {
         return evaluateFilterMono(dest, src, numSamples);
+    } else {
+        return evaluateFilterMulti(dest, src, numSamples, numChannels);
     }
 }
 
@@ -232,6 +284,14 @@ FIRFilter * FIRFilter::newInstance()
     uExtensions = detectCPUextensions();
 
     // Check if MMX/SSE/3DNow! instruction set extensions supported by CPU
+#ifdef ALLOW_AVX2
+    if (uExtensions & MM_AVX2)
+    {
+        // AVX2 support
+        return ::new FIRFilterAVX2;
+    }
+    else
+#endif // ALLOW_AVX2
 #ifdef ALLOW_SSE2
     if (uExtensions & MM_SSE2)
     {
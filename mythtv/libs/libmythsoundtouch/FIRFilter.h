@@ -67,6 +67,10 @@ protected:
     virtual uint evaluateFilterMono(soundtouch::SAMPLETYPE *dest, 
                                     const soundtouch::SAMPLETYPE *src, 
                                     uint numSamples) const;
+    virtual uint evaluateFilterMulti(soundtouch::SAMPLETYPE *dest, 
+                                     const soundtouch::SAMPLETYPE *src, 
+                                     uint numSamples, 
+                                     uint numChannels) const;
 
 public:
     FIRFilter();
@@ -116,6 +120,29 @@ public:
 
 #endif // ALLOW_SSE2
 
+#ifdef ALLOW_AVX2
+    /// Class that implements AVX2/FMA optimized functions exclusive for
+    /// floating point samples type, for any number of channels.
+    class FIRFilterAVX2 : public FIRFilter
+    {
+    protected:
+        /// Coefficients divided by resultDivider
+        float *filterCoeffsScaled;
+        /// Scaled coefficients with each one repeated for both channels
+        float *filterCoeffsStereo;
+
+        virtual uint evaluateFilterStereo(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMono(float *dest, const float *src, uint numSamples) const;
+        virtual uint evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels) const;
+    public:
+        FIRFilterAVX2();
+        ~FIRFilterAVX2();
+
+        virtual void setCoefficients(const float *coeffs, uint newLength, uint uResultDivFactor);
+    };
+
+#endif // ALLOW_AVX2
+
 #ifdef ALLOW_MMX
 
     /// Class that implements MMX optimized functions exclusive for 16bit integer samples type.
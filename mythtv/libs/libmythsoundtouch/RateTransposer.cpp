@@ -45,6 +45,7 @@
 #include <limits.h>
 #include "RateTransposer.h"
 #include "AAFilter.h"
+#include "cpu_detect.h"
 
 using namespace soundtouch;
 
@@ -57,6 +58,7 @@ protected:
     int iSlopeCount;
     uint uRate;
     SAMPLETYPE sPrevSampleL, sPrevSampleR;
+    SAMPLETYPE sPrevSample[MULTICHANNEL];
 
     virtual void resetRegisters();
 
@@ -66,6 +68,9 @@ protected:
     virtual uint transposeMono(SAMPLETYPE *dest, 
                        const SAMPLETYPE *src, 
                        uint numSamples);
+    virtual uint transposeMulti(SAMPLETYPE *dest, 
+                        const SAMPLETYPE *src, 
+                        uint numSamples);
 
 public:
     RateTransposerInteger();
@@ -78,30 +83,6 @@ public:
 };
 
 
-/// A linear samplerate transposer class that uses floating point arithmetics
-/// for the transposing.
-class RateTransposerFloat : public RateTransposer
-{
-protected:
-    float fSlopeCount;
-    float fRateStep;
-    SAMPLETYPE sPrevSampleL, sPrevSampleR;
-
-    virtual void resetRegisters();
-
-    virtual uint transposeStereo(SAMPLETYPE *dest, 
-                         const SAMPLETYPE *src, 
-                         uint numSamples);
-    virtual uint transposeMono(SAMPLETYPE *dest, 
-                       const SAMPLETYPE *src, 
-                       uint numSamples);
-
-public:
-    RateTransposerFloat();
-    virtual ~RateTransposerFloat();
-};
-
-
 
 #ifndef min
 #define min(a,b) ((a > b) ? b : a)
@@ -124,6 +105,10 @@ RateTransposer *RateTransposer::newInstance()
 #ifdef INTEGER_SAMPLES
     return ::new RateTransposerInteger;
 #else
+#ifdef ALLOW_AVX2
+    if (detectCPUextensions() & MM_AVX2)
+        return ::new RateTransposerFloatAVX2;
+#endif // ALLOW_AVX2
     return ::new RateTransposerFloat;
 #endif
 }
@@ -318,10 +303,14 @@ inline uint RateTransposer::transpose(SAMPLETYPE *dest, const SAMPLETYPE *src, u
     {
         return transposeStereo(dest, src, numSamples);
     } 
-    else 
+    else if (uChannels == 1) 
     {
         return transposeMono(dest, src, numSamples);
     }
+    else 
+    {
+        return transposeMulti(dest, src, numSamples);
+    }
 }
 
 
@@ -394,6 +383,7 @@ void RateTransposerInteger::resetRegisters()
     iSlopeCount = 0;
     sPrevSampleL = 
     sPrevSampleR = 0;
+    memset(sPrevSample, 0, sizeof(sPrevSample));
 }
 
 
@@ -498,6 +488,65 @@ end:
 }
 
 
+// Transposes the sample rate of the given samples using linear interpolation. 
+// 'Multichannel' version of the routine. Returns the number of samples 
+// returned in the "dest" buffer
+uint RateTransposerInteger::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples)
+{
+    unsigned int srcPos, i, c, used;
+    LONG_SAMPLETYPE temp, vol1;
+
+    if (numSamples == 0) return 0;  // no samples, no work
+
+    used = 0;    
+    i = 0;
+
+    // Process the last sample saved from the previous call first...
+    while (iSlopeCount <= SCALE) 
+    {
+        vol1 = (LONG_SAMPLETYPE)(SCALE - iSlopeCount);
+        for (c = 0; c < uChannels; c++)
+        {
+            temp = vol1 * sPrevSample[c] + iSlopeCount * src[c];
+            dest[uChannels * i + c] = (SAMPLETYPE)(temp / SCALE);
+        }
+        i++;
+        iSlopeCount += uRate;
+    }
+    // now always (iSlopeCount > SCALE)
+    iSlopeCount -= SCALE;
+
+    if (numSamples == 1) goto end;
+
+    while (1)
+    {
+        while (iSlopeCount > SCALE) 
+        {
+            iSlopeCount -= SCALE;
+            used ++;
+            if (used >= numSamples - 1) goto end;
+        }
+        srcPos = uChannels * used;
+        vol1 = (LONG_SAMPLETYPE)(SCALE - iSlopeCount);
+        for (c = 0; c < uChannels; c++)
+        {
+            temp = src[srcPos + c] * vol1 + 
+                   iSlopeCount * src[srcPos + uChannels + c];
+            dest[uChannels * i + c] = (SAMPLETYPE)(temp / SCALE);
+        }
+
+        i++;
+        iSlopeCount += uRate;
+    }
+end:
+    // Store the last sample for the next round
+    memcpy(sPrevSample, src + uChannels * (numSamples - 1), 
+           uChannels * sizeof(SAMPLETYPE));
+
+    return i;
+}
+
+
 // Sets new target uRate. Normal uRate = 1.0, smaller values represent slower 
 // uRate, larger faster uRates.
 void RateTransposerInteger::setRate(float newRate)
@@ -534,6 +583,7 @@ void RateTransposerFloat::resetRegisters()
     fSlopeCount = 0;
     sPrevSampleL = 
     sPrevSampleR = 0;
+    memset(sPrevSample, 0, sizeof(sPrevSample));
 }
 
 
@@ -629,3 +679,55 @@ end:
 
     return i;
 }
+
+
+// Transposes the sample rate of the given samples using linear interpolation. 
+// 'Multichannel' version of the routine. Returns the number of samples 
+// returned in the "dest" buffer
+uint RateTransposerFloat::transposeMulti(SAMPLETYPE *dest, const SAMPLETYPE *src, uint numSamples)
+{
+    unsigned int srcPos, i, c, used;
+
+    if (numSamples == 0) return 0;  // no samples, no work
+
+    used = 0;    
+    i = 0;
+
+    // Process the last sample saved from the previous call first...
+    while (fSlopeCount <= 1.0f) 
+    {
+        for (c = 0; c < uChannels; c++)
+            dest[uChannels * i + c] = (SAMPLETYPE)((1.0f - fSlopeCount) * 
+                sPrevSample[c] + fSlopeCount * src[c]);
+        i++;
+        fSlopeCount += fRate;
+    }
+    // now always (fSlopeCount > 1.0f)
+    fSlopeCount -= 1.0f;
+
+    if (numSamples == 1) goto end;
+
+    while (1)
+    {
+        while (fSlopeCount > 1.0f) 
+        {
+            fSlopeCount -= 1.0f;
+            used ++;
+            if (used >= numSamples - 1) goto end;
+        }
+        srcPos = uChannels * used;
+
+        for (c = 0; c < uChannels; c++)
+            dest[uChannels * i + c] = (SAMPLETYPE)((1.0f - fSlopeCount) * 
+                src[srcPos + c] + fSlopeCount * src[srcPos + uChannels + c]);
+
+        i++;
+        fSlopeCount += fRate;
+    }
+end:
+    // Store the last sample for the next round
+    memcpy(sPrevSample, src + uChannels * (numSamples - 1), 
+           uChannels * sizeof(SAMPLETYPE));
+
+    return i;
+}
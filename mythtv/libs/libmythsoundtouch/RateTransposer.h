@@ -92,6 +92,9 @@ protected:
     virtual uint transposeMono(soundtouch::SAMPLETYPE *dest, 
                        const soundtouch::SAMPLETYPE *src, 
                        uint numSamples) = 0;
+    virtual uint transposeMulti(soundtouch::SAMPLETYPE *dest, 
+                        const soundtouch::SAMPLETYPE *src, 
+                        uint numSamples) = 0;
     uint transpose(soundtouch::SAMPLETYPE *dest, 
                    const soundtouch::SAMPLETYPE *src, 
                    uint numSamples);
@@ -157,6 +160,44 @@ public:
     int isEmpty() const;
 };
 
+
+/// A linear samplerate transposer class that uses floating point arithmetics
+/// for the transposing.
+class RateTransposerFloat : public RateTransposer
+{
+protected:
+    float fSlopeCount;
+    float fRateStep;
+    soundtouch::SAMPLETYPE sPrevSampleL, sPrevSampleR;
+    soundtouch::SAMPLETYPE sPrevSample[MULTICHANNEL];
+
+    virtual void resetRegisters();
+
+    virtual uint transposeStereo(soundtouch::SAMPLETYPE *dest, 
+                         const soundtouch::SAMPLETYPE *src, 
+                         uint numSamples);
+    virtual uint transposeMono(soundtouch::SAMPLETYPE *dest, 
+                       const soundtouch::SAMPLETYPE *src, 
+                       uint numSamples);
+    virtual uint transposeMulti(soundtouch::SAMPLETYPE *dest, 
+                        const soundtouch::SAMPLETYPE *src, 
+                        uint numSamples);
+
+public:
+    RateTransposerFloat();
+    virtual ~RateTransposerFloat();
+};
+
+#ifdef ALLOW_AVX2
+    /// Floating point transposer that interpolates all channels of a
+    /// multichannel frame at once with AVX2/FMA.
+    class RateTransposerFloatAVX2 : public RateTransposerFloat
+    {
+    protected:
+        virtual uint transposeMulti(float *dest, const float *src, uint numSamples);
+    };
+#endif // ALLOW_AVX2
+
 }
 
 #endif
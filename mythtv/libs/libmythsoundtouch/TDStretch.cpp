@@ -803,6 +803,14 @@ TDStretch * TDStretch::newInstance()
     uExtensions = detectCPUextensions();
 
     // Check if MMX/SSE/3DNow! instruction set extensions supported by CPU
+#ifdef ALLOW_AVX2
+    if (uExtensions & MM_AVX2)
+    {
+        // AVX2 support
+        return ::new TDStretchAVX2;
+    }
+    else
+#endif // ALLOW_AVX2
 #ifdef ALLOW_SSE3
     if (uExtensions & MM_SSE3)
     {
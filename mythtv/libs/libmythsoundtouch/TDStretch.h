@@ -264,6 +264,22 @@ public:
 
 #endif /// ALLOW_SSE3
 
+#ifdef ALLOW_AVX2
+    /// Class that implements AVX2/FMA optimized routines for float samples
+    /// type, including the multichannel (5.1, 7.1) paths.
+    class TDStretchAVX2 : public TDStretch
+    {
+    protected:
+#ifdef MULTICHANNEL
+        double calcCrossCorrMulti(const float *mixingPos, const float *compare) const;
+        virtual void overlapMulti(float *output, const float *input) const;
+#endif
+        double calcCrossCorrStereo(const float *mixingPos, const float *compare) const;
+        virtual void overlapStereo(float *output, const float *input) const;
+    };
+
+#endif /// ALLOW_AVX2
+
 #ifdef ALLOW_MMX
     /// Class that implements MMX optimized routines for 16bit integer samples type.
     class TDStretchMMX : public TDStretch
@@ -0,0 +1,306 @@
+// AVX2/FMA versions of the expensive routines for float samples
+//
+// These are compiled with a function level target attribute so that the
+// rest of the library can still be built for the baseline CPU; they are
+// only ever called when detectCPUextensions() reports MM_AVX2.
+
+#include <string.h>
+#include <immintrin.h>
+
+#include "STTypes.h"
+#include "TDStretch.h"
+#include "FIRFilter.h"
+#include "RateTransposer.h"
+
+using namespace soundtouch;
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+// Lane masks for loading/storing the first 'n' floats of a frame
+static const int laneMask[16] =
+    { -1, -1, -1, -1, -1, -1, -1, -1,  0,  0,  0,  0,  0,  0,  0,  0 };
+
+static inline AVX2_TARGET __m256i maskFirst(uint n)
+{
+    return _mm256_loadu_si256((const __m256i *)(laneMask + 8 - n));
+}
+
+static inline AVX2_TARGET double hsum(__m256 v)
+{
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    __m256d d = _mm256_add_pd(_mm256_cvtps_pd(lo), _mm256_cvtps_pd(hi));
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(d),
+                           _mm256_extractf128_pd(d, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+// Dot product of 'count' floats
+static AVX2_TARGET double dot(const float *a, const float *b, uint count)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    uint i = 0;
+
+    for (; i + 16 <= count; i += 16)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),
+                               _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),
+                               _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    if (i + 8 <= count)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),
+                               _mm256_loadu_ps(b + i), acc0);
+        i += 8;
+    }
+
+    double corr = hsum(_mm256_add_ps(acc0, acc1));
+    for (; i < count; i++)
+        corr += a[i] * b[i];
+
+    return corr;
+}
+
+// Cross-correlation skips the first frame, like the C version
+AVX2_TARGET double TDStretchAVX2::calcCrossCorrStereo(const float *mPos, const float *cPos) const
+{
+    return dot(mPos + 2, cPos + 2, 2 * (overlapLength - 1));
+}
+
+AVX2_TARGET double TDStretchAVX2::calcCrossCorrMulti(const float *mPos, const float *cPos) const
+{
+    return dot(mPos + channels, cPos + channels, channels * (overlapLength - 1));
+}
+
+// Cross fade 'count' floats of 'input' in over 'pMidBuffer', 'chans'
+// interleaved channels at a time
+static AVX2_TARGET void crossFade(float *output, const float *input,
+                                  const float *mid, uint count, uint chans,
+                                  uint overlapLength)
+{
+    const float fScale = 1.0f / (float)overlapLength;
+    const float fChans = 1.0f / (float)chans;
+    const __m256 vScale = _mm256_set1_ps(fScale);
+    const __m256 vChans = _mm256_set1_ps(fChans);
+    const __m256 vHalf  = _mm256_set1_ps(0.5f);
+    const __m256 vStep  = _mm256_set1_ps(8.0f);
+    __m256 idx = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    uint i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        // frame number of each lane, then its fade in weight
+        __m256 frame = _mm256_floor_ps(
+            _mm256_mul_ps(_mm256_add_ps(idx, vHalf), vChans));
+        __m256 fi  = _mm256_mul_ps(frame, vScale);
+        __m256 in  = _mm256_loadu_ps(input + i);
+        __m256 md  = _mm256_loadu_ps(mid + i);
+        _mm256_storeu_ps(output + i,
+                         _mm256_fmadd_ps(_mm256_sub_ps(in, md), fi, md));
+        idx = _mm256_add_ps(idx, vStep);
+    }
+
+    for (; i < count; i++)
+    {
+        float fi = (float)(i / chans) * fScale;
+        output[i] = mid[i] + (input[i] - mid[i]) * fi;
+    }
+}
+
+AVX2_TARGET void TDStretchAVX2::overlapStereo(float *output, const float *input) const
+{
+    crossFade(output, input, pMidBuffer, 2 * overlapLength, 2, overlapLength);
+}
+
+AVX2_TARGET void TDStretchAVX2::overlapMulti(float *output, const float *input) const
+{
+    crossFade(output, input, pMidBuffer, channels * overlapLength, channels,
+              overlapLength);
+}
+
+
+FIRFilterAVX2::FIRFilterAVX2() : FIRFilter()
+{
+    filterCoeffsScaled = NULL;
+    filterCoeffsStereo = NULL;
+}
+
+FIRFilterAVX2::~FIRFilterAVX2()
+{
+    delete[] filterCoeffsScaled;
+    delete[] filterCoeffsStereo;
+    filterCoeffsScaled = NULL;
+    filterCoeffsStereo = NULL;
+}
+
+// Keeps the coefficients pre-divided so the kernels need no final scaling
+void FIRFilterAVX2::setCoefficients(const float *coeffs, uint newLen, uint uRDF)
+{
+    uint i;
+    FIRFilter::setCoefficients(coeffs, newLen, uRDF);
+
+    delete[] filterCoeffsScaled;
+    delete[] filterCoeffsStereo;
+    filterCoeffsScaled = new float[newLen];
+    filterCoeffsStereo = new float[2 * newLen];
+
+    float fdiv = (float)resultDivider;
+    for (i = 0; i < newLen; i++)
+    {
+        filterCoeffsScaled[i] = coeffs[i] / fdiv;
+        filterCoeffsStereo[2 * i + 0] =
+        filterCoeffsStereo[2 * i + 1] = coeffs[i] / fdiv;
+    }
+}
+
+AVX2_TARGET uint FIRFilterAVX2::evaluateFilterMono(float *dest, const float *src, uint numSamples) const
+{
+    uint j, end;
+
+    end = numSamples - length;
+    for (j = 0; j < end; j++)
+        dest[j] = (float)dot(src + j, filterCoeffsScaled, length);
+
+    return end;
+}
+
+AVX2_TARGET uint FIRFilterAVX2::evaluateFilterStereo(float *dest, const float *src, uint numSamples) const
+{
+    uint i, j, end, count;
+
+    end = 2 * (numSamples - length);
+    count = 2 * length;
+
+    for (j = 0; j < end; j += 2)
+    {
+        const float *ptr = src + j;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+
+        // even lanes accumulate the left channel, odd lanes the right
+        for (i = 0; i + 16 <= count; i += 16)
+        {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(ptr + i),
+                                   _mm256_loadu_ps(filterCoeffsStereo + i), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(ptr + i + 8),
+                                   _mm256_loadu_ps(filterCoeffsStereo + i + 8), acc1);
+        }
+        if (i + 8 <= count)
+        {
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(ptr + i),
+                                   _mm256_loadu_ps(filterCoeffsStereo + i), acc0);
+            i += 8;
+        }
+
+        __m256 acc = _mm256_add_ps(acc0, acc1);
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc),
+                              _mm256_extractf128_ps(acc, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+
+        float suml = _mm_cvtss_f32(s);
+        float sumr = _mm_cvtss_f32(_mm_shuffle_ps(s, s, 1));
+        for (; i < count; i += 2)
+        {
+            suml += ptr[i + 0] * filterCoeffsStereo[i + 0];
+            sumr += ptr[i + 1] * filterCoeffsStereo[i + 1];
+        }
+
+        dest[j + 0] = suml;
+        dest[j + 1] = sumr;
+    }
+    return numSamples - length;
+}
+
+// One frame of up to eight channels per vector, so 5.1 and 7.1 need no
+// shuffling at all
+AVX2_TARGET uint FIRFilterAVX2::evaluateFilterMulti(float *dest, const float *src, uint numSamples, uint numChannels) const
+{
+    uint i, j, end;
+    __m256i mask = maskFirst(numChannels);
+
+    end = numChannels * (numSamples - length);
+
+    for (j = 0; j < end; j += numChannels)
+    {
+        const float *ptr = src + j;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+
+        for (i = 0; i + 2 <= length; i += 2)
+        {
+            acc0 = _mm256_fmadd_ps(_mm256_maskload_ps(ptr, mask),
+                                   _mm256_broadcast_ss(filterCoeffsScaled + i),
+                                   acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_maskload_ps(ptr + numChannels, mask),
+                                   _mm256_broadcast_ss(filterCoeffsScaled + i + 1),
+                                   acc1);
+            ptr += 2 * numChannels;
+        }
+        if (i < length)
+        {
+            acc0 = _mm256_fmadd_ps(_mm256_maskload_ps(ptr, mask),
+                                   _mm256_broadcast_ss(filterCoeffsScaled + i),
+                                   acc0);
+        }
+
+        _mm256_maskstore_ps(dest + j, mask, _mm256_add_ps(acc0, acc1));
+    }
+    return numSamples - length;
+}
+
+
+// Interpolates every channel of a frame in one vector operation
+AVX2_TARGET uint RateTransposerFloatAVX2::transposeMulti(float *dest, const float *src, uint numSamples)
+{
+    unsigned int i, used;
+    __m256i mask = maskFirst(uChannels);
+
+    if (numSamples == 0) return 0;  // no samples, no work
+
+    used = 0;
+    i = 0;
+
+    // Process the last sample saved from the previous call first...
+    __m256 prev = _mm256_maskload_ps(sPrevSample, mask);
+    __m256 next = _mm256_maskload_ps(src, mask);
+    while (fSlopeCount <= 1.0f)
+    {
+        __m256 slope = _mm256_set1_ps(fSlopeCount);
+        _mm256_maskstore_ps(dest + uChannels * i, mask,
+            _mm256_fmadd_ps(_mm256_sub_ps(next, prev), slope, prev));
+        i++;
+        fSlopeCount += fRate;
+    }
+    // now always (fSlopeCount > 1.0f)
+    fSlopeCount -= 1.0f;
+
+    if (numSamples > 1)
+    {
+        while (1)
+        {
+            while (fSlopeCount > 1.0f)
+            {
+                fSlopeCount -= 1.0f;
+                used ++;
+                if (used >= numSamples - 1) goto end;
+            }
+            const float *sp = src + uChannels * used;
+            prev = _mm256_maskload_ps(sp, mask);
+            next = _mm256_maskload_ps(sp + uChannels, mask);
+
+            __m256 slope = _mm256_set1_ps(fSlopeCount);
+            _mm256_maskstore_ps(dest + uChannels * i, mask,
+                _mm256_fmadd_ps(_mm256_sub_ps(next, prev), slope, prev));
+            i++;
+            fSlopeCount += fRate;
+        }
+    }
+end:
+    // Store the last sample for the next round
+    memcpy(sPrevSample, src + uChannels * (numSamples - 1),
+           uChannels * sizeof(float));
+
+    return i;
+}
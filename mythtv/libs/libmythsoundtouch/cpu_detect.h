@@ -55,6 +55,8 @@
 #define MM_SSSE3  0x0080 /* SSSE3 functions */
 #define MM_SSE4   0x0100 /* SSE4.1 functions */
 #define MM_SSE42  0x0200 /* SSE4.2 functions */
+#define MM_AVX    0x0400 /* AVX functions, with OS support for YMM state */
+#define MM_AVX2   0x0800 /* AVX2 and FMA3 functions */
 
 /// Checks which instruction set extensions are supported by the CPU.
 ///
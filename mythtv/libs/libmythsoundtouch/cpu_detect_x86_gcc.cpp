@@ -89,6 +89,26 @@ void disableExtensions(uint dwDisableMask)
            "=c" (ecx), "=d" (edx)\
          : "0" (index));
 
+/* cpuid leaf 7 needs the sub-leaf in ecx */
+#define cpuid_count(index,count,eax,ebx,ecx,edx)\
+    __asm __volatile\
+        ("mov %%"REG_b", %%"REG_S"\n\t"\
+         "cpuid\n\t"\
+         "xchg %%"REG_b", %%"REG_S\
+         : "=a" (eax), "=S" (ebx),\
+           "=c" (ecx), "=d" (edx)\
+         : "0" (index), "2" (count));
+
+/* Returns the low word of XCR0, which says which register states the OS
+   saves on a context switch */
+static int xgetbv0(void)
+{
+    int eax, edx;
+    __asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" /* xgetbv */
+                          : "=a" (eax), "=d" (edx) : "c" (0));
+    return eax;
+}
+
 /* Function to test if multimedia instructions are supported...  */
 static int mm_support(void)
 {
@@ -139,6 +159,20 @@ static int mm_support(void)
             rval |= MM_SSE4;
         if (ecx & 0x00100000 )
             rval |= MM_SSE42;
+        /* AVX needs both the CPU flag and the OS saving the YMM registers
+           (OSXSAVE set, and XCR0 bits 1 and 2) */
+        if ((ecx & 0x18000000) == 0x18000000 && (xgetbv0() & 0x6) == 0x6)
+        {
+            rval |= MM_AVX;
+            /* FMA3 is required by the AVX2 code paths */
+            if (max_std_level >= 7 && (ecx & 0x00001000))
+            {
+                int ecx7, edx7;
+                cpuid_count(7, 0, eax, ebx, ecx7, edx7);
+                if (ebx & 0x00000020)
+                    rval |= MM_AVX2;
+            }
+        }
     }
 
     cpuid(0x80000000, max_ext_level, ebx, ecx, edx);
@@ -31,6 +31,10 @@ SOURCES += cpu_detect_x86_gcc.cpp
 contains(ARCH_X86, yes) {
         DEFINES += ALLOW_SSE2 ALLOW_SSE3
         SOURCES += sse_gcc.cpp
+        # AVX2 kernels are built with a per function target attribute and
+        # only used when the CPU and OS support them
+        DEFINES += ALLOW_AVX2
+        SOURCES += avx2_gcc.cpp
 }
 
 include ( ../libs-targetfix.pro )
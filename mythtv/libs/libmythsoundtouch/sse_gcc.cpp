@@ -342,6 +342,12 @@ uint FIRFilterSSE2::evaluateFilterStereo(float *dest, const float *src, const ui
 
     for (int i = 0; i < count; i += 2)
     {
+        // the asm advances these, so they must be in/out operands
+        float *dp = dest;
+        const float *sp = src;
+        const float *cp = filterCoeffsAlign;
+        uint loops = length >> 3;
+
         __asm__ volatile(
             "xorpd      %%xmm6, %%xmm6          \n\t"
             "xorpd      %%xmm7, %%xmm7          \n\t"
@@ -379,8 +385,9 @@ uint FIRFilterSSE2::evaluateFilterStereo(float *dest, const float *src, const ui
             "shufps     $0xe4,  %%xmm7, %%xmm6  \n\t"
             "addps      %%xmm0, %%xmm6          \n\t"
             "movups     %%xmm6, (%0)            \n\t"
+            :"+r"(dp),"+r"(sp),"+r"(cp),"+c"(loops)
             :
-            :"r"(dest),"r"(src),"r"(filterCoeffsAlign),"c"(length>>3)
+            :"memory","xmm0","xmm1","xmm2","xmm3","xmm4","xmm6","xmm7"
         );
         src  += 4;
         dest += 4;
@@ -383,11 +383,22 @@ bool HTTPLiveStream::WriteMetaPlaylist(void)
 
     file.write(QString(
         "#EXTM3U\n"
-        "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%1\n"
-        "%2.m3u8\n"
+        "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%1,RESOLUTION=%2x%3\n"
+        "%4.m3u8\n"
         ).arg((int)((m_bitrate + m_audioBitrate) * 1.1))
+         .arg(m_width).arg(m_height)
          .arg(m_outFileEncoded).toLatin1());
 
+    QList<HLSVariant>::const_iterator it = m_variants.begin();
+    for (; it != m_variants.end(); ++it)
+    {
+        file.write(QString(
+            "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%1,RESOLUTION=%2x%3\n"
+            "%4\n"
+            ).arg((*it).bandwidth).arg((*it).width).arg((*it).height)
+             .arg((*it).playlist).toLatin1());
+    }
+
     if (m_audioOnlyBitrate)
     {
         file.write(QString(
@@ -402,6 +413,34 @@ bool HTTPLiveStream::WriteMetaPlaylist(void)
     return true;
 }
 
+/** \brief Adds another stream of the same source to the meta playlist.
+ *
+ *  The variant's segments and playlist are written by the variant itself,
+ *  this only makes the variant known to clients reading the meta playlist
+ *  written by the next call to WriteMetaPlaylist().
+ */
+void HTTPLiveStream::AddVariant(const HTTPLiveStream &variant)
+{
+    HLSVariant v;
+    v.width     = variant.m_width;
+    v.height    = variant.m_height;
+    v.bandwidth = (uint32_t)((variant.m_bitrate + variant.m_audioBitrate) * 1.1);
+    v.playlist  = variant.m_outFileEncoded + ".m3u8";
+
+    QList<HLSVariant>::iterator it = m_variants.begin();
+    while (it != m_variants.end() && (*it).bandwidth > v.bandwidth)
+        ++it;
+    m_variants.insert(it, v);
+}
+
+/// \brief Stops this stream from writing an audio-only playlist.
+void HTTPLiveStream::DisableAudioOnly(void)
+{
+    m_audioOnlyBitrate = 0;
+    m_audioOutFile.clear();
+    m_audioOutFileEncoded.clear();
+}
+
 QString HTTPLiveStream::GetPlaylistName(bool audioOnly) const
 {
     if (m_streamid == -1)
@@ -2,6 +2,7 @@
 #define HTTPLIVESTREAM_H
 
 #include <QString>
+#include <QList>
 
 #include "datacontracts/liveStreamInfoList.h"
 
@@ -56,6 +57,9 @@ class MTV_PUBLIC HTTPLiveStream
     int      AddStream(void);
     bool     AddSegment(void);
 
+    void AddVariant(const HTTPLiveStream &variant);
+    void DisableAudioOnly(void);
+
     bool WriteHTML(void);
     bool WriteMetaPlaylist(void);
     bool WritePlaylist(bool audioOnly = false, bool writeEndTag = false);
@@ -115,6 +119,16 @@ class MTV_PUBLIC HTTPLiveStream
     QString     m_statusMessage;
 
     HTTPLiveStreamStatus m_status;
+
+    /// Other bitrates of the same source listed in the meta playlist
+    typedef struct hlsVariant
+    {
+        uint16_t width;
+        uint16_t height;
+        uint32_t bandwidth;
+        QString  playlist;
+    } HLSVariant;
+    QList<HLSVariant> m_variants;
 };
 
 #endif
@@ -13,6 +13,7 @@
 
 // Qt headers
 #include <QString>
+#include <QMap>
 
 // MythTV headers
 #include "ThreadedFileWriter.h"
@@ -43,6 +44,38 @@ void TFWSyncThread::run(void)
 const uint ThreadedFileWriter::kMaxBufferSize = 128 * 1024 * 1024;
 const uint ThreadedFileWriter::kMinWriteSize = 64 * 1024;
 
+/// How long a write latency sample is remembered, in milliseconds
+static const int kLatencyWindow = 5000;
+
+/// Recent write latency of the writers on one filesystem
+class TFWLatency
+{
+  public:
+    TFWLatency() : writers(0), current(0), previous(0)
+    {
+        window.start();
+    }
+
+    /// Starts a new window once the current one is old enough
+    void Rotate(void)
+    {
+        int elapsed = window.elapsed();
+        if (elapsed < kLatencyWindow)
+            return;
+        previous = (elapsed < 2 * kLatencyWindow) ? current : 0;
+        current  = 0;
+        window.start();
+    }
+
+    int       writers;
+    int       current;  ///< worst latency in this window, in ms
+    int       previous; ///< worst latency in the previous window, in ms
+    MythTimer window;
+};
+
+static QMutex                  tfw_latency_lock;
+static QMap<dev_t, TFWLatency> tfw_latency;
+
 /** \class ThreadedFileWriter
  *  \brief This class supports the writing of recordings to disk.
  *
@@ -62,6 +95,7 @@ ThreadedFileWriter::ThreadedFileWriter(const QString &fname,
     // file stuff
     filename(fname),                     flags(pflags),
     mode(pmode),                         fd(-1),
+    device(0),                           registered(false),
     // state
     flush(false),                        in_dtor(false),
     ignore_writes(false),                tfw_min_write_size(kMinWriteSize),
@@ -86,6 +120,7 @@ bool ThreadedFileWriter::ReOpen(QString newFilename)
 
     if (fd >= 0)
     {
+        UnregisterDevice();
         close(fd);
         fd = -1;
     }
@@ -127,6 +162,8 @@ bool ThreadedFileWriter::Open(void)
 #ifdef USING_MINGW
         _setmode(fd, _O_BINARY);
 #endif
+        RegisterDevice();
+
         if (!writeThread)
         {
             writeThread = new TFWWriteThread(this);
@@ -185,11 +222,81 @@ ThreadedFileWriter::~ThreadedFileWriter()
 
     if (fd >= 0)
     {
+        UnregisterDevice();
         close(fd);
         fd = -1;
     }
 }
 
+/** \brief Counts this writer against the filesystem it writes to, so
+ *         GetWriteLatency() knows someone is recording there.
+ */
+void ThreadedFileWriter::RegisterDevice(void)
+{
+    UnregisterDevice();
+
+    struct stat st;
+    if (filename == "-" || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return;
+
+    QMutexLocker locker(&tfw_latency_lock);
+    device = st.st_dev;
+    registered = true;
+    tfw_latency[device].writers++;
+}
+
+void ThreadedFileWriter::UnregisterDevice(void)
+{
+    QMutexLocker locker(&tfw_latency_lock);
+    if (!registered)
+        return;
+    registered = false;
+
+    QMap<dev_t, TFWLatency>::iterator it = tfw_latency.find(device);
+    if (it != tfw_latency.end() && --(*it).writers <= 0)
+        tfw_latency.erase(it);
+}
+
+/// \brief Records how long a write or sync to our filesystem took.
+void ThreadedFileWriter::ReportLatency(int msecs)
+{
+    QMutexLocker locker(&tfw_latency_lock);
+    if (!registered)
+        return;
+
+    TFWLatency &latency = tfw_latency[device];
+    latency.Rotate();
+    latency.current = qMax(latency.current, msecs);
+}
+
+/** \brief Worst time a write or sync by any ThreadedFileWriter on the
+ *         filesystem 'dev' took in the last few seconds.
+ *
+ *  This lets background work on the same disk, such as slow deletes,
+ *  back off when it starts to hold up recordings.
+ *
+ *  \param dev     st_dev of the filesystem
+ *  \param writers if not NULL, set to the number of open writers on it
+ *  \return latency in milliseconds, 0 if nothing is writing there
+ */
+int ThreadedFileWriter::GetWriteLatency(dev_t dev, int *writers)
+{
+    QMutexLocker locker(&tfw_latency_lock);
+
+    QMap<dev_t, TFWLatency>::iterator it = tfw_latency.find(dev);
+    if (it == tfw_latency.end())
+    {
+        if (writers)
+            *writers = 0;
+        return 0;
+    }
+
+    (*it).Rotate();
+    if (writers)
+        *writers = (*it).writers;
+    return qMax((*it).current, (*it).previous);
+}
+
 /** \fn ThreadedFileWriter::Write(const void*, uint)
  *  \brief Writes data to the end of the write buffer
  *
@@ -365,7 +472,10 @@ void ThreadedFileWriter::SyncLoop(void)
     {
         locker.unlock();
 
+        MythTimer syncTimer;
+        syncTimer.start();
         Sync();
+        ReportLatency(syncTimer.elapsed());
 
         locker.relock();
         bufferSyncWait.wait(&buflock, 1000);
@@ -495,6 +605,8 @@ void ThreadedFileWriter::DiskLoop(void)
         buf->lastUsed = MythDate::current();
         emptyBuffers.push_back(buf);
 
+        ReportLatency(writeTimer.elapsed());
+
         if (writeTimer.elapsed() > 1000)
         {
             LOG(VB_GENERAL, LOG_WARNING, LOC +
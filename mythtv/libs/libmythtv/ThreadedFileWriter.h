@@ -10,9 +10,11 @@ using namespace std;
 #include <QString>
 #include <QMutex>
 
+#include <sys/types.h>
 #include <fcntl.h>
 #include <stdint.h>
 
+#include "mythtvexp.h"
 #include "mthread.h"
 
 class ThreadedFileWriter;
@@ -37,7 +39,7 @@ class TFWSyncThread : public MThread
     ThreadedFileWriter *m_parent;
 };
 
-class ThreadedFileWriter
+class MTV_PUBLIC ThreadedFileWriter
 {
     friend class TFWWriteThread;
     friend class TFWSyncThread;
@@ -56,17 +58,26 @@ class ThreadedFileWriter
     void Sync(void);
     void Flush(void);
 
+    static int GetWriteLatency(dev_t dev, int *writers = NULL);
+
   protected:
     void DiskLoop(void);
     void SyncLoop(void);
     void TrimEmptyBuffers(void);
 
+  private:
+    void RegisterDevice(void);
+    void UnregisterDevice(void);
+    void ReportLatency(int msecs);
+
   private:
     // file info
     QString         filename;
     int             flags;
     mode_t          mode;
     int             fd;
+    dev_t           device;             // filesystem of fd, if registered
+    bool            registered;         // counted as a writer on device
 
     // state
     bool            flush;              // protected by buflock
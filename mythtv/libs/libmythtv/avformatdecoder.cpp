@@ -34,6 +34,8 @@ using namespace std;
 #include "subtitlereader.h"
 #include "interactivetv.h"
 #include "videodisplayprofile.h"
+#include "decoderthreadbudget.h"
+#include "bytereader.h"
 #include "mythuihelper.h"
 #include "DVD/dvdringbuffer.h"
 #include "Bluray/bdringbuffer.h"
@@ -297,6 +299,7 @@ AvFormatDecoder::AvFormatDecoder(MythPlayer *parent,
     : DecoderBase(parent, pginfo),
       private_dec(NULL),
       is_db_ignored(gCoreContext->IsDatabaseIgnored()),
+      m_decoderThreads(0),
       m_h264_parser(new H264Parser()),
       ic(NULL),
       frame_decoded(0),             decoded_video_frame(NULL),
@@ -405,6 +408,7 @@ void AvFormatDecoder::CloseCodecs()
                 avcodec_close(st->codec);
         }
     }
+    ReleaseDecoderThreads();
 }
 
 void AvFormatDecoder::CloseContext()
@@ -709,6 +713,7 @@ void AvFormatDecoder::SeekReset(long long newKey, uint skipFrames,
         reordered_pts_detected = false;
 
         ff_read_frame_flush(ic);
+        pendingCaptions.clear();
 
         // Only reset the internal state if we're using our seeking,
         // not when using libavformat's seeking
@@ -2255,12 +2260,7 @@ int AvFormatDecoder::ScanStreams(bool novideo)
             if (FlagIsSet(kDecodeSingleThreaded))
                 thread_count = 1;
 
-            LOG(VB_PLAYBACK, LOG_INFO, LOC +
-                QString("Using %1 CPUs for decoding")
-                .arg(HAVE_THREADS ? thread_count : 1));
-
-            if (HAVE_THREADS)
-                enc->thread_count = thread_count;
+            SetupDecoderThreads(enc, HAVE_THREADS ? thread_count : 1);
 
             InitVideoCodec(ic->streams[selTrack], enc, true);
 
@@ -2378,6 +2378,73 @@ bool AvFormatDecoder::OpenAVCodec(AVCodecContext *avctx, const AVCodec *codec)
     }
 }
 
+/** \brief Picks the threading for the video codec and reserves the
+ *         threads for it from the DecoderThreadBudget.
+ *
+ *  Frame threading scales best, but each thread holds a picture until it
+ *  is done with it, so it is only used for codecs that support it and
+ *  with at most kMaxFrameThreads threads. Other codecs, including
+ *  MPEG-2, which has a slice per macroblock row, use slice threading.
+ */
+void AvFormatDecoder::SetupDecoderThreads(AVCodecContext *enc, uint wanted)
+{
+    // leaves headroom for H.264 references in the 31 decode buffers
+    static const uint kMaxFrameThreads = 4;
+
+    ReleaseDecoderThreads();
+
+    const AVCodec *codec = avcodec_find_decoder(enc->codec_id);
+    bool frame_threads = codec &&
+        (codec->capabilities & CODEC_CAP_FRAME_THREADS);
+
+    if (frame_threads)
+        wanted = min(wanted, kMaxFrameThreads);
+
+    m_decoderThreads = DecoderThreadBudget::Acquire(
+        wanted, FlagIsSet(kVideoIsNull));
+
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Using %1 CPUs for decoding%2").arg(m_decoderThreads)
+        .arg((m_decoderThreads <= 1) ? "" :
+             frame_threads ? " with frame threads" : " with slice threads"));
+
+    if (HAVE_THREADS)
+    {
+        enc->thread_count = m_decoderThreads;
+        enc->thread_type  = frame_threads ? FF_THREAD_FRAME : FF_THREAD_SLICE;
+    }
+}
+
+void AvFormatDecoder::ReleaseDecoderThreads(void)
+{
+    if (!m_decoderThreads)
+        return;
+
+    DecoderThreadBudget::Release(m_decoderThreads, FlagIsSet(kVideoIsNull));
+    m_decoderThreads = 0;
+}
+
+/// Opens a closed video codec again, dropping to one thread if that fails
+bool AvFormatDecoder::ReopenVideoCodec(AVCodecContext *enc,
+                                       const AVCodec *codec)
+{
+    if (OpenAVCodec(enc, codec))
+        return true;
+
+    if (enc->thread_count <= 1)
+        return false;
+
+    LOG(VB_GENERAL, LOG_WARNING, LOC +
+        "Retrying the video codec without threads");
+
+    ReleaseDecoderThreads();
+    m_decoderThreads = DecoderThreadBudget::Acquire(
+        1, FlagIsSet(kVideoIsNull));
+    enc->thread_count = 1;
+
+    return OpenAVCodec(enc, codec);
+}
+
 void AvFormatDecoder::UpdateFramesPlayed(void)
 {
     return DecoderBase::UpdateFramesPlayed();
@@ -3174,6 +3241,19 @@ int AvFormatDecoder::H264PreProcessPkt(AVStream *stream, AVPacket *pkt)
 
         if (fps_changed || res_changed)
         {
+            // The ffmpeg H.264 decoder does not support resolution
+            // changes with frame threading, so the codec is re-opened.
+            // It is closed first so the frames its threads still hold
+            // are released before the video buffers are re-initialized.
+            const AVCodec *codec = context->codec;
+            bool reopen = HAVE_THREADS && res_changed && codec &&
+                (context->active_thread_type & FF_THREAD_FRAME);
+            if (reopen)
+            {
+                QMutexLocker locker(avcodeclock);
+                avcodec_close(context);
+            }
+
             m_parent->SetVideoParams(width, height, seqFPS, kScan_Detect);
 
             current_width  = width;
@@ -3199,47 +3279,8 @@ int AvFormatDecoder::H264PreProcessPkt(AVStream *stream, AVPacket *pkt)
                         .arg(avFPS).arg(seqFPS));
             }
 
-            // HACK HACK HACK - begin
-
-            // The ffmpeg H.264 decoder currently does not support
-            // resolution changes when thread_count!=1, so we
-            // close and re-open the codec for resolution changes.
-
-            bool do_it = HAVE_THREADS && res_changed;
-            for (uint i = 0; do_it && (i < ic->nb_streams); i++)
-            {
-                AVCodecContext *enc = ic->streams[i]->codec;
-                if ((AVMEDIA_TYPE_VIDEO == enc->codec_type) &&
-                    (kCodec_H264 == video_codec_id) &&
-                    (enc->codec) && (enc->thread_count>1))
-                {
-                    QMutexLocker locker(avcodeclock);
-                    const AVCodec *codec = enc->codec;
-                    avcodec_close(enc);
-                    int open_val = avcodec_open2(enc, codec, NULL);
-                    if (open_val < 0)
-                    {
-                        LOG(VB_GENERAL, LOG_ERR, LOC +
-                            QString("Could not re-open codec 0x%1, "
-                                    "id(%2) type(%3) "
-                                    "aborting. reason %4")
-                            .arg((uint64_t)enc,0,16)
-                            .arg(ff_codec_id_string(enc->codec_id))
-                            .arg(ff_codec_type_string(enc->codec_type))
-                            .arg(open_val));
-                    }
-                    else
-                    {
-                        LOG(VB_GENERAL, LOG_INFO, LOC +
-                            QString("Re-opened codec 0x%1, id(%2) type(%3)")
-                            .arg((uint64_t)enc,0,16)
-                            .arg(ff_codec_id_string(enc->codec_id))
-                            .arg(ff_codec_type_string(enc->codec_type)));
-                    }
-                }
-            }
-
-            // HACK HACK HACK - end
+            if (reopen)
+                ReopenVideoCodec(context, codec);
         }
 
         HandleGopStart(pkt, true);
@@ -3533,6 +3574,142 @@ bool AvFormatDecoder::ProcessVideoFrame(AVStream *stream, AVFrame *mpa_pic)
     return true;
 }
 
+/** \brief Finds the ATSC A/53 caption data in a video packet that is
+ *         not going to be decoded.
+ *
+ *  This is the cc_data() the MPEG-2 and H.264 decoders would otherwise
+ *  attach to the decoded picture, carried in MPEG-2 picture user data or
+ *  in H.264 SEI registered user data. It arrives in decode order, so it
+ *  is held until every picture before it has been presented.
+ */
+void AvFormatDecoder::ScanVideoPacketForCaptions(
+    AVStream *stream, AVPacket *pkt)
+{
+    enum CodecID codec_id = stream->codec->codec_id;
+    bool h264 = (AV_CODEC_ID_H264 == codec_id);
+    if (!h264 && (AV_CODEC_ID_MPEG2VIDEO != codec_id) &&
+        (AV_CODEC_ID_MPEG1VIDEO != codec_id))
+    {
+        return;
+    }
+
+    QByteArray cc_data;
+    const uint8_t *buf     = pkt->data;
+    const uint8_t *buf_end = pkt->data + pkt->size;
+    uint32_t state = 0xffffffff;
+
+    while (buf < buf_end)
+    {
+        buf = ByteReader::find_start_code(buf, buf_end, &state);
+        if ((state & 0xffffff00) != 0x100)
+            break;
+
+        if (!h264 && (state == 0x1B2))
+        {
+            // user_data: "GA94" user_data_type_code(0x03) cc_data()
+            if ((buf_end - buf >= 7) && !memcmp(buf, "GA94", 4) &&
+                (buf[4] == 0x03))
+            {
+                uint len = 2 + (buf[5] & 0x1f) * 3;
+                if (buf + 5 + len <= buf_end)
+                    cc_data.append((const char*)buf + 5, len);
+            }
+            continue;
+        }
+
+        if (!h264 || ((state & 0x1f) != 6))
+            continue;
+
+        // SEI NAL unit, strip the emulation prevention bytes up to the
+        // next start code
+        QByteArray rbsp;
+        uint zeros = 0;
+        const uint8_t *p = buf;
+        for (; p < buf_end; ++p)
+        {
+            if ((zeros >= 2) && (*p <= 0x01))
+                break;
+            if ((zeros >= 2) && (*p == 0x03))
+            {
+                zeros = 0;
+                continue;
+            }
+            zeros = (*p) ? 0 : zeros + 1;
+            rbsp.append((char)*p);
+        }
+        // back up to the start of the next start code
+        buf   = (p < buf_end) ? p - 2 : p;
+        state = 0xffffffff;
+        while (rbsp.endsWith('\0'))
+            rbsp.chop(1);
+
+        const uint8_t *sei     = (const uint8_t*) rbsp.constData();
+        const uint8_t *sei_end = sei + rbsp.size();
+        // the last byte is the rbsp trailing bits
+        while (sei_end - sei >= 2)
+        {
+            uint type = 0, size = 0;
+            while ((sei < sei_end) && (*sei == 0xff))
+                type += *sei++;
+            if (sei < sei_end)
+                type += *sei++;
+            while ((sei < sei_end) && (*sei == 0xff))
+                size += *sei++;
+            if (sei < sei_end)
+                size += *sei++;
+            if (size > (uint)(sei_end - sei))
+                break;
+
+            // user_data_registered_itu_t_t35: country 0xB5, provider
+            // 0x0031, "GA94", user_data_type_code(0x03), cc_data()
+            if ((type == 4) && (size >= 10) && (sei[0] == 0xB5) &&
+                (sei[1] == 0x00) && (sei[2] == 0x31) &&
+                !memcmp(sei + 3, "GA94", 4) && (sei[7] == 0x03))
+            {
+                uint len = 2 + (sei[8] & 0x1f) * 3;
+                if (8 + len <= size)
+                    cc_data.append((const char*)sei + 8, len);
+            }
+            sei += size;
+        }
+    }
+
+    if (cc_data.isEmpty())
+        return;
+
+    int64_t pts = (pkt->pts != (int64_t)AV_NOPTS_VALUE) ? pkt->pts : pkt->dts;
+    int64_t dts = (pkt->dts != (int64_t)AV_NOPTS_VALUE) ? pkt->dts : pts;
+    if (pts == (int64_t)AV_NOPTS_VALUE)
+    {
+        pendingCaptions.insert(lastccptsu, cc_data);
+        DecodePendingCaptions(lastccptsu);
+        return;
+    }
+
+    double tb = av_q2d(stream->time_base) * 1000000;
+    pendingCaptions.insert((long long)(tb * pts), cc_data);
+    DecodePendingCaptions((long long)(tb * dts));
+}
+
+/// Decodes the caption data held for pictures presented by upto_ptsu
+void AvFormatDecoder::DecodePendingCaptions(long long upto_ptsu)
+{
+    long long ptsu = lastccptsu;
+
+    QMultiMap<long long, QByteArray>::iterator it = pendingCaptions.begin();
+    while ((it != pendingCaptions.end()) && (it.key() <= upto_ptsu))
+    {
+        lastccptsu = it.key();
+        const uint8_t *cc_buf = (const uint8_t*) it->constData();
+        uint cc_len = it->size();
+        for (uint i = 0; i < cc_len; i += ((cc_buf[i] & 0x1f) * 3) + 2)
+            DecodeDTVCC(cc_buf + i, cc_len - i, false);
+        it = pendingCaptions.erase(it);
+    }
+
+    lastccptsu = ptsu;
+}
+
 /** \fn AvFormatDecoder::ProcessVBIDataPacket(const AVStream*, const AVPacket*)
  *  \brief Process ivtv proprietary embedded vertical blanking
  *         interval captions.
@@ -4670,6 +4847,7 @@ bool AvFormatDecoder::GetFrame(DecodeType decodetype)
                     continue;
 
                 SetEof(true);
+                DecodePendingCaptions(INT64_MAX);
                 delete pkt;
                 errno = -retval;
                 LOG(VB_GENERAL, LOG_ERR, QString("decoding error") + ENO);
@@ -4800,6 +4978,8 @@ bool AvFormatDecoder::GetFrame(DecodeType decodetype)
 
                 if (!(decodetype & kDecodeVideo))
                 {
+                    if (decodeAllSubtitles)
+                        ScanVideoPacketForCaptions(curstream, pkt);
                     framesPlayed++;
                     gotVideoFrame = 1;
                     break;
@@ -144,6 +144,8 @@ class AvFormatDecoder : public DecoderBase
     QString      GetCodecDecoderName(void) const;
     QString      GetRawEncodingType(void);
     MythCodecID  GetVideoCodecID(void) const { return video_codec_id; }
+    /// pts in microseconds of the last video packet read
+    long long    GetLastVideoPTSU(void) const { return lastccptsu; }
     void        *GetVideoCodecPrivate(void);
 
     virtual void SetDisablePassThrough(bool disable);
@@ -214,6 +216,8 @@ class AvFormatDecoder : public DecoderBase
     friend int close_avf(URLContext *h);
 
     void DecodeDTVCC(const uint8_t *buf, uint buf_size, bool scte);
+    void ScanVideoPacketForCaptions(AVStream *stream, AVPacket *pkt);
+    void DecodePendingCaptions(long long upto_ptsu);
     void InitByteContext(void);
     void InitVideoCodec(AVStream *stream, AVCodecContext *enc,
                         bool selectedStream = false);
@@ -255,6 +259,9 @@ class AvFormatDecoder : public DecoderBase
     float normalized_fps(AVStream *stream, AVCodecContext *enc);
     void av_update_stream_timings_video(AVFormatContext *ic);
     bool OpenAVCodec(AVCodecContext *avctx, const AVCodec *codec);
+    void SetupDecoderThreads(AVCodecContext *enc, uint wanted);
+    void ReleaseDecoderThreads(void);
+    bool ReopenVideoCodec(AVCodecContext *enc, const AVCodec *codec);
 
     virtual void UpdateFramesPlayed(void);
     virtual bool DoRewindSeek(long long desiredFrame);
@@ -271,6 +278,9 @@ class AvFormatDecoder : public DecoderBase
 
     bool is_db_ignored;
 
+    /// Threads reserved from the DecoderThreadBudget for the video codec
+    uint m_decoderThreads;
+
     H264Parser *m_h264_parser;
 
     AVFormatContext *ic;
@@ -333,6 +343,9 @@ class AvFormatDecoder : public DecoderBase
     uint             last_scte_field;
     CC608Decoder     *ccd608;
     CC708Decoder     *ccd708;
+    /// A/53 caption data of video packets that were not decoded,
+    /// by presentation time in microseconds
+    QMultiMap<long long, QByteArray> pendingCaptions;
     TeletextDecoder  *ttd;
     int               cc608_parity_table[256];
     /// Lookup table for whether a stream was seen in the PMT
@@ -2450,6 +2450,17 @@ NULL
             return false;
     }
 
+    if (dbver == "1315")
+    {
+        // The services API filters and pages recordings by start time
+        const char *updates[] = {
+            "ALTER TABLE recorded ADD INDEX starttime (starttime);",
+            NULL
+        };
+        if (!performActualUpdate(&updates[0], "1316", dbver))
+            return false;
+    }
+
     return true;
 }
 
@@ -0,0 +1,68 @@
+// Qt headers
+#include <QMutexLocker>
+#include <QThread>
+#include <QMutex>
+
+// MythTV headers
+#include "decoderthreadbudget.h"
+#include "mythlogging.h"
+
+#define LOC QString("DecThreads: ")
+
+static QMutex s_budgetLock;
+static uint   s_foregroundInUse = 0;
+static uint   s_backgroundInUse = 0;
+
+/// Reserves up to wanted decoding threads, which must be given back with
+/// Release() when the codec is closed.
+uint DecoderThreadBudget::Acquire(uint wanted, bool background)
+{
+    QMutexLocker locker(&s_budgetLock);
+
+    uint cores   = qMax(QThread::idealThreadCount(), 1);
+    uint granted = Grant(wanted, background, cores,
+                         s_foregroundInUse, s_backgroundInUse);
+
+    if (background)
+        s_backgroundInUse += granted;
+    else
+        s_foregroundInUse += granted;
+
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Granted %1 of %2 threads to a %3 decoder, "
+                "%4 playback and %5 background threads in use")
+        .arg(granted).arg(wanted)
+        .arg(background ? "background" : "playback")
+        .arg(s_foregroundInUse).arg(s_backgroundInUse));
+
+    return granted;
+}
+
+void DecoderThreadBudget::Release(uint threads, bool background)
+{
+    QMutexLocker locker(&s_budgetLock);
+
+    uint &inUse = background ? s_backgroundInUse : s_foregroundInUse;
+    inUse -= qMin(threads, inUse);
+}
+
+/** \brief The policy behind Acquire(), without the process wide state.
+ *
+ *  Playback only competes with other playback, so a preview being
+ *  generated never takes threads from a player that starts later.
+ */
+uint DecoderThreadBudget::Grant(uint wanted, bool background, uint cores,
+                                uint foregroundInUse, uint backgroundInUse)
+{
+    if (wanted <= 1)
+        return 1;
+
+    uint free = (cores > foregroundInUse) ? cores - foregroundInUse : 0;
+    if (background)
+    {
+        free /= 2;
+        free = (free > backgroundInUse) ? free - backgroundInUse : 0;
+    }
+
+    return qMax(qMin(wanted, free), 1U);
+}
@@ -0,0 +1,26 @@
+#ifndef DECODERTHREADBUDGET_H_
+#define DECODERTHREADBUDGET_H_
+
+#include "mythtvexp.h"
+
+/** \class DecoderThreadBudget
+ *  \brief Shares the CPU cores of this process between the video decoders
+ *         running in it.
+ *
+ *   Each decoder asks for the threads its display profile allows and is
+ *   given what is left. Playback, including PiP and PbP players, has first
+ *   call on the cores. Background decoding, such as preview generation,
+ *   is limited to half of what playback leaves free so it can't slow
+ *   down what is on screen. Every decoder gets at least one thread.
+ */
+class MTV_PUBLIC DecoderThreadBudget
+{
+  public:
+    static uint Acquire(uint wanted, bool background);
+    static void Release(uint threads, bool background);
+
+    static uint Grant(uint wanted, bool background, uint cores,
+                      uint foregroundInUse, uint backgroundInUse);
+};
+
+#endif
@@ -13,6 +13,7 @@ using namespace std;
 #include <QRegExp>
 #include <QEvent>
 #include <QCoreApplication>
+#include <QRunnable>
 
 #include "mythconfig.h"
 
@@ -26,12 +27,16 @@ using namespace std;
 #include "recordingprofile.h"
 #include "recordinginfo.h"
 #include "mthread.h"
+#include "mthreadpool.h"
+#include "jobresources.h"
+#include "ThreadedFileWriter.h"
 
 #include "mythdb.h"
 #include "mythdirs.h"
 #include "mythsystemlegacy.h"
 #include "mythlogging.h"
 #include "mythmiscutil.h"
+#include "mythmetrics.h"
 
 #ifndef O_STREAMING
 #define O_STREAMING 0
@@ -43,6 +48,17 @@ using namespace std;
 
 #define LOC     QString("JobQueue: ")
 
+/// Seconds between checks for new jobs when they are announced by events
+static const int kEventCheckFrequency = 300;
+/// Seconds before looking again at a job that had to wait for resources
+static const int kResourceRecheck = 15;
+/// Longest time a busy host leaves a new job for other hosts, in seconds
+static const int kMaxClaimDelay = 30;
+/// Memory that must be free to start a second job, in KB
+static const long long kMinJobMemory = 256 * 1024;
+/// Write time in ms above which recordings have their disk to themselves
+static const int kMaxRecorderLatency = 300;
+
 JobQueue::JobQueue(bool master) :
     m_hostname(gCoreContext->GetHostName()),
     jobsRunning(0),
@@ -51,10 +67,17 @@ JobQueue::JobQueue(bool master) :
     runningJobsLock(new QMutex(QMutex::Recursive)),
     isMaster(master),
     queueThread(new MThread("JobQueue", this)),
-    processQueue(false)
+    processQueue(false),
+    queueChanged(false),
+    resources(new JobResources())
 {
     jobQueueCPU = gCoreContext->GetNumSetting("JobQueueCPU", 0);
 
+    MythMetrics::Describe("mythbackend_jobqueue_running", MythMetrics::kGauge,
+                          "Jobs running on this host.");
+    MythMetrics::Describe("mythbackend_jobqueue_queued", MythMetrics::kGauge,
+                          "Jobs waiting in the queue, for any host.");
+
 #ifndef USING_VALGRIND
     QMutexLocker locker(&queueThreadCondLock);
     processQueue = true;
@@ -82,6 +105,7 @@ JobQueue::~JobQueue(void)
     gCoreContext->removeListener(this);
 
     delete runningJobsLock;
+    delete resources;
 }
 
 void JobQueue::customEvent(QEvent *e)
@@ -91,6 +115,16 @@ void JobQueue::customEvent(QEvent *e)
         MythEvent *me = (MythEvent *)e;
         QString message = me->Message();
 
+        if (message == "JOBQUEUE_CHANGE" ||
+            message == "GLOBAL_JOBQUEUE_CHANGE" ||
+            message == "LOCAL_JOBQUEUE_CHANGE")
+        {
+            QMutexLocker locker(&queueThreadCondLock);
+            queueChanged = true;
+            queueThreadCond.wakeAll();
+            return;
+        }
+
         if (message.startsWith("LOCAL_JOB"))
         {
             // LOCAL_JOB action ID jobID
@@ -182,6 +216,9 @@ void JobQueue::ProcessQueue(void)
     bool atMax = false;
     bool inTimeWindow = true;
     bool startedJobAlready = false;
+    bool deferred = false;
+    QDateTime nextCheck;
+    int claimDelay = 0;
     QMap<int, RunningJobInfo>::Iterator rjiter;
 
     QMutexLocker locker(&queueThreadCondLock);
@@ -190,8 +227,12 @@ void JobQueue::ProcessQueue(void)
         locker.unlock();
 
         startedJobAlready = false;
+        deferred = false;
+        nextCheck = QDateTime();
         sleepTime = gCoreContext->GetNumSetting("JobQueueCheckFrequency", 30);
         maxJobs = gCoreContext->GetNumSetting("JobQueueMaxSimultaneousJobs", 3);
+        if (maxJobs <= 0)
+            maxJobs = resources->GetCPUCount();
         LOG(VB_JOBQUEUE, LOG_INFO, LOC +
             QString("Currently set to run up to %1 job(s) max.")
                         .arg(maxJobs));
@@ -210,9 +251,21 @@ void JobQueue::ProcessQueue(void)
         jobsRunning = 0;
         GetJobsInQueue(jobs);
 
-        if (jobs.size())
+        int jobsQueued = 0;
+
+        if (jobs.empty())
+        {
+            MythMetrics::Set("mythbackend_jobqueue_running", 0);
+            MythMetrics::Set("mythbackend_jobqueue_queued", 0);
+        }
+        else
         {
             inTimeWindow = InJobRunWindow();
+            if (inTimeWindow)
+            {
+                resources->Sample();
+                claimDelay = ClaimDelay();
+            }
             for (int x = 0; x < jobs.size(); x++)
             {
                 status = jobs[x].status;
@@ -222,9 +275,14 @@ void JobQueue::ProcessQueue(void)
                      (status == JOB_STARTING) ||
                      (status == JOB_PAUSED)) &&
                     (hostname == m_hostname))
-                jobsRunning++;
+                    jobsRunning++;
+                else if (status == JOB_QUEUED)
+                    jobsQueued++;
             }
 
+            MythMetrics::Set("mythbackend_jobqueue_running", jobsRunning);
+            MythMetrics::Set("mythbackend_jobqueue_queued", jobsQueued);
+
             message = QString("Currently Running %1 jobs.")
                               .arg(jobsRunning);
             if (!inTimeWindow)
@@ -325,6 +383,10 @@ void JobQueue::ProcessQueue(void)
                                       .arg(jobs[x].schedruntime
                                            .toString(Qt::ISODate));
                     LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+
+                    if (!nextCheck.isValid() ||
+                        (jobs[x].schedruntime < nextCheck))
+                        nextCheck = jobs[x].schedruntime;
                     continue;
                 }
 
@@ -435,6 +497,37 @@ void JobQueue::ProcessQueue(void)
                 if (startedJobAlready)
                     continue;
 
+                // Leave new jobs to less busy hosts for a while
+                if ((inTimeWindow) && (hostname.isEmpty()) && (claimDelay > 0))
+                {
+                    QDateTime claimTime =
+                        jobs[x].statustime.addSecs(claimDelay);
+                    if (claimTime > MythDate::current())
+                    {
+                        message = QString("Leaving '%1' job for %2 to less "
+                                          "busy hosts until %3")
+                                          .arg(JobText(jobs[x].type))
+                                          .arg(logInfo)
+                                          .arg(claimTime.toString(Qt::ISODate));
+                        LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+
+                        if (!nextCheck.isValid() || (claimTime < nextCheck))
+                            nextCheck = claimTime;
+                        continue;
+                    }
+                }
+
+                QString reason;
+                if ((inTimeWindow) && (!HaveResourcesFor(jobs[x], reason)))
+                {
+                    message = QString("Deferring '%1' job for %2, %3")
+                                      .arg(JobText(jobs[x].type)).arg(logInfo)
+                                      .arg(reason);
+                    LOG(VB_JOBQUEUE, LOG_INFO, LOC + message);
+                    deferred = true;
+                    continue;
+                }
+
                 if ((inTimeWindow) &&
                     (hostname.isEmpty()) &&
                     (!ChangeJobHost(jobID, m_hostname)))
@@ -491,12 +584,29 @@ void JobQueue::ProcessQueue(void)
 
 
         locker.relock();
-        if (processQueue)
+        if (processQueue && !queueChanged)
         {
-            int st = (startedJobAlready) ? (5 * 1000) : (sleepTime * 1000);
+            // New and changed jobs wake us up through JOBQUEUE_CHANGE
+            // events, so only poll often when they can't reach us
+            int st = sleepTime * 1000;
+            if (startedJobAlready)
+                st = 5 * 1000;
+            else if (deferred)
+                st = kResourceRecheck * 1000;
+            else if (gCoreContext->IsBackend() ||
+                     gCoreContext->IsConnectedToMaster())
+                st = qMax(sleepTime, kEventCheckFrequency) * 1000;
+
+            if (nextCheck.isValid())
+            {
+                int secs = MythDate::current().secsTo(nextCheck) + 1;
+                st = qMin(st, qMax(secs, 1) * 1000);
+            }
+
             if (st > 0)
                 queueThreadCond.wait(locker.mutex(), st);
         }
+        queueChanged = false;
     }
 }
 
@@ -609,6 +719,8 @@ bool JobQueue::QueueJob(int jobType, uint chanid, const QDateTime &recstartts,
         return false;
     }
 
+    NotifyQueueChanged();
+
     return true;
 }
 
@@ -921,6 +1033,8 @@ bool JobQueue::ChangeJobCmds(int jobID, int newCmds)
         return false;
     }
 
+    NotifyQueueChanged();
+
     return true;
 }
 
@@ -943,6 +1057,8 @@ bool JobQueue::ChangeJobCmds(int jobType, uint chanid,
         return false;
     }
 
+    NotifyQueueChanged();
+
     return true;
 }
 
@@ -991,6 +1107,10 @@ bool JobQueue::ChangeJobStatus(int jobID, int newStatus, QString comment)
         return false;
     }
 
+    // Finished jobs may let others for the same recording or host start
+    if ((newStatus & JOB_DONE) || (newStatus == JOB_QUEUED))
+        NotifyQueueChanged();
+
     return true;
 }
 
@@ -1451,6 +1571,116 @@ bool JobQueue::AllowedToRun(JobQueueEntry job)
     return false;
 }
 
+/** \brief Checks this host has the CPU, memory and disk time to spare
+ *         for 'job' right now.
+ *
+ *  An idle host always takes one job, so the queue keeps moving, unless
+ *  recordings on the same disk are already slow to write. Recordings
+ *  come first.
+ *
+ *  \param reason set to why the job has to wait
+ */
+bool JobQueue::HaveResourcesFor(const JobQueueEntry &job, QString &reason)
+{
+    // Metadata lookups wait on the network, not on this host
+    if (job.type == JOB_METADATA)
+        return true;
+
+    if (jobsRunning > 0)
+    {
+        double idleCPUs = resources->GetCPUIdle() * resources->GetCPUCount();
+        if (idleCPUs < 1.0)
+        {
+            reason = QString("only %1 CPU(s) idle").arg(idleCPUs, 0, 'f', 1);
+            return false;
+        }
+
+        long long memory = resources->GetMemAvailable();
+        if ((memory >= 0) && (memory < kMinJobMemory))
+        {
+            reason = QString("only %1 MB of memory available")
+                             .arg(memory / 1024);
+            return false;
+        }
+    }
+
+    if (!job.chanid)
+        return true;
+
+    ProgramInfo pginfo(job.chanid, job.recstartts);
+    QString path = pginfo.GetPlaybackURL(false, true);
+    struct stat st;
+    if (!path.startsWith("/") ||
+        (stat(path.toLocal8Bit().constData(), &st) != 0))
+        return true;
+
+    int writers = 0;
+    int latency = ThreadedFileWriter::GetWriteLatency(st.st_dev, &writers);
+    if ((writers > 0) && (latency > kMaxRecorderLatency))
+    {
+        reason = QString("%1 recording(s) on its disk take %2 ms to write")
+                         .arg(writers).arg(latency);
+        return false;
+    }
+
+    double busy = resources->GetDiskBusy(st.st_dev);
+    double limit = (writers > 0) ? 0.5 : 0.8;
+    if (((jobsRunning > 0) || (writers > 0)) && (busy > limit))
+    {
+        reason = QString("its disk is %1% busy").arg((int)(busy * 100));
+        return false;
+    }
+
+    return true;
+}
+
+/** \brief Seconds to leave a new job unclaimed, so hosts with more CPU
+ *         to spare get to it first.
+ */
+int JobQueue::ClaimDelay(void) const
+{
+    return (int)((1.0 - resources->GetCPUIdle()) * kMaxClaimDelay);
+}
+
+/// Sends a message to the master backend from a slave, whose own
+/// messages are only dispatched locally.
+class SendMasterMessage : public QRunnable
+{
+  public:
+    SendMasterMessage(const QString &msg) : m_message(msg) { }
+
+    void run(void)
+    {
+        QStringList strlist("MESSAGE");
+        strlist << m_message;
+        gCoreContext->SendReceiveStringList(strlist);
+    }
+
+  private:
+    QString m_message;
+};
+
+/** \brief Tells the JobQueue on every host that a job was queued, changed
+ *         or finished, so they don't have to wait for their next check.
+ *
+ *  The master backend passes GLOBAL_ messages on to the slave backends as
+ *  LOCAL_ ones, which is the only way they get its events. A slave tells
+ *  its own JobQueue straight away and has the master tell everyone else.
+ */
+void JobQueue::NotifyQueueChanged(void)
+{
+    if (gCoreContext->IsBackend() && !gCoreContext->IsMasterBackend())
+    {
+        MythEvent me("LOCAL_JOBQUEUE_CHANGE");
+        gCoreContext->dispatch(me);
+        MThreadPool::globalInstance()->start(
+            new SendMasterMessage("GLOBAL_JOBQUEUE_CHANGE"),
+            "JobQueueChange");
+    }
+    else
+        gCoreContext->SendMessage("GLOBAL_JOBQUEUE_CHANGE");
+}
+
 enum JobCmds JobQueue::GetJobCmd(int jobID)
 {
     MSqlQuery query(MSqlQuery::InitCon());
@@ -1833,6 +2063,10 @@ void JobQueue::RemoveRunningJob(int id)
     }
 
     runningJobsLock->unlock();
+
+    QMutexLocker locker(&queueThreadCondLock);
+    queueChanged = true;
+    queueThreadCond.wakeAll();
 }
 
 QString JobQueue::PrettyPrint(off_t bytes)
@@ -16,6 +16,7 @@
 class MThread;
 class ProgramInfo;
 class RecordingInfo;
+class JobResources;
 
 using namespace std;
 
@@ -210,6 +211,9 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
     void ProcessJob(JobQueueEntry job);
 
     bool AllowedToRun(JobQueueEntry job);
+    bool HaveResourcesFor(const JobQueueEntry &job, QString &reason);
+    int ClaimDelay(void) const;
+    static void NotifyQueueChanged(void);
 
     static bool InJobRunWindow(int orStartingWithinMins = 0);
 
@@ -252,6 +256,9 @@ class MTV_PUBLIC JobQueue : public QObject, public QRunnable
     QWaitCondition queueThreadCond;
     QMutex queueThreadCondLock;
     bool processQueue;
+    bool queueChanged;  // protected by queueThreadCondLock
+
+    JobResources *resources;
 };
 
 #endif
@@ -0,0 +1,209 @@
+// POSIX headers
+#include <sys/types.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
+
+// Qt headers
+#include <QThread>
+#include <QFile>
+#include <QList>
+
+// MythTV headers
+#include "jobresources.h"
+
+const int JobResources::kMaxSampleAge  = 10 * 1000;
+const int JobResources::kMinSampleTime = 500;
+
+static QByteArray read_proc_file(const char *name)
+{
+    QFile file(name);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    // /proc files report a size of 0, so read until EOF
+    return file.readAll();
+}
+
+JobResources::JobResources() :
+    m_cpuCount(qMax(QThread::idealThreadCount(), 1)),
+    m_cpuIdle(1.0), m_memAvailable(-1), m_sampleTime(0)
+{
+    m_cpuBusy[0] = m_cpuBusy[1] = 0;
+    m_cpuTotal[0] = m_cpuTotal[1] = 0;
+}
+
+/** \brief Takes a new reading, and updates the figures to cover the time
+ *         since the previous one.
+ *
+ *  When the previous reading is too old to say much about the current
+ *  load, this takes two readings kMinSampleTime apart instead. If 'wait'
+ *  is false it never sleeps: it only takes the first of those readings
+ *  and returns false, and while the previous reading is less than
+ *  kMinSampleTime old it keeps the figures it has.
+ *
+ *  \return true if the figures are up to date
+ */
+bool JobResources::Sample(bool wait)
+{
+    if (!m_sampleTimer.isRunning() ||
+        m_sampleTimer.elapsed() > kMaxSampleAge)
+    {
+        Read();
+        if (!wait)
+        {
+            m_sampleTime = 0;
+            return false;
+        }
+        usleep(kMinSampleTime * 1000);
+    }
+    else if (!wait && m_sampleTimer.elapsed() < kMinSampleTime)
+    {
+        return m_sampleTime > 0;
+    }
+    Read();
+
+    unsigned long long total = m_cpuTotal[1] - m_cpuTotal[0];
+    unsigned long long busy  = m_cpuBusy[1] - m_cpuBusy[0];
+    if (m_cpuTotal[0] && total > 0 && busy <= total)
+        m_cpuIdle = 1.0 - (double)busy / total;
+    else
+        m_cpuIdle = 1.0;
+
+    m_memAvailable = ParseMemAvailable(read_proc_file("/proc/meminfo"));
+
+    return true;
+}
+
+void JobResources::Read(void)
+{
+    if (m_sampleTimer.isRunning())
+        m_sampleTime = m_sampleTimer.restart();
+    else
+    {
+        m_sampleTime = 0;
+        m_sampleTimer.start();
+    }
+
+    m_cpuBusy[0]   = m_cpuBusy[1];
+    m_cpuTotal[0]  = m_cpuTotal[1];
+    m_diskTicks[0] = m_diskTicks[1];
+
+    if (!ParseCPU(read_proc_file("/proc/stat"), m_cpuBusy[1], m_cpuTotal[1]))
+        m_cpuBusy[1] = m_cpuTotal[1] = 0;
+
+    m_diskTicks[1].clear();
+    ParseDiskStats(read_proc_file("/proc/diskstats"), m_diskTicks[1]);
+}
+
+/** \brief Fraction of the time between the last two samples that the disk
+ *         holding the filesystem 'dev' was busy, 0 if unknown.
+ */
+double JobResources::GetDiskBusy(dev_t dev) const
+{
+#ifdef __linux__
+    quint64 key = DiskKey(major(dev), minor(dev));
+
+    QMap<quint64, unsigned long long>::const_iterator before =
+        m_diskTicks[0].find(key);
+    QMap<quint64, unsigned long long>::const_iterator after =
+        m_diskTicks[1].find(key);
+
+    if (before == m_diskTicks[0].end() || after == m_diskTicks[1].end() ||
+        m_sampleTime <= 0 || *after < *before)
+        return 0.0;
+
+    return qMin(1.0, (double)(*after - *before) / m_sampleTime);
+#else
+    (void)dev;
+    return 0.0;
+#endif
+}
+
+/** \brief Reads the time all CPUs spent busy and in total from the
+ *         contents of /proc/stat, in clock ticks.
+ */
+bool JobResources::ParseCPU(const QByteArray &stat,
+                            unsigned long long &busy,
+                            unsigned long long &total)
+{
+    // cpu  user nice system idle iowait irq softirq steal guest guest_nice
+    int end = stat.indexOf('\n');
+    QList<QByteArray> fields = stat.left(end).simplified().split(' ');
+    if (fields.size() < 5 || fields[0] != "cpu")
+        return false;
+
+    unsigned long long idle = 0;
+    total = 0;
+
+    // guest time is already counted in user time
+    for (int i = 1; i < fields.size() && i <= 8; i++)
+    {
+        unsigned long long value = fields[i].toULongLong();
+        total += value;
+        if (i == 4 || i == 5)
+            idle += value;
+    }
+
+    busy = total - idle;
+    return true;
+}
+
+/** \brief Reads the memory that can be given to new processes from the
+ *         contents of /proc/meminfo, in KB, or -1 if it is not there.
+ *
+ *  Kernels before 3.14 do not report MemAvailable, for those this is an
+ *  estimate from the free memory and the page cache.
+ */
+long long JobResources::ParseMemAvailable(const QByteArray &meminfo)
+{
+    long long available = -1, memFree = -1, buffers = 0, cached = 0;
+
+    QList<QByteArray> lines = meminfo.split('\n');
+    QList<QByteArray>::const_iterator it = lines.begin();
+    for (; it != lines.end(); ++it)
+    {
+        QList<QByteArray> fields = (*it).simplified().split(' ');
+        if (fields.size() < 2)
+            continue;
+
+        long long value = fields[1].toLongLong();
+        if (fields[0] == "MemAvailable:")
+            available = value;
+        else if (fields[0] == "MemFree:")
+            memFree = value;
+        else if (fields[0] == "Buffers:")
+            buffers = value;
+        else if (fields[0] == "Cached:")
+            cached = value;
+    }
+
+    if (available >= 0)
+        return available;
+    if (memFree >= 0)
+        return memFree + buffers + cached;
+    return -1;
+}
+
+/** \brief Reads the milliseconds each disk and partition has spent doing
+ *         I/O from the contents of /proc/diskstats.
+ *
+ *  \param ticks filled in with the time, keyed by DiskKey()
+ */
+void JobResources::ParseDiskStats(const QByteArray &diskstats,
+                                  QMap<quint64, unsigned long long> &ticks)
+{
+    // major minor name reads ... writes ... in_flight io_ticks weighted ...
+    QList<QByteArray> lines = diskstats.split('\n');
+    QList<QByteArray>::const_iterator it = lines.begin();
+    for (; it != lines.end(); ++it)
+    {
+        QList<QByteArray> fields = (*it).simplified().split(' ');
+        if (fields.size() < 13)
+            continue;
+
+        uint devMajor = fields[0].toUInt();
+        uint devMinor = fields[1].toUInt();
+        ticks[DiskKey(devMajor, devMinor)] = fields[12].toULongLong();
+    }
+}
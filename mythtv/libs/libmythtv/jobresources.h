@@ -0,0 +1,62 @@
+#ifndef JOBRESOURCES_H_
+#define JOBRESOURCES_H_
+
+#include <sys/types.h>
+
+#include <QByteArray>
+#include <QMap>
+
+#include "mythtvexp.h"
+#include "mythtimer.h"
+
+/** \class JobResources
+ *  \brief Measures how much CPU, memory and disk time is left over on
+ *         this host, so the JobQueue can decide whether to start a job.
+ *
+ *   The figures come from /proc on Linux. Where they are not available
+ *   the host always looks idle, so the JobQueue falls back to its job
+ *   count limit.
+ */
+class MTV_PUBLIC JobResources
+{
+  public:
+    JobResources();
+
+    bool Sample(bool wait = true);
+
+    /// Fraction of the CPU time that was idle between the last two samples
+    double GetCPUIdle(void) const { return m_cpuIdle; }
+    int GetCPUCount(void) const { return m_cpuCount; }
+    /// Memory new processes can use without swapping in KB, -1 if unknown
+    long long GetMemAvailable(void) const { return m_memAvailable; }
+    double GetDiskBusy(dev_t dev) const;
+
+    static bool ParseCPU(const QByteArray &stat,
+                         unsigned long long &busy, unsigned long long &total);
+    static long long ParseMemAvailable(const QByteArray &meminfo);
+    static void ParseDiskStats(const QByteArray &diskstats,
+                               QMap<quint64, unsigned long long> &ticks);
+    static quint64 DiskKey(uint major, uint minor)
+        { return ((quint64)major << 32) | minor; }
+
+  private:
+    void Read(void);
+
+    int                               m_cpuCount;
+    double                            m_cpuIdle;
+    long long                         m_memAvailable;
+
+    // The previous and latest readings
+    MythTimer                         m_sampleTimer;
+    int                               m_sampleTime;   ///< ms between them
+    unsigned long long                m_cpuBusy[2];
+    unsigned long long                m_cpuTotal[2];
+    QMap<quint64, unsigned long long> m_diskTicks[2];
+
+    /// Readings older than this are not used as the start of an interval
+    static const int kMaxSampleAge;
+    /// How long to measure for when there is no recent reading
+    static const int kMinSampleTime;
+};
+
+#endif
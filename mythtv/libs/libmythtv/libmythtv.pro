@@ -116,7 +116,7 @@ HEADERS += recordinginfo.h
 HEADERS += dbcheck.h
 HEADERS += videodbcheck.h
 HEADERS += tvremoteutil.h           tv.h
-HEADERS += jobqueue.h
+HEADERS += jobqueue.h               jobresources.h
 HEADERS += filtermanager.h          recordingprofile.h
 HEADERS += remoteencoder.h          videosource.h
 HEADERS += cardutil.h               sourceutil.h
@@ -130,6 +130,7 @@ HEADERS += signalmonitorvalue.h     signalmonitorlistener.h
 HEADERS += livetvchain.h            playgroup.h
 HEADERS += channelsettings.h
 HEADERS += previewgenerator.h       previewgeneratorqueue.h
+HEADERS += decoderthreadbudget.h
 HEADERS += transporteditor.h        listingsources.h
 HEADERS += myth_imgconvert.h
 HEADERS += channelgroup.h           channelgroupsettings.h
@@ -144,7 +145,7 @@ SOURCES += recordinginfo.cpp
 SOURCES += dbcheck.cpp
 SOURCES += videodbcheck.cpp
 SOURCES += tvremoteutil.cpp         tv.cpp
-SOURCES += jobqueue.cpp
+SOURCES += jobqueue.cpp             jobresources.cpp
 SOURCES += filtermanager.cpp        recordingprofile.cpp
 SOURCES += remoteencoder.cpp        videosource.cpp
 SOURCES += cardutil.cpp             sourceutil.cpp
@@ -158,6 +159,7 @@ SOURCES += signalmonitorvalue.cpp
 SOURCES += livetvchain.cpp          playgroup.cpp
 SOURCES += channelsettings.cpp
 SOURCES += previewgenerator.cpp     previewgeneratorqueue.cpp
+SOURCES += decoderthreadbudget.cpp
 SOURCES += transporteditor.cpp
 SOURCES += channelgroup.cpp         channelgroupsettings.cpp
 SOURCES += myth_imgconvert.cpp
@@ -201,7 +203,7 @@ HEADERS += mpeg/atsc_huffman.h
 HEADERS += mpeg/freesat_huffman.h   mpeg/freesat_tables.h
 HEADERS += mpeg/iso6937tables.h
 HEADERS += mpeg/tsstats.h           mpeg/streamlisteners.h
-HEADERS += mpeg/H264Parser.h
+HEADERS += mpeg/H264Parser.h        mpeg/bytereader.h
 
 SOURCES += mpeg/tspacket.cpp        mpeg/pespacket.cpp
 SOURCES += mpeg/mpegtables.cpp      mpeg/atsctables.cpp
@@ -216,7 +218,7 @@ SOURCES += mpeg/dishdescriptors.cpp mpeg/premieredescriptors.cpp
 SOURCES += mpeg/atsc_huffman.cpp
 SOURCES += mpeg/freesat_huffman.cpp
 SOURCES += mpeg/iso6937tables.cpp
-SOURCES += mpeg/H264Parser.cpp
+SOURCES += mpeg/H264Parser.cpp      mpeg/bytereader.cpp
 
 # Channels, and the multiplexes that transmit them
 HEADERS += frequencies.h            frequencytables.h
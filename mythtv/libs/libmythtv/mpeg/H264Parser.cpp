@@ -1,5 +1,6 @@
 // MythTV headers
 #include "H264Parser.h"
+#include "bytereader.h"
 #include <iostream>
 #include "mythlogging.h"
 #include "recorders/dtvrecorder.h" // for FrameRate
@@ -412,8 +413,8 @@ uint32_t H264Parser::addBytes(const uint8_t  *bytes,
 
     while (startP < bytes + byte_count && !on_frame)
     {
-        endP = avpriv_mpv_find_start_code(startP,
-                                  bytes + byte_count, &sync_accumulator);
+        endP = ByteReader::find_start_code(startP, bytes + byte_count,
+                                           &sync_accumulator);
 
         found_start_code = ((sync_accumulator & 0xffffff00) == 0x00000100);
 
@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include "mythconfig.h"
 #include "compat.h" // for uint on Darwin, MinGW
+#include "mythtvexp.h"
 
 #ifndef INT_BIT
 #define INT_BIT (CHAR_BIT * sizeof(int))
@@ -50,7 +51,7 @@ extern "C" {
 
 class FrameRate;
 
-class H264Parser {
+class MTV_PUBLIC H264Parser {
   public:
 
     enum {
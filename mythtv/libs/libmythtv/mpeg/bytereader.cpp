@@ -0,0 +1,48 @@
+// -*- Mode: c++ -*-
+
+// C headers
+#include <string.h>
+
+// MythTV headers
+#include "bytereader.h"
+
+static inline uint32_t read_be32(const uint8_t *p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+           (uint32_t(p[2]) <<  8) |  uint32_t(p[3]);
+}
+
+const uint8_t *ByteReader::find_start_code(
+    const uint8_t *p, const uint8_t *end, uint32_t *state)
+{
+    if (p >= end)
+        return end;
+
+    // a start code may have begun in the previous buffer
+    for (int i = 0; i < 3; i++)
+    {
+        uint32_t tmp = *state << 8;
+        *state = tmp + *(p++);
+        if (tmp == 0x100 || p == end)
+            return p;
+    }
+
+    // look for the 01, it needs two zeros before it and a value after it
+    const uint8_t *one = p - 1;
+    while (one < end - 1)
+    {
+        one = (const uint8_t*) memchr(one, 0x01, end - 1 - one);
+        if (!one)
+            break;
+
+        if (!one[-1] && !one[-2])
+        {
+            *state = read_be32(one - 2);
+            return one + 2;
+        }
+        one++;
+    }
+
+    *state = read_be32(end - 4);
+    return end;
+}
@@ -0,0 +1,29 @@
+// -*- Mode: c++ -*-
+#ifndef BYTEREADER_H_
+#define BYTEREADER_H_
+
+#include <stdint.h>
+
+#include "mythtvexp.h"
+
+namespace ByteReader
+{
+    /** \brief Finds the next MPEG start code (00 00 01 xx).
+     *
+     *  A drop in replacement for avpriv_mpv_find_start_code(). The bytes
+     *  are searched for the 01 with memchr(), which the C library
+     *  vectorizes, rather than one to three bytes at a time.
+     *
+     *  \param p     first byte to search
+     *  \param end   one past the last byte to search
+     *  \param state the last four bytes seen, carried between calls so
+     *               start codes split across buffers are found
+     *  \return one past the start code value byte when a start code is
+     *          found, in which case (*state & 0xffffff00) == 0x100,
+     *          otherwise end.
+     */
+    MTV_PUBLIC const uint8_t *find_start_code(
+        const uint8_t *p, const uint8_t *end, uint32_t *state);
+}
+
+#endif // BYTEREADER_H_
@@ -49,11 +49,14 @@ TeletextStuff::~TeletextStuff() { delete reader; }
 DVBSubStuff::~DVBSubStuff() { delete reader; }
 
 MythCCExtractorPlayer::MythCCExtractorPlayer(
-    PlayerFlags flags, bool showProgress, const QString &fileName) :
+    PlayerFlags flags, bool showProgress, const QString &fileName,
+    bool demuxOnly) :
     MythPlayer(flags),
     m_curTime(0),
+    m_firstVideoPtsu(-1),
     m_myFramesPlayed(0),
     m_showProgress(showProgress),
+    m_demuxOnly(demuxOnly),
     m_fileName(fileName)
 {
     // Determine where we will put extracted info.
@@ -70,9 +73,31 @@ MythCCExtractorPlayer::MythCCExtractorPlayer(
 
 void MythCCExtractorPlayer::OnGotNewFrame(void)
 {
-    m_myFramesPlayed = decoder->GetFramesRead();
-    videoOutput->StartDisplayingFrame();
+    if (m_demuxOnly)
     {
+        // There is no frame, so the time comes from the packet pts. Packets
+        // are in decode order, so don't let reordered pictures step back.
+        m_myFramesPlayed = decoder->GetFramesPlayed();
+        AvFormatDecoder *avd = dynamic_cast<AvFormatDecoder *>(decoder);
+        if (avd)
+        {
+            long long ptsu = avd->GetLastVideoPTSU();
+            // first packet, or the pts wrapped or was reset by a seek
+            if (m_firstVideoPtsu < 0 || ptsu < m_firstVideoPtsu)
+                m_firstVideoPtsu = ptsu - (long long)(m_curTime * 1000);
+            m_curTime = max(m_curTime, (ptsu - m_firstVideoPtsu) / 1000.0);
+        }
+        else
+        {
+            double fps = GetDecoder()->GetFPS();
+            if (fps > 0)
+                m_curTime += 1000 / fps;
+        }
+    }
+    else
+    {
+        m_myFramesPlayed = decoder->GetFramesRead();
+        videoOutput->StartDisplayingFrame();
         VideoFrame *frame = videoOutput->GetLastShownFrame();
         double fps = frame->frame_rate;
         if (fps <= 0)
@@ -143,10 +168,16 @@ bool MythCCExtractorPlayer::run(void)
     save_timer.start();
 
     m_curTime = 0;
+    m_firstVideoPtsu = -1;
 
     QString currDir = QFileInfo(m_fileName).path();
 
-    if (DecoderGetFrame(kDecodeVideo))
+    // Subtitle and teletext packets are decoded either way, but when only
+    // demuxing, the decoder picks the CEA-608/708 captions out of the
+    // video packets itself rather than decoding them.
+    DecodeType decodetype = (m_demuxOnly) ? kDecodeNothing : kDecodeVideo;
+
+    if (DecoderGetFrame(decodetype))
         OnGotNewFrame();
 
     if (m_showProgress)
@@ -171,7 +202,7 @@ bool MythCCExtractorPlayer::run(void)
             cout << qPrintable(str) << '\r' << flush;
         }
 
-        if (!DecoderGetFrame(kDecodeVideo))
+        if (!DecoderGetFrame(decodetype))
             break;
 
         OnGotNewFrame();
@@ -188,6 +219,13 @@ bool MythCCExtractorPlayer::run(void)
         cout << qPrintable(str) << endl;
     }
 
+    if (m_demuxOnly)
+    {
+        // The captions of the last few frames are decoded at the end
+        Ingest608Captions();
+        Ingest708Captions();
+    }
+
     Process608Captions(kProcessFinalize);
     Process708Captions(kProcessFinalize);
     ProcessTeletext(kProcessFinalize);
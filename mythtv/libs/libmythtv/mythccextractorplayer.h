@@ -119,7 +119,7 @@ class MTV_PUBLIC MythCCExtractorPlayer : public MythPlayer
 {
   public:
     MythCCExtractorPlayer(PlayerFlags flags, bool showProgress,
-                          const QString &fileName);
+                          const QString &fileName, bool demuxOnly = false);
     ~MythCCExtractorPlayer() {}
 
     bool run(void);
@@ -172,8 +172,12 @@ class MTV_PUBLIC MythCCExtractorPlayer : public MythPlayer
 
     /// Keeps track for decoding time to make timestamps for subtitles.
     double  m_curTime;
+    /// Video pts in microseconds at m_curTime 0, only used when demuxing
+    long long m_firstVideoPtsu;
     uint64_t m_myFramesPlayed;
     bool    m_showProgress;
+    /// Only demux the video, see run()
+    bool    m_demuxOnly;
     QString m_fileName;
     QDir    m_workingDir;
     QString m_baseName;
@@ -37,6 +37,8 @@
 
 #define LOC QString("Preview: ")
 
+const int PreviewGenerator::kFrameCacheMaxWidth = 1280;
+
 /** \class PreviewGenerator
  *  \brief This class creates a preview image of a recording.
  *
@@ -50,6 +52,10 @@
  *
  *   The PreviewGenerator will send a PREVIEW_SUCCESS or a
  *   PREVIEW_FAILED event when the preview completes or fails.
+ *
+ *   The frame grabbed for a preview is kept next to the recording, so
+ *   previews of other sizes at the same point in the recording are
+ *   scaled from it rather than decoded again.
  */
 
 /**
@@ -200,7 +206,20 @@ bool PreviewGenerator::Run(void)
     bool local_ok = ((IsLocal() || !!(mode & kForceLocal)) &&
                      (!!(mode & kLocal)) &&
                      QFileInfo(command).isExecutable());
-    if (!local_ok)
+    bool in_seconds = timeInSeconds;
+    long long captime = (local_ok) ? GetCaptureTime(in_seconds) : -1;
+    if (local_ok &&
+        SaveFromFrameCache(CreateAccessibleFilename(pathname, outFileName),
+                           captime, in_seconds, dtm))
+    {
+        ok = true;
+        msg = QString("Scaled from cached frame on %1 in %2 seconds, "
+                      "starting at %3")
+            .arg(gCoreContext->GetHostName())
+            .arg(tm.elapsed()*0.001)
+            .arg(tm.toString(Qt::ISODate));
+    }
+    else if (!local_ok)
     {
         if (!!(mode & kRemote))
         {
@@ -605,15 +624,14 @@ bool PreviewGenerator::SavePreview(QString filename,
     return false;
 }
 
-bool PreviewGenerator::LocalPreviewRun(void)
+/** \brief Returns the point to grab the preview at, which is the
+ *         bookmark or a third of the way into the program if no time
+ *         was set.
+ */
+long long PreviewGenerator::GetCaptureTime(bool &in_seconds) const
 {
-    programInfo.MarkAsInUse(true, kPreviewGeneratorInUseID);
-
-    float aspect = 0;
-    int   width, height, sz;
     long long captime = captureTime;
-
-    QDateTime dt = MythDate::current();
+    in_seconds = timeInSeconds;
 
     if (captime > 0)
         LOG(VB_GENERAL, LOG_INFO, "Preview from time spec");
@@ -623,7 +641,7 @@ bool PreviewGenerator::LocalPreviewRun(void)
         captime = programInfo.QueryBookmark();
         if (captime > 0)
         {
-            timeInSeconds = false;
+            in_seconds = false;
             LOG(VB_GENERAL, LOG_INFO,
                 QString("Preview from bookmark (frame %1)").arg(captime));
         }
@@ -633,7 +651,7 @@ bool PreviewGenerator::LocalPreviewRun(void)
 
     if (captime <= 0)
     {
-        timeInSeconds = true;
+        in_seconds = true;
         int startEarly = 0;
         int programDuration = 0;
         int preroll =  gCoreContext->GetNumSetting("RecordPreRoll", 0);
@@ -664,18 +682,38 @@ bool PreviewGenerator::LocalPreviewRun(void)
             QString("Preview at calculated offset (%1 seconds)").arg(captime));
     }
 
+    return captime;
+}
+
+bool PreviewGenerator::LocalPreviewRun(void)
+{
+    programInfo.MarkAsInUse(true, kPreviewGeneratorInUseID);
+
+    float aspect = 0;
+    int   width, height, sz;
+
+    QDateTime dt = MythDate::current();
+
+    long long captime = GetCaptureTime(timeInSeconds);
+    QString outname = CreateAccessibleFilename(pathname, outFileName);
+
+    bool ok = SaveFromFrameCache(outname, captime, timeInSeconds, dt);
+    if (ok)
+    {
+        programInfo.MarkAsInUse(false, kPreviewGeneratorInUseID);
+        return ok;
+    }
+
     width = height = sz = 0;
     unsigned char *data = (unsigned char*)
         GetScreenGrab(programInfo, pathname,
                       captime, timeInSeconds,
                       sz, width, height, aspect);
 
-    QString outname = CreateAccessibleFilename(pathname, outFileName);
-
     int dw = (outSize.width()  < 0) ? width  : outSize.width();
     int dh = (outSize.height() < 0) ? height : outSize.height();
 
-    bool ok = SavePreview(outname, data, width, height, aspect, dw, dh);
+    ok = SavePreview(outname, data, width, height, aspect, dw, dh);
 
     if (ok)
     {
@@ -684,6 +722,11 @@ bool PreviewGenerator::LocalPreviewRun(void)
         struct utimbuf times;
         times.actime = times.modtime = dt.toTime_t();
         utime(outname.toLocal8Bit().constData(), &times);
+
+        QString cachename =
+            GetFrameCacheFilename(pathname, captime, timeInSeconds);
+        if (!cachename.isEmpty())
+            SaveFrameCache(cachename, data, width, height, aspect);
     }
 
     delete[] data;
@@ -693,6 +736,109 @@ bool PreviewGenerator::LocalPreviewRun(void)
     return ok;
 }
 
+/** \brief Returns where the frame grabbed at time is cached, or an
+ *         empty string for recordings not on a local file system.
+ *
+ *   The name ends in .png so the frame is deleted with the previews
+ *   when the recording is.
+ */
+QString PreviewGenerator::GetFrameCacheFilename(
+    const QString &pathname, long long time, bool in_seconds)
+{
+    if (!pathname.startsWith("/"))
+        return QString();
+
+    return QString("%1.%2%3.frame.png")
+        .arg(pathname).arg(time).arg((in_seconds) ? "s" : "f");
+}
+
+/** \brief Saves a grabbed frame at its display aspect ratio, to be
+ *         scaled to other preview sizes later.
+ */
+bool PreviewGenerator::SaveFrameCache(
+    const QString &filename, const unsigned char *data,
+    uint width, uint height, float aspect)
+{
+    if (!data || !width || !height)
+        return false;
+
+    const QImage img((unsigned char*) data,
+                     width, height, QImage::Format_RGB32);
+
+    aspect = (aspect <= 0.0f) ? ((float) width) / height : aspect;
+    int cw = (int) (height * aspect + 0.5f);
+    int ch = height;
+    if (cw > kFrameCacheMaxWidth)
+    {
+        cw = kFrameCacheMaxWidth;
+        ch = (int) (cw / aspect + 0.5f);
+    }
+
+    QImage frame = img.scaled(max(cw, 1), max(ch, 1),
+        Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    QTemporaryFile f(filename + ".XXXXXX");
+    f.setAutoRemove(false);
+    if (f.open() && frame.save(&f, "PNG"))
+    {
+        makeFileAccessible(f.fileName().toLocal8Bit().constData());
+        QFile::remove(filename);
+        if (f.rename(filename))
+        {
+            LOG(VB_FILE, LOG_INFO, LOC + QString("Cached frame '%1' %2x%3")
+                    .arg(filename).arg(cw).arg(ch));
+            return true;
+        }
+        f.remove();
+    }
+
+    return false;
+}
+
+/** \brief Saves the preview from the frame cached at time, if there is
+ *         one newer than the recording.
+ *  \return true iff the preview was saved.
+ */
+bool PreviewGenerator::SaveFromFrameCache(
+    const QString &outname, long long time, bool in_seconds,
+    const QDateTime &dt)
+{
+    QString cachename = GetFrameCacheFilename(pathname, time, in_seconds);
+    if (cachename.isEmpty())
+        return false;
+
+    QFileInfo cinfo(cachename);
+    QFileInfo rinfo(pathname);
+    if (!cinfo.isReadable() || !rinfo.exists() ||
+        (cinfo.lastModified() < rinfo.lastModified()))
+    {
+        return false;
+    }
+
+    QImage frame(cachename);
+    if (frame.isNull())
+        return false;
+    frame = frame.convertToFormat(QImage::Format_RGB32);
+
+    int dw = (outSize.width()  < 0) ? frame.width()  : outSize.width();
+    int dh = (outSize.height() < 0) ? frame.height() : outSize.height();
+
+    if (!SavePreview(outname, frame.bits(), frame.width(), frame.height(),
+                     0.0f, dw, dh))
+    {
+        return false;
+    }
+
+    struct utimbuf times;
+    times.actime = times.modtime = dt.toTime_t();
+    utime(outname.toLocal8Bit().constData(), &times);
+
+    LOG(VB_PLAYBACK, LOG_INFO, LOC +
+        QString("Scaled preview '%1' from cached frame").arg(outname));
+
+    return true;
+}
+
 QString PreviewGenerator::CreateAccessibleFilename(
     const QString &pathname, const QString &outFileName)
 {
@@ -80,6 +80,8 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
 
     bool RunReal(void);
 
+    long long GetCaptureTime(bool &in_seconds) const;
+
     static char *GetScreenGrab(const ProgramInfo &pginfo,
                                const QString     &filename,
                                long long          seektime,
@@ -98,6 +100,15 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
     static QString CreateAccessibleFilename(
         const QString &pathname, const QString &outFileName);
 
+    static QString GetFrameCacheFilename(const QString &pathname,
+                                         long long time, bool in_seconds);
+    static bool SaveFrameCache(const QString &filename,
+                               const unsigned char *data,
+                               uint width, uint height, float aspect);
+    bool SaveFromFrameCache(const QString &outname,
+                            long long time, bool in_seconds,
+                            const QDateTime &dt);
+
     virtual bool event(QEvent *e); // QObject
     bool SaveOutFile(const QByteArray &data, const QDateTime &dt);
 
@@ -120,6 +131,9 @@ class MTV_PUBLIC PreviewGenerator : public QObject, public MThread
     QString            token;
     bool               gotReply;
     bool               pixmapOk;
+
+    /// Frames are cached no wider than this, which covers every preview size
+    static const int   kFrameCacheMaxWidth;
 };
 
 #endif // PREVIEW_GENERATOR_H_
@@ -1,8 +1,10 @@
 #include <QCoreApplication>
 #include <QFileInfo>
+#include <QTimerEvent>
 
 #include "previewgeneratorqueue.h"
 #include "previewgenerator.h"
+#include "jobresources.h"
 #include "mythcorecontext.h"
 #include "mythcontext.h"
 #include "mythlogging.h"
@@ -12,6 +14,9 @@
 
 #define LOC QString("PreviewQueue: ")
 
+/// How often previews waiting for a CPU look at the CPU load again, in ms
+static const int kSampleInterval = 1000;
+
 PreviewGeneratorQueue *PreviewGeneratorQueue::s_pgq = NULL;
 
 void PreviewGeneratorQueue::CreatePreviewGeneratorQueue(
@@ -35,12 +40,14 @@ PreviewGeneratorQueue::PreviewGeneratorQueue(
     MThread("PreviewGeneratorQueue"),
     m_mode(mode),
     m_running(0), m_maxThreads(2),
-    m_maxAttempts(maxAttempts), m_minBlockSeconds(minBlockSeconds)
+    m_maxAttempts(maxAttempts), m_minBlockSeconds(minBlockSeconds),
+    m_resources(NULL), m_sampleTimerId(0)
 {
     if (PreviewGenerator::kLocal & mode)
     {
         int idealThreads = QThread::idealThreadCount();
-        m_maxThreads = (idealThreads >= 1) ? idealThreads * 2 : 2;
+        m_maxThreads = (idealThreads >= 1) ? idealThreads : 2;
+        m_resources = new JobResources();
     }
 
     moveToThread(qthread());
@@ -59,6 +66,8 @@ PreviewGeneratorQueue::~PreviewGeneratorQueue()
     }
     locker.unlock();
     wait();
+
+    delete m_resources;
 }
 
 void PreviewGeneratorQueue::GetPreviewImage(
@@ -446,10 +455,44 @@ void PreviewGeneratorQueue::IncPreviewGeneratorPriority(
     }
 }
 
+/** \brief Starts the most recently requested preview, if a generator
+ *         is free.
+ *
+ *  Previews generated on this host decode video, so past the first one
+ *  a preview is only started while a CPU is left idle. Otherwise it
+ *  waits for one of the running previews to finish, or for the CPU load
+ *  to drop. The load is sampled without waiting, since this runs on the
+ *  queue's event thread, so the first look may not have a figure yet.
+ */
 void PreviewGeneratorQueue::UpdatePreviewGeneratorThreads(void)
 {
     QMutexLocker locker(&m_lock);
     QStringList &q = m_queue;
+    if (q.empty() || (m_running >= m_maxThreads))
+        return;
+
+    if (m_resources && (m_running > 0))
+    {
+        locker.unlock();
+        bool sampled = m_resources->Sample(false);
+        double idleCPUs =
+            m_resources->GetCPUIdle() * m_resources->GetCPUCount();
+        locker.relock();
+
+        if (!sampled || (idleCPUs < 1.0))
+        {
+            if (!m_sampleTimerId)
+                m_sampleTimerId = startTimer(kSampleInterval);
+            if (sampled)
+            {
+                LOG(VB_PLAYBACK, LOG_INFO, LOC +
+                    QString("Waiting for a CPU, %1 previews running")
+                        .arg(m_running));
+            }
+            return;
+        }
+    }
+
     if (!q.empty() && (m_running < m_maxThreads))
     {
         QString fn = q.back();
@@ -464,6 +507,20 @@ void PreviewGeneratorQueue::UpdatePreviewGeneratorThreads(void)
     }
 }
 
+void PreviewGeneratorQueue::timerEvent(QTimerEvent *e)
+{
+    if (e->timerId() != m_sampleTimerId)
+    {
+        QObject::timerEvent(e);
+        return;
+    }
+
+    killTimer(m_sampleTimerId);
+    m_sampleTimerId = 0;
+
+    UpdatePreviewGeneratorThreads();
+}
+
 /** \brief Sets the PreviewGenerator for a specific file.
  *  \return true iff call succeeded.
  */
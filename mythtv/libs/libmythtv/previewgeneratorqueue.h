@@ -13,6 +13,7 @@
 #include "mthread.h"
 
 class ProgramInfo;
+class JobResources;
 class QSize;
 
 class PreviewGenState
@@ -70,6 +71,7 @@ class MTV_PUBLIC PreviewGeneratorQueue : public QObject, public MThread
     void ClearPreviewGeneratorAttempts(const QString &key);
 
     virtual bool event(QEvent *e); // QObject
+    virtual void timerEvent(QTimerEvent *e); // QObject
 
     void SendEvent(const ProgramInfo &pginfo,
                    const QString     &eventname,
@@ -91,6 +93,10 @@ class MTV_PUBLIC PreviewGeneratorQueue : public QObject, public MThread
     uint                   m_maxThreads;
     uint                   m_maxAttempts;
     uint                   m_minBlockSeconds;
+    /// Measures idle CPU time when previews are generated on this host
+    JobResources          *m_resources;
+    /// Looks at the queue again while previews wait for a CPU
+    int                    m_sampleTimerId;
 };
 
 #endif // _PREVIEW_GENERATOR_QUEUE_H_
@@ -25,9 +25,11 @@
 #include "programinfo.h"
 #include "mythlogging.h"
 #include "mpegtables.h"
+#include "bytereader.h"
 #include "ringbuffer.h"
 #include "tv_rec.h"
 #include "mythsystemevent.h"
+#include "mythmetrics.h"
 
 extern "C" {
 #include "libavcodec/mpegvideo.h"
@@ -82,6 +84,7 @@ DTVRecorder::DTVRecorder(TVRec *rec) :
     _use_pts(false),
     _packet_count(0),
     _continuity_error_count(0),
+    _metrics_packet_count(0),       _metrics_error_count(0),
     _frames_seen_count(0),          _frames_written_count(0),
     _total_duration(0),
     _td_base(0),
@@ -96,6 +99,13 @@ DTVRecorder::DTVRecorder(TVRec *rec) :
     memset(_stream_id,  0, sizeof(_stream_id));
     memset(_pid_status, 0, sizeof(_pid_status));
     memset(_continuity_counter, 0xff, sizeof(_continuity_counter));
+
+    MythMetrics::Describe("mythbackend_recorder_ts_packets_total",
+                          MythMetrics::kCounter,
+                          "Transport stream packets received.");
+    MythMetrics::Describe("mythbackend_recorder_ts_continuity_errors_total",
+                          MythMetrics::kCounter,
+                          "Transport stream continuity counter errors.");
 }
 
 DTVRecorder::~DTVRecorder()
@@ -218,6 +228,8 @@ void DTVRecorder::ClearStatistics(void)
     //_ts_first_dt -- doesn't need to be cleared only used if _ts_first>=0
     _packet_count.fetchAndStoreRelaxed(0);
     _continuity_error_count.fetchAndStoreRelaxed(0);
+    _metrics_packet_count       = 0;
+    _metrics_error_count        = 0;
     _frames_seen_count          = 0;
     _frames_written_count       = 0;
     _total_duration             = 0;
@@ -446,7 +458,7 @@ bool DTVRecorder::FindMPEG2Keyframes(const TSPacket* tspacket)
 
     while (bufptr < bufend)
     {
-        bufptr = avpriv_mpv_find_start_code(bufptr, bufend, &_start_code);
+        bufptr = ByteReader::find_start_code(bufptr, bufend, &_start_code);
         bytes_left = bufend - bufptr;
         if ((_start_code & 0xffffff00) == 0x00000100)
         {
@@ -830,6 +842,9 @@ bool DTVRecorder::FindH264Keyframes(const TSPacket *tspacket)
     bool hasFrame = false;
     bool hasKeyFrame = false;
 
+    // nothing is written while the packet is scanned
+    const long long write_pos = ringBuffer->GetWritePosition();
+
     // scan for PES packets and H.264 NAL units
     uint i = tspacket->AFCOffset();
     for (; i < TSPacket::kSize; ++i)
@@ -902,7 +917,7 @@ bool DTVRecorder::FindH264Keyframes(const TSPacket *tspacket)
 
         uint32_t bytes_used = m_h264_parser.addBytes
                               (tspacket->data() + i, TSPacket::kSize - i,
-                               ringBuffer->GetWritePosition());
+                               write_pos);
         i += (bytes_used - 1);
 
         if (m_h264_parser.stateChanged())
@@ -1038,7 +1053,7 @@ void DTVRecorder::FindPSKeyFrames(const uint8_t *buffer, uint len)
 
         const uint8_t *tmp = bufptr;
         bufptr =
-            avpriv_mpv_find_start_code(bufptr + skip, bufend, &_start_code);
+            ByteReader::find_start_code(bufptr + skip, bufend, &_start_code);
         _audio_bytes_remaining = 0;
         _other_bytes_remaining = 0;
         _video_bytes_remaining -= std::min(
@@ -1454,4 +1469,20 @@ RecordingQuality *DTVRecorder::GetRecordingQuality(const RecordingInfo *r) const
     return recq;
 }
 
+void DTVRecorder::UpdateMetrics(const QString &labels)
+{
+    RecorderBase::UpdateMetrics(labels);
+
+    int packets = _packet_count.fetchAndAddRelaxed(0);
+    int errors  = _continuity_error_count.fetchAndAddRelaxed(0);
+
+    MythMetrics::Add("mythbackend_recorder_ts_packets_total",
+                     max(packets - _metrics_packet_count, 0), labels);
+    MythMetrics::Add("mythbackend_recorder_ts_continuity_errors_total",
+                     max(errors - _metrics_error_count, 0), labels);
+
+    _metrics_packet_count = packets;
+    _metrics_error_count  = errors;
+}
+
 /* vim: set expandtab tabstop=4 shiftwidth=4: */
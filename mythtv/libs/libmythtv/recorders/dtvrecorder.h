@@ -55,6 +55,7 @@ class DTVRecorder :
 
     virtual void Reset(void);
     virtual void ClearStatistics(void);
+    virtual void UpdateMetrics(const QString &labels);
     virtual RecordingQuality *GetRecordingQuality(const RecordingInfo*) const;
 
     // MPEG Stream Listener
@@ -181,6 +182,8 @@ class DTVRecorder :
     QDateTime     _ts_first_dt[256];
     mutable QAtomicInt _packet_count;
     mutable QAtomicInt _continuity_error_count;
+    int _metrics_packet_count; ///< _packet_count last published
+    int _metrics_error_count;  ///< _continuity_error_count last published
     unsigned long long _frames_seen_count;
     unsigned long long _frames_written_count;
     double _total_duration; // usec
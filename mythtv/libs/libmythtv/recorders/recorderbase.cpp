@@ -29,6 +29,7 @@ using namespace std;
 #include "cardutil.h"
 #include "tv_rec.h"
 #include "mythdate.h"
+#include "mythmetrics.h"
 
 #define TVREC_CARDNUM \
         ((tvrec != NULL) ? QString::number(tvrec->GetCaptureCardNum()) : "NULL")
@@ -49,9 +50,16 @@ RecorderBase::RecorderBase(TVRec *rec)
       request_pause(false),     paused(false),
       request_recording(false), recording(false),
       nextRingBuffer(NULL),     nextRecording(NULL),
-      positionMapType(MARK_GOP_BYFRAME)
+      positionMapType(MARK_GOP_BYFRAME),
+      metricsWritePos(0)
 {
     ClearStatistics();
+    MythMetrics::Describe("mythbackend_recorder_bytes_total",
+                          MythMetrics::kCounter,
+                          "Bytes written by the recorder.");
+    MythMetrics::Describe("mythbackend_recorder_bitrate_bits",
+                          MythMetrics::kGauge,
+                          "Bits per second written since the last update.");
     QMutexLocker locker(avcodeclock);
 #if 0
     avcodec_init(); // init CRC's
@@ -60,6 +68,15 @@ RecorderBase::RecorderBase(TVRec *rec)
 
 RecorderBase::~RecorderBase(void)
 {
+    // The card isn't writing anything any more, don't leave its last
+    // bitrate behind. The byte counters keep their totals.
+    if (tvrec)
+    {
+        MythMetrics::Remove("mythbackend_recorder_bitrate_bits",
+                            MythMetrics::Label("cardid",
+                                QString::number(tvrec->GetCaptureCardNum())));
+    }
+
     if (weMadeBuffer && ringBuffer)
     {
         delete ringBuffer;
@@ -511,6 +528,12 @@ void RecorderBase::SavePositionMap(bool force)
         {
             curRecording->SaveFilesize(ringBuffer->GetWritePosition());
         }
+
+        if (tvrec)
+        {
+            UpdateMetrics(MythMetrics::Label(
+                "cardid", QString::number(tvrec->GetCaptureCardNum())));
+        }
     }
     else
     {
@@ -518,6 +541,35 @@ void RecorderBase::SavePositionMap(bool force)
     }
 }
 
+/** \brief Publishes what was written since the last call.
+ *
+ *  This is called along with the periodic position map save rather than
+ *  from the write path, so the recorder thread never waits on the metrics
+ *  lock.  Subclasses with more statistics should call this too.
+ */
+void RecorderBase::UpdateMetrics(const QString &labels)
+{
+    if (!ringBuffer)
+        return;
+
+    long long pos = ringBuffer->GetWritePosition();
+    // a new file or a ring buffer switch starts the position again
+    long long written = (pos >= metricsWritePos) ? pos - metricsWritePos : pos;
+    int elapsed = 0;
+    if (metricsTimer.isRunning())
+        elapsed = metricsTimer.restart();
+    else
+        metricsTimer.start();
+    metricsWritePos = pos;
+
+    MythMetrics::Add("mythbackend_recorder_bytes_total", written, labels);
+    if (elapsed > 0)
+    {
+        MythMetrics::Set("mythbackend_recorder_bitrate_bits",
+                         written * 8000.0 / elapsed, labels);
+    }
+}
+
 void RecorderBase::AspectChange(uint aspect, long long frame)
 {
     MarkTypes mark = MARK_ASPECT_4_3;
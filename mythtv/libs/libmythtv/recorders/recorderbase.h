@@ -249,6 +249,7 @@ class MTV_PUBLIC RecorderBase : public QRunnable
 
     virtual void ResetForNewFile(void) = 0;
     virtual void ClearStatistics(void);
+    virtual void UpdateMetrics(const QString &labels);
     virtual void FinishRecording(void) = 0;
     virtual void StartNewFile(void) { }
 
@@ -322,6 +323,10 @@ class MTV_PUBLIC RecorderBase : public QRunnable
     frm_pos_map_t  durationMapDelta;
     MythTimer      positionMapTimer;
 
+    // Metrics, published from SavePositionMap()
+    long long      metricsWritePos;
+    MythTimer      metricsTimer;
+
     // Statistics
     // Note: Once we enter RecorderBase::run(), only that thread can
     // update these values safely. These values are read in that thread
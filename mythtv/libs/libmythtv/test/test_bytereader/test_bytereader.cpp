@@ -0,0 +1,3 @@
+#include "test_bytereader.h"
+
+QTEST_APPLESS_MAIN(TestByteReader)
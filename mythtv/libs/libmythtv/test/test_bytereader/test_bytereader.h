@@ -0,0 +1,106 @@
+/*
+ *  Class TestByteReader
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <QtTest/QtTest>
+
+#include "bytereader.h"
+
+class TestByteReader: public QObject
+{
+    Q_OBJECT
+
+  private:
+    /// Offsets just past each start code value byte, fed in chunks
+    static QList<int> FindAll(const QByteArray &data, int chunk)
+    {
+        QList<int> found;
+        const uint8_t *base = (const uint8_t*) data.constData();
+        uint32_t state = 0xffffffff;
+
+        for (int start = 0; start < data.size(); start += chunk)
+        {
+            const uint8_t *p   = base + start;
+            const uint8_t *end = base + qMin(start + chunk, data.size());
+            while (p < end)
+            {
+                p = ByteReader::find_start_code(p, end, &state);
+                if ((state & 0xffffff00) == 0x100)
+                    found.push_back(p - base);
+            }
+        }
+        return found;
+    }
+
+    static QList<int> FindAllSlowly(const QByteArray &data)
+    {
+        QList<int> found;
+        for (int i = 3; i < data.size(); i++)
+        {
+            if (data[i-3] == 0 && data[i-2] == 0 && data[i-1] == 1)
+            {
+                found.push_back(i + 1);
+                i += 2;
+            }
+        }
+        return found;
+    }
+
+  private slots:
+    void FindsStartCodes(void)
+    {
+        QByteArray data = QByteArray::fromHex(
+            "000001b3" "1234" "00000001e0" "ff01" "000001" "00");
+
+        QList<int> expected;
+        expected << 4 << 11 << 17;
+        QCOMPARE(FindAll(data, data.size()), expected);
+
+        uint32_t state = 0xffffffff;
+        const uint8_t *p = (const uint8_t*) data.constData();
+        QCOMPARE(ByteReader::find_start_code(p, p + data.size(), &state),
+                 p + 4);
+        QCOMPARE(state, 0x000001b3U);
+    }
+
+    void SplitAcrossBuffers(void)
+    {
+        QByteArray data = QByteArray::fromHex("aa00000109bb0000");
+
+        for (int chunk = 1; chunk <= data.size(); chunk++)
+            QCOMPARE(FindAll(data, chunk), QList<int>() << 5);
+    }
+
+    void MatchesByteByByte(void)
+    {
+        qsrand(1);
+        for (int iter = 0; iter < 1000; iter++)
+        {
+            // mostly 00 and 01, so start codes are common
+            QByteArray data(qrand() % 400, '\0');
+            for (int i = 0; i < data.size(); i++)
+            {
+                int r = qrand() % 6;
+                data[i] = (r < 3) ? 0 : (r < 5) ? 1 : qrand() % 256;
+            }
+
+            QList<int> expected = FindAllSlowly(data);
+            QCOMPARE(FindAll(data, data.size()), expected);
+            QCOMPARE(FindAll(data, 184), expected);
+        }
+    }
+};
@@ -0,0 +1,3 @@
+#include "test_decoderthreadbudget.h"
+
+QTEST_APPLESS_MAIN(TestDecoderThreadBudget)
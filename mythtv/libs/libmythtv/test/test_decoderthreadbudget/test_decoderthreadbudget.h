@@ -0,0 +1,54 @@
+/*
+ *  Class TestDecoderThreadBudget
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <QtTest/QtTest>
+
+#include "decoderthreadbudget.h"
+
+class TestDecoderThreadBudget: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void SingleThreaded(void)
+    {
+        QCOMPARE(DecoderThreadBudget::Grant(1, false, 8, 0, 0), 1U);
+        QCOMPARE(DecoderThreadBudget::Grant(0, true,  8, 0, 0), 1U);
+    }
+
+    void PlaybackShares(void)
+    {
+        // main player, then a PiP player on a four core machine
+        QCOMPARE(DecoderThreadBudget::Grant(4, false, 4, 0, 0), 4U);
+        QCOMPARE(DecoderThreadBudget::Grant(4, false, 4, 4, 0), 1U);
+        QCOMPARE(DecoderThreadBudget::Grant(4, false, 8, 4, 0), 4U);
+        QCOMPARE(DecoderThreadBudget::Grant(4, false, 8, 6, 0), 2U);
+    }
+
+    void BackgroundYields(void)
+    {
+        // background decoding gets half of what playback leaves
+        QCOMPARE(DecoderThreadBudget::Grant(8, true, 8, 0, 0), 4U);
+        QCOMPARE(DecoderThreadBudget::Grant(8, true, 8, 4, 0), 2U);
+        QCOMPARE(DecoderThreadBudget::Grant(8, true, 8, 4, 2), 1U);
+        QCOMPARE(DecoderThreadBudget::Grant(8, true, 8, 8, 0), 1U);
+
+        // and never takes threads away from playback
+        QCOMPARE(DecoderThreadBudget::Grant(8, false, 8, 0, 4), 8U);
+    }
+};
@@ -0,0 +1,3 @@
+#include "test_jobresources.h"
+
+QTEST_APPLESS_MAIN(TestJobResources)
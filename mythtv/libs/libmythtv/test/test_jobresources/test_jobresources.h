@@ -0,0 +1,91 @@
+/*
+ *  Class TestJobResources
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <QtTest/QtTest>
+
+#include "jobresources.h"
+
+class TestJobResources: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void ParseCPU(void)
+    {
+        QByteArray stat(
+            "cpu  100 20 30 400 50 6 7 8 90 0\n"
+            "cpu0 50 10 15 200 25 3 3 4 45 0\n"
+            "intr 12345\n");
+
+        unsigned long long busy = 0, total = 0;
+        QVERIFY(JobResources::ParseCPU(stat, busy, total));
+        // guest time is part of user time, idle includes iowait
+        QCOMPARE(total, 621ULL);
+        QCOMPARE(busy, 171ULL);
+    }
+
+    void ParseCPUOldKernel(void)
+    {
+        unsigned long long busy = 0, total = 0;
+        QVERIFY(JobResources::ParseCPU("cpu 10 0 10 80\n", busy, total));
+        QCOMPARE(total, 100ULL);
+        QCOMPARE(busy, 20ULL);
+
+        QVERIFY(!JobResources::ParseCPU("", busy, total));
+        QVERIFY(!JobResources::ParseCPU("intr 1 2 3\n", busy, total));
+    }
+
+    void ParseMemAvailable(void)
+    {
+        QByteArray meminfo(
+            "MemTotal:        8000000 kB\n"
+            "MemFree:          100000 kB\n"
+            "MemAvailable:    3000000 kB\n"
+            "Buffers:           20000 kB\n"
+            "Cached:          2000000 kB\n");
+        QCOMPARE(JobResources::ParseMemAvailable(meminfo), 3000000LL);
+    }
+
+    void ParseMemAvailableOldKernel(void)
+    {
+        QByteArray meminfo(
+            "MemTotal:        8000000 kB\n"
+            "MemFree:          100000 kB\n"
+            "Buffers:           20000 kB\n"
+            "Cached:          2000000 kB\n");
+        QCOMPARE(JobResources::ParseMemAvailable(meminfo), 2120000LL);
+        QCOMPARE(JobResources::ParseMemAvailable(""), -1LL);
+    }
+
+    void ParseDiskStats(void)
+    {
+        QByteArray diskstats(
+            "   8       0 sda 1000 10 80000 500 2000 20 160000 900 0 1234 1400\n"
+            "   8       1 sda1 900 10 70000 400 1900 20 150000 800 0 1100 1200\n"
+            " 253       0 dm-0 10 0 80 1 0 0 0 0 0 7 1\n"
+            "   7       0 loop0 0 0 0 0\n");
+
+        QMap<quint64, unsigned long long> ticks;
+        JobResources::ParseDiskStats(diskstats, ticks);
+        QCOMPARE(ticks.size(), 3);
+        QCOMPARE(ticks[JobResources::DiskKey(8, 0)], 1234ULL);
+        QCOMPARE(ticks[JobResources::DiskKey(8, 1)], 1100ULL);
+        QCOMPARE(ticks[JobResources::DiskKey(253, 0)], 7ULL);
+        QVERIFY(!ticks.contains(JobResources::DiskKey(7, 0)));
+    }
+};
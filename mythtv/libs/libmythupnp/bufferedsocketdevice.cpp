@@ -601,6 +601,17 @@ bool BufferedSocketDevice::CanReadLine()
 
     return false;
 }
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+bool BufferedSocketDevice::HasHeaderBlock()
+{
+    ReadBytes();
+
+    return m_bufRead.scanBlankLine();
+}
                                
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -99,6 +99,7 @@ class BufferedSocketDevice
         int                 Ungetch             (int);
 
         bool                CanReadLine         ();
+        bool                HasHeaderBlock      ();
         QString             ReadLine            ();
         QString             ReadLine            ( int msecs );
         qlonglong           ReadLine            ( char *data,
@@ -123,6 +123,10 @@ static const int g_off         = 0;
 
 const char *HTTPRequest::m_szServerHeaders = "Accept-Ranges: bytes\r\n";
 
+// Smaller files are sent before the request is done, it costs less than
+// handing the connection over
+const qint64 HTTPRequest::kMinDeferredFileSize = 256 * 1024;
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
@@ -137,7 +141,10 @@ HTTPRequest::HTTPRequest() : m_procReqLineExp ( "[ \r\n][ \r\n]*"  ),
                              m_bSOAPRequest   ( false ),
                              m_eResponseType  ( ResponseTypeUnknown),
                              m_nResponseStatus( 200 ),
-                             m_pPostProcess   ( NULL )
+                             m_pPostProcess   ( NULL ),
+                             m_bCanDeferFile  ( false ),
+                             m_llDeferredStart(   0 ),
+                             m_llDeferredBytes(   0 )
 {
     m_response.open( QIODevice::ReadWrite );
 }
@@ -470,7 +477,14 @@ long HTTPRequest::SendResponseFile( QString sFileName )
         QString("SendResponseFile : size = %1, start = %2, end = %3")
             .arg(llSize).arg(llStart).arg(llEnd));
 #endif
-    if (( m_eType != RequestTypeHead ) && (llSize != 0))
+    if (( m_eType != RequestTypeHead ) && (llSize != 0) &&
+        m_bCanDeferFile && (llSize >= kMinDeferredFileSize))
+    {
+        m_sDeferredFile   = sFileName;
+        m_llDeferredStart = llStart;
+        m_llDeferredBytes = llSize;
+    }
+    else if (( m_eType != RequestTypeHead ) && (llSize != 0))
     {
         long long sent = SendFile( tmpFile, llStart, llSize );
 
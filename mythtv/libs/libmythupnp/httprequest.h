@@ -94,6 +94,7 @@ class UPNP_PUBLIC HTTPRequest
     protected:
 
         static const char  *m_szServerHeaders;
+        static const qint64 kMinDeferredFileSize;
 
         QRegExp             m_procReqLineExp;
         QRegExp             m_parseRangeExp;
@@ -137,6 +138,15 @@ class UPNP_PUBLIC HTTPRequest
 
         IPostProcess       *m_pPostProcess;
 
+        // Set by the server when it can send the body of a large file
+        // response itself, after the request is done.  SendResponseFile()
+        // then only writes the header and fills in the m_sDeferred* fields.
+
+        bool                m_bCanDeferFile;
+        QString             m_sDeferredFile;
+        qint64              m_llDeferredStart;
+        qint64              m_llDeferredBytes;
+
     protected:
 
         RequestType     SetRequestType      ( const QString &sType  );
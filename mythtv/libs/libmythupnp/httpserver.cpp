@@ -18,8 +18,23 @@
 #include <compat.h>
 #ifndef USING_MINGW
 #include <sys/utsname.h> 
+#include <unistd.h>
+#include <poll.h>
+#endif
+#include <fcntl.h>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#ifndef O_LARGEFILE
+#define O_LARGEFILE 0
 #endif
 
+// C++ headers
+#include <vector>
+using namespace std;
+
 // Qt headers
 #include <QScriptEngine>
 
@@ -50,10 +65,23 @@ QString  HttpServer::s_platform;
 HttpServer::HttpServer(const QString sApplicationPrefix) :
     ServerPool(), m_sSharePath(GetShareDir()),
     m_pHtmlServer(new HtmlServerExtension(m_sSharePath, sApplicationPrefix)),
-    m_threadPool("HttpServerPool"), m_running(true)
+    m_threadPool("HttpServerPool"), m_pMonitor(NULL), m_running(true)
 {
     setMaxPendingConnections(20);
 
+#ifndef USING_MINGW
+    // Workers only run while there is a request to handle, so a few of
+    // them can serve many idle keep-alive connections
+    Configuration *pConfig = UPnp::GetConfiguration();
+
+    m_threadPool.setMaxThreadCount(
+        pConfig->GetValue("HTTP/MaxWorkerThreads", 16));
+
+    m_pMonitor = new HttpSocketMonitor(
+        *this, 1000 * pConfig->GetValue("HTTP/KeepAliveTimeoutSecs", 10));
+    m_pMonitor->start();
+#endif
+
     // ----------------------------------------------------------------------
     // Build Platform String
     // ----------------------------------------------------------------------
@@ -88,8 +116,19 @@ HttpServer::~HttpServer()
     m_running = false;
     m_rwlock.unlock();
 
+    if (m_pMonitor)
+        m_pMonitor->Stop();
+
     m_threadPool.Stop();
 
+    if (m_pMonitor)
+    {
+        // workers may still try to hand their connection back
+        m_threadPool.waitForDone();
+        delete m_pMonitor;
+        m_pMonitor = NULL;
+    }
+
     while (!m_extensions.empty())
     {
         delete m_extensions.takeFirst();
@@ -124,8 +163,15 @@ QScriptEngine* HttpServer::ScriptEngine()
 
 void HttpServer::newTcpConnection(qt_socket_fd_t nSocket)
 {
+    BufferedSocketDevice *pSocket = new BufferedSocketDevice( nSocket );
+
+    // A worker is started once the request arrives
+
+    if (ParkConnection(pSocket))
+        return;
+
     m_threadPool.startReserved(
-        new HttpWorker(*this, nSocket),
+        new HttpWorker(*this, pSocket, false),
         QString("HttpServer%1").arg(nSocket));
 }
 
@@ -133,6 +179,52 @@ void HttpServer::newTcpConnection(qt_socket_fd_t nSocket)
 //
 /////////////////////////////////////////////////////////////////////////////
 
+void HttpServer::StartWorker(BufferedSocketDevice *pSocket)
+{
+    m_threadPool.start(
+        new HttpWorker(*this, pSocket, true),
+        QString("HttpServer%1").arg(pSocket->socket()));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Hands a connection to the monitor until its next request arrives
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpServer::ParkConnection(BufferedSocketDevice *pSocket)
+{
+    return m_pMonitor && m_pMonitor->AddConnection(pSocket);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpServer::CanDeferFile(void) const
+{
+#ifdef __linux__
+    return m_pMonitor != NULL;
+#else
+    return false;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Hands a connection to the monitor to send the file body of the response
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpServer::SendDeferredFile(BufferedSocketDevice *pSocket,
+                                  const HTTPRequest &request, bool bKeepAlive)
+{
+    return m_pMonitor &&
+        m_pMonitor->AddTransfer(pSocket, request.m_sDeferredFile,
+                                request.m_llDeferredStart,
+                                request.m_llDeferredBytes, bKeepAlive);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
 void HttpServer::RegisterExtension( HttpServerExtension *pExtension )
 {
     if (pExtension != NULL )
@@ -238,8 +330,10 @@ void HttpServer::DelegateRequest(HTTPRequest *pRequest)
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
-HttpWorker::HttpWorker(HttpServer &httpServer, qt_socket_fd_t sock) :
-    m_httpServer(httpServer), m_socket(sock), m_socketTimeout(10000)
+HttpWorker::HttpWorker(HttpServer &httpServer, BufferedSocketDevice *pSocket,
+                       bool bReadable) :
+    m_httpServer(httpServer), m_pSocket(pSocket), m_bReadable(bReadable),
+    m_socketTimeout(10000)
 {
     m_socketTimeout = 1000 *
         UPnp::GetConfiguration()->GetValue("HTTP/KeepAliveTimeoutSecs", 10);
@@ -253,109 +347,123 @@ void HttpWorker::run(void)
 {
 #if 0
     LOG(VB_UPNP, LOG_DEBUG,
-        QString("HttpWorker::run() socket=%1 -- begin").arg(m_socket));
+        QString("HttpWorker::run() socket=%1 -- begin")
+            .arg(m_pSocket->socket()));
 #endif
 
     bool                    bTimeout   = false;
     bool                    bKeepAlive = true;
-    BufferedSocketDevice   *pSocket    = NULL;
     HTTPRequest            *pRequest   = NULL;
+    int                     nSocket    = m_pSocket->socket();
 
     try
     {
-        if ((pSocket = new BufferedSocketDevice( m_socket )) == NULL)
-        {
-            LOG(VB_GENERAL, LOG_ERR, "Error Creating BufferedSocketDevice");
-            return;
-        }
-
-        pSocket->SocketDevice()->setBlocking( true );
+        m_pSocket->SocketDevice()->setBlocking( true );
 
-        while (m_httpServer.IsRunning() && bKeepAlive && pSocket->IsValid())
+        while (m_httpServer.IsRunning() && bKeepAlive && m_pSocket->IsValid())
         {
-            bTimeout = false;
-
-            int64_t nBytes = pSocket->WaitForMore(m_socketTimeout, &bTimeout);
-            if (!m_httpServer.IsRunning())
-                break;
-
-            if ( nBytes > 0)
+            // --------------------------------------------------------------
+            // Requests the client pipelined behind the last one are already
+            // buffered, they are handled before waiting for more. Until the
+            // whole header is here the monitor waits for it, so a slow
+            // client does not hold a worker.
+            // --------------------------------------------------------------
+
+            if (!m_pSocket->HasHeaderBlock())
             {
-                // ----------------------------------------------------------
-                // See if this is a valid request
-                // ----------------------------------------------------------
+                // Readable with nothing to read means the client has gone
 
-                pRequest = new BufferedSocketDeviceRequest( pSocket );
-                if (pRequest != NULL)
-                {
-                    if ( pRequest->ParseRequest() )
-                    {
-                        bKeepAlive = pRequest->GetKeepAlive();
+                if (m_bReadable && m_pSocket->BytesAvailable() == 0)
+                    break;
 
-                        // ------------------------------------------------------
-                        // Request Parsed... Pass on to Main HttpServer class to 
-                        // delegate processing to HttpServerExtensions.
-                        // ------------------------------------------------------
+                if (m_httpServer.ParkConnection(m_pSocket))
+                {
+                    m_pSocket = NULL;
+                    break;
+                }
+            }
 
-                        if (pRequest->m_nResponseStatus != 401)
-                            m_httpServer.DelegateRequest(pRequest);
-                    }
-                    else
-                    {
-                        LOG(VB_UPNP, LOG_ERR, "ParseRequest Failed.");
+            if (m_pSocket->BytesAvailable() == 0)
+            {
+                bTimeout = false;
 
-                        pRequest->m_nResponseStatus = 501;
-                        bKeepAlive = false;
-                    }
+                int64_t nBytes = m_pSocket->WaitForMore(m_socketTimeout,
+                                                        &bTimeout);
+                if (!m_httpServer.IsRunning() || nBytes <= 0)
+                    break;
+            }
 
-#if 0
-                    // Dump Request Header 
-                    if (!bKeepAlive )
-                    {
-                        for ( QStringMap::iterator it  = pRequest->m_mapHeaders.begin(); 
-                                                   it != pRequest->m_mapHeaders.end(); 
-                                                 ++it ) 
-                        {  
-                            LOG(VB_GENERAL, LOG_DEBUG, QString("%1: %2") 
-                                .arg(it.key()) .arg(it.data()));
-                        }
-                    }
-#endif
+            m_bReadable = false;
 
-                    // -------------------------------------------------------
-                    // Always MUST send a response.
-                    // -------------------------------------------------------
+            // ----------------------------------------------------------
+            // See if this is a valid request
+            // ----------------------------------------------------------
 
-                    if (pRequest->SendResponse() < 0)
-                    {
-                        bKeepAlive = false;
-                        LOG(VB_UPNP, LOG_ERR,
-                            QString("socket(%1) - Error returned from "
-                                    "SendResponse... Closing connection")
-                                .arg(m_socket));
-                    }
+            pRequest = new BufferedSocketDeviceRequest( m_pSocket );
+            pRequest->m_bCanDeferFile = m_httpServer.CanDeferFile();
 
-                    // -------------------------------------------------------
-                    // Check to see if a PostProcess was registered
-                    // -------------------------------------------------------
+            if ( pRequest->ParseRequest() )
+            {
+                bKeepAlive = pRequest->GetKeepAlive();
 
-                    if ( pRequest->m_pPostProcess != NULL )
-                        pRequest->m_pPostProcess->ExecutePostProcess();
+                // ------------------------------------------------------
+                // Request Parsed... Pass on to Main HttpServer class to 
+                // delegate processing to HttpServerExtensions.
+                // ------------------------------------------------------
 
-                    delete pRequest;
-                    pRequest = NULL;
-                }
-                else
-                {
-                    LOG(VB_GENERAL, LOG_ERR,
-                        "Error Creating BufferedSocketDeviceRequest");
-                    bKeepAlive = false;
-                }
+                if (pRequest->m_nResponseStatus != 401)
+                    m_httpServer.DelegateRequest(pRequest);
             }
             else
             {
+                LOG(VB_UPNP, LOG_ERR, "ParseRequest Failed.");
+
+                pRequest->m_nResponseStatus = 501;
                 bKeepAlive = false;
             }
+
+            // -------------------------------------------------------
+            // Always MUST send a response.
+            // -------------------------------------------------------
+
+            bool bSent = (pRequest->SendResponse() >= 0);
+
+            if (!bSent)
+            {
+                bKeepAlive = false;
+                LOG(VB_UPNP, LOG_ERR,
+                    QString("socket(%1) - Error returned from "
+                            "SendResponse... Closing connection")
+                        .arg(nSocket));
+            }
+
+            // -------------------------------------------------------
+            // Check to see if a PostProcess was registered
+            // -------------------------------------------------------
+
+            if ( pRequest->m_pPostProcess != NULL )
+                pRequest->m_pPostProcess->ExecutePostProcess();
+
+            // -------------------------------------------------------
+            // The header is out, leave the body of a large file to
+            // the monitor.  The connection can't be used for anything
+            // else if that fails.
+            // -------------------------------------------------------
+
+            if (!pRequest->m_sDeferredFile.isEmpty())
+            {
+                if (bSent && m_httpServer.SendDeferredFile(m_pSocket,
+                                                           *pRequest,
+                                                           bKeepAlive))
+                    m_pSocket = NULL;
+
+                delete pRequest;
+                pRequest = NULL;
+                break;
+            }
+
+            delete pRequest;
+            pRequest = NULL;
         }
     }
     catch(...)
@@ -367,14 +475,410 @@ void HttpWorker::run(void)
     if (pRequest != NULL)
         delete pRequest;
 
-    pSocket->Close();
-
-    delete pSocket;
-    m_socket = 0;
+    if (m_pSocket != NULL)
+    {
+        m_pSocket->Close();
+        delete m_pSocket;
+        m_pSocket = NULL;
+    }
 
 #if 0
     LOG(VB_UPNP, LOG_DEBUG, "HttpWorkerThread::run() -- end");
 #endif
 }
 
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+//
+// HttpSocketMonitor Class Implementation
+//
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+HttpSocketMonitor::HttpSocketMonitor(HttpServer &httpServer,
+                                     int keepAliveTimeout) :
+    MThread("HttpSocketMonitor"), m_httpServer(httpServer),
+    m_keepAliveTimeout(keepAliveTimeout), m_running(true)
+{
+    m_wakeFds[0] = m_wakeFds[1] = -1;
 
+#ifndef USING_MINGW
+    if (pipe(m_wakeFds) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, "HttpSocketMonitor: pipe() failed " + ENO);
+        m_wakeFds[0] = m_wakeFds[1] = -1;
+    }
+    else
+    {
+        fcntl(m_wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(m_wakeFds[1], F_SETFL, O_NONBLOCK);
+    }
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+HttpSocketMonitor::~HttpSocketMonitor()
+{
+    Stop();
+    wait();
+
+    if (m_wakeFds[0] >= 0)
+        ::close(m_wakeFds[0]);
+    if (m_wakeFds[1] >= 0)
+        ::close(m_wakeFds[1]);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpSocketMonitor::Stop(void)
+{
+    m_lock.lock();
+    m_running = false;
+    m_lock.unlock();
+
+    Wake();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpSocketMonitor::Wake(void)
+{
+    if (m_wakeFds[1] >= 0)
+    {
+        char c = 0;
+        if (write(m_wakeFds[1], &c, 1) < 0 && errno != EAGAIN)
+            LOG(VB_UPNP, LOG_ERR, "HttpSocketMonitor: wake failed " + ENO);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// \brief Takes a connection until its next request arrives.
+/// \return false if the monitor is not running, the caller keeps the socket
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpSocketMonitor::AddConnection(BufferedSocketDevice *pSocket)
+{
+    Connection *pConn  = new Connection;
+    pConn->pSocket     = pSocket;
+    pConn->nFile       = -1;
+    pConn->llOffset    = 0;
+    pConn->llRemaining = 0;
+    pConn->llBuffered  = pSocket->BytesAvailable();
+    pConn->bKeepAlive  = true;
+
+    return Add(pConn);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// \brief Takes a connection to send part of a file down it.
+///
+/// Once the file is sent the connection waits for its next request, or is
+/// closed if it is not to be kept alive.
+///
+/// \return false if the file can not be opened or the monitor is not
+///         running, the caller keeps the socket
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpSocketMonitor::AddTransfer(BufferedSocketDevice *pSocket,
+                                    const QString &sFileName,
+                                    qint64 llStart, qint64 llBytes,
+                                    bool bKeepAlive)
+{
+    int nFile = ::open(sFileName.toLocal8Bit().constData(),
+                       O_RDONLY | O_LARGEFILE);
+
+    if (nFile < 0)
+    {
+        LOG(VB_UPNP, LOG_ERR, QString("HttpSocketMonitor: Unable to open "
+                                      "'%1' ").arg(sFileName) + ENO);
+        return false;
+    }
+
+    Connection *pConn  = new Connection;
+    pConn->pSocket     = pSocket;
+    pConn->nFile       = nFile;
+    pConn->llOffset    = llStart;
+    pConn->llRemaining = llBytes;
+    pConn->llBuffered  = 0;
+    pConn->bKeepAlive  = bKeepAlive;
+
+    pSocket->SocketDevice()->setBlocking( false );
+
+    if (Add(pConn))
+        return true;
+
+    pSocket->SocketDevice()->setBlocking( true );
+    ::close(nFile);
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpSocketMonitor::Add(Connection *pConn)
+{
+    QMutexLocker locker(&m_lock);
+
+    if (!m_running || m_wakeFds[0] < 0)
+    {
+        delete pConn;
+        return false;
+    }
+
+    pConn->idle.start();
+    m_incoming.append(pConn);
+    locker.unlock();
+
+    Wake();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// \brief Sends as much of the file as the socket will take without
+///        blocking.
+/// \return false if the connection can not continue
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpSocketMonitor::Send(Connection *pConn)
+{
+#ifdef __linux__
+    __off64_t offset = pConn->llOffset;
+
+    ssize_t sent = sendfile64(pConn->pSocket->socket(), pConn->nFile, &offset,
+                              (size_t)min(pConn->llRemaining,
+                                          (qint64)(1024 * 1024)));
+    if (sent < 0)
+        return (errno == EAGAIN || errno == EINTR);
+
+    // The file is shorter than it was when the header was sent
+    if (sent == 0)
+        return false;
+
+    pConn->llOffset     = offset;
+    pConn->llRemaining -= sent;
+    pConn->idle.start();
+    return true;
+#else
+    return false;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpSocketMonitor::Close(Connection *pConn)
+{
+    if (pConn->nFile >= 0)
+        ::close(pConn->nFile);
+
+    pConn->pSocket->Close();
+    delete pConn->pSocket;
+    delete pConn;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// \brief Reads what has arrived on an idle connection and starts a worker
+///        once it holds a whole request header.
+/// \return true if the connection was handed on or closed, false while it
+///         is still waiting for the rest of the header
+/////////////////////////////////////////////////////////////////////////////
+
+bool HttpSocketMonitor::Receive(Connection *pConn, short revents)
+{
+    if (pConn->pSocket->HasHeaderBlock())
+    {
+        m_httpServer.StartWorker(pConn->pSocket);
+        delete pConn;
+        return true;
+    }
+
+    qint64 llBuffered = pConn->pSocket->BytesAvailable();
+
+    // Readable with nothing more to read means the client has gone
+
+    if ((revents & (POLLERR | POLLHUP | POLLNVAL)) ||
+        llBuffered <= pConn->llBuffered)
+    {
+        Close(pConn);
+        return true;
+    }
+
+    if (llBuffered > kMaxHeaderSize)
+    {
+        LOG(VB_UPNP, LOG_WARNING,
+            QString("HttpSocketMonitor: request header on socket %1 is "
+                    "over %2 bytes").arg(pConn->pSocket->socket())
+                .arg(kMaxHeaderSize));
+        Close(pConn);
+        return true;
+    }
+
+    // The rest of the header has until the keep-alive timeout to arrive
+
+    pConn->llBuffered = llBuffered;
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpSocketMonitor::run(void)
+{
+    RunProlog();
+
+#ifndef USING_MINGW
+    QList<Connection*>    conns;
+    vector<struct pollfd> fds;
+
+    while (true)
+    {
+        m_lock.lock();
+        bool bRunning = m_running;
+        conns += m_incoming;
+        m_incoming.clear();
+        m_lock.unlock();
+
+        if (!bRunning)
+            break;
+
+        // ------------------------------------------------------------------
+        // Wait for the next request on any idle connection, for room to
+        // send more of any file, or for the soonest keep-alive to expire or
+        // transfer to stall
+        // ------------------------------------------------------------------
+
+        int timeout = m_keepAliveTimeout;
+
+        fds.resize(conns.size() + 1);
+        fds[0].fd      = m_wakeFds[0];
+        fds[0].events  = POLLIN;
+        fds[0].revents = 0;
+
+        for (int i = 0; i < conns.size(); ++i)
+        {
+            Connection *pConn = conns[i];
+
+            fds[i + 1].fd      = pConn->pSocket->socket();
+            fds[i + 1].events  = (pConn->nFile >= 0) ? POLLOUT : POLLIN;
+            fds[i + 1].revents = 0;
+
+            int nLimit = m_keepAliveTimeout;
+            if (pConn->nFile >= 0)
+                nLimit = kTransferStallTimeout;
+
+            timeout = min(timeout, max(0, nLimit - pConn->idle.elapsed()));
+        }
+
+        if (poll(&fds[0], fds.size(), timeout) < 0)
+        {
+            if (errno != EINTR)
+            {
+                LOG(VB_GENERAL, LOG_ERR,
+                    "HttpSocketMonitor: poll() failed " + ENO);
+                usleep(100 * 1000);
+            }
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            char buf[64];
+            while (read(m_wakeFds[0], buf, sizeof(buf)) > 0);
+        }
+
+        // ------------------------------------------------------------------
+        // Going backwards, so connections can be removed as we go
+        // ------------------------------------------------------------------
+
+        for (int i = conns.size() - 1; i >= 0; --i)
+        {
+            Connection *pConn   = conns[i];
+            short       revents = fds[i + 1].revents;
+
+            if (pConn->nFile >= 0)
+            {
+                if (revents & (POLLERR | POLLHUP | POLLNVAL))
+                {
+                    Close(pConn);
+                    conns.removeAt(i);
+                }
+                else if ((revents & POLLOUT) && !Send(pConn))
+                {
+                    LOG(VB_UPNP, LOG_INFO,
+                        QString("HttpSocketMonitor: send to socket %1 "
+                                "failed ").arg(fds[i + 1].fd) + ENO);
+                    Close(pConn);
+                    conns.removeAt(i);
+                }
+                else if (pConn->llRemaining <= 0)
+                {
+                    ::close(pConn->nFile);
+                    pConn->nFile = -1;
+                    pConn->pSocket->SocketDevice()->setBlocking( true );
+
+                    if (!pConn->bKeepAlive)
+                    {
+                        Close(pConn);
+                        conns.removeAt(i);
+                    }
+                    else if (pConn->pSocket->HasHeaderBlock())
+                    {
+                        // A request was pipelined behind the file
+                        m_httpServer.StartWorker(pConn->pSocket);
+                        delete pConn;
+                        conns.removeAt(i);
+                    }
+                    else
+                    {
+                        pConn->llBuffered = pConn->pSocket->BytesAvailable();
+                        pConn->idle.start();
+                    }
+                }
+                else if (pConn->idle.elapsed() >= kTransferStallTimeout)
+                {
+                    LOG(VB_UPNP, LOG_INFO,
+                        QString("HttpSocketMonitor: transfer to socket %1 "
+                                "stalled, closing").arg(fds[i + 1].fd));
+                    Close(pConn);
+                    conns.removeAt(i);
+                }
+            }
+            else if (revents)
+            {
+                if (Receive(pConn, revents))
+                    conns.removeAt(i);
+                else if (pConn->idle.elapsed() >= m_keepAliveTimeout)
+                {
+                    Close(pConn);
+                    conns.removeAt(i);
+                }
+            }
+            else if (pConn->idle.elapsed() >= m_keepAliveTimeout)
+            {
+                Close(pConn);
+                conns.removeAt(i);
+            }
+        }
+    }
+
+    m_lock.lock();
+    conns += m_incoming;
+    m_incoming.clear();
+    m_lock.unlock();
+
+    while (!conns.empty())
+        Close(conns.takeFirst());
+#endif
+
+    RunEpilog();
+}
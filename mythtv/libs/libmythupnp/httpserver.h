@@ -34,12 +34,15 @@
 #include "serverpool.h"
 #include "httprequest.h"
 #include "mthreadpool.h"
+#include "mythtimer.h"
+#include "mthread.h"
 #include "upnputil.h"
 #include "compat.h"
 
 typedef struct timeval  TaskTime;
 
 class HttpWorkerThread;
+class HttpSocketMonitor;
 class QScriptEngine;
 class HttpServer;
 
@@ -92,6 +95,7 @@ class UPNP_PUBLIC HttpServer : public ServerPool
     QString                 m_sSharePath;
     HttpServerExtension    *m_pHtmlServer;
     MThreadPool             m_threadPool;
+    HttpSocketMonitor      *m_pMonitor; // NULL where poll() is not used
     bool                    m_running; // protected by m_rwlock
 
     static QMutex           s_platformLock;
@@ -109,6 +113,12 @@ class UPNP_PUBLIC HttpServer : public ServerPool
 
     virtual void newTcpConnection(qt_socket_fd_t socket); // QTcpServer
 
+    void StartWorker(BufferedSocketDevice *pSocket);
+    bool ParkConnection(BufferedSocketDevice *pSocket);
+    bool CanDeferFile(void) const;
+    bool SendDeferredFile(BufferedSocketDevice *pSocket,
+                          const HTTPRequest &request, bool bKeepAlive);
+
     QString GetSharePath(void) const
     { // never modified after creation, so no need to lock
         return m_sSharePath;
@@ -137,14 +147,88 @@ class HttpWorker : public QRunnable
 {
   public:
 
-    HttpWorker(HttpServer &httpServer, qt_socket_fd_t sock);
+    HttpWorker(HttpServer &httpServer, BufferedSocketDevice *pSocket,
+               bool bReadable);
 
     virtual void run(void);
 
   protected:
-    HttpServer &m_httpServer; 
-    qt_socket_fd_t m_socket;
-    int         m_socketTimeout;
+    HttpServer           &m_httpServer;
+    BufferedSocketDevice *m_pSocket;
+    bool                  m_bReadable; ///< started because a request came in
+    int                   m_socketTimeout;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+//
+// HttpSocketMonitor Class Definition
+//
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+/** \class HttpSocketMonitor
+ *  \brief Watches the connections that are between requests.
+ *
+ *   Keep-alive connections spend most of their time waiting for the
+ *   client's next request. Instead of a pool thread blocking on each one,
+ *   connections are handed to this thread between requests. It poll()s
+ *   all of them at once and only starts a worker once a request's whole
+ *   header has arrived, so slow clients can not tie up the workers.
+ *   Connections left idle, or part way through a header, for longer than
+ *   the keep-alive timeout are closed.
+ *
+ *   It also sends the bodies of large file responses, as fast as each
+ *   socket will take them, so a client streaming a recording does not hold
+ *   a worker for the length of the transfer. Transfers that make no
+ *   progress for kTransferStallTimeout are dropped.
+ */
+class HttpSocketMonitor : public MThread
+{
+  public:
+    HttpSocketMonitor(HttpServer &httpServer, int keepAliveTimeout);
+    ~HttpSocketMonitor();
+
+    bool AddConnection(BufferedSocketDevice *pSocket);
+    bool AddTransfer(BufferedSocketDevice *pSocket, const QString &sFileName,
+                     qint64 llStart, qint64 llBytes, bool bKeepAlive);
+    void Stop(void);
+
+  protected:
+    virtual void run(void);
+
+  private:
+    struct Connection
+    {
+        BufferedSocketDevice *pSocket;
+        MythTimer             idle;        ///< time since the last request,
+                                           ///< or the file last progressed
+        int                   nFile;       ///< file being sent, or -1
+        qint64                llOffset;
+        qint64                llRemaining;
+        qint64                llBuffered;  ///< bytes of the next request read
+        bool                  bKeepAlive;
+    };
+
+    /// Largest request header waited for before the connection is dropped
+    static const qint64 kMaxHeaderSize = 64 * 1024;
+    /// Time in ms a file transfer may go without progress before it is
+    /// dropped
+    static const int    kTransferStallTimeout = 60 * 1000;
+
+    bool Add(Connection *pConn);
+    bool Receive(Connection *pConn, short revents);
+    bool Send(Connection *pConn);
+    void Close(Connection *pConn);
+    void Wake(void);
+
+    HttpServer         &m_httpServer;
+    int                 m_keepAliveTimeout;
+    int                 m_wakeFds[2];
+
+    QMutex              m_lock;
+    bool                m_running;  // protected by m_lock
+    QList<Connection*>  m_incoming; // protected by m_lock
 };
 
 
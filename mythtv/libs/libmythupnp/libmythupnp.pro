@@ -30,7 +30,7 @@ HEADERS += servicehost.h wsdl.h htmlserver.h serverSideScripting.h xsd.h
 
 HEADERS += serializers/serializer.h     serializers/xmlSerializer.h 
 HEADERS += serializers/jsonSerializer.h serializers/soapSerializer.h
-HEADERS += serializers/xmlplistSerializer.h
+HEADERS += serializers/xmlplistSerializer.h serializers/serializedType.h
 
 SOURCES += mmulticastsocketdevice.cpp
 SOURCES += msocketdevice.cpp
@@ -47,7 +47,7 @@ SOURCES += servicehost.cpp wsdl.cpp upnpsubscription.cpp xsd.cpp
 
 SOURCES += serializers/serializer.cpp     serializers/xmlSerializer.cpp
 SOURCES += serializers/jsonSerializer.cpp 
-SOURCES += serializers/xmlplistSerializer.cpp
+SOURCES += serializers/xmlplistSerializer.cpp serializers/serializedType.cpp
 
 INCLUDEPATH += ../libmythbase ../libmythservicecontracts ..
 INCLUDEPATH += ./serializers
@@ -75,6 +75,7 @@ inc.files += servicehost.h wsdl.h htmlserver.h serverSideScripting.h
 
 inc.files += serializers/serializer.h     serializers/xmlSerializer.h 
 inc.files += serializers/jsonSerializer.h serializers/soapSerializer.h
+inc.files += serializers/serializedType.h
 
 INSTALLS += inc
 
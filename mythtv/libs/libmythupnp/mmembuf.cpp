@@ -149,6 +149,37 @@ bool MMembuf::scanNewline(QByteArray *store)
     return retval;
 }
 
+/*! \internal
+    Scans for an empty line following some text, the end of an HTTP
+    header block. Carriage returns are ignored and empty lines before
+    the first text are skipped. Returns true if one was found;
+    otherwise returns false.
+*/
+bool MMembuf::scanBlankLine() const
+{
+    int newlines = -1; // no text seen yet
+    for (int j = 0; j < buf.size(); ++j) {
+        const QByteArray *a = buf.at(j);
+        const char *p = a->constData();
+        int n = a->size();
+        if (!j) {
+            // first buffer
+            p += _index;
+            n -= _index;
+        }
+        while (n-- > 0) {
+            if (*p == '\n') {
+                if (newlines >= 0 && ++newlines == 2)
+                    return true;
+            } else if (*p != '\r') {
+                newlines = 0;
+            }
+            p++;
+        }
+    }
+    return false;
+}
+
 int MMembuf::ungetch(int ch)
 {
     if (buf.isEmpty() || _index==0) {
@@ -70,6 +70,7 @@ public:
     bool consumeBytes(quint64 nbytes, char *sink);
     QByteArray readAll();
     bool scanNewline(QByteArray *store);
+    bool scanBlankLine() const;
     bool canReadLine() const;
 
     int ungetch(int ch);
@@ -94,10 +94,9 @@ void JSONSerializer::EndObject  ( const QString &sName, const QObject  *pObject
 //
 //////////////////////////////////////////////////////////////////////////////
 
-void JSONSerializer::AddProperty( const QString       &sName, 
-                                  const QVariant      &vValue,
-                                  const QMetaObject   *pMetaParent,
-                                  const QMetaProperty *pMetaProp )
+void JSONSerializer::AddProperty( const QString                  &sName,
+                                  const QVariant                 &vValue,
+                                  const SerializedType::Property *pProp )
 {
     if (m_bCommaNeeded)
         m_Stream << ", ";
@@ -244,29 +243,49 @@ void JSONSerializer::RenderMap( const QVariantMap &map )
 
 QString JSONSerializer::Encode(const QString &sIn)
 {
-    if (sIn.isEmpty())
-        return sIn;
+    // Most strings need nothing escaped, so only copy those that do
+
+    int nLen = sIn.length();
+    int nIdx = 0;
+
+    for (; nIdx < nLen; ++nIdx)
+    {
+        ushort ch = sIn.at( nIdx ).unicode();
+
+        if (ch < 0x20 || ch == '\\' || ch == '"' || ch == '/')
+            break;
+    }
 
-    QString sStr = sIn;
+    if (nIdx == nLen)
+        return sIn;
 
-    // -=>TODO: Would it be better to just loop through string once and build 
-    // new string with encoded chars instead of calling replace multiple times?
-    // It might perform better.
+    QString sStr = sIn.left( nIdx );
+    sStr.reserve( nLen + 16 );
 
-    sStr.replace( '\\', "\\\\" ); // This must be first
-    sStr.replace( '"' , "\\\"" ); 
+    for (; nIdx < nLen; ++nIdx)
+    {
+        QChar  qch = sIn.at( nIdx );
+        ushort ch  = qch.unicode();
 
-    sStr.replace( '\b', "\\b"  );
-    sStr.replace( '\f', "\\f"  );
-    sStr.replace( '\n', "\\n"  );
-    sStr.replace( "\r", "\\r"  );
-    sStr.replace( "\t", "\\t"  );
-    sStr.replace(  "/", "\\/"  );
+        switch (ch)
+        {
+            case '\\': sStr.append( "\\\\" ); break;
+            case '"' : sStr.append( "\\\"" ); break;
+            case '/' : sStr.append( "\\/"  ); break;
+            case '\b': sStr.append( "\\b"  ); break;
+            case '\f': sStr.append( "\\f"  ); break;
+            case '\n': sStr.append( "\\n"  ); break;
+            case '\r': sStr.append( "\\r"  ); break;
+            case '\t': sStr.append( "\\t"  ); break;
+            default:
+                if (ch < 0x20)
+                    sStr.append( QString( "\\u%1" )
+                                     .arg( ch, 4, 16, QChar('0') ));
+                else
+                    sStr.append( qch );
+                break;
+        }
+    }
 
-    // we don't handle hex values yet...
-    /*
-    if(ch>='\u0000' && ch<='\u001F')
-        sb.append("\\u####"); 
-    */
     return sStr;
 }
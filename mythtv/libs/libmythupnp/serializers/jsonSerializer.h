@@ -42,10 +42,9 @@ class UPNP_PUBLIC JSONSerializer : public Serializer
         virtual void BeginObject( const QString &sName, const QObject  *pObject );
         virtual void EndObject  ( const QString &sName, const QObject  *pObject );
 
-        virtual void AddProperty( const QString       &sName, 
-                                  const QVariant      &vValue,
-                                  const QMetaObject   *pMetaParent,
-                                  const QMetaProperty *pMetaProp );
+        virtual void AddProperty( const QString                  &sName,
+                                  const QVariant                 &vValue,
+                                  const SerializedType::Property *pProp );
 
 
         void RenderValue     ( const QVariant     &vValue );
@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: serializedType.cpp
+// Created     : Oct. 18, 2026
+//
+// Purpose     : Per class property layout used by the Serializers
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "serializedType.h"
+
+#include <QMetaClassInfo>
+#include <QStringList>
+#include <QMutexLocker>
+#include <QMutex>
+#include <QHash>
+
+static QMutex                                          s_typeLock;
+static QHash< const QMetaObject *, SerializedType * >  s_types;
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+static QString FindOptionValue( const QStringList &sOptions,
+                                const QString     &sName )
+{
+    QString sKey = sName + "=";
+
+    for (int nIdx = 0; nIdx < sOptions.size(); ++nIdx)
+    {
+        if (sOptions.at( nIdx ).startsWith( sKey ))
+            return sOptions.at( nIdx ).mid( sKey.length() );
+    }
+
+    return QString();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Types are never removed, QMetaObjects live as long as the process
+//////////////////////////////////////////////////////////////////////////////
+
+const SerializedType *SerializedType::Get( const QMetaObject *pMetaObject )
+{
+    QMutexLocker locker( &s_typeLock );
+
+    SerializedType *pType = s_types.value( pMetaObject, NULL );
+
+    if (pType == NULL)
+    {
+        pType = new SerializedType( pMetaObject );
+        s_types.insert( pMetaObject, pType );
+    }
+
+    return pType;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+QString SerializedType::GetItemName( const QString &sName )
+{
+    QString sTypeName( sName );
+
+    if (sName.at(0) == 'Q')
+        sTypeName = sName.mid( 1 );
+
+    sTypeName.remove( "DTC::"    );
+    sTypeName.remove( QChar('*') );
+
+    return sTypeName;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//////////////////////////////////////////////////////////////////////////////
+
+SerializedType::SerializedType( const QMetaObject *pMetaObject )
+{
+    int nIdx = pMetaObject->indexOfClassInfo( "version" );
+
+    if (nIdx >= 0)
+        m_sVersion = pMetaObject->classInfo( nIdx ).value();
+
+    int nCount = pMetaObject->propertyCount();
+
+    for (nIdx = 0; nIdx < nCount; ++nIdx)
+    {
+        Property prop;
+
+        prop.metaProp = pMetaObject->property( nIdx );
+        prop.sName    = prop.metaProp.name();
+
+        if (prop.sName == "objectName")
+            continue;
+
+        prop.sNameUtf8  = prop.sName.toUtf8();
+        prop.bTransient = false;
+
+        // ------------------------------------------------------------------
+        // Options for the property are given as "key=value;key=value"
+        // in class info of the same name.  See datacontracthelper.h
+        // ------------------------------------------------------------------
+
+        QStringList sOptions;
+
+        int nClassIdx = pMetaObject->indexOfClassInfo( prop.metaProp.name() );
+
+        if (nClassIdx >= 0)
+            sOptions = QString( pMetaObject->classInfo( nClassIdx ).value() )
+                           .split( ';' );
+
+        prop.bTransient =
+            FindOptionValue( sOptions, "transient" ).toLower() == "true";
+
+        QString sContentName = FindOptionValue( sOptions, "name" );
+
+        if (sContentName.isEmpty())
+            sContentName = FindOptionValue( sOptions, "type" );
+
+        if (sContentName.isEmpty())
+            sContentName = prop.sName;
+
+        prop.sContentName = GetItemName( sContentName );
+
+        m_properties.append( prop );
+    }
+}
@@ -0,0 +1,61 @@
+//////////////////////////////////////////////////////////////////////////////
+// Program Name: serializedType.h
+// Created     : Oct. 18, 2026
+//
+// Purpose     : Per class property layout used by the Serializers
+//
+// Licensed under the GPL v2 or later, see COPYING for details
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __SERIALIZEDTYPE_H__
+#define __SERIALIZEDTYPE_H__
+
+#include <QMetaProperty>
+#include <QByteArray>
+#include <QString>
+#include <QList>
+
+#include "upnpexp.h"
+
+//////////////////////////////////////////////////////////////////////////////
+/** \class SerializedType
+ *  \brief The properties of a data contract class, in the form the
+ *         serializers write them out.
+ *
+ *  Finding each property by name and parsing the Q_CLASSINFO options for it
+ *  is the same for every object of a class, but used to be done again for
+ *  each property of each item in a list. This reads the QMetaObject once,
+ *  the first time a class is serialized, and keeps the result for the life
+ *  of the process, so serializing an object only has to read its values.
+ */
+//////////////////////////////////////////////////////////////////////////////
+
+class UPNP_PUBLIC SerializedType
+{
+    public:
+
+        struct Property
+        {
+            QMetaProperty metaProp;
+            QString       sName;
+            QByteArray    sNameUtf8;    ///< added to the ETag hash
+            QString       sContentName; ///< element name for list items
+            bool          bTransient;   ///< left out of the ETag hash
+        };
+
+        typedef QList< Property > PropertyList;
+
+        static const SerializedType *Get( const QMetaObject *pMetaObject );
+
+        static QString GetItemName( const QString &sName );
+
+        QString       m_sVersion;       ///< "version" class info, if any
+        PropertyList  m_properties;
+
+    private:
+
+        SerializedType( const QMetaObject *pMetaObject );
+};
+
+#endif
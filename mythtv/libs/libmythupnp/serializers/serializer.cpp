@@ -76,7 +76,7 @@ void Serializer::Serialize( const QVariant &vValue, const QString &_sName )
 
     BeginSerialize( sName );
 
-    AddProperty( sName, vValue, NULL, NULL );
+    AddProperty( sName, vValue, NULL );
 
     EndSerialize();
 }
@@ -104,72 +104,29 @@ void Serializer::SerializeObjectProperties( const QObject *pObject )
 {
     if (pObject != NULL)
     {
-        const QMetaObject *pMetaObject = pObject->metaObject();
+        const SerializedType *pType =
+            SerializedType::Get( pObject->metaObject() );
 
-        int nCount = pMetaObject->propertyCount();
+        SerializedType::PropertyList::const_iterator it =
+            pType->m_properties.begin();
 
-        for (int nIdx=0; nIdx < nCount; ++nIdx ) 
+        for (; it != pType->m_properties.end(); ++it)
         {
-            QMetaProperty metaProperty = pMetaObject->property( nIdx );
+            // Data contracts use DESIGNABLE to leave out optional details
+            if (!(*it).metaProp.isDesignable( pObject ))
+                continue;
 
-            if (metaProperty.isDesignable( pObject ))
+            QVariant value( (*it).metaProp.read( pObject ));
+
+            if (!(*it).bTransient)
             {
-                const char *pszPropName = metaProperty.name();
-                QString     sPropName( pszPropName );
-
-                if ( sPropName.compare( "objectName" ) == 0)
-                    continue;
-                
-                bool bHash = false;
-
-                if (ReadPropertyMetadata( pObject, 
-                                          sPropName, 
-                                          "transient").toLower() != "true" )
-                {
-                    bHash = true;
-                    m_hash.addData( sPropName.toUtf8() );
-                }
-
-                QVariant value( pObject->property( pszPropName ) );
-
-                if (bHash && !value.canConvert< QObject* >()) 
-                {
-                    m_hash.addData( value.toString().toUtf8() );
-                }
+                m_hash.addData( (*it).sNameUtf8 );
 
-                AddProperty( sPropName, value, pMetaObject, &metaProperty );
+                if (!value.canConvert< QObject* >())
+                    m_hash.addData( value.toString().toUtf8() );
             }
-        }
-    }
-}
-
-/////////////////////////////////////////////////////////////////////////////
-//
-/////////////////////////////////////////////////////////////////////////////
-
-QString Serializer::ReadPropertyMetadata( const QObject *pObject, 
-                                                QString  sPropName, 
-                                                QString  sKey )
-{
-    const QMetaObject *pMeta = pObject->metaObject();
-
-    int nIdx = pMeta->indexOfClassInfo( sPropName.toUtf8() );
-
-    if (nIdx >=0)
-    {
-        QString     sMetadata = pMeta->classInfo( nIdx ).value();
-        QStringList sOptions  = sMetadata.split( ';' );
-
-        QString     sFullKey  = sKey + "=";
 
-        for (int nIdx = 0; nIdx < sOptions.size(); ++nIdx)
-        {
-            if (sOptions.at( nIdx ).startsWith( sFullKey ))
-                return sOptions.at( nIdx ).mid( sFullKey.length() );
+            AddProperty( (*it).sName, value, &(*it) );
         }
     }
-
-    return QString();
 }
-
-
@@ -15,6 +15,7 @@
 
 #include "upnpexp.h"
 #include "upnputil.h"
+#include "serializedType.h"
 
 #include <QList>
 #include <QMetaType>
@@ -40,20 +41,16 @@ class UPNP_PUBLIC Serializer
         virtual void BeginObject( const QString &sName, const QObject  *pObject ) = 0;
         virtual void EndObject  ( const QString &sName, const QObject  *pObject ) = 0;
 
-        virtual void AddProperty( const QString       &sName, 
-                                  const QVariant      &vValue,
-                                  const QMetaObject   *pMetaParent,
-                                  const QMetaProperty *pMetaProp ) = 0;
+        // pProp is NULL when a plain value is serialized
+        virtual void AddProperty( const QString                  &sName,
+                                  const QVariant                 &vValue,
+                                  const SerializedType::Property *pProp ) = 0;
 
         //////////////////////////////////////////////////////////////////////
 
         void SerializeObject          ( const QObject *pObject, const QString &sName );
         void SerializeObjectProperties( const QObject *pObject );
 
-        QString    ReadPropertyMetadata  ( const QObject *pObject, 
-                                                 QString  sPropName, 
-                                                 QString  sKey );
-
     public:
 
         virtual void Serialize( const QObject *pObject, const QString &_sName = QString() );
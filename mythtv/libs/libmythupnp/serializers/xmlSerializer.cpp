@@ -13,7 +13,6 @@
 #include "xmlSerializer.h"
 #include "mythdate.h"
 
-#include <QMetaClassInfo>
 
 // --------------------------------------------------------------------------
 // This version should be bumped if the serializer code is changed in a way
@@ -89,12 +88,10 @@ void XmlSerializer::BeginObject( const QString &sName, const QObject  *pObject )
         m_bIsRoot = false;
     }
 
-    const QMetaObject *pMeta = pObject->metaObject();
+    const SerializedType *pType = SerializedType::Get( pObject->metaObject() );
 
-    int nIdx = pMeta->indexOfClassInfo( "version" );
-
-    if (nIdx >=0)
-        m_pXmlWriter->writeAttribute( "version", pMeta->classInfo( nIdx ).value() );
+    if (!pType->m_sVersion.isEmpty())
+        m_pXmlWriter->writeAttribute( "version", pType->m_sVersion );
 
     m_pXmlWriter->writeAttribute( "serializerVersion", XML_SERIALIZER_VERSION );
 
@@ -113,13 +110,12 @@ void XmlSerializer::EndObject  ( const QString &sName, const QObject  *pObject )
 //
 //////////////////////////////////////////////////////////////////////////////
 
-void XmlSerializer::AddProperty( const QString       &sName, 
-                                 const QVariant      &vValue,
-                                 const QMetaObject   *pMetaParent,
-                                 const QMetaProperty *pMetaProp )
+void XmlSerializer::AddProperty( const QString                  &sName,
+                                 const QVariant                 &vValue,
+                                 const SerializedType::Property *pProp )
 {
     m_pXmlWriter->writeStartElement( sName );
-    RenderValue( GetContentName( sName, pMetaParent, pMetaProp ), vValue );
+    RenderValue( pProp ? pProp->sContentName : GetItemName( sName ), vValue );
     m_pXmlWriter->writeEndElement();
 }
 
@@ -263,76 +259,11 @@ void XmlSerializer::RenderMap( const QString &sName, const QVariantMap &map )
     }
 }
 
-//////////////////////////////////////////////////////////////////////////////
-// -=>TODO: There should be a better way to handle this... 
-//          boy do I miss C#'s Custom Attributes... maybe leverage MOC somehow
-//////////////////////////////////////////////////////////////////////////////
-
-QString XmlSerializer::GetItemName( const QString &sName )
-{
-    QString sTypeName( sName );
-
-    if (sName.at(0) == 'Q')
-        sTypeName = sName.mid( 1 );
-
-    sTypeName.remove( "DTC::"    );
-    sTypeName.remove( QChar('*') );
-
-    return sTypeName;
-}
-
-//////////////////////////////////////////////////////////////////////////////
-//
-//////////////////////////////////////////////////////////////////////////////
-
-QString XmlSerializer::GetContentName( const QString        &sName, 
-                                       const QMetaObject   *pMetaObject,
-                                       const QMetaProperty *pMetaProp )
-{
-    // Try to read Name or TypeName from classinfo metadata.
-
-    int nClassIdx = pMetaObject->indexOfClassInfo( sName.toLatin1() );
-
-    if (nClassIdx >=0)
-    {
-        QString     sOptionData = pMetaObject->classInfo( nClassIdx ).value();
-        QStringList sOptions    = sOptionData.split( ';' );
-        
-        QString sNameOption = FindOptionValue( sOptions, "name" );
-
-        if (sNameOption.isEmpty())
-            sNameOption = FindOptionValue( sOptions, "type" );
-
-        if (!sNameOption.isEmpty())
-            return GetItemName(  sNameOption );
-    }
-
-    // Neither found, so lets use the type name (slightly modified).
-
-    QString sTypeName( sName );    
-
-    if (sName.at(0) == 'Q')        
-        sTypeName = sName.mid( 1 );    
-
-    sTypeName.remove( "DTC::"    );    
-    sTypeName.remove( QChar('*') );
-
-    return sTypeName;
-}
-
 //////////////////////////////////////////////////////////////////////////////
 //
 //////////////////////////////////////////////////////////////////////////////
 
-QString XmlSerializer::FindOptionValue( const QStringList &sOptions, const QString &sName )
+QString XmlSerializer::GetItemName( const QString &sName )
 {
-    QString sKey = sName + "=";
-
-    for (int nIdx = 0; nIdx < sOptions.size(); ++nIdx)
-    {
-        if (sOptions.at( nIdx ).startsWith( sKey ))
-            return sOptions.at( nIdx ).mid( sKey.length() );
-    }
-
-    return QString();
+    return SerializedType::GetItemName( sName );
 }
@@ -44,10 +44,9 @@ class UPNP_PUBLIC XmlSerializer : public Serializer
         virtual void BeginObject( const QString &sName, const QObject  *pObject );
         virtual void EndObject  ( const QString &sName, const QObject  *pObject );
 
-        virtual void AddProperty( const QString       &sName, 
-                                  const QVariant      &vValue,
-                                  const QMetaObject   *pMetaParent,
-                                  const QMetaProperty *pMetaProp );
+        virtual void AddProperty( const QString                  &sName,
+                                  const QVariant                 &vValue,
+                                  const SerializedType::Property *pProp );
 
         void    RenderValue     ( const QString &sName, const QVariant     &vValue );
 
@@ -57,13 +56,6 @@ class UPNP_PUBLIC XmlSerializer : public Serializer
 
         QString GetItemName     ( const QString &sName );
 
-        QString GetContentName  ( const QString        &sName, 
-                                  const QMetaObject   *pMetaObject,
-                                  const QMetaProperty *pMetaProp );
-
-        QString FindOptionValue ( const QStringList &sOptions, 
-                                  const QString &sName );
-
     public:
 
         bool     PropertiesAsAttributes;
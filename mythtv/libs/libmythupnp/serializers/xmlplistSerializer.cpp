@@ -17,7 +17,6 @@
 * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 */
 
-#include <QMetaClassInfo>
 #include <QDateTime>
 
 #include "xmlplistSerializer.h"
@@ -215,13 +214,12 @@ void XmlPListSerializer::RenderMap(const QString &sName,
 void XmlPListSerializer::BeginObject(const QString &sName,
                                      const QObject *pObject)
 {
-    const QMetaObject *pMeta = pObject->metaObject();
-    int nIdx = pMeta->indexOfClassInfo("version");
+    const SerializedType *pType = SerializedType::Get(pObject->metaObject());
 
-    if (nIdx >=0)
+    if (!pType->m_sVersion.isEmpty())
     {
         m_pXmlWriter->writeTextElement("key", "version");
-        m_pXmlWriter->writeTextElement("string", pMeta->classInfo(nIdx).value());
+        m_pXmlWriter->writeTextElement("string", pType->m_sVersion);
     }
 
     m_pXmlWriter->writeTextElement("key", "serializerversion");
@@ -239,8 +237,7 @@ void XmlPListSerializer::EndObject(const QString &sName,
 
 void XmlPListSerializer::AddProperty(const QString &sName,
                                      const QVariant &vValue,
-                                     const QMetaObject *pMetaParent,
-                                     const QMetaProperty *pMetaProp)
+                                     const SerializedType::Property *pProp)
 {
     RenderValue(sName, vValue);
 }
@@ -259,26 +256,15 @@ void XmlPListSerializer::SerializePListObjectProperties(const QString &sName,
     }
     m_pXmlWriter->writeStartElement("dict");
 
-    const QMetaObject *pMetaObject = pObject->metaObject();
+    const SerializedType *pType = SerializedType::Get(pObject->metaObject());
 
-    int nCount = pMetaObject->propertyCount();
+    SerializedType::PropertyList::const_iterator it =
+        pType->m_properties.begin();
 
-    for (int nIdx=0; nIdx < nCount; ++nIdx)
+    for (; it != pType->m_properties.end(); ++it)
     {
-        QMetaProperty metaProperty = pMetaObject->property(nIdx);
-
-        if (metaProperty.isDesignable(pObject))
-        {
-            const char *pszPropName = metaProperty.name();
-            QString     sPropName(pszPropName);
-
-            if (sPropName.compare("objectName") == 0)
-                continue;
-
-            QVariant value(pObject->property(pszPropName));
-
-            AddProperty(sPropName, value, pMetaObject, &metaProperty);
-        }
+        if ((*it).metaProp.isDesignable(pObject))
+            AddProperty((*it).sName, (*it).metaProp.read(pObject), &(*it));
     }
 
     m_pXmlWriter->writeEndElement();
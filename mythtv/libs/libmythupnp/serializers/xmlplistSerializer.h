@@ -24,10 +24,9 @@ class UPNP_PUBLIC XmlPListSerializer : public XmlSerializer
 
         virtual void BeginObject( const QString &sName, const QObject  *pObject );
         virtual void EndObject  ( const QString &sName, const QObject  *pObject );
-        virtual void AddProperty( const QString       &sName,
-                                  const QVariant      &vValue,
-                                  const QMetaObject   *pMetaParent,
-                                  const QMetaProperty *pMetaProp );
+        virtual void AddProperty( const QString                  &sName,
+                                  const QVariant                 &vValue,
+                                  const SerializedType::Property *pProp );
 
         void SerializePListObjectProperties( const QString &sName,
                                              const QObject *pObject,
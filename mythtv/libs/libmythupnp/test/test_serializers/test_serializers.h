@@ -0,0 +1,306 @@
+/*
+ *  Class TestSerializers
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <QtTest/QtTest>
+#include <QVariantList>
+#include <QDateTime>
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QMetaProperty>
+
+#include "xmlSerializer.h"
+#include "jsonSerializer.h"
+#include "serializedType.h"
+
+// Laid out like the data contracts in libmythservicecontracts
+class TestItem : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO( "AsOf", "transient=true" );
+
+    Q_PROPERTY( QString   Title     READ Title                         )
+    Q_PROPERTY( int       Number    READ Number                        )
+    Q_PROPERTY( QDateTime AsOf      READ AsOf                          )
+    Q_PROPERTY( QString   Details   READ Details DESIGNABLE HasDetails )
+
+  public:
+    TestItem(QObject *parent, const QString &title, int number,
+             bool hasDetails) :
+        QObject(parent), m_title(title), m_number(number),
+        m_asOf(QDateTime::currentDateTime()), m_hasDetails(hasDetails) {}
+
+    QString   Title(void)      const { return m_title;  }
+    int       Number(void)     const { return m_number; }
+    QDateTime AsOf(void)       const { return m_asOf;   }
+    QString   Details(void)    const { return "details of " + m_title; }
+    bool      HasDetails(void) const { return m_hasDetails; }
+
+  private:
+    QString   m_title;
+    int       m_number;
+    QDateTime m_asOf;
+    bool      m_hasDetails;
+};
+
+class TestItemList : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO( "version", "2.5" );
+    Q_CLASSINFO( "Items", "type=DTC::TestItem" );
+
+    Q_PROPERTY( int          Count READ Count                  )
+    Q_PROPERTY( QVariantList Items READ Items DESIGNABLE true )
+
+  public:
+    TestItemList(void) {}
+
+    int          Count(void) const { return m_items.size(); }
+    QVariantList Items(void) const { return m_items; }
+
+    void AddItem(const QString &title, int number, bool hasDetails = false)
+    {
+        TestItem *item = new TestItem(this, title, number, hasDetails);
+        m_items.append(QVariant::fromValue<QObject *>(item));
+    }
+
+  private:
+    QVariantList m_items;
+};
+
+class TestSerializers : public QObject
+{
+    Q_OBJECT
+
+  private:
+    static QString ToXml(const QObject &obj)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        XmlSerializer ser(&buffer, "Test");
+        ser.Serialize(&obj, "TestItemList");
+        return QString::fromUtf8(buffer.data());
+    }
+
+    static QString ToJson(const QObject &obj)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        JSONSerializer ser(&buffer, "Test");
+        ser.Serialize(&obj, "TestItemList");
+        return QString::fromUtf8(buffer.data());
+    }
+
+    static QString ETag(const QObject &obj)
+    {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        XmlSerializer ser(&buffer, "Test");
+        ser.Serialize(&obj, "TestItemList");
+        QStringMap headers;
+        ser.AddHeaders(headers);
+        return headers["ETag"];
+    }
+
+    static void FillList(TestItemList &list, int count)
+    {
+        for (int i = 0; i < count; i++)
+            list.AddItem(QString("Title number %1").arg(i), i, i % 2);
+    }
+
+    // How Serializer walked an object before SerializedType, finding the
+    // transient option again for each property of each object
+    static void HashByLookup(const QObject *pObject, QCryptographicHash &hash)
+    {
+        const QMetaObject *pMetaObject = pObject->metaObject();
+
+        for (int nIdx = 0; nIdx < pMetaObject->propertyCount(); ++nIdx)
+        {
+            QMetaProperty metaProperty = pMetaObject->property(nIdx);
+            QString       sPropName(metaProperty.name());
+
+            if (!metaProperty.isDesignable(pObject) ||
+                sPropName == "objectName")
+                continue;
+
+            QString sTransient;
+            int nInfo = pMetaObject->indexOfClassInfo(sPropName.toUtf8());
+            if (nInfo >= 0)
+            {
+                QStringList sOptions = QString(
+                    pMetaObject->classInfo(nInfo).value()).split(';');
+                for (int i = 0; i < sOptions.size(); ++i)
+                {
+                    if (sOptions.at(i).startsWith("transient="))
+                        sTransient = sOptions.at(i).mid(10);
+                }
+            }
+
+            QVariant value(pObject->property(metaProperty.name()));
+
+            if (sTransient.toLower() != "true")
+            {
+                hash.addData(sPropName.toUtf8());
+                hash.addData(value.toString().toUtf8());
+            }
+        }
+    }
+
+    // The same walk over the cached layout, as Serializer does now
+    static void HashByLayout(const QObject *pObject, QCryptographicHash &hash)
+    {
+        const SerializedType *pType =
+            SerializedType::Get(pObject->metaObject());
+
+        SerializedType::PropertyList::const_iterator it =
+            pType->m_properties.begin();
+
+        for (; it != pType->m_properties.end(); ++it)
+        {
+            if (!(*it).metaProp.isDesignable(pObject))
+                continue;
+
+            QVariant value((*it).metaProp.read(pObject));
+
+            if (!(*it).bTransient)
+            {
+                hash.addData((*it).sNameUtf8);
+                hash.addData(value.toString().toUtf8());
+            }
+        }
+    }
+
+  private slots:
+    void XmlLayout(void)
+    {
+        TestItemList list;
+        list.AddItem("First", 1);
+        list.AddItem("Second", 2, true);
+
+        QString xml = ToXml(list);
+
+        QVERIFY(xml.contains("<TestItemList "));
+        QVERIFY(xml.contains("version=\"2.5\""));
+        QVERIFY(xml.contains("<Count>2</Count>"));
+        // list items are named by the type option, without the namespace
+        QVERIFY(xml.contains("<Items><TestItem><Title>First</Title>"
+                             "<Number>1</Number>"));
+        QCOMPARE(xml.count("<TestItem>"), 2);
+        QCOMPARE(xml.count("<Details>"), 1);
+        QVERIFY(xml.contains("<Details>details of Second</Details>"));
+        QVERIFY(!xml.contains("objectName"));
+    }
+
+    void JsonLayout(void)
+    {
+        TestItemList list;
+        list.AddItem("Up/Down \"quoted\"\t\x01", 7);
+
+        QString json = ToJson(list);
+
+        QVERIFY(json.startsWith("{\"TestItemList\": {\"Count\": \"1\", "
+                                "\"Items\": [{\"Title\": "));
+        QVERIFY(json.contains("\"Title\": \"Up\\/Down \\\"quoted\\\""
+                              "\\t\\u0001\""));
+        QVERIFY(json.contains("\"Number\": \"7\""));
+        QVERIFY(!json.contains("Details"));
+        QVERIFY(json.endsWith("]}}"));
+    }
+
+    void TransientNotHashed(void)
+    {
+        TestItemList list1, list2;
+        list1.AddItem("Same", 1);
+        QTest::qSleep(1100);
+        list2.AddItem("Same", 1);
+
+        // only AsOf differs, and it is transient
+        QCOMPARE(ETag(list1), ETag(list2));
+
+        TestItemList list3;
+        list3.AddItem("Different", 1);
+        QVERIFY(ETag(list1) != ETag(list3));
+    }
+
+    void PropertyWalkBenchmark_data(void)
+    {
+        QTest::addColumn<bool>("cached");
+
+        QTest::newRow("per object lookup") << false;
+        QTest::newRow("cached layout")     << true;
+    }
+
+    // Compares the per-object work of both walks over the same list, both
+    // must hash the same data
+    void PropertyWalkBenchmark(void)
+    {
+        QFETCH(bool, cached);
+
+        TestItemList list;
+        FillList(list, 10000);
+        QVariantList items = list.Items();
+
+        QCryptographicHash expected(QCryptographicHash::Sha1);
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        for (int i = 0; i < items.size(); ++i)
+        {
+            HashByLookup(items[i].value<QObject *>(), expected);
+            HashByLayout(items[i].value<QObject *>(), hash);
+        }
+        QCOMPARE(hash.result(), expected.result());
+
+        QBENCHMARK
+        {
+            hash.reset();
+            for (int i = 0; i < items.size(); ++i)
+            {
+                if (cached)
+                    HashByLayout(items[i].value<QObject *>(), hash);
+                else
+                    HashByLookup(items[i].value<QObject *>(), hash);
+            }
+        }
+    }
+
+    void XmlBenchmark(void)
+    {
+        TestItemList list;
+        FillList(list, 10000);
+
+        QBENCHMARK
+        {
+            QBuffer buffer;
+            buffer.open(QIODevice::WriteOnly);
+            XmlSerializer ser(&buffer, "Test");
+            ser.Serialize(&list, "TestItemList");
+        }
+    }
+
+    void JsonBenchmark(void)
+    {
+        TestItemList list;
+        FillList(list, 10000);
+
+        QBENCHMARK
+        {
+            QBuffer buffer;
+            buffer.open(QIODevice::WriteOnly);
+            JSONSerializer ser(&buffer, "Test");
+            ser.Serialize(&list, "TestItemList");
+        }
+    }
+};
@@ -10,18 +10,29 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 
+#include <climits>
 #include <cmath>
 #include <algorithm>
 using namespace std;
 
+#include <QMutexLocker>
+
 #include "upnp.h"
 #include "upnpcds.h"
 #include "upnputil.h"
 #include "mythlogging.h"
+#include "mythcorecontext.h"
+#include "mythdate.h"
 
 #define DIDL_LITE_BEGIN "<DIDL-Lite xmlns:dc=\"http://purl.org/dc/elements/1.1/\" xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\" xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">"
 #define DIDL_LITE_END   "</DIDL-Lite>";
 
+// Characters of Browse results kept between content changes
+static const int kMaxBrowseCacheSize = 16 * 1024 * 1024;
+// Seconds cached results and counts are kept, not every change (e.g. video
+// metadata edits) raises an event
+static const int kCacheExpireSecs = 5 * 60;
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
@@ -52,7 +63,8 @@ QString UPnpCDSExtensionResults::GetResultXML(FilterMap &filter)
 /////////////////////////////////////////////////////////////////////////////
 
 UPnpCDS::UPnpCDS( UPnpDevice *pDevice, const QString &sSharePath )
-  : Eventing( "UPnpCDS", "CDS_Event", sSharePath )
+  : Eventing( "UPnpCDS", "CDS_Event", sSharePath ),
+    m_nBrowseCacheSize( 0 ), m_nSystemUpdateID( 1 )
 {
     m_root.m_eType      = OT_Container;
     m_root.m_sId        = "0";
@@ -64,9 +76,9 @@ UPnpCDS::UPnpCDS( UPnpDevice *pDevice, const QString &sSharePath )
 
     AddVariable( new StateVariable< QString        >( "TransferIDs"       , true ) );
     AddVariable( new StateVariable< QString        >( "ContainerUpdateIDs", true ) );
-    AddVariable( new StateVariable< unsigned short >( "SystemUpdateID"    , true ) );
+    AddVariable( new StateVariable< uint           >( "SystemUpdateID"    , true ) );
 
-    SetValue< unsigned short >( "SystemUpdateID", 1 );
+    SetValue< uint >( "SystemUpdateID", m_nSystemUpdateID );
 
     QString sUPnpDescPath = UPnp::GetConfiguration()->GetValue( "UPnP/DescXmlPath", sSharePath );
 
@@ -77,6 +89,10 @@ UPnpCDS::UPnpCDS( UPnpDevice *pDevice, const QString &sSharePath )
     // Add our Service Definition to the device.
 
     RegisterService( pDevice );
+
+    // Content change events keep the update IDs and cached results current
+
+    gCoreContext->addListener( this );
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -85,6 +101,8 @@ UPnpCDS::UPnpCDS( UPnpDevice *pDevice, const QString &sSharePath )
 
 UPnpCDS::~UPnpCDS()
 {
+    gCoreContext->removeListener( this );
+
     while (!m_extensions.empty())
     {
         delete m_extensions.back();
@@ -152,6 +170,49 @@ QStringList UPnpCDS::GetBasePaths()
     return Eventing::GetBasePaths() << m_sControlUrl;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Each extension decides which events change its content.  A change bumps
+// the SystemUpdateID and the extension's container update ID, and drops
+// the Browse results built from the old content.
+/////////////////////////////////////////////////////////////////////////////
+
+void UPnpCDS::customEvent( QEvent *pEvent )
+{
+    if (pEvent->type() != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent  *me = static_cast<MythEvent *>(pEvent);
+    QStringList sContainers;
+
+    UPnpCDSExtensionList::iterator it = m_extensions.begin();
+    for (; it != m_extensions.end(); ++it)
+    {
+        if ((*it)->ProcessEvent( *me ))
+        {
+            sContainers << (*it)->m_sExtensionId
+                        << QString::number( (*it)->GetUpdateID() );
+        }
+    }
+
+    if (sContainers.isEmpty())
+        return;
+
+    uint nSystemUpdateID;
+
+    m_cacheLock.lock();
+    m_browseCache.clear();
+    m_nBrowseCacheSize = 0;
+    nSystemUpdateID    = ++m_nSystemUpdateID;
+    m_cacheLock.unlock();
+
+    LOG(VB_UPNP, LOG_DEBUG,
+        QString("UPnpCDS: %1 changed, SystemUpdateID=%2")
+            .arg(sContainers.join(",")).arg(nSystemUpdateID));
+
+    SetValue< QString >( "ContainerUpdateIDs", sContainers.join(",") );
+    SetValue< uint    >( "SystemUpdateID"    , nSystemUpdateID );
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
@@ -330,12 +391,59 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
 
     UPnPResultCode eErrorCode      = UPnPResult_CDS_NoSuchObject;
     QString        sErrorDesc      = "";
-    short          nNumberReturned = 0;
-    short          nTotalMatches   = 0;
-    short          nUpdateID       = 0;
+    int            nNumberReturned = 0;
+    int            nTotalMatches   = 0;
+    uint           nUpdateID       = 0;
     QString        sResultXML;
     FilterMap filter =  (FilterMap) request.m_sFilter.split(',');
 
+    // ----------------------------------------------------------------------
+    // Renderers page through the same containers again and again, answer
+    // from the results kept since the content last changed if we can.
+    // ----------------------------------------------------------------------
+
+    QStringList sKeyParts;
+
+    sKeyParts << QString::number( request.m_eClient        )
+              << QString::number( request.m_nClientVersion )
+              << request.m_sObjectId
+              << request.m_sContainerID
+              << QString::number( request.m_eBrowseFlag    )
+              << request.m_sFilter
+              << QString::number( request.m_nStartingIndex )
+              << QString::number( request.m_nRequestedCount)
+              << request.m_sSortCriteria;
+
+    QString sCacheKey = sKeyParts.join( "\n" );
+
+    m_cacheLock.lock();
+
+    uint nCacheUpdateID = m_nSystemUpdateID;
+    BrowseCache::iterator itCache = m_browseCache.find( sCacheKey );
+
+    if (itCache != m_browseCache.end() &&
+        (*itCache).dtExpires < MythDate::current())
+    {
+        m_nBrowseCacheSize -= (*itCache).sResultXML.length();
+        m_browseCache.erase( itCache );
+        itCache = m_browseCache.end();
+    }
+
+    if (itCache != m_browseCache.end())
+    {
+        BrowseResult result = *itCache;
+        m_cacheLock.unlock();
+
+        LOG(VB_UPNP, LOG_DEBUG,
+            QString("UPnpCDS::HandleBrowse ObjectID=%1 (cached)")
+                .arg(request.m_sObjectId));
+
+        FormatBrowseResponse( pRequest, result );
+        return;
+    }
+
+    m_cacheLock.unlock();
+
     LOG(VB_UPNP, LOG_INFO,
         QString("UPnpCDS::HandleBrowse ObjectID=%1, ContainerId=%2")
             .arg(request.m_sObjectId) .arg(request.m_sContainerID));
@@ -357,7 +465,7 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
                 eErrorCode      = UPnPResult_Success;
                 nNumberReturned = 1;
                 nTotalMatches   = 1;
-                nUpdateID       = m_root.m_nUpdateId;
+                nUpdateID       = nCacheUpdateID;
 
                 m_root.SetChildCount( m_extensions.count() );
 
@@ -370,17 +478,15 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
             {
                 // Loop Through each extension and Build the Root Folders
 
-                // -=>TODO: Need to handle StartingIndex & RequestedCount
-
                 eErrorCode      = UPnPResult_Success;
                 nTotalMatches   = m_extensions.count();
-                nUpdateID       = m_root.m_nUpdateId;
+                nUpdateID       = nCacheUpdateID;
 
                 if (request.m_nRequestedCount == 0)
                     request.m_nRequestedCount = nTotalMatches;
 
-                short nStart = Max( request.m_nStartingIndex, short( 0 ));
-                short nCount = Min( nTotalMatches, request.m_nRequestedCount );
+                int nStart = Max( request.m_nStartingIndex, 0 );
+                int nCount = Min( nTotalMatches, request.m_nRequestedCount );
 
                 UPnpCDSRequest       childRequest;
 
@@ -458,18 +564,34 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
 
     if (eErrorCode == UPnPResult_Success)
     {
-        NameValues list;
+        BrowseResult result;
 
-        QString sResults = DIDL_LITE_BEGIN;
-        sResults += sResultXML;
-        sResults += DIDL_LITE_END;
+        result.sResultXML      = sResultXML;
+        result.nNumberReturned = nNumberReturned;
+        result.nTotalMatches   = nTotalMatches;
+        result.nUpdateID       = nUpdateID;
+        result.dtExpires       = MythDate::current().addSecs(kCacheExpireSecs);
 
-        list.push_back(NameValue("Result",         sResults));
-        list.push_back(NameValue("NumberReturned", nNumberReturned));
-        list.push_back(NameValue("TotalMatches",   nTotalMatches));
-        list.push_back(NameValue("UpdateID",       nUpdateID));
+        // Only keep it if the content didn't change while it was built
 
-        pRequest->FormatActionResponse(list);
+        m_cacheLock.lock();
+
+        if (nCacheUpdateID == m_nSystemUpdateID &&
+            sResultXML.length() < kMaxBrowseCacheSize / 4)
+        {
+            if (m_nBrowseCacheSize + sResultXML.length() > kMaxBrowseCacheSize)
+            {
+                m_browseCache.clear();
+                m_nBrowseCacheSize = 0;
+            }
+
+            m_browseCache.insert( sCacheKey, result );
+            m_nBrowseCacheSize += sResultXML.length();
+        }
+
+        m_cacheLock.unlock();
+
+        FormatBrowseResponse( pRequest, result );
     }
     else
         UPnp::FormatErrorResponse ( pRequest, eErrorCode, sErrorDesc );
@@ -480,6 +602,27 @@ void UPnpCDS::HandleBrowse( HTTPRequest *pRequest )
 //
 /////////////////////////////////////////////////////////////////////////////
 
+void UPnpCDS::FormatBrowseResponse( HTTPRequest        *pRequest,
+                                    const BrowseResult &result )
+{
+    NameValues list;
+
+    QString sResults = DIDL_LITE_BEGIN;
+    sResults += result.sResultXML;
+    sResults += DIDL_LITE_END;
+
+    list.push_back(NameValue("Result",         sResults));
+    list.push_back(NameValue("NumberReturned", result.nNumberReturned));
+    list.push_back(NameValue("TotalMatches",   result.nTotalMatches));
+    list.push_back(NameValue("UpdateID",       result.nUpdateID));
+
+    pRequest->FormatActionResponse(list);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
 void UPnpCDS::HandleSearch( HTTPRequest *pRequest )
 {
     UPnpCDSExtensionResults *pResult  = NULL;
@@ -487,9 +630,9 @@ void UPnpCDS::HandleSearch( HTTPRequest *pRequest )
 
     UPnPResultCode eErrorCode      = UPnPResult_InvalidAction;
     QString       sErrorDesc      = "";
-    short         nNumberReturned = 0;
-    short         nTotalMatches   = 0;
-    short         nUpdateID       = 0;
+    int           nNumberReturned = 0;
+    int           nTotalMatches   = 0;
+    uint          nUpdateID       = 0;
     QString       sResultXML;
 
     DetermineClient( pRequest, &request );
@@ -670,7 +813,7 @@ void UPnpCDS::HandleGetSystemUpdateID( HTTPRequest *pRequest )
         QString("UPnpCDS::ProcessRequest : %1 : %2")
             .arg(pRequest->m_sBaseUrl) .arg(pRequest->m_sMethod));
 
-    unsigned short nId = GetValue<unsigned short>("SystemUpdateID");
+    uint nId = GetValue<uint>("SystemUpdateID");
 
     list.push_back(NameValue("Id", nId));
 
@@ -731,6 +874,8 @@ UPnpCDSExtensionResults *UPnpCDSExtension::Browse( UPnpCDSRequest *pRequest )
 
     if (pResults != NULL)
     {
+        pResults->m_nUpdateID = GetUpdateID();
+
         if (!key.isEmpty())
             idPath.last().append(QString("=%1").arg(key));
         else
@@ -813,6 +958,8 @@ UPnpCDSExtensionResults *UPnpCDSExtension::Search( UPnpCDSRequest *pRequest )
 
     UPnpCDSExtensionResults *pResults = new UPnpCDSExtensionResults();
 
+    pResults->m_nUpdateID = GetUpdateID();
+
     CreateItems( pRequest, pResults, 0, "", false );
 
     return pResults;
@@ -850,9 +997,8 @@ UPnpCDSExtensionResults *
                                    QStringList             &/*idPath*/ )
 {
     pResults->m_nTotalMatches   = 0;
-    pResults->m_nUpdateID       = 1;
 
-    short nRootCount = GetRootCount();
+    int nRootCount = GetRootCount();
 
     switch( pRequest->m_eBrowseFlag )
     {
@@ -863,7 +1009,6 @@ UPnpCDSExtensionResults *
             // --------------------------------------------------------------
 
             pResults->m_nTotalMatches   = 1;
-            pResults->m_nUpdateID       = 1;
 
             CDSObject *pRoot = CreateContainer( m_sExtensionId, m_sName, "0");
 
@@ -877,19 +1022,17 @@ UPnpCDSExtensionResults *
         case CDS_BrowseDirectChildren:
         {
             LOG(VB_UPNP, LOG_DEBUG, "CDS_BrowseDirectChildren");
-            pResults->m_nUpdateID     = 1;
             pResults->m_nTotalMatches = nRootCount ;
 
             if ( pRequest->m_nRequestedCount == 0)
                 pRequest->m_nRequestedCount = nRootCount ;
 
-            short nStart = max(pRequest->m_nStartingIndex, short(0));
-            short nEnd   = min(nRootCount,
-                               short(nStart + pRequest->m_nRequestedCount));
+            int nStart = max(pRequest->m_nStartingIndex, 0);
+            int nEnd   = min(nRootCount, nStart + pRequest->m_nRequestedCount);
 
             if (nStart < nRootCount)
             {
-                for (short nIdx = nStart; nIdx < nEnd; nIdx++)
+                for (int nIdx = nStart; nIdx < nEnd; nIdx++)
                 {
                     UPnpCDSRootInfo *pInfo = GetRootInfo( nIdx );
                     if (pInfo != NULL)
@@ -929,7 +1072,6 @@ UPnpCDSExtensionResults *
                                    QStringList             &/*idPath*/ )
 {
     pResults->m_nTotalMatches   = 0;
-    pResults->m_nUpdateID       = 1;
 
     // ----------------------------------------------------------------------
     //
@@ -948,7 +1090,6 @@ UPnpCDSExtensionResults *
             if (pInfo != NULL)
             {
                 pResults->m_nTotalMatches   = 1;
-                pResults->m_nUpdateID       = 1;
 
                 CDSObject *pItem =
                     CreateContainer( pRequest->m_sObjectId,
@@ -988,7 +1129,6 @@ UPnpCDSExtensionResults *
                                   QStringList             &idPath)
 {
     pResults->m_nTotalMatches   = 0;
-    pResults->m_nUpdateID       = 1;
 
     // ----------------------------------------------------------------------
     //
@@ -1051,7 +1191,6 @@ UPnpCDSExtensionResults *
                                   QStringList             &idPath )
 {
     pResults->m_nTotalMatches   = 0;
-    pResults->m_nUpdateID       = 1;
 
     // ----------------------------------------------------------------------
     //
@@ -1101,7 +1240,6 @@ UPnpCDSExtensionResults *
                         // ----------------------------------------------
 
                         pResults->m_nTotalMatches   = 1;
-                        pResults->m_nUpdateID       = 1;
 
                         CDSObject *pItem =
                             CreateContainer( pRequest->m_sObjectId,
@@ -1142,7 +1280,6 @@ UPnpCDSExtensionResults *
                                         int                      nNodeIdx,
                                         QStringList             &/*idPath*/ )
 {
-    pResults->m_nUpdateID     = 1;
     pResults->m_nTotalMatches = 0;
 
     UPnpCDSRootInfo *pInfo = GetRootInfo( nNodeIdx );
@@ -1159,7 +1296,6 @@ UPnpCDSExtensionResults *
             // --------------------------------------------------------------
 
             pResults->m_nTotalMatches   = 1;
-            pResults->m_nUpdateID       = 1;
 
             CDSObject *pItem = CreateContainer( pRequest->m_sObjectId,
                                                 QObject::tr( pInfo->title ),
@@ -1174,10 +1310,9 @@ UPnpCDSExtensionResults *
         case CDS_BrowseDirectChildren:
         {
             pResults->m_nTotalMatches = GetDistinctCount( pInfo );
-            pResults->m_nUpdateID     = 1;
 
             if (pRequest->m_nRequestedCount == 0)
-                pRequest->m_nRequestedCount = SHRT_MAX;
+                pRequest->m_nRequestedCount = INT_MAX;
 
             MSqlQuery query(MSqlQuery::InitCon());
 
@@ -1233,62 +1368,78 @@ UPnpCDSExtensionResults *
 
 int UPnpCDSExtension::GetDistinctCount( UPnpCDSRootInfo *pInfo )
 {
-    int nCount = 0;
-
     if ((pInfo == NULL) || (pInfo->column == NULL))
         return 0;
 
-    MSqlQuery query(MSqlQuery::InitCon());
+    // Note: Tried to use Bind, however it would not allow me to use it
+    //       for column & table names
 
-    if (query.isConnected())
+    QString sSQL;
+
+    if (strncmp( pInfo->column, "*", 1) == 0)
     {
-        // Note: Tried to use Bind, however it would not allow me to use it
-        //       for column & table names
+        sSQL = QString( "SELECT count( %1 ) FROM %2" )
+                  .arg( pInfo->column )
+                  .arg( GetTableName( pInfo->column ));
+    }
+    else
+    {
+        sSQL = QString( "SELECT count( DISTINCT %1 ) FROM %2" )
+                  .arg( pInfo->column )
+                  .arg( GetTableName( pInfo->column ) );
+    }
 
-        QString sSQL;
+    return QueryCount( sSQL );
+}
 
-        if (strncmp( pInfo->column, "*", 1) == 0)
-        {
-            sSQL = QString( "SELECT count( %1 ) FROM %2" )
-                      .arg( pInfo->column )
-                      .arg( GetTableName( pInfo->column ));
-        }
-        else
-        {
-            sSQL = QString( "SELECT count( DISTINCT %1 ) FROM %2" )
-                      .arg( pInfo->column )
-                      .arg( GetTableName( pInfo->column ) );
-        }
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
 
-        query.prepare( sSQL );
+int UPnpCDSExtension::GetCount( const QString &sColumn, const QString &sKey )
+{
+    QString sSQL = QString("SELECT count( %1 ) FROM %2")
+                   .arg( sColumn ).arg( GetTableName( sColumn ) );
 
-        if (query.exec() && query.next())
-        {
-            nCount = query.value(0).toInt();
-        }
-    }
+    if ( sKey.length() )
+        sSQL += " WHERE " + sColumn + " = :KEY";
 
-    return( nCount );
+    return QueryCount( sSQL, sKey );
 }
 
 /////////////////////////////////////////////////////////////////////////////
-//
+// Counts only change with the content, so each one is queried once and
+// kept until ContentChanged(), or for kCacheExpireSecs at most.  A non
+// empty sKey is bound to :KEY.
 /////////////////////////////////////////////////////////////////////////////
 
-int UPnpCDSExtension::GetCount( const QString &sColumn, const QString &sKey )
+int UPnpCDSExtension::QueryCount( const QString &sSQL, const QString &sKey )
 {
+    QString sCacheKey = sSQL + '\n' + sKey;
+
+    m_cacheLock.lock();
+    if (!m_dtCountsExpire.isValid() ||
+        m_dtCountsExpire < MythDate::current())
+    {
+        m_mapCounts.clear();
+        m_dtCountsExpire = MythDate::current().addSecs(kCacheExpireSecs);
+    }
+    QMap<QString, int>::const_iterator it = m_mapCounts.find( sCacheKey );
+    if (it != m_mapCounts.end())
+    {
+        int nCount = *it;
+        m_cacheLock.unlock();
+        return nCount;
+    }
+    uint nUpdateID = m_nUpdateID;
+    m_cacheLock.unlock();
+
     int nCount = 0;
 
     MSqlQuery query(MSqlQuery::InitCon());
 
     if (query.isConnected())
     {
-        QString sSQL = QString("SELECT count( %1 ) FROM %2")
-                       .arg( sColumn ).arg( GetTableName( sColumn ) );
-
-        if ( sKey.length() )
-            sSQL += " WHERE " + sColumn + " = :KEY";
-
         query.prepare( sSQL );
         if ( sKey.length() )
             query.bindValue( ":KEY", sKey );
@@ -1297,10 +1448,15 @@ int UPnpCDSExtension::GetCount( const QString &sColumn, const QString &sKey )
         {
             nCount = query.value(0).toInt();
         }
-        LOG(VB_UPNP, LOG_DEBUG, "UPnpCDSExtension::GetCount() - " +
+        LOG(VB_UPNP, LOG_DEBUG, "UPnpCDSExtension::QueryCount() - " +
                                 sSQL + " = " + QString::number(nCount));
     }
 
+    m_cacheLock.lock();
+    if (nUpdateID == m_nUpdateID)
+        m_mapCounts.insert( sCacheKey, nCount );
+    m_cacheLock.unlock();
+
     return( nCount );
 }
 
@@ -1308,6 +1464,29 @@ int UPnpCDSExtension::GetCount( const QString &sColumn, const QString &sKey )
 //
 /////////////////////////////////////////////////////////////////////////////
 
+void UPnpCDSExtension::ContentChanged( void )
+{
+    QMutexLocker locker( &m_cacheLock );
+
+    m_mapCounts.clear();
+    m_nUpdateID++;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+uint UPnpCDSExtension::GetUpdateID( void )
+{
+    QMutexLocker locker( &m_cacheLock );
+
+    return m_nUpdateID;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
 void UPnpCDSExtension::CreateItems( UPnpCDSRequest          *pRequest,
                                     UPnpCDSExtensionResults *pResults,
                                     int                      nNodeIdx,
@@ -1315,7 +1494,6 @@ void UPnpCDSExtension::CreateItems( UPnpCDSRequest          *pRequest,
                                     bool                     bAddRef )
 {
     pResults->m_nTotalMatches = 0;
-    pResults->m_nUpdateID     = 1;
 
     UPnpCDSRootInfo *pInfo = GetRootInfo( nNodeIdx );
 
@@ -1323,10 +1501,9 @@ void UPnpCDSExtension::CreateItems( UPnpCDSRequest          *pRequest,
         return;
 
     pResults->m_nTotalMatches = GetCount( pInfo->column, sKey );
-    pResults->m_nUpdateID     = 1;
 
     if (pRequest->m_nRequestedCount == 0)
-        pRequest->m_nRequestedCount = SHRT_MAX;
+        pRequest->m_nRequestedCount = INT_MAX;
 
     MSqlQuery query(MSqlQuery::InitCon());
 
@@ -13,14 +13,17 @@
 #ifndef UPnpCDS_H_
 #define UPnpCDS_H_
 
+#include <QDateTime>
 #include <QList>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
 
 #include "upnp.h"
 #include "upnpcdsobjects.h"
 #include "eventing.h"
 #include "mythdbcon.h"
+#include "mythevent.h"
 
 class UPnpCDS;
 
@@ -71,8 +74,8 @@ class UPNP_PUBLIC UPnpCDSRequest
 
         QString           m_sContainerID;
         QString           m_sFilter;
-        short             m_nStartingIndex;
-        short             m_nRequestedCount;
+        int               m_nStartingIndex;
+        int               m_nRequestedCount;
         QString           m_sSortCriteria;
 
         // Browse specific properties
@@ -111,8 +114,8 @@ class UPNP_PUBLIC UPnpCDSExtensionResults
         UPnPResultCode          m_eErrorCode;
         QString                 m_sErrorDesc;
 
-        short                   m_nTotalMatches;
-        short                   m_nUpdateID;
+        int                     m_nTotalMatches;
+        uint                    m_nUpdateID;
 
     public:
 
@@ -154,10 +157,20 @@ class UPNP_PUBLIC UPnpCDSExtension
         QString     m_sName;
         QString     m_sClass;
 
+    private:
+
+        QMutex              m_cacheLock;
+        QMap<QString, int>  m_mapCounts;    ///< counts already queried
+        QDateTime           m_dtCountsExpire;
+        uint                m_nUpdateID;
+
     protected:
 
         QString RemoveToken ( const QString &sToken, const QString &sStr, int num );
 
+        int  QueryCount     ( const QString &sSQL, const QString &sKey = "" );
+        void ContentChanged ( );
+
         virtual UPnpCDSExtensionResults *ProcessRoot     ( UPnpCDSRequest          *pRequest, 
                                                            UPnpCDSExtensionResults *pResults,
                                                            QStringList             &idPath );
@@ -215,7 +228,7 @@ class UPNP_PUBLIC UPnpCDSExtension
 
         UPnpCDSExtension( QString sName, 
                           QString sExtensionId, 
-                          QString sClass )
+                          QString sClass ) : m_nUpdateID( 1 )
         {
             m_sName        = QObject::tr(sName.toLatin1().constData());
             m_sExtensionId = sExtensionId;
@@ -229,6 +242,12 @@ class UPNP_PUBLIC UPnpCDSExtension
 
         virtual QString GetSearchCapabilities() { return( "" ); }
         virtual QString GetSortCapabilities  () { return( "" ); }
+
+        /// Called with each MythEvent message, returns true if it changed
+        /// what the extension serves (after calling ContentChanged())
+        virtual bool ProcessEvent( const MythEvent &/*event*/ ) { return false; }
+
+        uint GetUpdateID( );
 };
 
 typedef QList<UPnpCDSExtension*> UPnpCDSExtensionList;
@@ -245,9 +264,27 @@ class UPNP_PUBLIC UPnpCDS : public Eventing
 {
     private:
 
+        /// A Browse response kept until the content changes, or until
+        /// dtExpires for changes that are not evented
+        struct BrowseResult
+        {
+            QString   sResultXML;
+            int       nNumberReturned;
+            int       nTotalMatches;
+            uint      nUpdateID;
+            QDateTime dtExpires;
+        };
+
+        typedef QMap<QString, BrowseResult> BrowseCache;
+
         UPnpCDSExtensionList   m_extensions;
         CDSObject              m_root;
 
+        QMutex                 m_cacheLock;
+        BrowseCache            m_browseCache;
+        int                    m_nBrowseCacheSize;  ///< characters held
+        uint                   m_nSystemUpdateID;
+
         QString                m_sServiceDescFileName;
         QString                m_sControlUrl;
 
@@ -262,6 +299,7 @@ class UPNP_PUBLIC UPnpCDS : public Eventing
         void            HandleGetSortCapabilities  ( HTTPRequest *pRequest );
         void            HandleGetSystemUpdateID    ( HTTPRequest *pRequest );
         void            DetermineClient            ( HTTPRequest *pRequest, UPnpCDSRequest *pCDSRequest );
+        void            FormatBrowseResponse       ( HTTPRequest *pRequest, const BrowseResult &result );
 
     protected:
 
@@ -272,6 +310,8 @@ class UPNP_PUBLIC UPnpCDS : public Eventing
         virtual QString GetServiceControlURL() { return m_sControlUrl.mid( 1 ); }
         virtual QString GetServiceDescURL   () { return m_sControlUrl.mid( 1 ) + "/GetServDesc"; }
 
+        virtual void customEvent( QEvent *pEvent );
+
     public:
         UPnpCDS( UPnpDevice *pDevice,
                  const QString &sSharePath ); 
@@ -40,6 +40,7 @@ using namespace std;
 #include "mainserver.h"
 #include "compat.h"
 #include "mythlogging.h"
+#include "mythmetrics.h"
 
 #define LOC     QString("AutoExpire: ")
 #define LOC_ERR QString("AutoExpire Error: ")
@@ -51,6 +52,15 @@ extern AutoExpire *expirer;
  */
 #define SPACE_TOO_BIG_KB 3*1024*1024
 
+/// Filesystem info younger than this is reused by CalcParams(), in seconds
+static const int kFilesystemCacheSecs = 5 * 60;
+/// The expire candidates are reloaded from the database this often, in
+/// case something changed them without telling us, in seconds
+static const int kCandidateReloadSecs = 6 * 60 * 60;
+/// A recording still there this long after it was expired failed to
+/// delete, in seconds
+static const int kExpireRetrySecs = 10 * 60;
+
 /// \brief This calls AutoExpire::RunExpirer() from within a new thread.
 void ExpireThread::run(void)
 {
@@ -83,8 +93,20 @@ AutoExpire::AutoExpire(QMap<int, EncoderLink *> *tvList) :
     expire_thread_run(true),
     main_server(NULL),
     update_pending(false),
-    update_thread(NULL)
+    update_thread(NULL),
+    candidates_valid(false),
+    expire_method(emOldestFirst),
+    watched_first(false),
+    day_priority(3),
+    expire_now(false),
+    change_wakeup(false)
 {
+    MythMetrics::Describe("mythbackend_storage_free_bytes", MythMetrics::kGauge,
+                          "Free space on each storage group directory.");
+    MythMetrics::Describe("mythbackend_storage_total_bytes",
+                          MythMetrics::kGauge,
+                          "Size of each storage group directory's filesystem.");
+
     expire_thread->start();
     gCoreContext->addListener(this);
 }
@@ -99,7 +121,13 @@ AutoExpire::AutoExpire() :
     expire_thread_run(false),
     main_server(NULL),
     update_pending(false),
-    update_thread(NULL)
+    update_thread(NULL),
+    candidates_valid(false),
+    expire_method(emOldestFirst),
+    watched_first(false),
+    day_priority(3),
+    expire_now(false),
+    change_wakeup(false)
 {
 }
 
@@ -114,6 +142,12 @@ AutoExpire::~AutoExpire()
         instance_cond.wakeAll();
     }
 
+    {
+        QMutexLocker locker(&change_lock);
+        change_wakeup = true;
+        change_cond.wakeAll();
+    }
+
     {
         QMutexLocker locker(&instance_lock);
         while (update_pending)
@@ -127,6 +161,8 @@ AutoExpire::~AutoExpire()
         delete expire_thread;
         expire_thread = NULL;
     }
+
+    ClearCandidates();
 }
 
 /**
@@ -151,9 +187,13 @@ void AutoExpire::CalcParams()
 
     QList<FileSystemInfo> fsInfos;
 
+    // Walking every filesystem is slow, and which ones exist rarely
+    // changes, so use what the last expire pass found if it is recent
     instance_lock.lock();
-    if (main_server)
-        main_server->GetFilesystemInfos(fsInfos);
+    if (fs_infos.empty() ||
+        fs_infos_time.secsTo(MythDate::current()) > kFilesystemCacheSecs)
+        RefreshFilesystems();
+    fsInfos = fs_infos;
     instance_lock.unlock();
 
     if (fsInfos.empty())
@@ -283,23 +323,44 @@ void AutoExpire::CalcParams()
  *   maintain enough free space on all directories in MythTV Storage Groups.
  *   The thread deletes short LiveTV programs every 2 minutes and long
  *   LiveTV and regular programs as needed every "desired_freq" minutes.
+ *
+ *   In between, recording list changes and file size updates are applied
+ *   as they arrive, and recordings are expired as soon as a filesystem's
+ *   free space falls below what it needs.
  */
 void AutoExpire::RunExpirer(void)
 {
-    QTime timer;
     QDateTime curTime;
     QDateTime next_expire = MythDate::current().addSecs(60);
+    QDateTime next_minute;
 
     QMutexLocker locker(&instance_lock);
 
     // wait a little for main server to come up and things to settle down
     Sleep(20 * 1000);
 
-    timer.start();
+    next_minute = MythDate::current();
 
     while (expire_thread_run)
     {
+        ProcessChanges();
+
         curTime = MythDate::current();
+        if (curTime < next_minute)
+        {
+            if (expire_now)
+            {
+                LOG(VB_FILE, LOG_INFO, LOC +
+                    "A filesystem is low on space, running now!");
+                UpdateDontExpireSet();
+                ExpireRecordings(false);
+            }
+
+            WaitForWork(curTime.msecsTo(next_minute));
+            continue;
+        }
+        next_minute = curTime.addSecs(60);
+
         // recalculate auto expire parameters
         if (curTime >= next_expire)
         {
@@ -309,7 +370,6 @@ void AutoExpire::RunExpirer(void)
             if (!expire_thread_run)
                 break;
         }
-        timer.restart();
 
         UpdateDontExpireSet();
 
@@ -334,10 +394,12 @@ void AutoExpire::RunExpirer(void)
 
             ExpireEpisodesOverMax();
 
-            ExpireRecordings();
-        }
+            if (CandidateSettings() != candidate_settings ||
+                candidates_loaded.secsTo(curTime) > kCandidateReloadSecs)
+                candidates_valid = false;
 
-        Sleep(60 * 1000 - timer.elapsed());
+            ExpireRecordings(true);
+        }
     }
 }
 
@@ -361,6 +423,163 @@ void AutoExpire::Sleep(int sleepTime)
     }
 }
 
+/**
+ *  \brief Sleeps for up to sleepTime milliseconds, returning early when a
+ *         message needs looking at or the expire thread is told to quit.
+ *         Must be called with instance_lock held.
+ *
+ *  \note Will release instance_lock!
+ */
+void AutoExpire::WaitForWork(int sleepTime)
+{
+    instance_lock.unlock();
+
+    change_lock.lock();
+    if (!change_wakeup && sleepTime > 0)
+        change_cond.wait(&change_lock, sleepTime);
+    change_wakeup = false;
+    change_lock.unlock();
+
+    instance_lock.lock();
+}
+
+/**
+ *  \brief Queues the recording list changes and file size updates the
+ *         expire thread needs to know about, and wakes it up.
+ */
+void AutoExpire::customEvent(QEvent *event)
+{
+    if (event->type() != MythEvent::MythEventMessage)
+        return;
+
+    MythEvent *me = static_cast<MythEvent *>(event);
+    QStringList tokens = me->Message().split(" ", QString::SkipEmptyParts);
+    if (tokens.isEmpty())
+        return;
+
+    ExpireChange change;
+    change.filesize = -1;
+    bool resize = false;
+
+    if (tokens[0] == "RECORDING_LIST_CHANGE" && tokens.size() >= 4)
+    {
+        change.chanid     = tokens[2].toUInt();
+        change.recstartts = MythDate::fromString(tokens[3]);
+    }
+    else if (tokens[0] == "MASTER_UPDATE_PROG_INFO" && tokens.size() >= 3)
+    {
+        change.chanid     = tokens[1].toUInt();
+        change.recstartts = MythDate::fromString(tokens[2]);
+    }
+    else if (tokens[0] == "UPDATE_FILE_SIZE" && tokens.size() >= 4)
+    {
+        change.chanid     = tokens[1].toUInt();
+        change.recstartts = MythDate::fromString(tokens[2]);
+        change.filesize   = tokens[3].toLongLong();
+        resize = true;
+    }
+    else
+    {
+        return;
+    }
+
+    if (!change.chanid || !change.recstartts.isValid())
+        return;
+
+    QString key = ProgramInfo::MakeUniqueKey(change.chanid, change.recstartts);
+
+    QMutexLocker locker(&change_lock);
+    if (resize)
+        resized[key] = change;
+    else
+        changed[key] = change;
+    change_wakeup = true;
+    change_cond.wakeAll();
+}
+
+/**
+ *  \brief Applies the messages queued by customEvent(). Must be called
+ *         with instance_lock held.
+ *
+ *  Changed recordings are reloaded and put back in their place in the
+ *  expire order. File size updates are taken off the free space of the
+ *  recording's filesystem, and set expire_now if that leaves it with less
+ *  than it needs.
+ */
+void AutoExpire::ProcessChanges(void)
+{
+    QHash<QString, ExpireChange> changes, sizes;
+
+    change_lock.lock();
+    changes.swap(changed);
+    sizes.swap(resized);
+    change_lock.unlock();
+
+    QHash<QString, ExpireChange>::const_iterator it;
+    for (it = changes.begin(); it != changes.end(); ++it)
+    {
+        ProgramInfo *pginfo = new ProgramInfo(it->chanid, it->recstartts);
+
+        // A recording that is gone doesn't grow any more
+        if (!pginfo->GetChanID())
+        {
+            written.remove(it.key());
+            expiring.remove(it.key());
+        }
+
+        if (candidates_valid)
+        {
+            RemoveCandidate(it.key());
+            if (pginfo->GetChanID() && IsCandidate(pginfo))
+            {
+                AddCandidate(pginfo);
+                continue;
+            }
+        }
+
+        delete pginfo;
+    }
+
+    for (it = sizes.begin(); it != sizes.end(); ++it)
+    {
+        QHash<QString, WrittenRecording>::iterator wit =
+            written.find(it.key());
+        if (wit == written.end())
+        {
+            WrittenRecording rec;
+            ProgramInfo pginfo(it->chanid, it->recstartts);
+            if (pginfo.GetChanID())
+                LocateRecording(&pginfo, rec.dir);
+            rec.filesize = -1;
+            wit = written.insert(it.key(), rec);
+        }
+
+        // The first size seen is only a starting point, the filesystem
+        // was measured after some of it had already been written
+        int64_t grown = (wit->filesize < 0) ? 0 : it->filesize - wit->filesize;
+        wit->filesize = it->filesize;
+
+        QHash<QString, int>::const_iterator fit = dir_fsids.find(wit->dir);
+        if (grown <= 0 || fit == dir_fsids.end())
+            continue;
+
+        // Only act when the filesystem crosses the line, if a pass
+        // couldn't free enough it won't do any better until things change
+        int fsID = *fit;
+        int64_t wanted = desired_space.value(fsID, 0);
+        bool wasEnough = fs_free[fsID] >= wanted;
+        fs_free[fsID] -= grown / 1024;
+        if (wasEnough && fs_free[fsID] < wanted)
+        {
+            LOG(VB_FILE, LOG_INFO, LOC +
+                QString("fsID #%1 is down to %2 MB free, we want %3 MB")
+                    .arg(fsID).arg(fs_free[fsID] / 1024)
+                    .arg(wanted / 1024));
+            expire_now = true;
+        }
+    }
+}
+
 /** \fn AutoExpire::ExpireLiveTV(int type)
  *  \brief This expires LiveTV programs.
  */
@@ -400,23 +619,127 @@ void AutoExpire::ExpireQuickDeleted(void)
     ClearExpireList(expireList);
 }
 
-/** \fn AutoExpire::ExpireRecordings()
+/**
+ *  \brief Measures every filesystem, and maps each recording directory
+ *         on it to its file system ID. Must be called with instance_lock
+ *         held.
+ */
+void AutoExpire::RefreshFilesystems(void)
+{
+    QList<FileSystemInfo> fsInfos;
+
+    if (main_server)
+        main_server->GetFilesystemInfos(fsInfos);
+
+    if (fsInfos.empty())
+        return;
+
+    fs_infos = fsInfos;
+    fs_infos_time = MythDate::current();
+
+    dir_fsids.clear();
+    fs_free.clear();
+
+    QList<FileSystemInfo>::const_iterator fsit;
+    for (fsit = fs_infos.begin(); fsit != fs_infos.end(); ++fsit)
+    {
+        dir_fsids[fsit->getHostname() + ':' + fsit->getPath()] =
+            fsit->getFSysID();
+        fs_free[fsit->getFSysID()] = fsit->getFreeSpace();
+
+        QString labels = MythMetrics::Label("host", fsit->getHostname()) +
+            ',' + MythMetrics::Label("path", fsit->getPath());
+        MythMetrics::Set("mythbackend_storage_free_bytes",
+                         fsit->getFreeSpace() * 1024.0, labels);
+        MythMetrics::Set("mythbackend_storage_total_bytes",
+                         fsit->getTotalSpace() * 1024.0, labels);
+
+        if (!fs_queues.contains(fsit->getFSysID()))
+            fs_queues[fsit->getFSysID()] = ExpireQueue();
+    }
+
+    // What has been written so far is in the new numbers
+    QHash<QString, WrittenRecording>::iterator wit = written.begin();
+    for (; wit != written.end(); ++wit)
+        wit->filesize = -1;
+
+    // File system IDs are handed out afresh each time, so move any
+    // candidates whose directory now has a different one
+    PlaceCandidates();
+}
+
+/**
+ *  \brief Finds the file of a recording, which may be on another backend.
+ *
+ *  \param dir set to "hostname:directory" of the file
+ *  \return the file system ID of the directory, or -1 if the file
+ *          could not be found.
+ */
+int AutoExpire::LocateRecording(ProgramInfo *p, QString &dir)
+{
+    QString myHostName = gCoreContext->GetHostName();
+
+    if (!p->IsLocal())
+    {
+        bool foundFile = false;
+        QMap<int, EncoderLink *>::Iterator eit = encoderList->begin();
+        while (eit != encoderList->end())
+        {
+            EncoderLink *el = *eit;
+            eit++;
+
+            if ((p->GetHostname() == el->GetHostName()) ||
+                ((p->GetHostname() == myHostName) &&
+                 (el->IsLocal())))
+            {
+                if (el->IsConnected())
+                    foundFile = el->CheckFile(p);
+
+                eit = encoderList->end();
+            }
+        }
+
+        if (!foundFile && (p->GetHostname() != myHostName))
+        {
+            // Wasn't found so check locally
+            QString file = GetPlaybackURL(p);
+
+            if (file.startsWith("/"))
+            {
+                p->SetPathname(file);
+                p->SetHostname(myHostName);
+                foundFile = true;
+            }
+        }
+
+        if (!foundFile)
+            return -1;
+    }
+
+    QFileInfo vidFile(p->GetPathname());
+    dir = p->GetHostname() + ':' + vidFile.path();
+    return dir_fsids.value(dir, -1);
+}
+
+/** \fn AutoExpire::ExpireRecordings(bool)
  *  \brief This expires normal recordings.
  *
+ *  \param refresh measure the filesystems first, rather than relying on
+ *                 the free space accounted since they were last measured
  */
-void AutoExpire::ExpireRecordings(void)
+void AutoExpire::ExpireRecordings(bool refresh)
 {
-    pginfolist_t expireList;
     pginfolist_t deleteList;
-    QList<FileSystemInfo> fsInfos;
     QList<FileSystemInfo>::iterator fsit;
 
     LOG(VB_FILE, LOG_INFO, LOC + "ExpireRecordings()");
 
-    if (main_server)
-        main_server->GetFilesystemInfos(fsInfos);
+    expire_now = false;
 
-    if (fsInfos.empty())
+    if (refresh || fs_infos.empty())
+        RefreshFilesystems();
+
+    if (fs_infos.empty())
     {
         LOG(VB_GENERAL, LOG_ERR, LOC + "Filesystem Info cache is empty, unable "
                                       "to determine what Recordings to expire");
@@ -424,7 +747,10 @@ void AutoExpire::ExpireRecordings(void)
         return;
     }
 
-    FillExpireList(expireList);
+    CheckExpiring();
+
+    if (!candidates_valid)
+        LoadCandidates();
 
     QMap <int, bool> truncateMap;
     MSqlQuery query(MSqlQuery::InitCon());
@@ -448,7 +774,7 @@ void AutoExpire::ExpireRecordings(void)
                 QString("%1:%2 has an in-progress truncating delete.")
                     .arg(rechost).arg(recdir));
 
-            for (fsit = fsInfos.begin(); fsit != fsInfos.end(); ++fsit)
+            for (fsit = fs_infos.begin(); fsit != fs_infos.end(); ++fsit)
             {
                 if ((fsit->getHostname() == rechost) &&
                     (fsit->getPath() == recdir))
@@ -461,32 +787,35 @@ void AutoExpire::ExpireRecordings(void)
     }
 
     QMap <int, bool> fsMap;
-    for (fsit = fsInfos.begin(); fsit != fsInfos.end(); ++fsit)
+    for (fsit = fs_infos.begin(); fsit != fs_infos.end(); ++fsit)
     {
-        if (fsMap.contains(fsit->getFSysID()))
+        int fsID = fsit->getFSysID();
+
+        if (fsMap.contains(fsID))
             continue;
 
-        fsMap[fsit->getFSysID()] = true;
+        fsMap[fsID] = true;
 
         LOG(VB_FILE, LOG_INFO,
             QString("fsID #%1: Total: %2 GB   Used: %3 GB   Free: %4 GB")
-                .arg(fsit->getFSysID())
+                .arg(fsID)
                 .arg(fsit->getTotalSpace() / 1024.0 / 1024.0, 7, 'f', 1)
-                .arg(fsit->getUsedSpace() / 1024.0 / 1024.0, 7, 'f', 1)
-                .arg(fsit->getFreeSpace() / 1024.0 / 1024.0, 7, 'f', 1));
+                .arg((fsit->getTotalSpace() - fs_free[fsID])
+                     / 1024.0 / 1024.0, 7, 'f', 1)
+                .arg(fs_free[fsID] / 1024.0 / 1024.0, 7, 'f', 1));
 
         if ((fsit->getTotalSpace() == -1) || (fsit->getUsedSpace() == -1))
         {
             LOG(VB_FILE, LOG_ERR, LOC +
                 QString("fsID #%1 has invalid info, AutoExpire cannot run for "
                         "this filesystem.  Continuing on to next...")
-                    .arg(fsit->getFSysID()));
+                    .arg(fsID));
             LOG(VB_FILE, LOG_INFO, QString("Directories on filesystem ID %1:")
-                    .arg(fsit->getFSysID()));
+                    .arg(fsID));
             QList<FileSystemInfo>::iterator fsit2;
-            for (fsit2 = fsInfos.begin(); fsit2 != fsInfos.end(); ++fsit2)
+            for (fsit2 = fs_infos.begin(); fsit2 != fs_infos.end(); ++fsit2)
             {
-                if (fsit2->getFSysID() == fsit->getFSysID())
+                if (fsit2->getFSysID() == fsID)
                 {
                     LOG(VB_FILE, LOG_INFO, QString("    %1:%2")
                             .arg(fsit2->getHostname()).arg(fsit2->getPath()));
@@ -496,122 +825,175 @@ void AutoExpire::ExpireRecordings(void)
             continue;
         }
 
-        if (truncateMap.contains(fsit->getFSysID()))
+        if (truncateMap.contains(fsID))
         {
             LOG(VB_FILE, LOG_INFO,
                 QString("    fsid %1 has a truncating delete in progress,  "
                         "AutoExpire cannot run for this filesystem until the "
                         "delete has finished.  Continuing on to next...")
-                    .arg(fsit->getFSysID()));
+                    .arg(fsID));
             continue;
         }
 
-        if (max((int64_t)0LL, fsit->getFreeSpace()) <
-            desired_space[fsit->getFSysID()])
+        if (max((int64_t)0LL, fs_free[fsID]) < desired_space[fsID])
         {
             LOG(VB_FILE, LOG_INFO,
                 QString("    Not Enough Free Space!  We want %1 MB")
-                    .arg(desired_space[fsit->getFSysID()] / 1024));
-
-            QMap<QString, int> dirList;
-            QList<FileSystemInfo>::iterator fsit2;
+                    .arg(desired_space[fsID] / 1024));
 
             LOG(VB_FILE, LOG_INFO,
-                QString("    Directories on filesystem ID %1:")
-                    .arg(fsit->getFSysID()));
+                QString("    Directories on filesystem ID %1:").arg(fsID));
 
-            for (fsit2 = fsInfos.begin(); fsit2 != fsInfos.end(); ++fsit2)
+            QList<FileSystemInfo>::iterator fsit2;
+            for (fsit2 = fs_infos.begin(); fsit2 != fs_infos.end(); ++fsit2)
             {
-                if (fsit2->getFSysID() == fsit->getFSysID())
+                if (fsit2->getFSysID() == fsID)
                 {
                     LOG(VB_FILE, LOG_INFO, QString("        %1:%2")
                             .arg(fsit2->getHostname()).arg(fsit2->getPath()));
-                    dirList[fsit2->getHostname() + ":" + fsit2->getPath()] = 1;
                 }
             }
 
             LOG(VB_FILE, LOG_INFO,
                 "    Searching for files expirable in these directories");
-            QString myHostName = gCoreContext->GetHostName();
-            pginfolist_t::iterator it = expireList.begin();
-            while ((it != expireList.end()) &&
-                   (max((int64_t)0LL, fsit->getFreeSpace()) <
-                    desired_space[fsit->getFSysID()]))
-            {
-                ProgramInfo *p = *it;
-                ++it;
+            ExpireFromFilesystem(fsID, deleteList);
+        }
+    }
 
-                LOG(VB_FILE, LOG_INFO, QString("        Checking %1 => %2")
-                        .arg(p->toString(ProgramInfo::kRecordingKey))
-                        .arg(p->GetTitle()));
+    SendDeleteMessages(deleteList);
 
-                if (!p->IsLocal())
-                {
-                    bool foundFile = false;
-                    QMap<int, EncoderLink *>::Iterator eit =
-                         encoderList->begin();
-                    while (eit != encoderList->end())
-                    {
-                        EncoderLink *el = *eit;
-                        eit++;
-
-                        if ((p->GetHostname() == el->GetHostName()) ||
-                            ((p->GetHostname() == myHostName) &&
-                             (el->IsLocal())))
-                        {
-                            if (el->IsConnected())
-                                foundFile = el->CheckFile(p);
-
-                            eit = encoderList->end();
-                        }
-                    }
+    ClearExpireList(deleteList);
+}
 
-                    if (!foundFile && (p->GetHostname() != myHostName))
-                    {
-                        // Wasn't found so check locally
-                        QString file = GetPlaybackURL(p);
-
-                        if (file.startsWith("/"))
-                        {
-                            p->SetPathname(file);
-                            p->SetHostname(myHostName);
-                            foundFile = true;
-                        }
-                    }
+/**
+ *  \brief Reloads the candidates if a recording that was expired a while
+ *         ago is still there. Must be called with instance_lock held.
+ *
+ *  Candidates are taken out of the expire order when they are expired, so
+ *  one whose delete failed would otherwise not be tried again until the
+ *  next scheduled reload.
+ */
+void AutoExpire::CheckExpiring(void)
+{
+    QDateTime now = MythDate::current();
 
-                    if (!foundFile)
-                    {
-                        LOG(VB_FILE, LOG_ERR, LOC +
-                            QString("        ERROR: Can't find file for %1")
-                                .arg(p->toString(ProgramInfo::kRecordingKey)));
-                        continue;
-                    }
-                }
+    QHash<QString, ExpiringRecording>::iterator it = expiring.begin();
+    while (it != expiring.end())
+    {
+        if (it->sent.secsTo(now) < kExpireRetrySecs)
+        {
+            ++it;
+            continue;
+        }
 
-                QFileInfo vidFile(p->GetPathname());
-                if (dirList.contains(p->GetHostname() + ':' + vidFile.path()))
-                {
-                    fsit->setUsedSpace(fsit->getUsedSpace()
-                                                - (p->GetFilesize() / 1024));
-                    deleteList.push_back(p);
-
-                    LOG(VB_FILE, LOG_INFO,
-                        QString("        FOUND file expirable. "
-                                "%1 is located at %2 which is on fsID #%3. "
-                                "Adding to deleteList.  After deleting we "
-                                "should have %4 MB free on this filesystem.")
-                            .arg(p->toString(ProgramInfo::kRecordingKey))
-                            .arg(p->GetPathname()).arg(fsit->getFSysID())
-                            .arg(fsit->getFreeSpace() / 1024));
-                }
-            }
+        // One that is still being deleted isn't a candidate either way
+        ProgramInfo pginfo(it->chanid, it->recstartts);
+        if (pginfo.GetChanID() && !pginfo.IsDeletePending())
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                QString("%1 was not deleted when it was expired, "
+                        "it will be expired again")
+                    .arg(pginfo.toString(ProgramInfo::kRecordingKey)));
+            candidates_valid = false;
         }
+
+        it = expiring.erase(it);
     }
+}
 
-    SendDeleteMessages(deleteList);
+/**
+ *  \brief Takes candidates on one filesystem, in expire order, until it
+ *         would have the space it needs.
+ *
+ *  Candidates that haven't been located yet are located as the walk
+ *  reaches them, and go into the queue of whichever filesystem they are
+ *  on. The candidates taken are removed from the queues and now belong
+ *  to deleteList.
+ */
+void AutoExpire::ExpireFromFilesystem(int fsID, pginfolist_t &deleteList)
+{
+    ExpireQueue &placed = fs_queues[fsID];
+    ExpireQueue::iterator pit = placed.begin();
+    ExpireQueue::iterator uit = unplaced_queue.begin();
 
-    ClearExpireList(deleteList, false);
-    ClearExpireList(expireList);
+    while (max((int64_t)0LL, fs_free[fsID]) < desired_space[fsID])
+    {
+        bool fromUnplaced = (uit != unplaced_queue.end()) &&
+            (pit == placed.end() || uit.key() < pit.key());
+
+        if (!fromUnplaced && pit == placed.end())
+            break;
+
+        ProgramInfo *p = fromUnplaced ? *uit : *pit;
+        QString key = p->MakeUniqueKey();
+
+        LOG(VB_FILE, LOG_INFO, QString("        Checking %1 => %2")
+                .arg(p->toString(ProgramInfo::kRecordingKey))
+                .arg(p->GetTitle()));
+
+        if (fromUnplaced)
+        {
+            QString dir;
+            int candFS = LocateRecording(p, dir);
+            if (dir.isEmpty())
+            {
+                LOG(VB_FILE, LOG_ERR, LOC +
+                    QString("        ERROR: Can't find file for %1")
+                        .arg(p->toString(ProgramInfo::kRecordingKey)));
+                ++uit;
+                continue;
+            }
+
+            ExpireCandidate &cand = candidates[key];
+            cand.fsID = candFS;
+            cand.dir  = dir;
+            uit = unplaced_queue.erase(uit);
+
+            if (candFS != fsID)
+            {
+                // Directories not on any filesystem we know of are looked
+                // for again on the next walk, as they used to be
+                if (candFS >= 0)
+                    fs_queues[candFS].insert(cand.key, p);
+                else
+                    unplaced_queue.insert(cand.key, p);
+                continue;
+            }
+
+            if (IsInDontExpireSet(p->GetChanID(), p->GetRecordingStartTime()))
+            {
+                // Inserted ahead of pit, which stays valid
+                placed.insert(cand.key, p);
+                LOG(VB_FILE, LOG_INFO, LOC +
+                    "        Skipping it because it is in use");
+                continue;
+            }
+        }
+        else
+        {
+            if (IsInDontExpireSet(p->GetChanID(), p->GetRecordingStartTime()))
+            {
+                ++pit;
+                LOG(VB_FILE, LOG_INFO, LOC +
+                    "        Skipping it because it is in use");
+                continue;
+            }
+            pit = placed.erase(pit);
+        }
+
+        candidates.remove(key);
+        fs_free[fsID] += p->GetFilesize() / 1024;
+        deleteList.push_back(p);
+
+        LOG(VB_FILE, LOG_INFO,
+            QString("        FOUND file expirable. "
+                    "%1 is located at %2 which is on fsID #%3. "
+                    "Adding to deleteList.  After deleting we "
+                    "should have %4 MB free on this filesystem.")
+                .arg(p->toString(ProgramInfo::kRecordingKey))
+                .arg(p->GetPathname()).arg(fsID)
+                .arg(fs_free[fsID] / 1024));
+    }
 }
 
 /**
@@ -645,6 +1027,11 @@ void AutoExpire::SendDeleteMessages(pginfolist_t &deleteList)
                      .arg((*it)->GetRecordingStartTime(MythDate::ISODate)));
         gCoreContext->dispatch(me);
 
+        ExpiringRecording &exp = expiring[(*it)->MakeUniqueKey()];
+        exp.chanid     = (*it)->GetChanID();
+        exp.recstartts = (*it)->GetRecordingStartTime();
+        exp.sent       = MythDate::current();
+
         ++it; // move on to next program
     }
 }
@@ -770,24 +1157,24 @@ void AutoExpire::ExpireEpisodesOverMax(void)
     }
 }
 
-/** \fn AutoExpire::FillExpireList(pginfolist_t&)
+/** \fn AutoExpire::FillExpireList(pginfolist_t&, bool)
  *  \brief Uses the "AutoExpireMethod" setting in the database to
  *         fill the list of files that are deletable.
  */
-void AutoExpire::FillExpireList(pginfolist_t &expireList)
+void AutoExpire::FillExpireList(pginfolist_t &expireList, bool skipInUse)
 {
     int expMethod = gCoreContext->GetNumSetting("AutoExpireMethod", 1);
 
     ClearExpireList(expireList);
 
-    FillDBOrdered(expireList, emNormalDeletedPrograms);
+    FillDBOrdered(expireList, emNormalDeletedPrograms, skipInUse);
 
     switch(expMethod)
     {
         case emOldestFirst:
         case emLowestPriorityFirst:
         case emWeightedTimePriority:
-                FillDBOrdered(expireList, expMethod);
+                FillDBOrdered(expireList, expMethod, skipInUse);
                 break;
         // default falls through so list is empty so no AutoExpire
     }
@@ -840,16 +1227,9 @@ void AutoExpire::PrintExpireList(QString expHost)
  */
 void AutoExpire::GetAllExpiring(QStringList &strList)
 {
-    QMutexLocker lockit(&instance_lock);
     pginfolist_t expireList;
 
-    UpdateDontExpireSet();
-
-    FillDBOrdered(expireList, emShortLiveTVPrograms);
-    FillDBOrdered(expireList, emNormalLiveTVPrograms);
-    FillDBOrdered(expireList, emNormalDeletedPrograms);
-    FillDBOrdered(expireList, gCoreContext->GetNumSetting("AutoExpireMethod",
-                  emOldestFirst));
+    GetAllExpiring(expireList);
 
     strList << QString::number(expireList.size());
 
@@ -865,22 +1245,110 @@ void AutoExpire::GetAllExpiring(QStringList &strList)
  */
 void AutoExpire::GetAllExpiring(pginfolist_t &list)
 {
-    QMutexLocker lockit(&instance_lock);
-    pginfolist_t expireList;
+    GetAllExpiring(list, 0, 0);
+}
 
-    UpdateDontExpireSet();
+/** \fn AutoExpire::GetAllExpiring(pginfolist_t&, uint, uint)
+ *  \brief Gets one page of the programs that can expire in expiration order
+ *
+ *  This is the order of the FillDBOrdered() passes of FillExpireList(),
+ *  with a program counted in the first pass that takes it. It is worked
+ *  out by the database, so only the programs in the page are loaded.
+ *
+ *  \param list  filled with the programs, the caller must delete them
+ *  \param start number of programs to skip
+ *  \param count most programs to return, 0 for all of them
+ *  \return total number of programs that can expire
+ */
+uint AutoExpire::GetAllExpiring(pginfolist_t &list, uint start, uint count)
+{
+    const int passes[] =
+    {
+        emShortLiveTVPrograms,
+        emNormalLiveTVPrograms,
+        emNormalDeletedPrograms,
+        gCoreContext->GetNumSetting("AutoExpireMethod", emOldestFirst),
+    };
+
+    // Number each program by the first pass that takes it
+    QString pass = "CASE";
+    QMap<uint, QStringList> passOrders;
+    for (uint i = 0; i < sizeof(passes) / sizeof(passes[0]); ++i)
+    {
+        QString where, msg;
+        if (expire_method_query(passes[i], where, passOrders[i], msg))
+            pass += QString(" WHEN (%1) THEN %2").arg(where).arg(i);
+        else
+            passOrders.remove(i);
+    }
+    pass += " END";
 
-    FillDBOrdered(expireList, emShortLiveTVPrograms);
-    FillDBOrdered(expireList, emNormalLiveTVPrograms);
-    FillDBOrdered(expireList, emNormalDeletedPrograms);
-    FillDBOrdered(expireList, gCoreContext->GetNumSetting("AutoExpireMethod",
-                  emOldestFirst));
+    // and only use the order of that pass within it
+    QStringList order;
+    QMap<uint, QStringList>::const_iterator pit = passOrders.begin();
+    for (; pit != passOrders.end(); ++pit)
+    {
+        QStringList::const_iterator it = pit->begin();
+        for (; it != pit->end(); ++it)
+        {
+            int dir = it->lastIndexOf(' ');
+            order << QString("CASE WHEN %1 = %2 THEN %3 END%4")
+                .arg(pass).arg(pit.key()).arg(it->left(dir)).arg(it->mid(dir));
+        }
+    }
 
-    pginfolist_t::iterator it = expireList.begin();
-    for (; it != expireList.end(); ++it)
-        list.push_back( new ProgramInfo( *(*it) ));
+    // Programs that are in use are left out, as UpdateDontExpireSet() does
+    QString from = QString(
+        "FROM recorded "
+        "LEFT JOIN channel ON recorded.chanid = channel.chanid "
+        "WHERE deletepending = 0 AND %1 IS NOT NULL "
+        "AND NOT EXISTS "
+        "    (SELECT 1 FROM inuseprograms "
+        "     WHERE inuseprograms.chanid = recorded.chanid "
+        "       AND inuseprograms.starttime = recorded.starttime "
+        "       AND lastupdatetime > DATE_ADD(NOW(), INTERVAL -2 HOUR)) ")
+        .arg(pass);
 
-    ClearExpireList(expireList);
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare("SELECT COUNT(*) " + from);
+    if (!query.exec() || !query.next())
+    {
+        MythDB::DBError("AutoExpire::GetAllExpiring()", query);
+        return 0;
+    }
+    uint total = query.value(0).toUInt();
+
+    if (start >= total)
+        return total;
+
+    QString querystr = "SELECT recorded.chanid, starttime " + from +
+        QString("ORDER BY %1, autoexpire DESC, %2")
+            .arg(pass).arg(order.join(", "));
+    if (count > 0)
+        querystr += QString(" LIMIT %1, %2").arg(start).arg(count);
+    else if (start > 0)
+        querystr += QString(" LIMIT %1, 18446744073709551615").arg(start);
+
+    query.prepare(querystr);
+    if (!query.exec())
+    {
+        MythDB::DBError("AutoExpire::GetAllExpiring()", query);
+        return total;
+    }
+
+    while (query.next())
+    {
+        uint chanid = query.value(0).toUInt();
+        QDateTime recstartts = MythDate::as_utc(query.value(1).toDateTime());
+
+        ProgramInfo *pginfo = new ProgramInfo(chanid, recstartts);
+        if (pginfo->GetChanID())
+            list.push_back(pginfo);
+        else
+            delete pginfo;
+    }
+
+    return total;
 }
 
 /** \fn AutoExpire::ClearExpireList(pginfolist_t&, bool)
@@ -901,17 +1369,21 @@ void AutoExpire::ClearExpireList(pginfolist_t &expireList, bool deleteProg)
     }
 }
 
-/** \fn AutoExpire::FillDBOrdered(pginfolist_t&, int)
- *  \brief Creates a list of programs to delete using the database to
- *         order list.
+/**
+ *  \brief Gets the recordings an expire method takes, and their order.
+ *
+ *  \param where set to the condition on the recorded table
+ *  \param order set to the ORDER BY terms, after "autoexpire DESC"
+ *  \param msg   set to a description for the log
+ *  \return false if the method takes nothing with the current settings
  */
-void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
+static bool expire_method_query(int expMethod, QString &where,
+                                QStringList &order, QString &msg)
 {
-    QString where;
-    QString orderby;
-    QString msg;
     int maxAge;
 
+    order.clear();
+
     switch (expMethod)
     {
         default:
@@ -919,64 +1391,83 @@ void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
             msg = "Adding programs expirable in Oldest First order";
             where = "autoexpire > 0";
             if (gCoreContext->GetNumSetting("AutoExpireWatchedPriority", 0))
-                orderby = "recorded.watched DESC, ";
-            orderby += "starttime ASC";
+                order << "recorded.watched DESC";
+            order << "starttime ASC";
             break;
         case emLowestPriorityFirst:
             msg = "Adding programs expirable in Lowest Priority First order";
             where = "autoexpire > 0";
             if (gCoreContext->GetNumSetting("AutoExpireWatchedPriority", 0))
-                orderby = "recorded.watched DESC, ";
-            orderby += "recorded.recpriority ASC, starttime ASC";
+                order << "recorded.watched DESC";
+            order << "recorded.recpriority ASC" << "starttime ASC";
             break;
         case emWeightedTimePriority:
             msg = "Adding programs expirable in Weighted Time Priority order";
             where = "autoexpire > 0";
             if (gCoreContext->GetNumSetting("AutoExpireWatchedPriority", 0))
-                orderby = "recorded.watched DESC, ";
-            orderby += QString("DATE_ADD(starttime, INTERVAL '%1' * "
-                                        "recorded.recpriority DAY) ASC")
-                      .arg(gCoreContext->GetNumSetting("AutoExpireDayPriority", 3));
+                order << "recorded.watched DESC";
+            order << QString("DATE_ADD(starttime, INTERVAL '%1' * "
+                             "recorded.recpriority DAY) ASC")
+                .arg(gCoreContext->GetNumSetting("AutoExpireDayPriority", 3));
             break;
         case emShortLiveTVPrograms:
             msg = "Adding Short LiveTV programs in starttime order";
             where = "recgroup = 'LiveTV' "
                     "AND endtime < DATE_ADD(starttime, INTERVAL '2' MINUTE) "
                     "AND endtime <= DATE_ADD(NOW(), INTERVAL '-1' MINUTE) ";
-            orderby = "starttime ASC";
+            order << "starttime ASC";
             break;
         case emNormalLiveTVPrograms:
             msg = "Adding LiveTV programs in starttime order";
             where = QString("recgroup = 'LiveTV' "
                     "AND endtime <= DATE_ADD(NOW(), INTERVAL '-%1' DAY) ")
                     .arg(gCoreContext->GetNumSetting("AutoExpireLiveTVMaxAge", 1));
-            orderby = "starttime ASC";
+            order << "starttime ASC";
             break;
         case emOldDeletedPrograms:
             if ((maxAge = gCoreContext->GetNumSetting("DeletedMaxAge", 0)) <= 0)
-                return;
+                return false;
             msg = QString("Adding programs deleted more than %1 days ago")
                           .arg(maxAge);
             where = QString("recgroup = 'Deleted' "
                     "AND lastmodified <= DATE_ADD(NOW(), INTERVAL '-%1' DAY) ")
                     .arg(maxAge);
-            orderby = "starttime ASC";
+            order << "starttime ASC";
             break;
         case emQuickDeletedPrograms:
             if (gCoreContext->GetNumSetting("DeletedMaxAge", 0) != 0)
-                return;
+                return false;
             msg = QString("Adding programs deleted more than 5 minutes ago");
             where = QString("recgroup = 'Deleted' "
                     "AND lastmodified <= DATE_ADD(NOW(), INTERVAL '-5' MINUTE) ");
-            orderby = "lastmodified ASC";
+            order << "lastmodified ASC";
             break;
         case emNormalDeletedPrograms:
             msg = "Adding deleted programs in FIFO order";
             where = "recgroup = 'Deleted'";
-            orderby = "lastmodified ASC";
+            order << "lastmodified ASC";
             break;
     }
 
+    return true;
+}
+
+/** \fn AutoExpire::FillDBOrdered(pginfolist_t&, int, bool)
+ *  \brief Creates a list of programs to delete using the database to
+ *         order list.
+ *
+ *  \param skipInUse leave out programs in the Don't Expire List
+ */
+void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod,
+                               bool skipInUse)
+{
+    QString where;
+    QStringList order;
+    QString msg;
+
+    if (!expire_method_query(expMethod, where, order, msg))
+        return;
+
     LOG(VB_FILE, LOG_INFO, LOC + "FillDBOrdered: " + msg);
 
     MSqlQuery query(MSqlQuery::InitCon());
@@ -985,7 +1476,7 @@ void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
         "FROM recorded "
         "LEFT JOIN channel ON recorded.chanid = channel.chanid "
         "WHERE %1 AND deletepending = 0 "
-        "ORDER BY autoexpire DESC, %2").arg(where).arg(orderby);
+        "ORDER BY autoexpire DESC, %2").arg(where).arg(order.join(", "));
 
     query.prepare(querystr);
 
@@ -997,7 +1488,7 @@ void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
         uint chanid = query.value(0).toUInt();
         QDateTime recstartts = MythDate::as_utc(query.value(1).toDateTime());
 
-        if (IsInDontExpireSet(chanid, recstartts))
+        if (skipInUse && IsInDontExpireSet(chanid, recstartts))
         {
             LOG(VB_FILE, LOG_INFO, LOC +
                 QString("    Skipping %1 at %2 because it is in Don't Expire "
@@ -1032,6 +1523,179 @@ void AutoExpire::FillDBOrdered(pginfolist_t &expireList, int expMethod)
     }
 }
 
+/**
+ *  \brief The settings that decide the expire order, so that a change to
+ *         them can be noticed.
+ */
+QString AutoExpire::CandidateSettings(void) const
+{
+    return QString("%1 %2 %3")
+        .arg(gCoreContext->GetNumSetting("AutoExpireMethod", emOldestFirst))
+        .arg(gCoreContext->GetNumSetting("AutoExpireWatchedPriority", 0))
+        .arg(gCoreContext->GetNumSetting("AutoExpireDayPriority", 3));
+}
+
+/**
+ *  \brief Loads every recording that may be expired from the database.
+ *         Must be called with instance_lock held.
+ *
+ *  Recordings that are in use are loaded as well, they are only skipped
+ *  when it comes to expiring them.
+ */
+void AutoExpire::LoadCandidates(void)
+{
+    pginfolist_t expireList;
+
+    LOG(VB_FILE, LOG_INFO, LOC + "Loading expire candidates");
+
+    ClearCandidates();
+    written.clear();
+
+    candidate_settings = CandidateSettings();
+    expire_method = gCoreContext->GetNumSetting("AutoExpireMethod",
+                                                emOldestFirst);
+    watched_first = gCoreContext->GetNumSetting("AutoExpireWatchedPriority", 0);
+    day_priority = gCoreContext->GetNumSetting("AutoExpireDayPriority", 3);
+
+    FillExpireList(expireList, false);
+
+    pginfolist_t::iterator it = expireList.begin();
+    for (; it != expireList.end(); ++it)
+        AddCandidate(*it);
+    expireList.clear();
+
+    candidates_valid = true;
+    candidates_loaded = MythDate::current();
+
+    LOG(VB_FILE, LOG_INFO, LOC +
+        QString("Loaded %1 expire candidates").arg(candidates.size()));
+}
+
+void AutoExpire::ClearCandidates(void)
+{
+    QMap<int, ExpireQueue>::iterator fit = fs_queues.begin();
+    for (; fit != fs_queues.end(); ++fit)
+    {
+        ExpireQueue::iterator it = fit->begin();
+        for (; it != fit->end(); ++it)
+            delete *it;
+        fit->clear();
+    }
+
+    ExpireQueue::iterator it = unplaced_queue.begin();
+    for (; it != unplaced_queue.end(); ++it)
+        delete *it;
+    unplaced_queue.clear();
+
+    candidates.clear();
+    candidates_valid = false;
+}
+
+/**
+ *  \brief Whether FillExpireList() would list this program.
+ */
+bool AutoExpire::IsCandidate(const ProgramInfo *pginfo) const
+{
+    if (pginfo->IsDeletePending())
+        return false;
+
+    if (pginfo->GetRecordingGroup() == "Deleted")
+        return true;
+
+    switch (expire_method)
+    {
+        case emOldestFirst:
+        case emLowestPriorityFirst:
+        case emWeightedTimePriority:
+            return pginfo->IsAutoExpirable();
+    }
+
+    return false;
+}
+
+/**
+ *  \brief Puts a program in its place in the expire order, taking
+ *         ownership of it. Must be called with instance_lock held.
+ */
+void AutoExpire::AddCandidate(ProgramInfo *pginfo)
+{
+    ExpireCandidate cand;
+    cand.fsID = -1;
+
+    ExpireKey &key = cand.key;
+    key.chanid     = pginfo->GetChanID();
+    key.recstartts = pginfo->GetRecordingStartTime();
+
+    if (pginfo->GetRecordingGroup() == "Deleted")
+    {
+        key.group = pginfo->IsAutoExpirable() ? 0 : 1;
+        key.when  = pginfo->GetLastModifiedTime();
+    }
+    else
+    {
+        key.group = (watched_first && !pginfo->IsWatched()) ? 3 : 2;
+        key.when  = key.recstartts;
+
+        if (expire_method == emLowestPriorityFirst)
+            key.priority = pginfo->GetRecordingPriority();
+        else if (expire_method == emWeightedTimePriority)
+            key.when = key.when.addDays(
+                day_priority * pginfo->GetRecordingPriority());
+    }
+
+    candidates.insert(pginfo->MakeUniqueKey(), cand);
+    unplaced_queue.insert(key, pginfo);
+}
+
+/**
+ *  \brief Forgets a candidate. Must be called with instance_lock held.
+ */
+void AutoExpire::RemoveCandidate(const QString &key)
+{
+    QHash<QString, ExpireCandidate>::iterator it = candidates.find(key);
+    if (it == candidates.end())
+        return;
+
+    ProgramInfo *pginfo = NULL;
+    if (it->fsID >= 0)
+        pginfo = fs_queues[it->fsID].take(it->key);
+    else
+        pginfo = unplaced_queue.take(it->key);
+    delete pginfo;
+
+    candidates.erase(it);
+}
+
+/**
+ *  \brief Moves each located candidate to the queue of the file system
+ *         ID its directory has now. Must be called with instance_lock held.
+ */
+void AutoExpire::PlaceCandidates(void)
+{
+    QHash<QString, ExpireCandidate>::iterator it = candidates.begin();
+    for (; it != candidates.end(); ++it)
+    {
+        if (it->dir.isEmpty())
+            continue;
+
+        int fsID = dir_fsids.value(it->dir, -1);
+        if (fsID == it->fsID)
+            continue;
+
+        ExpireQueue &from = (it->fsID >= 0) ?
+            fs_queues[it->fsID] : unplaced_queue;
+        ProgramInfo *pginfo = from.take(it->key);
+        if (!pginfo)
+            continue;
+
+        it->fsID = fsID;
+        if (fsID >= 0)
+            fs_queues[fsID].insert(it->key, pginfo);
+        else
+            unplaced_queue.insert(it->key, pginfo);
+    }
+}
+
 /** \brief This is used by Update(QMap<int, EncoderLink*> *, bool)
  *         to run CalcParams(vector<EncoderLink*>).
  *
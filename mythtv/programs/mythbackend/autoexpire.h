@@ -12,14 +12,17 @@ using namespace std;
 #include <QObject>
 #include <QString>
 #include <QMutex>
+#include <QHash>
+#include <QList>
 #include <QSet>
 #include <QMap>
 
 #include "mthread.h"
 
+#include "filesysteminfo.h"
+
 class ProgramInfo;
 class EncoderLink;
-class FileSystemInfo;
 class MainServer;
 
 typedef vector<ProgramInfo*> pginfolist_t;
@@ -36,6 +39,66 @@ enum ExpireMethodType {
     emQuickDeletedPrograms  = 10004
 };
 
+/// \brief Position of a recording in the expire order, smaller keys expire
+///        first. Mirrors the ORDER BY clauses of AutoExpire::FillDBOrdered().
+class ExpireKey
+{
+  public:
+    ExpireKey() : group(0), priority(0), chanid(0) {}
+
+    bool operator<(const ExpireKey &other) const
+    {
+        if (group != other.group)
+            return group < other.group;
+        if (priority != other.priority)
+            return priority < other.priority;
+        if (when != other.when)
+            return when < other.when;
+        if (chanid != other.chanid)
+            return chanid < other.chanid;
+        return recstartts < other.recstartts;
+    }
+
+    int       group;      ///< deleted recordings first, then watched ones
+    int       priority;   ///< recording priority, for emLowestPriorityFirst
+    QDateTime when;       ///< start time, or when it was deleted
+    uint      chanid;
+    QDateTime recstartts;
+};
+
+typedef QMap<ExpireKey, ProgramInfo*> ExpireQueue;
+
+/// \brief A recording that may be expired
+typedef struct
+{
+    ExpireKey key;
+    int       fsID;       ///< -1 until the file has been located
+    QString   dir;        ///< "hostname:directory" once located
+} ExpireCandidate;
+
+/// \brief A recording named in a backend message
+typedef struct
+{
+    uint      chanid;
+    QDateTime recstartts;
+    int64_t   filesize;   ///< bytes, for UPDATE_FILE_SIZE
+} ExpireChange;
+
+/// \brief A recording AutoExpire has asked the backend to delete
+typedef struct
+{
+    uint      chanid;
+    QDateTime recstartts;
+    QDateTime sent;       ///< when the AUTO_EXPIRE message was sent
+} ExpiringRecording;
+
+/// \brief What we know about a recording that is being written
+typedef struct
+{
+    QString   dir;        ///< "hostname:directory", empty if not found
+    int64_t   filesize;   ///< last reported size, -1 if not yet known
+} WrittenRecording;
+
 class AutoExpire;
 
 class ExpireThread : public MThread
@@ -77,6 +140,7 @@ class AutoExpire : public QObject
 
     void GetAllExpiring(QStringList &strList);
     void GetAllExpiring(pginfolist_t &list);
+    uint GetAllExpiring(pginfolist_t &list, uint start, uint count);
     void ClearExpireList(pginfolist_t &expireList, bool deleteProg = true);
 
     static void Update(int encoder, int fsID, bool immediately);
@@ -93,18 +157,35 @@ class AutoExpire : public QObject
   protected:
     void RunExpirer(void);
     void RunUpdate(void);
+    virtual void customEvent(QEvent *event);
 
   private:
     void ExpireLiveTV(int type);
     void ExpireOldDeleted(void);
     void ExpireQuickDeleted(void);
-    void ExpireRecordings(void);
+    void ExpireRecordings(bool refresh);
+    void ExpireFromFilesystem(int fsID, pginfolist_t &deleteList);
     void ExpireEpisodesOverMax(void);
 
-    void FillExpireList(pginfolist_t &expireList);
-    void FillDBOrdered(pginfolist_t &expireList, int expMethod);
+    void FillExpireList(pginfolist_t &expireList, bool skipInUse = true);
+    void FillDBOrdered(pginfolist_t &expireList, int expMethod,
+                       bool skipInUse = true);
     void SendDeleteMessages(pginfolist_t &deleteList);
     void Sleep(int sleepTime /*ms*/);
+    void WaitForWork(int sleepTime /*ms*/);
+
+    void RefreshFilesystems(void);
+    int  LocateRecording(ProgramInfo *pginfo, QString &dir);
+
+    QString CandidateSettings(void) const;
+    void LoadCandidates(void);
+    void ClearCandidates(void);
+    bool IsCandidate(const ProgramInfo *pginfo) const;
+    void AddCandidate(ProgramInfo *pginfo);
+    void RemoveCandidate(const QString &key);
+    void PlaceCandidates(void);
+    void ProcessChanges(void);
+    void CheckExpiring(void);
 
     void UpdateDontExpireSet(void);
     bool IsInDontExpireSet(uint chanid, const QDateTime &recstartts) const;
@@ -128,6 +209,35 @@ class AutoExpire : public QObject
     // update info
     bool          update_pending; // protected by instance_lock
     UpdateThread *update_thread;
+
+    // Expire candidates, kept up to date by recording list changes rather
+    // than reloaded on every pass. All protected by instance_lock.
+    QHash<QString, ExpireCandidate> candidates; // by ProgramInfo::MakeUniqueKey
+    QMap<int, ExpireQueue> fs_queues;  // located candidates by fsID
+    ExpireQueue    unplaced_queue;     // candidates not yet located
+    bool           candidates_valid;
+    QDateTime      candidates_loaded;
+    QString        candidate_settings; // settings the keys were made with
+    QHash<QString, ExpiringRecording> expiring; // sent to be deleted, by key
+    int            expire_method;
+    bool           watched_first;
+    int            day_priority;
+
+    // Free space, measured every pass and adjusted in between as
+    // recordings grow and get expired. All protected by instance_lock.
+    QList<FileSystemInfo>   fs_infos;
+    QDateTime               fs_infos_time;
+    QHash<QString, int>     dir_fsids;  // "hostname:directory" -> fsID
+    QMap<int, int64_t>      fs_free;    // KB
+    QHash<QString, WrittenRecording> written;
+    bool                    expire_now;
+
+    // Messages not yet looked at by the expire thread
+    QMutex                       change_lock;
+    QWaitCondition               change_cond;   // protected by change_lock
+    QHash<QString, ExpireChange> changed;       // protected by change_lock
+    QHash<QString, ExpireChange> resized;       // protected by change_lock
+    bool                         change_wakeup; // protected by change_lock
 };
 
 #endif
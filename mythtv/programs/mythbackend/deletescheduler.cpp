@@ -0,0 +1,330 @@
+// POSIX headers
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Qt headers
+#include <QFileInfo>
+
+// MythTV headers
+#include "deletescheduler.h"
+#include "ThreadedFileWriter.h"
+#include "programinfo.h"
+#include "mythlogging.h"
+#include "mythtimer.h"
+#include "mythdbcon.h"
+
+#define LOC QString("DeleteScheduler: ")
+
+const int       DeleteScheduler::kStepTime      = 250;
+const int       DeleteScheduler::kTargetLatency = 300;
+const long long DeleteScheduler::kMinRate       = 2LL * 1024 * 1024;
+const long long DeleteScheduler::kMaxRate       = 512LL * 1024 * 1024;
+const long long DeleteScheduler::kRateStep      = 1LL * 1024 * 1024;
+
+/// Steps to hold the rate after backing off, so the latency samples
+/// taken before the change have a chance to age out
+static const int kBackoffSteps = 8;
+
+DeleteScheduler::DeleteScheduler() :
+    MThread("DeleteScheduler"), m_running(true)
+{
+}
+
+DeleteScheduler::~DeleteScheduler()
+{
+    Stop();
+}
+
+/** \brief Stops truncating, and closes the files still queued so the
+ *         filesystem frees them all at once.
+ */
+void DeleteScheduler::Stop(void)
+{
+    {
+        QMutexLocker locker(&m_lock);
+        m_running = false;
+        m_wait.wakeAll();
+    }
+    wait();
+}
+
+/** \brief Queues an unlinked file to be truncated away and closed.
+ *
+ *  \param pginfo   recording to mark as being deleted, or NULL. The
+ *                  scheduler takes ownership of it.
+ *  \param fd       open descriptor of the unlinked file
+ *  \param filename name the file had, for the logs and status page
+ *  \param size     size of the file in bytes
+ */
+void DeleteScheduler::Add(ProgramInfo *pginfo, int fd,
+                          const QString &filename, off_t size)
+{
+    DeleteJob job;
+    job.filename = filename;
+    job.fd       = fd;
+    job.size     = size;
+    job.pginfo   = pginfo;
+
+    if (pginfo)
+    {
+        pginfo->SetPathname(filename);
+        pginfo->MarkAsInUse(true, kTruncatingDeleteInUseID);
+    }
+
+    dev_t dev = 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0)
+        dev = st.st_dev;
+
+    long long rate = InitialRate();
+
+    QMutexLocker locker(&m_lock);
+
+    if (!m_running)
+    {
+        locker.unlock();
+        Finish(job, true);
+        return;
+    }
+
+    QMap<dev_t,FilesystemQueue>::iterator it = m_queues.find(dev);
+    if (it == m_queues.end())
+    {
+        it = m_queues.insert(dev, FilesystemQueue());
+        (*it).rate = rate;
+    }
+    (*it).jobs.push_back(job);
+
+    LOG(VB_FILE, LOG_INFO, LOC +
+        QString("Truncating '%1' (%2 MB), %3 file(s) queued on its "
+                "filesystem, starting at %4 MB/s")
+            .arg(filename).arg(size / (1024.0 * 1024.0), 0, 'f', 2)
+            .arg((*it).jobs.size())
+            .arg((*it).rate / (1024.0 * 1024.0), 0, 'f', 2));
+
+    m_wait.wakeAll();
+}
+
+/// \brief Snapshot of the work left on each filesystem.
+QList<DeleteProgress> DeleteScheduler::GetProgress(void) const
+{
+    QList<DeleteProgress> list;
+    QMutexLocker locker(&m_lock);
+
+    QMap<dev_t,FilesystemQueue>::const_iterator it = m_queues.begin();
+    for (; it != m_queues.end(); ++it)
+    {
+        if ((*it).jobs.empty())
+            continue;
+
+        DeleteProgress progress;
+        progress.dir       = QFileInfo((*it).jobs.front().filename).path();
+        progress.files     = (*it).jobs.size();
+        progress.remaining = 0;
+        progress.rate      = (*it).rate;
+        progress.latency   = (*it).latency;
+        progress.writers   = (*it).writers;
+
+        QList<DeleteJob>::const_iterator jit = (*it).jobs.begin();
+        for (; jit != (*it).jobs.end(); ++jit)
+            progress.remaining += (*jit).size;
+
+        progress.eta = (progress.rate > 0) ?
+            (int)(progress.remaining / progress.rate) : -1;
+
+        list.push_back(progress);
+    }
+
+    return list;
+}
+
+void DeleteScheduler::run(void)
+{
+    RunProlog();
+
+    MythTimer stepTimer;
+    stepTimer.start();
+
+    QMutexLocker locker(&m_lock);
+    while (m_running)
+    {
+        if (m_queues.empty())
+        {
+            m_wait.wait(locker.mutex());
+            stepTimer.start();
+            continue;
+        }
+
+        // Only this thread removes queues, so the keys stay valid while
+        // the lock is released for the slow part
+        QList<dev_t> devs = m_queues.keys();
+        int elapsed = qMin(stepTimer.restart(), 2 * kStepTime);
+        locker.unlock();
+
+        QList<dev_t>::const_iterator it = devs.begin();
+        for (; it != devs.end(); ++it)
+            Step(*it, elapsed);
+
+        locker.relock();
+        int left = kStepTime - stepTimer.elapsed();
+        if (m_running && left > 0)
+            m_wait.wait(locker.mutex(), left);
+    }
+
+    QMap<dev_t,FilesystemQueue> queues = m_queues;
+    m_queues.clear();
+    locker.unlock();
+
+    QMap<dev_t,FilesystemQueue>::iterator qit = queues.begin();
+    for (; qit != queues.end(); ++qit)
+    {
+        while (!(*qit).jobs.empty())
+        {
+            Finish((*qit).jobs.front(), true);
+            (*qit).jobs.pop_front();
+        }
+    }
+
+    RunEpilog();
+}
+
+/** \brief Frees up to 'elapsed' milliseconds worth of space on one
+ *         filesystem, moving on to the next queued file when one is done.
+ */
+void DeleteScheduler::Step(dev_t dev, int elapsed)
+{
+    QMutexLocker locker(&m_lock);
+
+    QMap<dev_t,FilesystemQueue>::iterator it = m_queues.find(dev);
+    if (it == m_queues.end())
+        return;
+
+    long long budget = (*it).rate * elapsed / 1000;
+    int truncate_ms = 0;
+
+    while (budget > 0 && !(*it).jobs.empty())
+    {
+        DeleteJob job = (*it).jobs.front();
+        off_t newsize = (job.size > budget) ? job.size - budget : 0;
+        bool ok = true;
+
+        locker.unlock();
+
+        MythTimer timer;
+        timer.start();
+        if (newsize > 0)
+        {
+            ok = (0 == ftruncate(job.fd, newsize));
+            if (!ok)
+            {
+                LOG(VB_GENERAL, LOG_ERR, LOC +
+                    QString("Error truncating '%1'").arg(job.filename) + ENO);
+            }
+            else if (job.pginfo)
+            {
+                job.pginfo->UpdateInUseMark();
+            }
+        }
+        if (newsize == 0 || !ok)
+            Finish(job, ok);
+        truncate_ms += timer.elapsed();
+
+        locker.relock();
+        it = m_queues.find(dev);
+
+        if (newsize > 0 && ok)
+        {
+            (*it).jobs.front().size = newsize;
+            break;
+        }
+
+        budget -= job.size;
+        (*it).jobs.pop_front();
+    }
+
+    Adapt(*it, dev, truncate_ms);
+
+    if ((*it).jobs.empty())
+        m_queues.erase(it);
+}
+
+/** \brief Adjusts the rate of a filesystem after a step.
+ *
+ *  The rate is halved when the recorders on the filesystem see writes or
+ *  syncs slower than kTargetLatency, or when truncating took longer than
+ *  a step. Otherwise it grows by kRateStep, or by a quarter when nothing
+ *  is recording there.
+ */
+void DeleteScheduler::Adapt(FilesystemQueue &fsq, dev_t dev, int truncate_ms)
+{
+    fsq.latency = ThreadedFileWriter::GetWriteLatency(dev, &fsq.writers);
+
+    if (fsq.backoff > 0)
+    {
+        fsq.backoff--;
+        return;
+    }
+
+    long long old_rate = fsq.rate;
+
+    if (fsq.latency > kTargetLatency || truncate_ms > kStepTime)
+    {
+        fsq.rate /= 2;
+        fsq.backoff = kBackoffSteps;
+    }
+    else if (!fsq.writers)
+        fsq.rate += fsq.rate / 4;
+    else if (fsq.latency < kTargetLatency / 2)
+        fsq.rate += kRateStep;
+
+    fsq.rate = qMax(kMinRate, qMin(kMaxRate, fsq.rate));
+
+    if (fsq.rate < old_rate)
+    {
+        LOG(VB_FILE, LOG_INFO, LOC +
+            QString("Slowing to %1 MB/s, %2 recorder(s) saw %3 ms writes, "
+                    "truncate took %4 ms")
+                .arg(fsq.rate / (1024.0 * 1024.0), 0, 'f', 2)
+                .arg(fsq.writers).arg(fsq.latency).arg(truncate_ms));
+    }
+}
+
+/// \brief Closes a finished file, which frees what is left of it.
+void DeleteScheduler::Finish(DeleteJob &job, bool ok)
+{
+    if (close(job.fd) != 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Error closing '%1'").arg(job.filename) + ENO);
+        ok = false;
+    }
+
+    if (job.pginfo)
+    {
+        job.pginfo->MarkAsInUse(false, kTruncatingDeleteInUseID);
+        delete job.pginfo;
+        job.pginfo = NULL;
+    }
+
+    if (ok)
+    {
+        LOG(VB_FILE, LOG_INFO, LOC +
+            QString("Finished truncating '%1'").arg(job.filename));
+    }
+}
+
+/** \brief Rate to start a filesystem at, enough to keep up with every
+ *         capture card recording high definition at once.
+ */
+long long DeleteScheduler::InitialRate(void)
+{
+    int cards = 5;
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare("SELECT COUNT(cardid) FROM capturecard;");
+    if (query.exec() && query.next())
+        cards = query.value(0).toInt();
+
+    long long calc_rate = (long long)(cards * 1.2 * (22200000LL / 8));
+    return qMax(8LL * 1024 * 1024, qMin(kMaxRate, calc_rate));
+}
@@ -0,0 +1,100 @@
+#ifndef DELETESCHEDULER_H_
+#define DELETESCHEDULER_H_
+
+#include <sys/types.h>
+
+#include <QWaitCondition>
+#include <QString>
+#include <QMutex>
+#include <QList>
+#include <QMap>
+
+#include "mthread.h"
+
+class ProgramInfo;
+
+/// An unlinked file that is being truncated away
+class DeleteJob
+{
+  public:
+    QString      filename;
+    int          fd;
+    off_t        size;      ///< bytes still allocated to the file
+    ProgramInfo *pginfo;    ///< recording marked as in use, or NULL
+};
+
+/// Progress of the slow deletes on one filesystem, for the status page
+class DeleteProgress
+{
+  public:
+    QString   dir;          ///< directory of the file being truncated
+    uint      files;        ///< files waiting, including the current one
+    long long remaining;    ///< bytes left to free
+    long long rate;         ///< bytes freed per second
+    int       eta;          ///< seconds until done
+    int       latency;      ///< worst recent recorder write time in ms
+    int       writers;      ///< recorders writing to this filesystem
+};
+
+/** \class DeleteScheduler
+ *  \brief Frees the space of deleted recordings in the background.
+ *
+ *   Large files are truncated a step at a time so that freeing them does
+ *   not stall the disk for the recorders. Files on the same filesystem are
+ *   queued and truncated one after another at a rate shared between them,
+ *   while each filesystem is worked on independently.
+ *
+ *   The rate adapts to the recorders: it backs off quickly when the
+ *   ThreadedFileWriters on that filesystem see slow writes or syncs, and
+ *   speeds up slowly while they don't, or quickly when nothing is
+ *   recording there.
+ */
+class DeleteScheduler : public MThread
+{
+  public:
+    DeleteScheduler();
+   ~DeleteScheduler();
+
+    void Add(ProgramInfo *pginfo, int fd, const QString &filename,
+             off_t size);
+    void Stop(void);
+
+    QList<DeleteProgress> GetProgress(void) const;
+
+  protected:
+    virtual void run(void);
+
+  private:
+    class FilesystemQueue
+    {
+      public:
+        FilesystemQueue() : rate(0), latency(0), writers(0), backoff(0) {}
+
+        QList<DeleteJob> jobs;
+        long long        rate;      ///< bytes per second
+        int              latency;
+        int              writers;
+        int              backoff;   ///< steps left before adapting again
+    };
+
+    void Step(dev_t dev, int elapsed);
+    void Adapt(FilesystemQueue &fsq, dev_t dev, int truncate_ms);
+    void Finish(DeleteJob &job, bool ok);
+    static long long InitialRate(void);
+
+    mutable QMutex              m_lock;
+    QWaitCondition              m_wait;
+    bool                        m_running;
+    QMap<dev_t,FilesystemQueue> m_queues;
+
+    /// Time between truncation steps, in milliseconds
+    static const int       kStepTime;
+    /// Write latency the recorders should not see, in milliseconds
+    static const int       kTargetLatency;
+    static const long long kMinRate;
+    static const long long kMaxRate;
+    /// How much the rate grows each step while the recorders are happy
+    static const long long kRateStep;
+};
+
+#endif
@@ -1,3 +1,8 @@
+// POSIX headers
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QFileInfo>
@@ -14,20 +19,30 @@ FileTransfer::FileTransfer(QString &filename, MythSocket *remote,
     ReferenceCounter(QString("FileTransfer:%1").arg(filename)),
     readthreadlive(true), readsLocked(false),
     rbuffer(RingBuffer::Create(filename, false, usereadahead, timeout_ms, true)),
-    sock(remote), ateof(false), lock(QMutex::NonRecursive),
-    writemode(false)
+    sock(remote), ateof(false), sendfd(-1), sendpos(0),
+    lock(QMutex::NonRecursive), writemode(false)
 {
     pginfo = new ProgramInfo(filename);
     pginfo->MarkAsInUse(true, kFileTransferInUseID);
-    rbuffer->Start();
+
+    // Completed recordings and videos are sent straight from the file,
+    // so the read ahead thread isn't needed unless we fall back to it.
+    if (CanSendFile())
+        sendfd = open(rbuffer->GetFilename().toLocal8Bit().constData(),
+                      O_RDONLY);
+
+    if (sendfd >= 0)
+        LOG(VB_FILE, LOG_INFO, "Using sendfile() for " + filename);
+    else
+        rbuffer->Start();
 }
 
 FileTransfer::FileTransfer(QString &filename, MythSocket *remote, bool write) :
     ReferenceCounter(QString("FileTransfer:%1").arg(filename)),
     readthreadlive(true), readsLocked(false),
     rbuffer(RingBuffer::Create(filename, write)),
-    sock(remote), ateof(false), lock(QMutex::NonRecursive),
-    writemode(write)
+    sock(remote), ateof(false), sendfd(-1), sendpos(0),
+    lock(QMutex::NonRecursive), writemode(write)
 {
     pginfo = new ProgramInfo(filename);
     pginfo->MarkAsInUse(true, kFileTransferInUseID);
@@ -44,6 +59,9 @@ FileTransfer::~FileTransfer()
     if (sock) // FileTransfer becomes responsible for deleting the socket
         sock->DecrRef();
 
+    if (sendfd >= 0)
+        close(sendfd);
+
     if (rbuffer)
     {
         delete rbuffer;
@@ -118,6 +136,50 @@ void FileTransfer::Unpause(void)
         pginfo->UpdateInUseMark();
 }
 
+/// True when nothing can still be appending to the file, so it can be
+/// sent with sendfile() instead of through the RingBuffer
+bool FileTransfer::CanSendFile(void) const
+{
+    // DVDs, Blu-rays and streams need the RingBuffer to make sense of them
+    if (!rbuffer || rbuffer->GetType() != kRingBuffer_File ||
+        !rbuffer->IsOpen())
+        return false;
+
+    // Anything that isn't a recording (e.g. a video) is complete
+    if (!pginfo || !pginfo->GetChanID())
+        return true;
+
+    // In progress recordings, including LiveTV, are still growing
+    if (pginfo->GetRecordingEndTime() > MythDate::current())
+        return false;
+
+    QStringList byWho;
+    if (pginfo->QueryIsInUse(byWho))
+    {
+        for (int i = 0; i + 2 < byWho.size(); i += 3)
+        {
+            if (byWho[i] == kRecorderInUseID ||
+                byWho[i] == kImportRecorderInUseID)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/// Goes back to reading through the RingBuffer, from where sendfile() left off
+void FileTransfer::StopSendFile(void)
+{
+    LOG(VB_FILE, LOG_INFO,
+        QString("sendfile() not usable, reading %1 through the RingBuffer")
+        .arg(rbuffer->GetFilename()));
+
+    close(sendfd);
+    sendfd = -1;
+    rbuffer->Start();
+    rbuffer->Seek(sendpos, SEEK_SET);
+}
+
 int FileTransfer::RequestBlock(int size)
 {
     if (!readthreadlive || !rbuffer)
@@ -130,6 +192,24 @@ int FileTransfer::RequestBlock(int size)
     while (readsLocked)
         readsUnlockedCond.wait(&lock, 100 /*ms*/);
 
+    if (sendfd >= 0)
+    {
+        ret = sock->SendFile(sendfd, sendpos, max(size, 0));
+        if (ret != MythSocket::kSendFileUnsupported)
+        {
+            if (ret > 0)
+                sendpos += ret;
+
+            if (pginfo)
+                pginfo->UpdateInUseMark();
+
+            return (ret < 0) ? -1 : ret;
+        }
+
+        StopSendFile();
+        ret = 0;
+    }
+
     requestBuffer.resize(max((size_t)max(size,0) + 128, requestBuffer.size()));
     char *buf = &requestBuffer[0];
     while (tot < size && !rbuffer->GetStopReads() && readthreadlive)
@@ -203,6 +283,30 @@ long long FileTransfer::Seek(long long curpos, long long pos, int whence)
 
     ateof = false;
 
+    {
+        QMutexLocker locker(&lock);
+        if (sendfd >= 0)
+        {
+            long long newpos = -1;
+            if (whence == SEEK_SET)
+                newpos = pos;
+            else if (whence == SEEK_CUR)
+                newpos = curpos + pos;
+            else if (whence == SEEK_END)
+            {
+                struct stat st;
+                if (fstat(sendfd, &st) == 0)
+                    newpos = st.st_size + pos;
+            }
+
+            if (newpos < 0)
+                return -1;
+
+            sendpos = newpos;
+            return sendpos;
+        }
+    }
+
     Pause();
 
     if (whence == SEEK_CUR)
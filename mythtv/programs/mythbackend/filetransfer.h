@@ -50,6 +50,9 @@ class FileTransfer : public ReferenceCounter
   private:
    ~FileTransfer();
 
+    bool CanSendFile(void) const;
+    void StopSendFile(void);
+
     volatile bool  readthreadlive;
     bool           readsLocked;
     QWaitCondition readsUnlockedCond;
@@ -61,6 +64,11 @@ class FileTransfer : public ReferenceCounter
 
     vector<char> requestBuffer;
 
+    /// Descriptor used for sendfile() on completed local files, or -1
+    /// when reads go through rbuffer
+    int       sendfd;
+    long long sendpos;
+
     QMutex lock;
 
     bool writemode;
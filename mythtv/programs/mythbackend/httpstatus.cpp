@@ -40,6 +40,10 @@
 #include "jobqueue.h"
 #include "upnp.h"
 #include "mythdate.h"
+#include "mythmetrics.h"
+
+/// How long, in ms, a status snapshot is served before it is rebuilt
+const int HttpStatus::kSnapshotLifetime = 5000;
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -77,6 +81,7 @@ HttpStatusMethod HttpStatus::GetMethod( const QString &sURI )
     if (sURI == "GetStatusHTML"        ) return( HSM_GetStatusHTML   );
     if (sURI == "GetStatus"            ) return( HSM_GetStatusXML    );
     if (sURI == "xml"                  ) return( HSM_GetStatusXML    );
+    if (sURI == "Metrics"              ) return( HSM_GetMetrics      );
 
     return( HSM_Unknown );
 }
@@ -110,6 +115,7 @@ bool HttpStatus::ProcessRequest( HTTPRequest *pRequest )
             {
                 case HSM_GetStatusXML   : GetStatusXML   ( pRequest ); return true;
                 case HSM_GetStatusHTML  : GetStatusHTML  ( pRequest ); return true;
+                case HSM_GetMetrics     : GetMetrics     ( pRequest ); return true;
 
                 default:
                 {
@@ -136,22 +142,12 @@ bool HttpStatus::ProcessRequest( HTTPRequest *pRequest )
 
 void HttpStatus::GetStatusXML( HTTPRequest *pRequest )
 {
-    QDomDocument doc( "Status" );
-
-    // UTF-8 is the default, but good practice to specify it anyway
-    QDomProcessingInstruction encoding =
-        doc.createProcessingInstruction("xml",
-                                        "version=\"1.0\" encoding=\"UTF-8\"");
-    doc.appendChild(encoding);
-
-    FillStatusXML( &doc );
-
     pRequest->m_eResponseType   = ResponseTypeXML;
     pRequest->m_mapRespHeaders[ "Cache-Control" ] = "no-cache=\"Ext\", max-age = 5000";
 
-    QTextStream stream( &pRequest->m_response );
-    stream.setCodec("UTF-8");	// Otherwise locale default is used.
-    stream << doc.toString();
+    QMutexLocker locker(&m_snapshotLock);
+    UpdateSnapshot();
+    pRequest->m_response.write( m_snapshotXML );
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -163,12 +159,58 @@ void HttpStatus::GetStatusHTML( HTTPRequest *pRequest )
     pRequest->m_eResponseType = ResponseTypeHTML;
     pRequest->m_mapRespHeaders[ "Cache-Control" ] = "no-cache=\"Ext\", max-age = 5000";
 
+    QMutexLocker locker(&m_snapshotLock);
+    UpdateSnapshot();
+    pRequest->m_response.write( m_snapshotHTML );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::GetMetrics( HTTPRequest *pRequest )
+{
+    pRequest->m_eResponseType     = ResponseTypeOther;
+    pRequest->m_sResponseTypeText = "text/plain; version=0.0.4";
+    pRequest->m_mapRespHeaders[ "Cache-Control" ] = "no-cache";
+
+    MSqlQuery::UpdateQueryMetrics();
+
+    pRequest->m_response.write( MythMetrics::ToText().toUtf8() );
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Filling the status queries every encoder, the scheduler and the database,
+// so both the XML and HTML are built from one pass and reused for
+// kSnapshotLifetime.  The caller must hold m_snapshotLock.
+/////////////////////////////////////////////////////////////////////////////
+
+void HttpStatus::UpdateSnapshot( void )
+{
+    if (m_snapshotTimer.isRunning() &&
+        m_snapshotTimer.elapsed() < kSnapshotLifetime)
+    {
+        return;
+    }
+
     QDomDocument doc( "Status" );
 
+    // UTF-8 is the default, but good practice to specify it anyway
+    QDomProcessingInstruction encoding =
+        doc.createProcessingInstruction("xml",
+                                        "version=\"1.0\" encoding=\"UTF-8\"");
+    doc.appendChild(encoding);
+
     FillStatusXML( &doc );
 
-    QTextStream stream( &pRequest->m_response );
+    m_snapshotXML  = doc.toString().toUtf8();
+
+    m_snapshotHTML.clear();
+    QTextStream stream( &m_snapshotHTML );
     PrintStatus( stream, &doc );
+    stream.flush();
+
+    m_snapshotTimer.start();
 }
 
 static QString setting_to_localtime(const char *setting)
@@ -518,6 +560,32 @@ void HttpStatus::FillStatusXML( QDomDocument *pDoc )
             storage.appendChild(fsXML[fs_index]);
     }
 
+    // slow deletes   ---------------------
+
+    if (m_pMainServer)
+    {
+        QList<DeleteProgress> deletes = m_pMainServer->GetDeleteProgress();
+        if (!deletes.empty())
+        {
+            QDomElement deletions = pDoc->createElement("Deletions");
+            mInfo.appendChild(deletions);
+
+            QList<DeleteProgress>::const_iterator dit = deletes.begin();
+            for (; dit != deletes.end(); ++dit)
+            {
+                QDomElement fs = pDoc->createElement("Filesystem");
+                fs.setAttribute("dir"      , (*dit).dir );
+                fs.setAttribute("files"    , (*dit).files );
+                fs.setAttribute("remaining", (int)((*dit).remaining>>20) );
+                fs.setAttribute("rate"     , (int)((*dit).rate>>20) );
+                fs.setAttribute("eta"      , (*dit).eta );
+                fs.setAttribute("latency"  , (*dit).latency );
+                fs.setAttribute("writers"  , (*dit).writers );
+                deletions.appendChild(fs);
+            }
+        }
+    }
+
     // load average ---------------------
 
     double rgdAverages[3];
@@ -1376,6 +1444,61 @@ int HttpStatus::PrintMachineInfo( QTextStream &os, QDomElement info )
 
     os << "      </ul>\r\n";
 
+    // Slow deletes ---------------------
+
+    node = info.namedItem( "Deletions" );
+
+    if (!node.isNull())
+    {
+        os << "      Deletes in Progress:<br />\r\n";
+        os << "      <ul>\r\n";
+
+        QLocale c(QLocale::C);
+        node = node.firstChild();
+        while (!node.isNull())
+        {
+            QDomElement e = node.toElement();
+            node = node.nextSibling();
+
+            if (e.isNull() || e.tagName() != "Filesystem")
+                continue;
+
+            int nFiles     = e.attribute("files"    , "0" ).toInt();
+            int nRemaining = e.attribute("remaining", "0" ).toInt();
+            int nRate      = e.attribute("rate"     , "0" ).toInt();
+            int nEta       = e.attribute("eta"      , "-1").toInt();
+            int nLatency   = e.attribute("latency"  , "0" ).toInt();
+            int nWriters   = e.attribute("writers"  , "0" ).toInt();
+
+            os << "        <li>" << e.attribute("dir", "") << ":\r\n"
+               << "          <ul>\r\n"
+               << "            <li>Files: " << nFiles << "</li>\r\n"
+               << "            <li>Space Left to Free: "
+               << c.toString(nRemaining) << " MB</li>\r\n"
+               << "            <li>Rate: " << c.toString(nRate)
+               << " MB/s";
+            if (nWriters > 0)
+            {
+                os << " (" << nWriters << " recording(s), "
+                   << nLatency << " ms writes)";
+            }
+            os << "</li>\r\n";
+
+            if (nEta >= 0)
+            {
+                os << "            <li>Time Left: "
+                   << QString("%1:%2").arg(nEta / 60)
+                          .arg(nEta % 60, 2, 10, QChar('0'))
+                   << "</li>\r\n";
+            }
+
+            os << "          </ul>\r\n"
+               << "        </li>\r\n";
+        }
+
+        os << "      </ul>\r\n";
+    }
+
     // Guide Info ---------------------
 
     node = info.namedItem( "Guide" );
@@ -16,13 +16,15 @@
 #include <QMap>
 
 #include "httpserver.h"
+#include "mythtimer.h"
 #include "programinfo.h"
 
 typedef enum 
 {
     HSM_Unknown         =  0,
     HSM_GetStatusHTML   =  1,
-    HSM_GetStatusXML    =  2
+    HSM_GetStatusXML    =  2,
+    HSM_GetMetrics      =  3
 
 } HttpStatusMethod;
 
@@ -51,12 +53,23 @@ class HttpStatus : public HttpServerExtension
         int                          m_nPreRollSeconds;
         QMutex                       m_settingLock;
 
+        // Status built by the last request, shared until it is too old
+        QMutex                       m_snapshotLock;
+        MythTimer                    m_snapshotTimer;
+        QByteArray                   m_snapshotXML;
+        QByteArray                   m_snapshotHTML;
+
+        static const int             kSnapshotLifetime;
+
     private:
 
         HttpStatusMethod GetMethod( const QString &sURI );
 
         void    GetStatusXML      ( HTTPRequest *pRequest );
         void    GetStatusHTML     ( HTTPRequest *pRequest );
+        void    GetMetrics        ( HTTPRequest *pRequest );
+
+        void    UpdateSnapshot    ( void );
 
         void    FillStatusXML     ( QDomDocument *pDoc);
     
@@ -121,7 +121,6 @@ int delete_file_immediately(const QString &filename,
 
 };
 
-QMutex MainServer::truncate_and_close_lock;
 const uint MainServer::kMasterServerReconnectTimeout = 1000; //ms
 
 class ProcessRequestRunnable : public QRunnable
@@ -233,7 +232,8 @@ MainServer::MainServer(bool master, int port,
     masterServer(NULL), ismaster(master), threadPool("ProcessRequestPool"),
     masterBackendOverride(false),
     m_sched(sched), m_expirer(expirer), deferredDeleteTimer(NULL),
-    autoexpireUpdateTimer(NULL), m_exitCode(GENERIC_EXIT_OK),
+    autoexpireUpdateTimer(NULL), deleteScheduler(NULL),
+    m_exitCode(GENERIC_EXIT_OK),
     m_stopped(false)
 {
     PreviewGeneratorQueue::CreatePreviewGeneratorQueue(
@@ -242,6 +242,9 @@ MainServer::MainServer(bool master, int port,
 
     threadPool.setMaxThreadCount(PRT_STARTUP_THREAD_COUNT);
 
+    deleteScheduler = new DeleteScheduler();
+    deleteScheduler->start();
+
     masterBackendOverride =
         gCoreContext->GetNumSetting("MasterBackendOverride", 0);
 
@@ -308,6 +311,8 @@ MainServer::MainServer(bool master, int port,
         expirer->SetMainServer(this);
 
     metadatafactory = new MetadataFactory(this);
+    if (gCoreContext->GetNumSetting("VideoScanWatchDirs", 0))
+        metadatafactory->WatchVideoDirs();
 
     autoexpireUpdateTimer = new QTimer(this);
     connect(autoexpireUpdateTimer, SIGNAL(timeout()),
@@ -337,6 +342,8 @@ MainServer::~MainServer()
 {
     if (!m_stopped)
         Stop();
+
+    delete deleteScheduler;
 }
 
 void MainServer::Stop()
@@ -353,6 +360,9 @@ void MainServer::Stop()
 
     threadPool.Stop();
 
+    // Queued deletes are closed, anything deleted after this is too
+    deleteScheduler->Stop();
+
     // since Scheduler::SetMainServer() isn't thread-safe
     // we need to shut down the scheduler thread before we
     // can call SetMainServer(NULL)
@@ -423,13 +433,18 @@ void MainServer::NewConnection(int socketDescriptor)
     controlSocketList.insert(new MythSocket(socketDescriptor, this));
 }
 
-void MainServer::readyRead(MythSocket *sock)
+bool MainServer::IsExpectingReply(MythSocket *sock)
 {
     sockListLock.lockForRead();
     PlaybackSock *testsock = GetPlaybackBySock(sock);
     bool expecting_reply = testsock && testsock->isExpectingReply();
     sockListLock.unlock();
-    if (expecting_reply)
+    return expecting_reply;
+}
+
+void MainServer::readyRead(MythSocket *sock)
+{
+    if (IsExpectingReply(sock))
     {
         LOG(VB_GENERAL, LOG_INFO, "readyRead ignoring, expecting reply");
         return;
@@ -442,24 +457,104 @@ void MainServer::readyRead(MythSocket *sock)
     QCoreApplication::processEvents();
 }
 
-void MainServer::ProcessRequest(MythSocket *sock)
+/// Whether 'listline' is a REQUEST_BLOCK that a SEEK of the same file
+/// transfer, sent after it, has made pointless.
+static bool is_stale_block_request(const QStringList &listline,
+                                   const QList<QStringList> &backlog)
 {
-    if (sock->IsDataAvailable())
-        ProcessRequestWork(sock);
-    else
-        LOG(VB_GENERAL, LOG_INFO, QString("No data on sock %1")
-            .arg(sock->GetSocketDescriptor()));
+    if (listline.size() < 2 || listline[1] != "REQUEST_BLOCK" ||
+        !listline[0].startsWith("QUERY_FILETRANSFER"))
+        return false;
+
+    QList<QStringList>::const_iterator it = backlog.begin();
+    for (; it != backlog.end(); ++it)
+    {
+        if (it->size() >= 2 && (*it)[1] == "SEEK" &&
+            (*it)[0].simplified() == listline[0].simplified())
+            return true;
+    }
+    return false;
 }
 
-void MainServer::ProcessRequestWork(MythSocket *sock)
+/**
+ * \brief Handles the requests waiting on a socket, one at a time.
+ *
+ * RemoteFile keeps several REQUEST_BLOCKs in flight, and requests that
+ * arrive together only produce one readyRead(). So whichever runnable
+ * gets to a socket first keeps handling requests until none are left,
+ * and any runnable started for the same socket meanwhile just tells it
+ * to look again.
+ *
+ * When RemoteFile seeks it sends the SEEK without waiting for the blocks
+ * it has in flight. So before a block is sent, the requests queued behind
+ * it are read, and if there is a SEEK among them the block is answered as
+ * 0 bytes instead of sending data that would only be thrown away.
+ */
+void MainServer::ProcessRequest(MythSocket *sock)
 {
-    QStringList listline;
-    if (!sock->ReadStringList(listline) || listline.empty())
     {
-        LOG(VB_GENERAL, LOG_INFO, "No data in ProcessRequestWork()");
-        return;
+        QMutexLocker locker(&requestSocketLock);
+        if (requestSocketBusy.contains(sock))
+        {
+            requestSocketPending.insert(sock);
+            return;
+        }
+        requestSocketBusy.insert(sock);
+    }
+
+    QList<QStringList> backlog;
+    bool handled = false;
+    while (true)
+    {
+        while (!backlog.isEmpty() ||
+               (sock->IsDataAvailable() && !IsExpectingReply(sock)))
+        {
+            QStringList listline;
+            if (!backlog.isEmpty())
+                listline = backlog.takeFirst();
+            else if (!sock->ReadStringList(listline) || listline.empty())
+            {
+                LOG(VB_GENERAL, LOG_INFO, "No data in ProcessRequest()");
+                break;
+            }
+            handled = true;
+
+            if (listline.size() >= 2 && listline[1] == "REQUEST_BLOCK")
+            {
+                while (sock->IsDataAvailable())
+                {
+                    QStringList next;
+                    if (!sock->ReadStringList(next) || next.empty())
+                        break;
+                    backlog.push_back(next);
+                }
+
+                if (is_stale_block_request(listline, backlog))
+                {
+                    QStringList retlist("0");
+                    SendResponse(sock, retlist);
+                    continue;
+                }
+            }
+
+            ProcessRequestWork(sock, listline);
+        }
+
+        QMutexLocker locker(&requestSocketLock);
+        if (!requestSocketPending.remove(sock))
+        {
+            requestSocketBusy.remove(sock);
+            break;
+        }
     }
 
+    if (!handled)
+        LOG(VB_GENERAL, LOG_INFO, QString("No data on sock %1")
+            .arg(sock->GetSocketDescriptor()));
+}
+
+void MainServer::ProcessRequestWork(MythSocket *sock, QStringList &listline)
+{
     QString line = listline[0];
 
     line = line.simplified();
@@ -2083,7 +2178,10 @@ void MainServer::DoDeleteThread(DeleteStruct *ds)
     deletelock.unlock();
 
     if (slowDeletes && fd >= 0)
-        TruncateAndClose(&pginfo, fd, ds->m_filename, size);
+    {
+        deleteScheduler->Add(new ProgramInfo(pginfo), fd,
+                             ds->m_filename, size);
+    }
 }
 
 void MainServer::DeleteRecordedFiles(DeleteStruct *ds)
@@ -2222,8 +2320,8 @@ void MainServer::DoDeleteInDB(DeleteStruct *ds)
 /**
  *  \brief Deletes links and unlinks the main file and returns the descriptor.
  *
- *  This is meant to be used with TruncateAndClose() to slowly shrink a
- *  large file and then eventually delete the file by closing the file
+ *  This is meant to be used with DeleteScheduler::Add() to slowly shrink
+ *  a large file and then eventually delete the file by closing the file
  *  descriptor.
  *
  *  \return fd for success, -1 for error, -2 for only a symlink deleted.
@@ -2306,86 +2404,6 @@ int MainServer::OpenAndUnlink(const QString &filename)
     return fd;
 }
 
-/**
- *  \brief Repeatedly truncate an open file in small increments.
- *
- *   When the file is small enough this closes the file and returns.
- *
- *   NOTE: This acquires a lock so that only one instance of TruncateAndClose()
- *         is running at a time.
- */
-bool MainServer::TruncateAndClose(ProgramInfo *pginfo, int fd,
-                                  const QString &filename, off_t fsize)
-{
-    QMutexLocker locker(&truncate_and_close_lock);
-
-    if (pginfo)
-    {
-        pginfo->SetPathname(filename);
-        pginfo->MarkAsInUse(true, kTruncatingDeleteInUseID);
-    }
-
-    int cards = 5;
-    {
-        MSqlQuery query(MSqlQuery::InitCon());
-        query.prepare("SELECT COUNT(cardid) FROM capturecard;");
-        if (query.exec() && query.next())
-            cards = query.value(0).toInt();
-    }
-
-    // Time between truncation steps in milliseconds
-    const size_t sleep_time = 500;
-    const size_t min_tps    = 8 * 1024 * 1024;
-    const size_t calc_tps   = (size_t) (cards * 1.2 * (22200000LL / 8));
-    const size_t tps = max(min_tps, calc_tps);
-    const size_t increment  = (size_t) (tps * (sleep_time * 0.001f));
-
-    LOG(VB_FILE, LOG_INFO,
-        QString("Truncating '%1' by %2 MB every %3 milliseconds")
-            .arg(filename)
-            .arg(increment / (1024.0 * 1024.0), 0, 'f', 2)
-            .arg(sleep_time));
-
-    GetMythDB()->GetDBManager()->PurgeIdleConnections(false);
-
-    int count = 0;
-    while (fsize > 0)
-    {
-#if 0
-        LOG(VB_FILE, LOG_DEBUG, QString("Truncating '%1' to %2 MB")
-                .arg(filename).arg(fsize / (1024.0 * 1024.0), 0, 'f', 2));
-#endif
-
-        int err = ftruncate(fd, fsize);
-        if (err)
-        {
-            LOG(VB_GENERAL, LOG_ERR, QString("Error truncating '%1'")
-                    .arg(filename) + ENO);
-            if (pginfo)
-                pginfo->MarkAsInUse(false, kTruncatingDeleteInUseID);
-            return 0 == close(fd);
-        }
-
-        fsize -= increment;
-
-        if (pginfo && ((count % 100) == 0))
-            pginfo->UpdateInUseMark(true);
-
-        count++;
-
-        usleep(sleep_time * 1000);
-    }
-
-    bool ok = (0 == close(fd));
-
-    if (pginfo)
-        pginfo->MarkAsInUse(false, kTruncatingDeleteInUseID);
-
-    LOG(VB_FILE, LOG_INFO, QString("Finished truncating '%1'").arg(filename));
-
-    return ok;
-}
-
 void MainServer::HandleCheckRecordingActive(QStringList &slist,
                                             PlaybackSock *pbs)
 {
@@ -4723,17 +4741,17 @@ void MainServer::GetFilesystemInfos(QList<FileSystemInfo> &fsInfos)
     }
 }
 
-void TruncateThread::run(void)
+/// \brief Progress of the slow deletes on each local filesystem.
+QList<DeleteProgress> MainServer::GetDeleteProgress(void) const
 {
-    if (m_ms)
-        m_ms->DoTruncateThread(this);
+    return deleteScheduler->GetProgress();
 }
 
 void MainServer::DoTruncateThread(DeleteStruct *ds)
 {
     if (gCoreContext->GetNumSetting("TruncateDeletesSlowly", 0)) 
     {
-        TruncateAndClose(NULL, ds->m_fd, ds->m_filename, ds->m_size);
+        deleteScheduler->Add(NULL, ds->m_fd, ds->m_filename, ds->m_size);
     }
     else
     {
@@ -4813,10 +4831,9 @@ bool MainServer::HandleDeleteFile(QString filename, QString storagegroup,
     // DeleteFile() opened up a file for us to delete
     if (fd >= 0)
     {
-        // Thread off the actual file truncate
-        TruncateThread *truncateThread = 
-            new TruncateThread(this, fullfile, fd, size);
-        truncateThread->run();
+        // The delete scheduler does the actual file truncate
+        DeleteStruct ds(this, fullfile, fd, size);
+        DoTruncateThread(&ds);
     }
 
     return true;
@@ -5182,6 +5199,12 @@ void MainServer::HandleFileTransferQuery(QStringList &slist,
         ft->SetTimeout(fast);
         retlist << "OK";
     }
+    else if (command == "CAN_PIPELINE")
+    {
+        // REQUEST_BLOCKs on this socket may be sent without waiting for
+        // the previous reply, see ProcessRequest()
+        retlist << "1";
+    }
     else
     {
         LOG(VB_GENERAL, LOG_ERR, QString("Unknown command: %1").arg(command));
@@ -20,6 +20,7 @@ using namespace std;
 #include "scheduler.h"
 #include "livetvchain.h"
 #include "autoexpire.h"
+#include "deletescheduler.h"
 #include "mythsocket.h"
 #include "mythdeque.h"
 #include "mythdownloadmanager.h"
@@ -80,22 +81,11 @@ class DeleteThread : public QRunnable, public DeleteStruct
     void run(void);
 };
 
-class TruncateThread : public QRunnable, public DeleteStruct
-{
-  public:
-    TruncateThread(MainServer *ms, QString filename, int fd, off_t size) :
-                DeleteStruct(ms, filename, fd, size)  {}
-    void start(void)
-        { MThreadPool::globalInstance()->start(this, "Truncate"); }
-    void run(void);
-};
-
 class MainServer : public QObject, public MythSocketCBs
 {
     Q_OBJECT
 
     friend class DeleteThread;
-    friend class TruncateThread;
     friend class FreeSpaceUpdater;
   public:
     MainServer(bool master, int port,
@@ -124,6 +114,7 @@ class MainServer : public QObject, public MythSocketCBs
     void BackendQueryDiskSpace(QStringList &strlist, bool consolidated,
                                bool allHosts);
     void GetFilesystemInfos(QList<FileSystemInfo> &fsInfos);
+    QList<DeleteProgress> GetDeleteProgress(void) const;
 
     int GetExitCode() const { return m_exitCode; }
 
@@ -137,7 +128,7 @@ class MainServer : public QObject, public MythSocketCBs
 
   private:
 
-    void ProcessRequestWork(MythSocket *sock);
+    void ProcessRequestWork(MythSocket *sock, QStringList &listline);
     void HandleAnnounce(QStringList &slist, QStringList commands,
                         MythSocket *socket);
     void HandleDone(MythSocket *socket);
@@ -236,6 +227,7 @@ class MainServer : public QObject, public MythSocketCBs
     PlaybackSock *GetSlaveByHostname(const QString &hostname);
     PlaybackSock *GetMediaServerByHostname(const QString &hostname);
     PlaybackSock *GetPlaybackBySock(MythSocket *socket);
+    bool IsExpectingReply(MythSocket *socket);
     FileTransfer *GetFileTransferByID(int id);
     FileTransfer *GetFileTransferBySock(MythSocket *socket);
 
@@ -259,9 +251,6 @@ class MainServer : public QObject, public MythSocketCBs
     static int  DeleteFile(const QString &filename, bool followLinks,
                            bool deleteBrokenSymlinks = false);
     static int  OpenAndUnlink(const QString &filename);
-    static bool TruncateAndClose(ProgramInfo *pginfo,
-                                 int fd, const QString &filename,
-                                 off_t fsize);
 
     vector<LiveTVChain*> liveTVChains;
     QMutex liveTVChainsLock;
@@ -277,6 +266,12 @@ class MainServer : public QObject, public MythSocketCBs
     QSet<MythSocket*> controlSocketList;
     vector<MythSocket*> decrRefSocketList;
 
+    /// Sockets whose requests are being handled, and those that got more
+    /// data while they were; see ProcessRequest()
+    QMutex requestSocketLock;
+    QSet<MythSocket*> requestSocketBusy;
+    QSet<MythSocket*> requestSocketPending;
+
     QMutex masterFreeSpaceListLock;
     FreeSpaceUpdater * volatile masterFreeSpaceListUpdater;
     QWaitCondition masterFreeSpaceListWait;
@@ -306,7 +301,7 @@ class MainServer : public QObject, public MythSocketCBs
     MythDeque<DeferredDeleteStruct> deferredDeleteList;
 
     QTimer *autoexpireUpdateTimer; // audited ref #5318
-    static QMutex truncate_and_close_lock;
+    DeleteScheduler *deleteScheduler;
 
     QMap<QString, int> fsIDcache;
     QMutex fsIDcacheLock;
@@ -46,6 +46,7 @@ using namespace std;
 #include "mythdb.h"
 #include "mythsystemevent.h"
 #include "mythlogging.h"
+#include "mythmetrics.h"
 
 #define LOC QString("Scheduler: ")
 #define LOC_WARN QString("Scheduler, Warning: ")
@@ -74,6 +75,14 @@ Scheduler::Scheduler(bool runthread, QMap<int, EncoderLink *> *tvList,
     char *debug = getenv("DEBUG_CONFLICTS");
     debugConflicts = (debug != NULL);
 
+    MythMetrics::Describe("mythbackend_scheduler_runs_total",
+                          MythMetrics::kCounter, "Completed reschedules.");
+    MythMetrics::Describe("mythbackend_scheduler_run_seconds",
+                          MythMetrics::kGauge,
+                          "Time the last reschedule took, by stage.");
+    MythMetrics::Describe("mythbackend_scheduler_items", MythMetrics::kGauge,
+                          "Programs considered by the last reschedule.");
+
     if (master_sched)
         master_sched->GetAllPending(reclist);
 
@@ -1601,6 +1610,39 @@ bool Scheduler::GetAllPending(RecList &retList) const
     return hasconflicts;
 }
 
+/** \brief Copies one page of the pending recordings that pass a filter.
+ *
+ *  Only the recordings in the page are copied, so a client paging through
+ *  the schedule does not cost a copy of the whole list on each request.
+ *
+ *  \param retList filled with the recordings, the caller must delete them
+ *  \param filter  returns true for the recordings wanted, NULL for all
+ *  \param start   number of matching recordings to skip
+ *  \param count   most recordings to return, 0 for all of them
+ *  \return number of pending recordings that pass the filter
+ */
+uint Scheduler::GetAllPending(RecList &retList, PendingFilter filter,
+                              uint start, uint count) const
+{
+    QMutexLocker lockit(&schedLock);
+
+    uint matched = 0;
+
+    RecConstIter it = reclist.begin();
+    for (; it != reclist.end(); ++it)
+    {
+        if (filter && !filter(**it))
+            continue;
+
+        if (matched >= start && (count == 0 || matched < start + count))
+            retList.push_back(new RecordingInfo(**it));
+
+        ++matched;
+    }
+
+    return matched;
+}
+
 QMap<QString,ProgramInfo*> Scheduler::GetRecording(void) const
 {
     QMutexLocker lockit(&schedLock);
@@ -2204,6 +2246,15 @@ bool Scheduler::HandleReschedule(void)
                 matchTime, checkTime, placeTime);
     LOG(VB_GENERAL, LOG_INFO, msg);
 
+    MythMetrics::Add("mythbackend_scheduler_runs_total", 1);
+    MythMetrics::Set("mythbackend_scheduler_run_seconds", matchTime,
+                     MythMetrics::Label("stage", "match"));
+    MythMetrics::Set("mythbackend_scheduler_run_seconds", checkTime,
+                     MythMetrics::Label("stage", "check"));
+    MythMetrics::Set("mythbackend_scheduler_run_seconds", placeTime,
+                     MythMetrics::Label("stage", "place"));
+    MythMetrics::Set("mythbackend_scheduler_items", reclist.size());
+
     fsInfoCacheFillTime = MythDate::current().addSecs(-1000);
 
     // Write changed entries to oldrecorded.
@@ -63,6 +63,11 @@ class Scheduler : public MThread, public MythScheduler
     // Returns a list of all pending recordings and returns
     // true iff there are conflicts
     bool GetAllPending(RecList &retList) const;
+    // Returns one page of the pending recordings that pass the filter
+    // and the number that pass it
+    typedef bool (*PendingFilter)(const RecordingInfo &pginfo);
+    uint GetAllPending(RecList &retList, PendingFilter filter,
+                       uint start, uint count) const;
     virtual void GetAllPending(QStringList &strList) const;
     virtual QMap<QString,ProgramInfo*> GetRecording(void) const;
 
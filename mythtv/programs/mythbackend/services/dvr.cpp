@@ -45,17 +45,138 @@
 extern QMap<int, EncoderLink *> tvList;
 extern AutoExpire  *expirer;
 
+static bool is_upcoming(const RecordingInfo &pginfo)
+{
+    return pginfo.GetRecordingStartTime() >= MythDate::current();
+}
+
+static bool will_record(const RecordingInfo &pginfo)
+{
+    return pginfo.GetRecordingStatus() <= rsWillRecord && is_upcoming(pginfo);
+}
+
+static bool is_conflict(const RecordingInfo &pginfo)
+{
+    return pginfo.GetRecordingStatus() == rsConflict && is_upcoming(pginfo);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Fills recordingList with one page of the pending recordings that pass
+// filter, and returns how many pass it.  On the master backend only the
+// page is copied out of the scheduler.
+/////////////////////////////////////////////////////////////////////////////
+
+static uint GetPendingPage( RecordingList            &recordingList,
+                            Scheduler::PendingFilter  filter,
+                            uint                      nStartIndex,
+                            uint                      nCount )
+{
+    Scheduler *pScheduler =
+        dynamic_cast< Scheduler* >( gCoreContext->GetScheduler() );
+
+    if (pScheduler)
+    {
+        RecList tmpList;
+        uint nAvailable = pScheduler->GetAllPending( tmpList, filter,
+                                                     nStartIndex, nCount );
+        RecIter it = tmpList.begin();
+        for (; it != tmpList.end(); ++it)
+            recordingList.push_back( *it );
+
+        return nAvailable;
+    }
+
+    RecordingList  tmpList;
+    bool hasConflicts;
+    LoadFromScheduler(tmpList, hasConflicts);
+
+    uint nAvailable = 0;
+
+    RecordingList::iterator it = tmpList.begin();
+    for(; it < tmpList.end(); ++it)
+    {
+        if (!filter(**it))
+            continue;
+
+        if (nAvailable >= nStartIndex &&
+            (nCount == 0 || nAvailable < nStartIndex + nCount))
+        {
+            recordingList.push_back(new RecordingInfo(**it));
+        }
+
+        ++nAvailable;
+    }
+
+    return nAvailable;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
 
-DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
-                                        int            nStartIndex,
-                                        int            nCount,
-                                        const QString &sTitleRegEx,
-                                        const QString &sRecGroup,
-                                        const QString &sStorageGroup )
+DTC::ProgramList* Dvr::GetRecordedList( bool             bDescending,
+                                        int              nStartIndex,
+                                        int              nCount,
+                                        const QString   &sTitleRegEx,
+                                        const QString   &sRecGroup,
+                                        const QString   &sStorageGroup,
+                                        const QDateTime &dtStartTime,
+                                        const QDateTime &dtEndTime,
+                                        const QString   &sSort )
 {
+    // ----------------------------------------------------------------------
+    // Filter, sort and page in the database, so only the requested page
+    // of recordings is loaded
+    // ----------------------------------------------------------------------
+
+    QStringList  conditions;
+    MSqlBindings bindings;
+
+    if (!sTitleRegEx.isEmpty())
+    {
+        conditions << "r.title REGEXP :TITLEREGEX";
+        bindings[":TITLEREGEX"] = sTitleRegEx;
+    }
+
+    if (!sRecGroup.isEmpty())
+    {
+        conditions << "r.recgroup = :RECGROUP";
+        bindings[":RECGROUP"] = sRecGroup;
+    }
+
+    if (!sStorageGroup.isEmpty())
+    {
+        conditions << "r.storagegroup = :STORAGEGROUP";
+        bindings[":STORAGEGROUP"] = sStorageGroup;
+    }
+
+    if (dtStartTime.isValid())
+    {
+        conditions << "r.starttime >= :STARTTIME";
+        bindings[":STARTTIME"] = dtStartTime.toUTC();
+    }
+
+    if (dtEndTime.isValid())
+    {
+        conditions << "r.starttime < :ENDTIME";
+        bindings[":ENDTIME"] = dtEndTime.toUTC();
+    }
+
+    QString sDirection = bDescending ? " DESC" : "";
+    QString sOrderBy;
+
+    if (sSort.isEmpty() || sSort.toLower() == "starttime")
+        sOrderBy = "r.starttime" + sDirection;
+    else if (sSort.toLower() == "title")
+        sOrderBy = "r.title" + sDirection + ", r.starttime" + sDirection;
+    else if (sSort.toLower() == "originalairdate")
+        sOrderBy = "r.originalairdate" + sDirection + ", r.starttime" + sDirection;
+    else
+        throw QString("Sort must be StartTime, Title or OriginalAirDate.");
+
+    // StartIndex has always counted from 1, with 0 treated as 1
+    uint nOffset = max(nStartIndex - 1, 0);
+
     QMap< QString, ProgramInfo* > recMap;
 
     if (gCoreContext->GetScheduler())
@@ -65,12 +186,11 @@ DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
     QMap< QString, bool >     isJobRunning= ProgramInfo::QueryJobsRunning(JOB_COMMFLAG);
 
     ProgramList progList;
+    uint nAvailable = 0;
 
-    int desc = 0;
-    if (bDescending)
-        desc = -1;
-
-    LoadFromRecorded( progList, false, inUseMap, isJobRunning, recMap, desc );
+    LoadFromRecorded( progList, conditions.join(" AND "), bindings,
+                      inUseMap, isJobRunning, recMap, sOrderBy,
+                      nOffset, (nCount > 0) ? nCount : 0, nAvailable );
 
     QMap< QString, ProgramInfo* >::iterator mit = recMap.begin();
 
@@ -82,32 +202,11 @@ DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
     // ----------------------------------------------------------------------
 
     DTC::ProgramList *pPrograms = new DTC::ProgramList();
-    int nAvailable = 0;
-
-    int nMax      = (nCount > 0) ? nCount : progList.size();
-
-    nAvailable = 0;
-    nCount = 0;
-
-    QRegExp rTitleRegEx        = QRegExp(sTitleRegEx, Qt::CaseInsensitive);
 
     for( unsigned int n = 0; n < progList.size(); n++)
     {
         ProgramInfo *pInfo = progList[ n ];
 
-        if ((!sTitleRegEx.isEmpty() && !pInfo->GetTitle().contains(rTitleRegEx)) ||
-            (!sRecGroup.isEmpty() && sRecGroup != pInfo->GetRecordingGroup()) ||
-            (!sStorageGroup.isEmpty() && sStorageGroup != pInfo->GetStorageGroup()))
-            continue;
-
-        ++nAvailable;
-
-        if ((nAvailable < nStartIndex) ||
-            (nCount >= nMax))
-            continue;
-
-        ++nCount;
-
         DTC::Program *pProgram = pPrograms->AddNewProgram();
 
         FillProgramInfo( pProgram, pInfo, true );
@@ -116,7 +215,7 @@ DTC::ProgramList* Dvr::GetRecordedList( bool           bDescending,
     // ----------------------------------------------------------------------
 
     pPrograms->setStartIndex    ( nStartIndex     );
-    pPrograms->setCount         ( nCount          );
+    pPrograms->setCount         ( progList.size() );
     pPrograms->setTotalAvailable( nAvailable      );
     pPrograms->setAsOf          ( MythDate::current() );
     pPrograms->setVersion       ( MYTH_BINARY_VERSION );
@@ -175,9 +274,13 @@ DTC::ProgramList* Dvr::GetExpiringList( int nStartIndex,
                                         int nCount      )
 {
     pginfolist_t  infoList;
+    uint          nAvailable = 0;
+
+    nStartIndex = max( nStartIndex, 0 );
 
     if (expirer)
-        expirer->GetAllExpiring( infoList );
+        nAvailable = expirer->GetAllExpiring( infoList, nStartIndex,
+                                              max( nCount, 0 ) );
 
     // ----------------------------------------------------------------------
     // Build Response
@@ -185,11 +288,10 @@ DTC::ProgramList* Dvr::GetExpiringList( int nStartIndex,
 
     DTC::ProgramList *pPrograms = new DTC::ProgramList();
 
-    nStartIndex   = min( nStartIndex, (int)infoList.size() );
-    nCount        = (nCount > 0) ? min( nCount, (int)infoList.size() ) : infoList.size();
-    int nEndIndex = min((nStartIndex + nCount), (int)infoList.size() );
+    nStartIndex   = min( nStartIndex, (int)nAvailable );
+    nCount        = infoList.size();
 
-    for( int n = nStartIndex; n < nEndIndex; n++)
+    for( int n = 0; n < nCount; n++)
     {
         ProgramInfo *pInfo = infoList[ n ];
 
@@ -207,7 +309,7 @@ DTC::ProgramList* Dvr::GetExpiringList( int nStartIndex,
 
     pPrograms->setStartIndex    ( nStartIndex     );
     pPrograms->setCount         ( nCount          );
-    pPrograms->setTotalAvailable( infoList.size() );
+    pPrograms->setTotalAvailable( nAvailable      );
     pPrograms->setAsOf          ( MythDate::current() );
     pPrograms->setVersion       ( MYTH_BINARY_VERSION );
     pPrograms->setProtoVer      ( MYTH_PROTO_VERSION  );
@@ -387,26 +489,12 @@ DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
                                         int  nCount,
                                         bool bShowAll )
 {
+    // Only those which will record, unless all are wanted
     RecordingList  recordingList;
-    RecordingList  tmpList;
-    bool hasConflicts;
-    LoadFromScheduler(tmpList, hasConflicts);
-
-    // Sort the upcoming into only those which will record
-    RecordingList::iterator it = tmpList.begin();
-    for(; it < tmpList.end(); ++it)
-    {
-        if (!bShowAll && ((*it)->GetRecordingStatus() <= rsWillRecord) &&
-            ((*it)->GetRecordingStartTime() >= MythDate::current()))
-        {
-            recordingList.push_back(new RecordingInfo(**it));
-        }
-        else if (bShowAll &&
-                 ((*it)->GetRecordingStartTime() >= MythDate::current()))
-        {
-            recordingList.push_back(new RecordingInfo(**it));
-        }
-    }
+    nStartIndex     = max( nStartIndex, 0 );
+    uint nAvailable = GetPendingPage( recordingList,
+                                      bShowAll ? is_upcoming : will_record,
+                                      nStartIndex, max( nCount, 0 ) );
 
     // ----------------------------------------------------------------------
     // Build Response
@@ -414,11 +502,10 @@ DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
 
     DTC::ProgramList *pPrograms = new DTC::ProgramList();
 
-    nStartIndex   = min( nStartIndex, (int)recordingList.size() );
-    nCount        = (nCount > 0) ? min( nCount, (int)recordingList.size() ) : recordingList.size();
-    int nEndIndex = min((nStartIndex + nCount), (int)recordingList.size() );
+    nStartIndex   = min( nStartIndex, (int)nAvailable );
+    nCount        = recordingList.size();
 
-    for( int n = nStartIndex; n < nEndIndex; n++)
+    for( int n = 0; n < nCount; n++)
     {
         ProgramInfo *pInfo = recordingList[ n ];
 
@@ -431,7 +518,7 @@ DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
 
     pPrograms->setStartIndex    ( nStartIndex     );
     pPrograms->setCount         ( nCount          );
-    pPrograms->setTotalAvailable( recordingList.size() );
+    pPrograms->setTotalAvailable( nAvailable      );
     pPrograms->setAsOf          ( MythDate::current() );
     pPrograms->setVersion       ( MYTH_BINARY_VERSION );
     pPrograms->setProtoVer      ( MYTH_PROTO_VERSION  );
@@ -446,21 +533,11 @@ DTC::ProgramList* Dvr::GetUpcomingList( int  nStartIndex,
 DTC::ProgramList* Dvr::GetConflictList( int  nStartIndex,
                                         int  nCount       )
 {
+    // Only those which are conflicts
     RecordingList  recordingList;
-    RecordingList  tmpList;
-    bool hasConflicts;
-    LoadFromScheduler(tmpList, hasConflicts);
-
-    // Sort the upcoming into only those which are conflicts
-    RecordingList::iterator it = tmpList.begin();
-    for(; it < tmpList.end(); ++it)
-    {
-        if (((*it)->GetRecordingStatus() == rsConflict) &&
-            ((*it)->GetRecordingStartTime() >= MythDate::current()))
-        {
-            recordingList.push_back(new RecordingInfo(**it));
-        }
-    }
+    nStartIndex     = max( nStartIndex, 0 );
+    uint nAvailable = GetPendingPage( recordingList, is_conflict,
+                                      nStartIndex, max( nCount, 0 ) );
 
     // ----------------------------------------------------------------------
     // Build Response
@@ -468,11 +545,10 @@ DTC::ProgramList* Dvr::GetConflictList( int  nStartIndex,
 
     DTC::ProgramList *pPrograms = new DTC::ProgramList();
 
-    nStartIndex   = min( nStartIndex, (int)recordingList.size() );
-    nCount        = (nCount > 0) ? min( nCount, (int)recordingList.size() ) : recordingList.size();
-    int nEndIndex = min((nStartIndex + nCount), (int)recordingList.size() );
+    nStartIndex   = min( nStartIndex, (int)nAvailable );
+    nCount        = recordingList.size();
 
-    for( int n = nStartIndex; n < nEndIndex; n++)
+    for( int n = 0; n < nCount; n++)
     {
         ProgramInfo *pInfo = recordingList[ n ];
 
@@ -485,7 +561,7 @@ DTC::ProgramList* Dvr::GetConflictList( int  nStartIndex,
 
     pPrograms->setStartIndex    ( nStartIndex     );
     pPrograms->setCount         ( nCount          );
-    pPrograms->setTotalAvailable( recordingList.size() );
+    pPrograms->setTotalAvailable( nAvailable      );
     pPrograms->setAsOf          ( MythDate::current() );
     pPrograms->setVersion       ( MYTH_BINARY_VERSION );
     pPrograms->setProtoVer      ( MYTH_PROTO_VERSION  );
@@ -48,7 +48,10 @@ class Dvr : public DvrServices
                                                 int              Count,
                                                 const QString   &TitleRegEx,
                                                 const QString   &RecGroup,
-                                                const QString   &StorageGroup );
+                                                const QString   &StorageGroup,
+                                                const QDateTime &StartTime,
+                                                const QDateTime &EndTime,
+                                                const QString   &Sort );
 
         DTC::Program*     GetRecorded         ( int              ChanId,
                                                 const QDateTime &StartTime  );
@@ -213,11 +216,15 @@ class ScriptableDvr : public QObject
                                        int              Count,
                                        const QString   &TitleRegEx,
                                        const QString   &RecGroup,
-                                       const QString   &StorageGroup)
+                                       const QString   &StorageGroup,
+                                       const QDateTime &StartTime,
+                                       const QDateTime &EndTime,
+                                       const QString   &Sort )
         {
             return m_obj.GetRecordedList( Descending, StartIndex, Count,
                                           TitleRegEx, RecGroup,
-                                          StorageGroup);
+                                          StorageGroup, StartTime, EndTime,
+                                          Sort );
         }
 
         QObject* GetRecorded         ( int              ChanId,
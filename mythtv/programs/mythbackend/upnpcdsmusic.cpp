@@ -249,6 +249,20 @@ bool UPnpCDSMusic::IsSearchRequestForUs( UPnpCDSRequest *pRequest )
     return UPnpCDSExtension::IsSearchRequestForUs( pRequest );
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// MUSIC_LIST_CHANGE is sent by the music scanner when it changed anything
+/////////////////////////////////////////////////////////////////////////////
+
+bool UPnpCDSMusic::ProcessEvent( const MythEvent &event )
+{
+    if (event.Message() != "MUSIC_LIST_CHANGE")
+        return false;
+
+    ContentChanged();
+
+    return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
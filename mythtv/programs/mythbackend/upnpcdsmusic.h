@@ -52,6 +52,8 @@ class UPnpCDSMusic : public UPnpCDSExtension
         }
 
         virtual ~UPnpCDSMusic() {}
+
+        virtual bool ProcessEvent( const MythEvent &event );
 };
 
 #endif
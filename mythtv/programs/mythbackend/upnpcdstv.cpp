@@ -18,6 +18,7 @@
 #include "storagegroup.h"
 #include "mythdate.h"
 #include "mythcorecontext.h"
+#include "programinfo.h"
 
 
 /*
@@ -274,6 +275,58 @@ bool UPnpCDSTv::IsSearchRequestForUs( UPnpCDSRequest *pRequest )
     return bOurs;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// RECORDING_LIST_CHANGE [ADD|UPDATE|DELETE chanid starttime]
+// MASTER_UPDATE_PROG_INFO chanid starttime
+// UPDATE_FILE_SIZE chanid starttime size
+/////////////////////////////////////////////////////////////////////////////
+
+bool UPnpCDSTv::ProcessEvent( const MythEvent &event )
+{
+    QStringList tokens = event.Message().split(" ", QString::SkipEmptyParts);
+
+    if (tokens.isEmpty())
+        return false;
+
+    // Progress and file size updates arrive every few seconds while
+    // recording, so they only drop that recording's cached details rather
+    // than telling every renderer to browse again.
+
+    if (tokens[0] == "MASTER_UPDATE_PROG_INFO" ||
+        tokens[0] == "UPDATE_FILE_SIZE")
+    {
+        if (tokens.size() >= 3)
+        {
+            m_detailLock.lock();
+            m_mapDetails.remove(
+                ProgramInfo::MakeUniqueKey(tokens[1].toUInt(),
+                                           MythDate::fromString(tokens[2])));
+            m_detailLock.unlock();
+        }
+        return false;
+    }
+
+    if (tokens[0] != "RECORDING_LIST_CHANGE")
+        return false;
+
+    m_detailLock.lock();
+
+    if (tokens.size() >= 4)
+    {
+        m_mapDetails.remove(
+            ProgramInfo::MakeUniqueKey(tokens[2].toUInt(),
+                                       MythDate::fromString(tokens[3])));
+    }
+    else
+        m_mapDetails.clear();
+
+    m_detailLock.unlock();
+
+    ContentChanged();
+
+    return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //
 /////////////////////////////////////////////////////////////////////////////
@@ -375,14 +428,47 @@ void UPnpCDSTv::AddItem( const UPnpCDSRequest    *pRequest,
     // Add Video Resource Element based on File contents/extension (HTTP)
     // ----------------------------------------------------------------------
 
-    StorageGroup sg(sStorageGrp, sHostName);
-    QString sFilePath = sg.FindFile(sBaseName);
-    QString sMimeType;
+    // Finding the file and its duration are the slow part, only do them
+    // the first time the recording is listed.
 
-    if ( QFile::exists(sFilePath) )
-        sMimeType = HTTPRequest::TestMimeType( sFilePath );
-    else
-        sMimeType = HTTPRequest::TestMimeType( sBaseName );
+    QString     sKey = ProgramInfo::MakeUniqueKey(nChanid, dtStartTime);
+    ItemDetails details;
+
+    m_detailLock.lock();
+    bool bCached = m_mapDetails.contains(sKey);
+    if (bCached)
+        details = m_mapDetails[sKey];
+    m_detailLock.unlock();
+
+    if (!bCached)
+    {
+        StorageGroup sg(sStorageGrp, sHostName);
+        QString sFilePath = sg.FindFile(sBaseName);
+
+        if ( QFile::exists(sFilePath) )
+            details.sMimeType = HTTPRequest::TestMimeType( sFilePath );
+        else
+            details.sMimeType = HTTPRequest::TestMimeType( sBaseName );
+
+        uint uiStart = dtProgStart.toTime_t();
+        uint uiEnd   = dtProgEnd.toTime_t();
+
+        details.nDuration = uiEnd - uiStart;
+
+        MSqlQuery query2(MSqlQuery::InitCon());
+        query2.prepare( "SELECT data FROM recordedmarkup WHERE chanid=:CHANID "
+                        "AND starttime=:STARTTIME AND type = 33" );
+        query2.bindValue(":CHANID", (int)nChanid);
+        query2.bindValue(":STARTTIME", dtProgStart);
+        if (query2.exec() && query2.next())
+            details.nDuration = query2.value(0).toUInt() / 1000;
+
+        m_detailLock.lock();
+        m_mapDetails.insert(sKey, details);
+        m_detailLock.unlock();
+    }
+
+    QString sMimeType = details.sMimeType;
 
 
     // If we are dealing with Window Media Player 12 (i.e. Windows 7)
@@ -416,17 +502,7 @@ void UPnpCDSTv::AddItem( const UPnpCDSRequest    *pRequest,
 
     Resource *pRes = pItem->AddResource( sProtocol, sURI );
 
-    uint uiStart = dtProgStart.toTime_t();
-    uint uiEnd   = dtProgEnd.toTime_t();
-    uint uiDur   = uiEnd - uiStart;
-    
-    MSqlQuery query2(MSqlQuery::InitCon());
-    query2.prepare( "SELECT data FROM recordedmarkup WHERE chanid=:CHANID AND "
-                    "starttime=:STARTTIME AND type = 33" );
-    query2.bindValue(":CHANID", (int)nChanid);
-    query2.bindValue(":STARTTIME", dtProgStart);
-    if (query2.exec() && query2.next())
-        uiDur = query2.value(0).toUInt() / 1000;
+    uint uiDur = details.nDuration;
 
     QString sDur;
 
@@ -11,6 +11,8 @@
 #ifndef UPnpCDSTV_H_
 #define UPnpCDSTV_H_
 
+#include <QMutex>
+
 #include "upnpcds.h"
 
 //////////////////////////////////////////////////////////////////////////////
@@ -27,6 +29,17 @@ class UPnpCDSTv : public UPnpCDSExtension
         QStringMap             m_mapBackendIp;
         QStringMap             m_mapBackendPort;
 
+        /// What AddItem() reads from a recording's file and markup, kept
+        /// until the recording changes
+        struct ItemDetails
+        {
+            QString sMimeType;
+            uint    nDuration;
+        };
+
+        QMutex                      m_detailLock;
+        QMap<QString, ItemDetails>  m_mapDetails;
+
     protected:
 
         virtual bool             IsBrowseRequestForUs( UPnpCDSRequest *pRequest );
@@ -54,6 +67,8 @@ class UPnpCDSTv : public UPnpCDSExtension
         }
 
         virtual ~UPnpCDSTv() {}
+
+        virtual bool ProcessEvent( const MythEvent &event );
 };
 
 #endif
@@ -213,18 +213,30 @@ bool UPnpCDSVideo::IsSearchRequestForUs( UPnpCDSRequest *pRequest )
 
 int UPnpCDSVideo::GetDistinctCount( UPnpCDSRootInfo *pInfo )
 {
-    int nCount = 0;
+    return QueryCount( "SELECT COUNT(*) FROM videometadata" );
+}
 
-    MSqlQuery query(MSqlQuery::InitCon());
+/////////////////////////////////////////////////////////////////////////////
+// VIDEO_LIST_CHANGE, with "added::id", "moved::id" and "deleted::id"
+/////////////////////////////////////////////////////////////////////////////
 
-    query.prepare("SELECT COUNT(*) FROM videometadata");
+bool UPnpCDSVideo::ProcessEvent( const MythEvent &event )
+{
+    if (event.Message() != "VIDEO_LIST_CHANGE")
+        return false;
 
-    if (query.exec() && query.next())
-    {
-        nCount = query.value(0).toInt();
-    }
+    QStringList changes = event.ExtraDataList();
+
+    m_detailLock.lock();
+
+    for (int i = 0; i < changes.size(); ++i)
+        m_mapDetails.remove( changes[i].section("::", 1).toInt() );
+
+    m_detailLock.unlock();
 
-    return nCount;
+    ContentChanged();
+
+    return true;
 }
 
 
@@ -350,13 +362,34 @@ void UPnpCDSVideo::AddItem( const UPnpCDSRequest    *pRequest,
         pItem->SetPropValue( "refID", sRefId );
     }
 
-    QString sFullFileName = sFilePath;
-    if (!QFile::exists( sFullFileName ))
+    // Looking for the file is the slow part, only do it the first time
+    // the video is listed.
+
+    ItemDetails details;
+
+    m_detailLock.lock();
+    bool bCached = m_mapDetails.contains( nVidID );
+    if (bCached)
+        details = m_mapDetails[ nVidID ];
+    m_detailLock.unlock();
+
+    if (!bCached)
     {
-        StorageGroup sgroup("Videos");
-        sFullFileName = sgroup.FindFile( sFullFileName );
+        QString sFullFileName = sFilePath;
+        if (!QFile::exists( sFullFileName ))
+        {
+            StorageGroup sgroup("Videos");
+            sFullFileName = sgroup.FindFile( sFullFileName );
+        }
+        QFileInfo fInfo( sFullFileName );
+
+        details.sMimeType = HTTPRequest::GetMimeType( fInfo.suffix() );
+        details.nFileSize = fInfo.size();
+
+        m_detailLock.lock();
+        m_mapDetails.insert( nVidID, details );
+        m_detailLock.unlock();
     }
-    QFileInfo fInfo( sFullFileName );
 
     pItem->SetPropValue( "date", dtInsertDate.toString("yyyy-MM-dd"));
     pResults->Add( pItem );
@@ -365,7 +398,7 @@ void UPnpCDSVideo::AddItem( const UPnpCDSRequest    *pRequest,
     // Add Video Resource Element based on File extension (HTTP)
     // ----------------------------------------------------------------------
 
-    QString sMimeType = HTTPRequest::GetMimeType( fInfo.suffix() );
+    QString sMimeType = details.sMimeType;
 
     // If we are dealing with a Sony Blu-ray player then we fake the
     // MIME type to force the video to appear
@@ -382,7 +415,7 @@ void UPnpCDSVideo::AddItem( const UPnpCDSRequest    *pRequest,
 
     Resource *pRes = pItem->AddResource( sProtocol, sURI );
 
-    pRes->AddAttribute( "size"      , QString("%1").arg(fInfo.size()) );
+    pRes->AddAttribute( "size"      , QString("%1").arg(details.nFileSize) );
 
     QString sDur;
     sDur.sprintf("%02d:%02d:00", (nLength / 60), nLength % 60 );
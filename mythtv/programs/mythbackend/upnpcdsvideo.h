@@ -11,6 +11,8 @@
 #ifndef UPnpCDSVIDEO_H_
 #define UPnpCDSVIDEO_H_
 
+#include <QMutex>
+
 #include "mainserver.h"
 #include "upnpcds.h"
               
@@ -30,6 +32,17 @@ class UPnpCDSVideo : public UPnpCDSExtension
         QStringMap             m_mapBackendIp;
         QStringMap             m_mapBackendPort;
 
+        /// What AddItem() reads from a video's file, kept until the video
+        /// is moved or deleted
+        struct ItemDetails
+        {
+            QString sMimeType;
+            qint64  nFileSize;
+        };
+
+        QMutex                  m_detailLock;
+        QMap<int, ItemDetails>  m_mapDetails;
+
     protected:
 
         virtual bool             IsBrowseRequestForUs( UPnpCDSRequest *pRequest );
@@ -58,6 +71,8 @@ class UPnpCDSVideo : public UPnpCDSExtension
         {
         }
         virtual ~UPnpCDSVideo() {}
+
+        virtual bool ProcessEvent( const MythEvent &event );
 };
 
 #endif
@@ -13,8 +13,18 @@ void MythCCExtractorCommandLineParser::LoadArguments(void)
     addSettingsOverride();
     addVersion();
     addLogging("none", LOG_ERR);
-    add(QStringList( QStringList() << "-i" << "--infile" ), "inputfile", "",
-            "input file", "");
+    add(QStringList( QStringList() << "-i" << "--infile" ), "inputfile",
+            QVariant::StringList,
+            "input file, can be used repeatedly", "");
+    add("--demux-only", "demuxonly", false,
+            "Do not decode the video, only demux it",
+            "Finds the ATSC captions in MPEG-2 user data and H.264 SEI "
+            "messages without decoding the video, which is much faster. "
+            "DVB subtitles and teletext are extracted as usual. SCTE-20 "
+            "captions are only found when the video is decoded.");
+    add("--jobs", "jobs", 1,
+            "Number of input files to extract from at once, "
+            "0 for one per CPU", "");
 }
 
 QString MythCCExtractorCommandLineParser::GetHelpHeader(void) const
@@ -2,10 +2,12 @@
 
 // C++ headers
 #include <iostream>
+#include <algorithm>
 using namespace std;
 
 // Qt headers
 #include <QCoreApplication>
+#include <QRunnable>
 #include <QString>
 #include <QtCore>
 #include <QtGui>
@@ -19,6 +21,7 @@ using namespace std;
 #include "ringbuffer.h"
 #include "exitcodes.h"
 #include "signalhandling.h"
+#include "mthreadpool.h"
 
 namespace {
     void cleanup()
@@ -47,7 +50,8 @@ namespace {
     };
 }
 
-static int RunCCExtract(const ProgramInfo &program_info)
+static int RunCCExtract(const ProgramInfo &program_info,
+                        bool demuxOnly, bool showProgress)
 {
     if (!program_info.IsLocal())
     {
@@ -79,7 +83,8 @@ static int RunCCExtract(const ProgramInfo &program_info)
                                       kDecodeNoLoopFilter | kDecodeFewBlocks |
                                       kDecodeLowRes | kDecodeSingleThreaded |
                                       kDecodeNoDecode);
-    MythCCExtractorPlayer *ccp = new MythCCExtractorPlayer(flags, true, filename);
+    MythCCExtractorPlayer *ccp = new MythCCExtractorPlayer(
+        flags, showProgress, filename, demuxOnly);
     PlayerContext *ctx = new PlayerContext(kCCExtractorInUseID);
     ctx->SetPlayingInfo(&program_info);
     ctx->SetRingBuffer(tmprbuf);
@@ -102,6 +107,31 @@ static int RunCCExtract(const ProgramInfo &program_info)
     return GENERIC_EXIT_OK;
 }
 
+/// Failures of the input files extracted from by CCExtractor
+static QMutex s_failuresLock;
+static int    s_failures = 0;
+
+class CCExtractor : public QRunnable
+{
+  public:
+    CCExtractor(const QString &infile, bool demuxOnly) :
+        m_infile(infile), m_demuxOnly(demuxOnly) {}
+
+    void run(void)
+    {
+        ProgramInfo pginfo(m_infile);
+        if (RunCCExtract(pginfo, m_demuxOnly, false) != GENERIC_EXIT_OK)
+        {
+            QMutexLocker locker(&s_failuresLock);
+            s_failures++;
+        }
+    }
+
+  private:
+    QString m_infile;
+    bool    m_demuxOnly;
+};
+
 int main(int argc, char *argv[])
 {
     QCoreApplication a(argc, argv);
@@ -133,8 +163,8 @@ int main(int argc, char *argv[])
         return GENERIC_EXIT_OK;
     }
 
-    QString infile = cmdline.toString("inputfile");
-    if (infile.isEmpty())
+    QStringList infiles = cmdline.toStringList("inputfile");
+    if (infiles.isEmpty())
     {
         cerr << "The input file --infile is required" << endl;
         return GENERIC_EXIT_INVALID_CMDLINE;
@@ -162,8 +192,41 @@ int main(int argc, char *argv[])
         return GENERIC_EXIT_NO_MYTHCONTEXT;
     }
 
-    ProgramInfo pginfo(infile);
-    return RunCCExtract(pginfo);
+    bool demuxOnly = cmdline.toBool("demuxonly");
+    int jobs = cmdline.toInt("jobs");
+    if (jobs <= 0)
+        jobs = max(QThread::idealThreadCount(), 1);
+
+    if ((jobs == 1) || (infiles.size() == 1))
+    {
+        int ret = GENERIC_EXIT_OK;
+        QStringList::const_iterator it = infiles.begin();
+        for (; it != infiles.end(); ++it)
+        {
+            ProgramInfo pginfo(*it);
+            int result = RunCCExtract(pginfo, demuxOnly, true);
+            if (result != GENERIC_EXIT_OK)
+                ret = result;
+        }
+        return ret;
+    }
+
+    // Progress is not shown, as the files would write over each other
+    MThreadPool pool("CCExtractor");
+    pool.setMaxThreadCount(jobs);
+    QStringList::const_iterator it = infiles.begin();
+    for (; it != infiles.end(); ++it)
+        pool.start(new CCExtractor(*it, demuxOnly), "CCExtractor");
+    pool.waitForDone();
+
+    if (s_failures)
+    {
+        cerr << s_failures << " of " << infiles.size()
+             << " files failed" << endl;
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    return GENERIC_EXIT_OK;
 }
 
 
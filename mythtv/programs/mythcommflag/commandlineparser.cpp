@@ -25,7 +25,14 @@ void MythCommFlagCommandLineParser::LoadArguments(void)
                     ->SetGroup("Input")
          << add("--video", "video", "", 
                 "Rebuild the seek table for a video (non-recording) file.", "")
-                    ->SetGroup("Input") );
+                    ->SetGroup("Input")
+         << add("--all-recordings", "allrecordings", false,
+                "Rebuild the seek tables of all recordings.",
+                "Rebuilds several at once where the disks and CPUs allow. "
+                "Deleted recordings and those still being recorded are "
+                "skipped.")
+                    ->SetGroup("Input")
+                    ->SetRequires("rebuild") );
 
     CommandLineArg::AllowOneOf( QList<CommandLineArg*>()
          << add("--gencutlist", "gencutlist", false,
@@ -52,7 +59,9 @@ void MythCommFlagCommandLineParser::LoadArguments(void)
                     ->SetGroup("Advanced")
                     ->SetRequires("file")
          << add("--rebuild", "rebuild", false,
-                "Do not flag commercials, just rebuild the seektable.", "")
+                "Do not flag commercials, just rebuild the seektable.",
+                "Needs a recording or file, or --all-recordings to rebuild "
+                "the seektables of every recording.")
                     ->SetGroup("Commflagging")
                     ->SetBlocks("commmethod") );
 
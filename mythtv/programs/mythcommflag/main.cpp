@@ -1,6 +1,7 @@
 // POSIX headers
 #include <unistd.h>
 #include <sys/time.h> // for gettimeofday
+#include <sys/stat.h>
 
 // ANSI C headers
 #include <cstdlib>
@@ -12,6 +13,7 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 using namespace std;
 
 // Qt headers
@@ -20,6 +22,9 @@ using namespace std;
 #include <QRegExp>
 #include <QDir>
 #include <QEvent>
+#include <QRunnable>
+#include <QWaitCondition>
+#include <QMutex>
 
 // MythTV headers
 #include "mythmiscutil.h"
@@ -40,6 +45,8 @@ using namespace std;
 #include "mythtranslation.h"
 #include "mythlogging.h"
 #include "signalhandling.h"
+#include "jobresources.h"
+#include "mthreadpool.h"
 
 // Commercial Flagging headers
 #include "CommDetectorBase.h"
@@ -1055,16 +1062,26 @@ static int RebuildSeekTable(ProgramInfo *pginfo, int jobid)
         cerr << "Rebuild started at " << qPrintable(time) << endl;
     }
 
-    cfp->RebuildSeekTable(progress);
+    bool ok = cfp->RebuildSeekTable(progress);
 
     if (progress)
     {
         QString time = QDateTime::currentDateTime().toString(Qt::TextDate);
-        cerr << "Rebuild completed at " << qPrintable(time) << endl;
+        if (ok)
+            cerr << "Rebuild completed at " << qPrintable(time) << endl;
+        else
+            cerr << "Rebuild failed at " << qPrintable(time) << endl;
     }
 
     delete ctx;
 
+    if (!ok)
+    {
+        LOG(VB_GENERAL, LOG_ERR,
+            QString("Unable to rebuild the seektable for %1").arg(filename));
+        return GENERIC_EXIT_NOT_OK;
+    }
+
     return GENERIC_EXIT_OK;
 }
 
@@ -1094,6 +1111,198 @@ static int RebuildSeekTable(uint chanid, QDateTime starttime, int jobid)
     return RebuildSeekTable(&pginfo, jobid);
 }
 
+/// Rebuilds running on each disk, guarded by rebuildLock
+static QMutex             rebuildLock;
+static QWaitCondition     rebuildDone;
+static QMap<quint64, int> rebuildsRunning;
+static int                rebuildFailures = 0;
+
+/// Disk key for recordings that are not on a local file system
+static const quint64 kRemoteDisk = ~0ULL;
+
+class SeekTableRebuilder : public QRunnable
+{
+  public:
+    SeekTableRebuilder(const ProgramInfo &pginfo, quint64 disk) :
+        m_pginfo(pginfo), m_disk(disk) {}
+
+    void run(void)
+    {
+        int ret = RebuildSeekTable(&m_pginfo, -1);
+
+        QMutexLocker locker(&rebuildLock);
+        if (--rebuildsRunning[m_disk] <= 0)
+            rebuildsRunning.remove(m_disk);
+        if (ret != GENERIC_EXIT_OK)
+            rebuildFailures++;
+        rebuildDone.wakeAll();
+    }
+
+  private:
+    ProgramInfo m_pginfo;
+    quint64     m_disk;
+};
+
+/// Returns true if a recorder is still writing this recording
+static bool is_being_recorded(const ProgramInfo &pginfo)
+{
+    QStringList byWho;
+    if (!pginfo.QueryIsInUse(byWho))
+        return false;
+
+    for (int i = 0; i + 2 < byWho.size(); i += 3)
+    {
+        if (byWho[i] == kRecorderInUseID ||
+            byWho[i] == kImportRecorderInUseID)
+            return true;
+    }
+
+    return false;
+}
+
+static quint64 get_disk(ProgramInfo *pginfo)
+{
+    QString path = get_filename(pginfo);
+    struct stat st;
+    if (!path.startsWith("/") ||
+        (stat(path.toLocal8Bit().constData(), &st) != 0))
+        return kRemoteDisk;
+    return st.st_dev;
+}
+
+/** \brief Rebuilds the seektables of all recordings, several at once.
+ *
+ *  Rebuilding only demuxes, so it is limited by how fast the files can be
+ *  read rather than by the CPU. Recordings on different disks are rebuilt
+ *  side by side, and a second one is started on a disk only while that
+ *  disk and the CPUs have time to spare. Recordings that are only
+ *  reachable through a backend are rebuilt one at a time.
+ */
+static int RebuildAllSeekTables(void)
+{
+    MSqlQuery query(MSqlQuery::InitCon());
+    query.prepare("SELECT chanid, starttime FROM recorded "
+                  "WHERE recgroup != 'Deleted' "
+                  "ORDER BY starttime;");
+    if (!query.exec())
+    {
+        MythDB::DBError("RebuildAllSeekTables", query);
+        return GENERIC_EXIT_DB_ERROR;
+    }
+
+    QList<ProgramInfo> pending;
+    QList<quint64> pendingDisks;
+    while (query.next())
+    {
+        ProgramInfo pginfo(query.value(0).toUInt(),
+                           MythDate::fromString(query.value(1).toString()));
+        if (!pginfo.GetChanID())
+            continue;
+
+        // The recorder keeps its own seektable up to date
+        if (is_being_recorded(pginfo))
+        {
+            LOG(VB_GENERAL, LOG_INFO,
+                QString("Skipping %1, it is still being recorded")
+                    .arg(get_filename(&pginfo)));
+            continue;
+        }
+
+        if (cmdline.toBool("dryrun"))
+        {
+            cerr << "Seektable would be rebuilt for "
+                 << get_filename(&pginfo).toLocal8Bit().constData() << endl;
+            continue;
+        }
+
+        pendingDisks.push_back(get_disk(&pginfo));
+        pending.push_back(pginfo);
+    }
+
+    if (pending.isEmpty())
+        return GENERIC_EXIT_OK;
+
+    // Each rebuild would otherwise write its own progress over the others
+    bool showProgress = progress;
+    progress = false;
+
+    JobResources resources;
+    int maxRunning = max(1, resources.GetCPUCount());
+    MThreadPool pool("RebuildSeekTables");
+    pool.setMaxThreadCount(maxRunning);
+
+    uint total = pending.size();
+    uint started = 0;
+
+    QMutexLocker locker(&rebuildLock);
+    while (!pending.isEmpty() || !rebuildsRunning.isEmpty())
+    {
+        locker.unlock();
+        resources.Sample();
+        locker.relock();
+
+        int running = 0;
+        QMap<quint64, int>::const_iterator rit = rebuildsRunning.begin();
+        for (; rit != rebuildsRunning.end(); ++rit)
+            running += *rit;
+
+        // The sample does not show rebuilds started since it was taken,
+        // so start at most one more per disk and CPU each time round.
+        double idleCPUs = resources.GetCPUIdle() * resources.GetCPUCount();
+        QList<quint64> startedOn;
+
+        for (int i = 0; (i < pending.size()) && (running < maxRunning); )
+        {
+            quint64 disk = pendingDisks[i];
+            bool busy = startedOn.contains(disk);
+            if (!busy && rebuildsRunning.contains(disk))
+            {
+                busy = (disk == kRemoteDisk) || (idleCPUs < 1.0) ||
+                    (resources.GetDiskBusy(disk) > 0.8);
+            }
+            if (busy)
+            {
+                i++;
+                continue;
+            }
+
+            ProgramInfo pginfo = pending.takeAt(i);
+            pendingDisks.removeAt(i);
+
+            if (showProgress)
+            {
+                cerr << QString("Rebuilding seektable %1/%2: %3")
+                    .arg(++started).arg(total)
+                    .arg(get_filename(&pginfo)).toLocal8Bit().constData()
+                     << endl;
+            }
+
+            rebuildsRunning[disk]++;
+            running++;
+            idleCPUs -= 1.0;
+            startedOn.push_back(disk);
+            pool.start(new SeekTableRebuilder(pginfo, disk),
+                       "RebuildSeekTable");
+        }
+
+        rebuildDone.wait(&rebuildLock, 1000);
+    }
+    locker.unlock();
+
+    pool.waitForDone();
+    progress = showProgress;
+
+    if (rebuildFailures)
+    {
+        LOG(VB_GENERAL, LOG_ERR, QString("Failed to rebuild %1 of %2 "
+                                         "seektables").arg(rebuildFailures)
+                                                      .arg(total));
+        return GENERIC_EXIT_NOT_OK;
+    }
+
+    return GENERIC_EXIT_OK;
+}
+
 int main(int argc, char *argv[])
 {
     int result = GENERIC_EXIT_OK;
@@ -1319,6 +1528,11 @@ int main(int argc, char *argv[])
         }
 
     }
+    else if (cmdline.toBool("allrecordings"))
+    {
+        // rebuild the seektables of all recordings
+        result = RebuildAllSeekTables();
+    }
     else
     {
         LOG(VB_GENERAL, LOG_ERR,
@@ -1170,6 +1170,21 @@ HostCheckBox *AudioAdvancedSettings::SRCQualityOverride()
     return gc;
 }
 
+HostCheckBox *AudioAdvancedSettings::AudioDSPThread()
+{
+    HostCheckBox *gc = new HostCheckBox("AudioDSPThread");
+
+    gc->setLabel(tr("Separate audio processing thread"));
+
+    gc->setValue(true);
+
+    gc->setHelpText(tr("Run time stretch, upmixing and AC-3 encoding on "
+                       "their own thread so they don't slow down video "
+                       "decoding. Disable to reduce audio latency on fast "
+                       "systems."));
+    return gc;
+}
+
 HostComboBox *AudioAdvancedSettings::SRCQuality()
 {
     HostComboBox *gc = new HostComboBox("SRCQuality", false);
@@ -1301,6 +1316,7 @@ AudioAdvancedSettings::AudioAdvancedSettings(bool mpcm)
     ConfigurationGroup *settings6 =
         new HorizontalConfigurationGroup(false, false);
     settings6->addChild(HBRPassthrough());
+    settings6->addChild(AudioDSPThread());
 
     addChild(settings4);
     addChild(settings5);
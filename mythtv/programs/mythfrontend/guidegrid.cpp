@@ -235,6 +235,8 @@ GuideGrid::GuideGrid(MythScreenStack *parent,
            m_channelCount(5),
            m_timeCount(30),
            m_verticalLayout(false),
+           m_rowSize(0.0),
+           m_colSize(0.0),
            m_player(player),
            m_usingNullVideo(false),
            m_embedVideo(embedVideo),
@@ -258,7 +260,7 @@ GuideGrid::GuideGrid(MythScreenStack *parent,
             this,                     SLOT(refreshVideo()));
 
     for (uint i = 0; i < MAX_DISPLAY_CHANS; i++)
-        m_programs.push_back(NULL);
+        m_programs[i] = NULL;
 
     for (int x = 0; x < MAX_DISPLAY_TIMES; ++x)
     {
@@ -315,6 +317,22 @@ bool GuideGrid::Create()
     m_timeCount = m_guideGrid->getTimeCount() * 6;
     m_verticalLayout = m_guideGrid->isVerticalLayout();
 
+    // The cell geometry only depends on the grid area, so work it out once
+    // instead of on every row fill. Use doubles to avoid large gaps at end.
+    m_programRect = m_guideGrid->GetArea();
+    if (m_verticalLayout)
+    {
+        m_rowSize = m_programRect.width() /
+            (double) m_guideGrid->getChannelCount();
+        m_colSize = m_programRect.height() / (double) m_timeCount;
+    }
+    else
+    {
+        m_rowSize = m_programRect.height() /
+            (double) m_guideGrid->getChannelCount();
+        m_colSize = m_programRect.width() / (double) m_timeCount;
+    }
+
     m_currentEndTime = m_currentStartTime.addSecs(m_timeCount * 60 * 5);
 
     LoadInBackground();
@@ -324,6 +342,7 @@ bool GuideGrid::Create()
 void GuideGrid::Load(void)
 {
     LoadFromScheduler(m_recList);
+    m_programCache.SetScheduleList(m_recList);
     fillChannelInfos();
 
     int maxchannel = max((int)GetChannelCount() - 1, 0);
@@ -341,7 +360,6 @@ void GuideGrid::Load(void)
         if (chanNum < 0)
             chanNum = 0;
 
-        delete m_programs[y];
         m_programs[y] = getProgramListFromProgram(chanNum);
     }
 }
@@ -376,13 +394,6 @@ GuideGrid::~GuideGrid()
 {
     gCoreContext->removeListener(this);
 
-    while (!m_programs.empty())
-    {
-        if (m_programs.back())
-            delete m_programs.back();
-        m_programs.pop_back();
-    }
-
     m_channelInfos.clear();
 
     if (m_updateTimer)
@@ -867,6 +878,7 @@ ChannelInfoList GuideGrid::GetSelection(void) const
 void GuideGrid::updateTimeout(void)
 {
     m_updateTimer->stop();
+    m_programCache.Clear();
     fillProgramInfos();
     m_updateTimer->start((int)(60 * 1000));
 }
@@ -1077,33 +1089,96 @@ void GuideGrid::fillProgramInfos(bool useExistingData)
 {
     m_guideGrid->ResetData();
 
+    if (!useExistingData)
+    {
+        vector<uint> visible;
+        for (int y = 0; y < m_channelCount; ++y)
+        {
+            m_programs[y] = NULL;
+            const ChannelInfo *chinfo =
+                GetChannelInfo(GetStartChannelOffset(y));
+            if (chinfo)
+                visible.push_back(chinfo->chanid);
+        }
+        m_programCache.Trim(visible);
+    }
+
     for (int y = 0; y < m_channelCount; ++y)
     {
         fillProgramRowInfos(y, useExistingData);
     }
 }
 
+/** \brief Returns the cached programs for the channel at chanNum
+ *         covering the visible time window, loading them if needed.
+ *  \note The list is owned by m_programCache.
+ */
 ProgramList *GuideGrid::getProgramListFromProgram(int chanNum)
 {
-    ProgramList *proglist = new ProgramList();
+    const ChannelInfo *chinfo = GetChannelInfo(chanNum);
+    if (!chinfo)
+        return NULL;
+
+    return m_programCache.Get(chinfo->chanid,
+                              m_currentStartTime, m_currentEndTime);
+}
 
-    if (proglist)
+/** \brief Asks m_programCache to load the rows or time window the user
+ *         is likely to move to next, based on the last movement.
+ */
+void GuideGrid::prefetchProgramInfos(MoveVector movement)
+{
+    uint cnt = GetChannelCount();
+    if (!cnt || m_channelCount <= 0)
+        return;
+
+    int span = m_currentStartTime.secsTo(m_currentEndTime);
+    QDateTime start = m_currentStartTime;
+    QDateTime end   = m_currentEndTime;
+    int first = 0;
+
+    switch (movement)
     {
-        MSqlBindings bindings;
-        QString querystr = "WHERE program.chanid = :CHANID "
-                           "  AND program.endtime >= :STARTTS "
-                           "  AND program.starttime <= :ENDTS "
-                           "  AND program.manualid = 0 ";
-        bindings[":CHANID"]  = GetChannelInfo(chanNum)->chanid;
-        bindings[":STARTTS"] =
-            m_currentStartTime.addSecs(0 - m_currentStartTime.time().second());
-        bindings[":ENDTS"] =
-            m_currentEndTime.addSecs(0 - m_currentEndTime.time().second());
+        case kScrollUp :
+        case kPageUp :
+            first = -m_channelCount;
+            break;
+        case kScrollDown :
+        case kPageDown :
+            first = m_channelCount;
+            break;
+        case kScrollLeft :
+        case kPageLeft :
+            start = start.addSecs(-span);
+            end   = end.addSecs(-span);
+            break;
+        case kScrollRight :
+        case kPageRight :
+            start = start.addSecs(span);
+            end   = end.addSecs(span);
+            break;
+        case kDayLeft :
+            start = start.addSecs(-24 * 60 * 60);
+            end   = end.addSecs(-24 * 60 * 60);
+            break;
+        case kDayRight :
+            start = start.addSecs(24 * 60 * 60);
+            end   = end.addSecs(24 * 60 * 60);
+            break;
+    }
 
-        LoadFromProgram(*proglist, querystr, bindings, m_recList);
+    vector<uint> chanids;
+    for (int y = 0; y < m_channelCount && y < (int)cnt; ++y)
+    {
+        int idx = ((int)m_currentStartChannel + first + y) % (int)cnt;
+        if (idx < 0)
+            idx += cnt;
+        const ChannelInfo *chinfo = GetChannelInfo(idx);
+        if (chinfo)
+            chanids.push_back(chinfo->chanid);
     }
 
-    return proglist;
+    m_programCache.Prefetch(chanids, start, end);
 }
 
 void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
@@ -1118,6 +1193,7 @@ void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
     {
         m_programInfos[row][x] = NULL;
     }
+    m_unknownPrograms[row].clear();
 
     if (m_channelInfos.empty())
         return;
@@ -1131,11 +1207,8 @@ void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
     if (chanNum < 0)
         chanNum = 0;
 
-    if (!useExistingData)
-    {
-        delete m_programs[row];
+    if (!useExistingData || !m_programs[row])
         m_programs[row] = getProgramListFromProgram(chanNum);
-    }
 
     ProgramList *proglist = m_programs[row];
     if (!proglist)
@@ -1159,14 +1232,15 @@ void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
 
     m_guideGrid->SetProgPast(progPast);
 
+    // The cached list covers a wider window than is visible, so skip
+    // over everything that ends before the column being filled.
     ProgramList::iterator program = proglist->begin();
-    vector<ProgramInfo*> unknownlist;
     bool unknown = false;
     ProgramInfo *proginfo = NULL;
     for (int x = 0; x < m_timeCount; ++x)
     {
-        if (program != proglist->end() &&
-            (ts >= (*program)->GetScheduledEndTime()))
+        while (program != proglist->end() &&
+               (ts >= (*program)->GetScheduledEndTime()))
         {
             ++program;
         }
@@ -1184,7 +1258,7 @@ void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
             {
                 proginfo = new ProgramInfo(kUnknownTitle, kUnknownCategory,
                                            ts, ts.addSecs(5*60));
-                unknownlist.push_back(proginfo);
+                m_unknownPrograms[row].push_back(proginfo);
                 proginfo->startCol = x;
                 proginfo->spread = 1;
                 unknown = true;
@@ -1211,29 +1285,8 @@ void GuideGrid::fillProgramRowInfos(unsigned int row, bool useExistingData)
         ts = ts.addSecs(5 * 60);
     }
 
-    vector<ProgramInfo*>::iterator it = unknownlist.begin();
-    for (; it != unknownlist.end(); ++it)
-        proglist->push_back(*it);
-
-    MythRect programRect = m_guideGrid->GetArea();
-
-    /// use doubles to avoid large gaps at end..
-    double ydifference = 0.0, xdifference = 0.0;
-
-    if (m_verticalLayout)
-    {
-        ydifference = programRect.width() /
-            (double) m_guideGrid->getChannelCount();
-        xdifference = programRect.height() /
-            (double) m_timeCount;
-    }
-    else
-    {
-        ydifference = programRect.height() /
-            (double) m_guideGrid->getChannelCount();
-        xdifference = programRect.width() /
-            (double) m_timeCount;
-    }
+    const MythRect &programRect = m_programRect;
+    double ydifference = m_rowSize, xdifference = m_colSize;
 
     int arrow = 0;
     int cnt = 0;
@@ -1370,6 +1423,7 @@ void GuideGrid::customEvent(QEvent *event)
         if (message == "SCHEDULE_CHANGE")
         {
             LoadFromScheduler(m_recList);
+            m_programCache.SetScheduleList(m_recList);
             fillProgramInfos();
             updateInfo();
         }
@@ -1679,6 +1733,7 @@ void GuideGrid::generateListings()
     m_channelCount = min(m_guideGrid->getChannelCount(), maxchannel + 1);
 
     LoadFromScheduler(m_recList);
+    m_programCache.SetScheduleList(m_recList);
     fillProgramInfos();
 }
 
@@ -1898,6 +1953,7 @@ void GuideGrid::moveLeftRight(MoveVector movement)
     m_guideGrid->SetRedraw();
     updateInfo();
     updateDateText();
+    prefetchProgramInfos(movement);
 }
 
 void GuideGrid::moveUpDown(MoveVector movement)
@@ -1924,6 +1980,7 @@ void GuideGrid::moveUpDown(MoveVector movement)
     m_guideGrid->SetRedraw();
     updateInfo();
     updateChannels();
+    prefetchProgramInfos(movement);
 }
 
 void GuideGrid::moveToTime(QDateTime datetime)
@@ -2003,6 +2060,7 @@ void GuideGrid::quickRecord()
 
     QuickRecord(pginfo);
     LoadFromScheduler(m_recList);
+    m_programCache.SetScheduleList(m_recList);
     fillProgramInfos();
     updateInfo();
 }
@@ -20,6 +20,7 @@ using namespace std;
 
 // mythfrontend
 #include "schedulecommon.h"
+#include "guideprogramcache.h"
 
 using namespace std;
 
@@ -180,6 +181,7 @@ class GuideGrid : public ScheduleCommon, public JumpToChannelListener
     void fillTimeInfos(void);
     void fillProgramInfos(bool useExistingData = false);
     void fillProgramRowInfos(unsigned int row, bool useExistingData = false);
+    void prefetchProgramInfos(MoveVector movement);
     ProgramList *getProgramListFromProgram(int chanNum);
 
     void setStartChannel(int newStartChannel);
@@ -200,7 +202,9 @@ class GuideGrid : public ScheduleCommon, public JumpToChannelListener
     db_chan_list_list_t m_channelInfos;
     QMap<uint,uint>      m_channelInfoIdx;
 
-    vector<ProgramList*> m_programs;
+    GuideProgramCache m_programCache;
+    ProgramList *m_programs[MAX_DISPLAY_CHANS];
+    ProgramList  m_unknownPrograms[MAX_DISPLAY_CHANS];
     ProgramInfo *m_programInfos[MAX_DISPLAY_CHANS][MAX_DISPLAY_TIMES];
     ProgramList  m_recList;
 
@@ -220,6 +224,10 @@ class GuideGrid : public ScheduleCommon, public JumpToChannelListener
     int  m_timeCount;
     bool m_verticalLayout;
 
+    MythRect m_programRect;
+    double   m_rowSize;
+    double   m_colSize;
+
     QDateTime m_firstTime;
     QDateTime m_lastTime;
 
@@ -0,0 +1,286 @@
+// -*- Mode: c++ -*-
+// vim:set sw=4 ts=4 expandtab:
+
+// C++ headers
+#include <algorithm>
+using namespace std;
+
+// Qt headers
+#include <QRunnable>
+
+// MythTV headers
+#include "guideprogramcache.h"
+#include "mthreadpool.h"
+#include "mythlogging.h"
+#include "mythdbcon.h"
+
+#define LOC QString("GuideCache: ")
+
+class GuideProgramLoader : public QRunnable
+{
+  public:
+    GuideProgramLoader(GuideProgramCache &c) : m_cache(c) {}
+
+    void run(void)
+    {
+        m_cache.RunLoader();
+    }
+
+    GuideProgramCache &m_cache;
+};
+
+GuideProgramCache::GuideProgramCache() :
+    m_useCounter(0), m_load_is_queued(false), m_loads_in_progress(0)
+{
+}
+
+GuideProgramCache::~GuideProgramCache()
+{
+    QMutexLocker locker(&m_lock);
+
+    m_requests.clear();
+    while (m_loads_in_progress)
+        m_load_wait.wait(&m_lock);
+
+    ClearEntries(m_entries);
+    ClearEntries(m_pending);
+}
+
+void GuideProgramCache::ClearEntries(EntryMap &entries)
+{
+    EntryMap::iterator it = entries.begin();
+    for (; it != entries.end(); ++it)
+        delete (*it).list;
+    entries.clear();
+}
+
+/** \brief Replaces the scheduler list used to set the recording status
+ *         of loaded programs, and drops everything that was loaded with
+ *         the old list.
+ */
+void GuideProgramCache::SetScheduleList(const ProgramList &schedList)
+{
+    QMutexLocker locker(&m_lock);
+
+    m_requests.clear();
+    while (m_loads_in_progress)
+        m_load_wait.wait(&m_lock);
+
+    m_schedList.clear();
+    ProgramList::const_iterator it = schedList.begin();
+    for (; it != schedList.end(); ++it)
+        m_schedList.push_back(new ProgramInfo(**it));
+
+    ClearEntries(m_entries);
+    ClearEntries(m_pending);
+}
+
+/** \brief Returns the programs on chanid overlapping [start, end].
+ *
+ *  The list is served from memory if it has been loaded or prefetched
+ *  already, otherwise it is loaded from the database before returning.
+ *  The returned list may contain programs outside the requested window.
+ */
+ProgramList *GuideProgramCache::Get(
+    uint chanid, const QDateTime &start, const QDateTime &end)
+{
+    QMutexLocker locker(&m_lock);
+
+    EntryMap::iterator it = m_entries.find(chanid);
+    if (it != m_entries.end() && (*it).Covers(start, end))
+    {
+        (*it).lastUse = ++m_useCounter;
+        return (*it).list;
+    }
+
+    EntryMap::iterator pit = m_pending.find(chanid);
+    if (pit != m_pending.end() && (*pit).Covers(start, end))
+    {
+        if (it != m_entries.end())
+            delete (*it).list;
+        Entry entry = *pit;
+        m_pending.erase(pit);
+        entry.lastUse = ++m_useCounter;
+        m_entries[chanid] = entry;
+        return entry.list;
+    }
+
+    m_loads_in_progress++;
+    locker.unlock();
+
+    int span = start.secsTo(end);
+    QDateTime wstart = start.addSecs(-span);
+    QDateTime wend   = end.addSecs(span);
+    ProgramList *list = Load(chanid, wstart, wend);
+
+    locker.relock();
+    m_loads_in_progress--;
+    m_load_wait.wakeAll();
+
+    it = m_entries.find(chanid);
+    if (it != m_entries.end())
+        delete (*it).list;
+
+    Entry entry(list, wstart, wend);
+    entry.lastUse = ++m_useCounter;
+    m_entries[chanid] = entry;
+
+    return list;
+}
+
+/** \brief Queues loading of the given channels for [start, end] on a pool
+ *         thread, skipping channels which are already in memory.
+ *
+ *  Any prefetch requests that have not been started yet are discarded,
+ *  so only the most recent direction of travel is loaded.
+ */
+void GuideProgramCache::Prefetch(
+    const vector<uint> &chanids, const QDateTime &start, const QDateTime &end)
+{
+    QMutexLocker locker(&m_lock);
+
+    m_requests.clear();
+
+    vector<uint>::const_iterator it = chanids.begin();
+    for (; it != chanids.end(); ++it)
+    {
+        EntryMap::const_iterator eit = m_entries.find(*it);
+        if (eit != m_entries.end() && (*eit).Covers(start, end))
+            continue;
+        EntryMap::const_iterator pit = m_pending.find(*it);
+        if (pit != m_pending.end() && (*pit).Covers(start, end))
+            continue;
+        m_requests.push_back(Request(*it, start, end));
+    }
+
+    if (!m_requests.empty() && !m_load_is_queued)
+    {
+        m_load_is_queued = true;
+        m_loads_in_progress++;
+        MThreadPool::globalInstance()->start(
+            new GuideProgramLoader(*this), "GuideProgramLoader");
+    }
+}
+
+void GuideProgramCache::RunLoader(void)
+{
+    QMutexLocker locker(&m_lock);
+
+    while (!m_requests.empty())
+    {
+        Request req = m_requests.takeFirst();
+
+        int span = req.start.secsTo(req.end);
+        QDateTime wstart = req.start.addSecs(-span);
+        QDateTime wend   = req.end.addSecs(span);
+
+        locker.unlock();
+        ProgramList *list = Load(req.chanid, wstart, wend);
+        locker.relock();
+
+        EntryMap::iterator it = m_pending.find(req.chanid);
+        if (it != m_pending.end())
+            delete (*it).list;
+        m_pending[req.chanid] = Entry(list, wstart, wend);
+    }
+
+    m_load_is_queued = false;
+    m_loads_in_progress--;
+    m_load_wait.wakeAll();
+}
+
+/** \brief Moves completed prefetches into the cache and evicts the least
+ *         recently used channels beyond kMaxCachedChannels.
+ *
+ *  Channels listed in keep are never evicted.
+ *  \note This invalidates ProgramInfo pointers previously returned by Get().
+ */
+void GuideProgramCache::Trim(const vector<uint> &keep)
+{
+    QMutexLocker locker(&m_lock);
+
+    EntryMap::iterator it = m_pending.begin();
+    for (; it != m_pending.end(); ++it)
+    {
+        EntryMap::iterator eit = m_entries.find(it.key());
+        if (eit != m_entries.end())
+        {
+            (*it).lastUse = (*eit).lastUse;
+            delete (*eit).list;
+        }
+        else
+        {
+            (*it).lastUse = ++m_useCounter;
+        }
+        m_entries[it.key()] = *it;
+    }
+    m_pending.clear();
+
+    if ((uint)m_entries.size() <= kMaxCachedChannels)
+        return;
+
+    vector<uint64_t> uses;
+    for (it = m_entries.begin(); it != m_entries.end(); ++it)
+        uses.push_back((*it).lastUse);
+    sort(uses.begin(), uses.end());
+    uint64_t threshold = uses[uses.size() - kMaxCachedChannels];
+
+    it = m_entries.begin();
+    while (it != m_entries.end())
+    {
+        if ((*it).lastUse < threshold &&
+            find(keep.begin(), keep.end(), it.key()) == keep.end())
+        {
+            delete (*it).list;
+            it = m_entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void GuideProgramCache::Clear(void)
+{
+    QMutexLocker locker(&m_lock);
+
+    m_requests.clear();
+    while (m_loads_in_progress)
+        m_load_wait.wait(&m_lock);
+
+    ClearEntries(m_entries);
+    ClearEntries(m_pending);
+}
+
+void GuideProgramCache::WaitForLoadToComplete(void) const
+{
+    QMutexLocker locker(&m_lock);
+    while (m_loads_in_progress)
+        m_load_wait.wait(&m_lock);
+}
+
+/// \note m_schedList is only replaced while no loads are in progress,
+///       so it is safe to read here without holding m_lock.
+ProgramList *GuideProgramCache::Load(
+    uint chanid, const QDateTime &start, const QDateTime &end) const
+{
+    ProgramList *proglist = new ProgramList();
+
+    MSqlBindings bindings;
+    QString querystr = "WHERE program.chanid = :CHANID "
+                       "  AND program.endtime >= :STARTTS "
+                       "  AND program.starttime <= :ENDTS "
+                       "  AND program.manualid = 0 ";
+    bindings[":CHANID"]  = chanid;
+    bindings[":STARTTS"] = start.addSecs(0 - start.time().second());
+    bindings[":ENDTS"]   = end.addSecs(0 - end.time().second());
+
+    if (!LoadFromProgram(*proglist, querystr, bindings, m_schedList))
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Failed to load programs for chanid %1").arg(chanid));
+    }
+
+    return proglist;
+}
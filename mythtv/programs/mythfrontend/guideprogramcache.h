@@ -0,0 +1,105 @@
+// -*- Mode: c++ -*-
+// vim:set sw=4 ts=4 expandtab:
+#ifndef _GUIDE_PROGRAM_CACHE_H_
+#define _GUIDE_PROGRAM_CACHE_H_
+
+// C++ headers
+#include <vector>
+using namespace std;
+
+// Qt headers
+#include <QWaitCondition>
+#include <QDateTime>
+#include <QMutex>
+#include <QList>
+#include <QMap>
+
+// MythTV headers
+#include "programinfo.h"
+
+class GuideProgramLoader;
+
+/** \class GuideProgramCache
+ *  \brief Sliding window of program guide rows.
+ *
+ *  Each channel's program list is loaded for a time window that is three
+ *  times as wide as the visible guide span, so that scrolling and paging
+ *  left or right can usually be served from memory. Rows that are about
+ *  to come into view can be loaded ahead of time on a pool thread with
+ *  Prefetch(); the results are picked up by the next Get() or Trim().
+ *
+ *  The ProgramInfo pointers handed out by Get() remain valid until the
+ *  next call to Trim(), Clear() or SetScheduleList(), or until Get() is
+ *  called for the same channel with a window that is not cached.
+ */
+class GuideProgramCache
+{
+    friend class GuideProgramLoader;
+
+  public:
+    GuideProgramCache();
+    ~GuideProgramCache();
+
+    void SetScheduleList(const ProgramList &schedList);
+
+    ProgramList *Get(uint chanid,
+                     const QDateTime &start, const QDateTime &end);
+    void Prefetch(const vector<uint> &chanids,
+                  const QDateTime &start, const QDateTime &end);
+    void Trim(const vector<uint> &keep);
+    void Clear(void);
+
+    void WaitForLoadToComplete(void) const;
+
+  private:
+    class Entry
+    {
+      public:
+        Entry() : list(NULL), lastUse(0) {}
+        Entry(ProgramList *l, const QDateTime &s, const QDateTime &e) :
+            list(l), start(s), end(e), lastUse(0) {}
+
+        bool Covers(const QDateTime &s, const QDateTime &e) const
+            { return list && start <= s && end >= e; }
+
+        ProgramList *list;
+        QDateTime    start;
+        QDateTime    end;
+        uint64_t     lastUse;
+    };
+
+    class Request
+    {
+      public:
+        Request() : chanid(0) {}
+        Request(uint c, const QDateTime &s, const QDateTime &e) :
+            chanid(c), start(s), end(e) {}
+
+        uint      chanid;
+        QDateTime start;
+        QDateTime end;
+    };
+
+    typedef QMap<uint,Entry> EntryMap;
+
+    ProgramList *Load(uint chanid,
+                      const QDateTime &start, const QDateTime &end) const;
+    void RunLoader(void);
+    static void ClearEntries(EntryMap &entries);
+
+  private:
+    mutable QMutex          m_lock;
+    EntryMap                m_entries;
+    EntryMap                m_pending;
+    QList<Request>          m_requests;
+    ProgramList             m_schedList;
+    uint64_t                m_useCounter;
+    bool                    m_load_is_queued;
+    uint                    m_loads_in_progress;
+    mutable QWaitCondition  m_load_wait;
+
+    /// Upper bound on the number of channels kept in memory
+    static const uint kMaxCachedChannels = 256;
+};
+
+#endif // _GUIDE_PROGRAM_CACHE_H_
@@ -31,7 +31,11 @@ void MythTranscodeCommandLineParser::LoadArguments(void)
     add("--audiotrack", "audiotrack", 0, "Select specific audio track.", "")
         ->SetGroup("Encoding");
     add(QStringList( QStringList() << "-m" << "--mpeg2" ), "mpeg2", false,
-            "Specifies that a lossless transcode should be used.", "")
+            "Specifies that a lossless transcode should be used.",
+            "H.264 transport streams are copied between key frames, "
+            "and only the GOPs split by a cut are re-encoded. Where "
+            "that isn't possible up to one GOP of cut material can "
+            "remain at the edges of the cut.")
         ->SetGroup("Encoding");
     add(QStringList( QStringList() << "-e" << "--ostream" ), "ostream", "",
             "Output stream type: dvd, ts", "")
@@ -109,5 +113,13 @@ void MythTranscodeCommandLineParser::LoadArguments(void)
         ->SetChildOf("hls");
     add("--hlsstreamid", "hlsstreamid", -1, "Stream ID to process", "")
         ->SetChildOf("hls");
+    add("--hlsrenditions", "hlsrenditions", "",
+            "Additional HTTP Live Stream bitrates to encode from the same "
+            "decode.",
+            "Comma separated list of WIDTHxHEIGHT@KBITS, for example "
+            "'1280x720@2000,416x0@200'. A width or height of 0 is "
+            "calculated from the source aspect ratio. Defaults to the "
+            "HTTPLiveStreamRenditions setting.")
+        ->SetChildOf("hls");
 }
 
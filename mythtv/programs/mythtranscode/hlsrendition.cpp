@@ -0,0 +1,278 @@
+#include <cstring>
+
+#include <QRunnable>
+
+#include "hlsrendition.h"
+#include "avformatwriter.h"
+#include "HLS/httplivestream.h"
+#include "mthreadpool.h"
+#include "mythlogging.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libswscale/swscale.h"
+#include "libavutil/mem.h"
+}
+
+#define LOC QString("HLSRendition(%1x%2): ").arg(m_width).arg(m_height)
+
+class HLSRenditionRunner : public QRunnable
+{
+  public:
+    HLSRenditionRunner(HLSRendition &r) : m_rendition(r) {}
+
+    void run(void)
+    {
+        m_rendition.run();
+    }
+
+    HLSRendition &m_rendition;
+};
+
+HLSSourceFrame::HLSSourceFrame(const unsigned char *buf, int width,
+                               int height, long long timecode,
+                               long long frameNumber)
+  : m_buf(NULL),              m_width(width),
+    m_height(height),         m_timecode(timecode),
+    m_frameNumber(frameNumber), m_ref(1)
+{
+    int size = width * height * 3 / 2;
+    m_buf = (unsigned char *)av_malloc(size);
+    if (m_buf)
+        memcpy(m_buf, buf, size);
+}
+
+HLSSourceFrame::~HLSSourceFrame()
+{
+    av_free(m_buf);
+}
+
+void HLSSourceFrame::DecrRef(void)
+{
+    if (!m_ref.deref())
+        delete this;
+}
+
+HLSRendition::HLSRendition(HTTPLiveStream *hls, AVFormatWriter *avfw,
+                           int width, int height, int segmentFrames,
+                           int maxQueued)
+  : m_hls(hls),               m_avfw(avfw),
+    m_width(width),           m_height(height),
+    m_segmentFrames(segmentFrames),
+    m_framesInSegment(0),     m_maxQueued(maxQueued),
+    m_scontext(NULL),
+    m_scaledBuf((unsigned char *)av_malloc(width * height * 3 / 2)),
+    m_finishing(false),       m_isRunning(false),
+    m_errored(false),         m_framesEncoded(0),
+    m_encodeMSecs(0)
+{
+}
+
+/// \note Finish() must have been called before the rendition is deleted.
+HLSRendition::~HLSRendition()
+{
+    if (m_avfw)
+    {
+        m_avfw->CloseFile();
+        delete m_avfw;
+    }
+
+    // Deleting the stream writes the final playlist with the end tag.
+    delete m_hls;
+
+    if (m_scontext)
+        sws_freeContext(m_scontext);
+    av_free(m_scaledBuf);
+}
+
+void HLSRendition::Start(void)
+{
+    QMutexLocker locker(&m_queueLock);
+    m_isRunning = true;
+    MThreadPool::globalInstance()->startReserved(
+        new HLSRenditionRunner(*this), "HLSRendition");
+}
+
+/** \brief Waits for all queued frames to be encoded and stops the
+ *         encoding thread.
+ */
+void HLSRendition::Finish(void)
+{
+    QMutexLocker locker(&m_queueLock);
+    m_finishing = true;
+    m_queueCond.wakeAll();
+
+    while (m_isRunning)
+        m_queueCond.wait(&m_queueLock);
+}
+
+/** \brief Queues a decoded frame for this rendition, blocking while the
+ *         rendition is more than m_maxQueued frames behind.
+ *
+ *  The slowest rendition thereby paces the decoder, which keeps memory
+ *  use bounded.
+ */
+void HLSRendition::AddVideoFrame(HLSSourceFrame *frame)
+{
+    frame->IncrRef();
+
+    HLSQueueItem item;
+    item.frame      = frame;
+    item.audioFrame = 0;
+    item.timecode   = frame->m_timecode;
+    Enqueue(item);
+}
+
+void HLSRendition::AddAudioFrame(const unsigned char *buf, int len,
+                                 int fnum, long long timecode)
+{
+    HLSQueueItem item;
+    item.frame      = NULL;
+    item.audio      = QByteArray((const char *)buf, len);
+    item.audioFrame = fnum;
+    item.timecode   = timecode;
+    Enqueue(item);
+}
+
+void HLSRendition::Enqueue(const HLSQueueItem &item)
+{
+    QMutexLocker locker(&m_queueLock);
+
+    while (m_isRunning && !m_errored && m_queue.size() >= m_maxQueued)
+        m_queueCond.wait(&m_queueLock);
+
+    if (!m_isRunning || m_errored)
+    {
+        if (item.frame)
+            item.frame->DecrRef();
+        return;
+    }
+
+    m_queue.push_back(item);
+    m_queueCond.wakeAll();
+}
+
+long long HLSRendition::GetFramesEncoded(void) const
+{
+    QMutexLocker locker(&m_queueLock);
+    return m_framesEncoded;
+}
+
+/// \brief Returns the frames per second this rendition spent encoding,
+///        excluding time spent waiting for the decoder.
+float HLSRendition::GetEncodeFPS(void) const
+{
+    QMutexLocker locker(&m_queueLock);
+    if (!m_encodeMSecs)
+        return 0.0f;
+    return m_framesEncoded * 1000.0f / m_encodeMSecs;
+}
+
+void HLSRendition::run(void)
+{
+    QMutexLocker locker(&m_queueLock);
+
+    while (true)
+    {
+        while (m_queue.isEmpty() && !m_finishing)
+            m_queueCond.wait(&m_queueLock);
+
+        if (m_queue.isEmpty() || m_errored)
+            break;
+
+        HLSQueueItem item = m_queue.takeFirst();
+        m_queueCond.wakeAll();
+        locker.unlock();
+
+        m_encodeTime.start();
+        if (item.frame)
+        {
+            EncodeVideo(item.frame);
+            item.frame->DecrRef();
+        }
+        else
+        {
+            long long tc = item.timecode;
+            m_avfw->WriteAudioFrame((unsigned char *)item.audio.data(),
+                                    item.audioFrame, tc);
+        }
+        int elapsed = m_encodeTime.elapsed();
+
+        locker.relock();
+        m_encodeMSecs += elapsed;
+        if (item.frame)
+            ++m_framesEncoded;
+    }
+
+    // Drop anything still queued after an error
+    while (!m_queue.isEmpty())
+    {
+        HLSQueueItem item = m_queue.takeFirst();
+        if (item.frame)
+            item.frame->DecrRef();
+    }
+
+    m_isRunning = false;
+    m_queueCond.wakeAll();
+}
+
+void HLSRendition::EncodeVideo(HLSSourceFrame *src)
+{
+    if (!src->m_buf || !m_scaledBuf)
+        return;
+
+    VideoFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.codec       = FMT_YV12;
+    frame.width       = m_width;
+    frame.height      = m_height;
+    frame.size        = m_width * m_height * 3 / 2;
+    frame.timecode    = src->m_timecode;
+    frame.frameNumber = src->m_frameNumber;
+
+    if ((src->m_width == m_width) && (src->m_height == m_height))
+    {
+        frame.buf = src->m_buf;
+    }
+    else
+    {
+        AVPicture imageIn, imageOut;
+
+        frame.buf = m_scaledBuf;
+        avpicture_fill(&imageIn, src->m_buf, PIX_FMT_YUV420P,
+                       src->m_width, src->m_height);
+        avpicture_fill(&imageOut, frame.buf, PIX_FMT_YUV420P,
+                       m_width, m_height);
+
+        int bottomBand = (src->m_height == 1088) ? 8 : 0;
+        m_scontext = sws_getCachedContext(m_scontext, src->m_width,
+                         src->m_height, PIX_FMT_YUV420P, m_width,
+                         m_height, PIX_FMT_YUV420P,
+                         SWS_FAST_BILINEAR, NULL, NULL, NULL);
+
+        sws_scale(m_scontext, imageIn.data, imageIn.linesize, 0,
+                  src->m_height - bottomBand,
+                  imageOut.data, imageOut.linesize);
+    }
+
+    if ((m_avfw->GetFramesWritten()) &&
+        (m_framesInSegment > m_segmentFrames) &&
+        (m_avfw->NextFrameIsKeyFrame()))
+    {
+        m_hls->AddSegment();
+        if (!m_avfw->ReOpen(m_hls->GetCurrentFilename()))
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + "Unable to open next segment");
+            QMutexLocker locker(&m_queueLock);
+            m_errored = true;
+            m_finishing = true;
+            return;
+        }
+        m_framesInSegment = 0;
+    }
+
+    if (m_avfw->WriteVideoFrame(&frame) > 0)
+        ++m_framesInSegment;
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
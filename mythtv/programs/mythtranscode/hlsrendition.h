@@ -0,0 +1,119 @@
+#ifndef HLSRENDITION_H
+#define HLSRENDITION_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QList>
+#include <QTime>
+
+class HTTPLiveStream;
+class AVFormatWriter;
+struct SwsContext;
+
+/// Size and video bitrate (bits/sec) of one extra HLS rendition
+typedef struct hlsRenditionInfo
+{
+    int width;
+    int height;
+    int bitrate;
+} HLSRenditionInfo;
+
+/** \class HLSSourceFrame
+ *  \brief One decoded YUV420P frame shared by all HLS renditions.
+ *
+ *  The decoder's frame is copied once, and each rendition scales from
+ *  this copy on its own thread. The last rendition to DecrRef() it
+ *  frees it.
+ */
+class HLSSourceFrame
+{
+  public:
+    HLSSourceFrame(const unsigned char *buf, int width, int height,
+                   long long timecode, long long frameNumber);
+
+    void IncrRef(void) { m_ref.ref(); }
+    void DecrRef(void);
+
+    unsigned char *m_buf;
+    int            m_width;
+    int            m_height;
+    long long      m_timecode;
+    long long      m_frameNumber;
+
+  private:
+    ~HLSSourceFrame();
+
+    QAtomicInt     m_ref;
+};
+
+/** \class HLSRendition
+ *  \brief Encodes one extra HTTP Live Stream bitrate on a pool thread.
+ *
+ *  mythtranscode decodes the source once and hands every frame and audio
+ *  block to each HLSRendition, which scales and encodes it into its own
+ *  segments and playlist. Segments are cut on the same frame counts and
+ *  key frame distance as the main stream, so all renditions stay GOP
+ *  aligned with each other.
+ */
+class HLSRendition
+{
+    friend class HLSRenditionRunner;
+
+  public:
+    HLSRendition(HTTPLiveStream *hls, AVFormatWriter *avfw,
+                 int width, int height, int segmentFrames,
+                 int maxQueued = 8);
+   ~HLSRendition();
+
+    void Start(void);
+    void Finish(void);
+
+    void AddVideoFrame(HLSSourceFrame *frame);
+    void AddAudioFrame(const unsigned char *buf, int len, int fnum,
+                       long long timecode);
+
+    HTTPLiveStream *GetStream(void) const { return m_hls; }
+    long long GetFramesEncoded(void) const;
+    float     GetEncodeFPS(void) const;
+    bool      IsErrored(void) const { return m_errored; }
+
+  private:
+    typedef struct hlsQueueItem
+    {
+        HLSSourceFrame *frame;
+        QByteArray      audio;
+        int             audioFrame;
+        long long       timecode;
+    } HLSQueueItem;
+
+    void Enqueue(const HLSQueueItem &item);
+    void run(void);
+    void EncodeVideo(HLSSourceFrame *src);
+
+    HTTPLiveStream         *m_hls;
+    AVFormatWriter         *m_avfw;
+    int                     m_width;
+    int                     m_height;
+    int                     m_segmentFrames;
+    int                     m_framesInSegment;
+    int                     m_maxQueued;
+
+    struct SwsContext      *m_scontext;
+    unsigned char          *m_scaledBuf;
+
+    mutable QMutex          m_queueLock;
+    QWaitCondition          m_queueCond;
+    QList<HLSQueueItem>     m_queue;
+    bool                    m_finishing;
+    bool                    m_isRunning;
+    bool                    m_errored;
+
+    long long               m_framesEncoded;
+    QTime                   m_encodeTime;
+    int                     m_encodeMSecs;
+};
+
+#endif
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -22,6 +22,7 @@ using namespace std;
 #include "mythdate.h"
 #include "transcode.h"
 #include "mpeg2fix.h"
+#include "tsstreamcutter.h"
 #include "remotefile.h"
 #include "mythtranslation.h"
 #include "mythlogging.h"
@@ -590,6 +591,25 @@ int main(int argc, char *argv[])
             transcode->SetHLSMaxSegments(cmdline.toInt("maxsegments"));
         if (cmdline.toBool("noaudioonly"))
             transcode->DisableAudioOnlyHLS();
+
+        QString renditions = cmdline.toBool("hlsrenditions") ?
+            cmdline.toString("hlsrenditions") :
+            gCoreContext->GetSetting("HTTPLiveStreamRenditions");
+        QStringList renditionList =
+            renditions.split(",", QString::SkipEmptyParts);
+        QStringList::const_iterator it = renditionList.begin();
+        for (; it != renditionList.end(); ++it)
+        {
+            QRegExp re("^\\s*(\\d+)x(\\d+)@(\\d+)\\s*$");
+            if (re.indexIn(*it) < 0)
+            {
+                LOG(VB_GENERAL, LOG_ERR,
+                    QString("Ignoring invalid HLS rendition '%1'").arg(*it));
+                continue;
+            }
+            transcode->AddHLSRendition(re.cap(1).toInt(), re.cap(2).toInt(),
+                                       re.cap(3).toInt() * 1000);
+        }
     }
 
     if (cmdline.toBool("avf") || cmdline.toBool("hls"))
@@ -643,38 +663,62 @@ int main(int argc, char *argv[])
            check_func = &CheckJobQueue;
         }
 
-        MPEG2fixup *m2f = new MPEG2fixup(infile, outfile,
-                                         &deleteMap, NULL, false, false, 20,
-                                         showprogress, otype, update_func,
-                                         check_func);
-
-        if (build_index)
+        if (!build_index && TSStreamCutter::IsH264TS(infile))
         {
-            int err = BuildKeyframeIndex(m2f, infile, posMap, durMap, jobID);
-            if (err)
-                return err;
-            if (update_index)
-                UpdatePositionMap(posMap, durMap, NULL, pginfo);
-            else
-                UpdatePositionMap(posMap, durMap, outfile + QString(".map"), pginfo);
+            // MPEG2fixup only handles MPEG-2 video, so H.264 transport
+            // streams are cut on key frames without re-encoding.
+            LOG(VB_GENERAL, LOG_INFO, "Cutting H.264 stream without re-encoding");
+            frm_pos_map_t inPosMap;
+            pginfo->QueryPositionMap(inPosMap, MARK_GOP_BYFRAME);
+
+            TSStreamCutter tscut(infile, outfile, deleteMap, inPosMap,
+                                 showprogress, update_func, check_func);
+            result = tscut.Start();
+            if (result == REENCODE_OK)
+            {
+                tscut.GetOutputMaps(posMap, durMap);
+                if (update_index)
+                    UpdatePositionMap(posMap, durMap, NULL, pginfo);
+                else
+                    UpdatePositionMap(posMap, durMap, outfile + QString(".map"),
+                                      pginfo);
+            }
         }
         else
         {
-            result = m2f->Start();
-            if (result == REENCODE_OK)
+            MPEG2fixup *m2f = new MPEG2fixup(infile, outfile,
+                                             &deleteMap, NULL, false, false, 20,
+                                             showprogress, otype, update_func,
+                                             check_func);
+
+            if (build_index)
             {
-                result = BuildKeyframeIndex(m2f, outfile, posMap, durMap, jobID);
+                int err = BuildKeyframeIndex(m2f, infile, posMap, durMap, jobID);
+                if (err)
+                    return err;
+                if (update_index)
+                    UpdatePositionMap(posMap, durMap, NULL, pginfo);
+                else
+                    UpdatePositionMap(posMap, durMap, outfile + QString(".map"), pginfo);
+            }
+            else
+            {
+                result = m2f->Start();
                 if (result == REENCODE_OK)
                 {
-                    if (update_index)
-                        UpdatePositionMap(posMap, durMap, NULL, pginfo);
-                    else
-                        UpdatePositionMap(posMap, durMap, outfile + QString(".map"),
-                                          pginfo);
+                    result = BuildKeyframeIndex(m2f, outfile, posMap, durMap, jobID);
+                    if (result == REENCODE_OK)
+                    {
+                        if (update_index)
+                            UpdatePositionMap(posMap, durMap, NULL, pginfo);
+                        else
+                            UpdatePositionMap(posMap, durMap, outfile + QString(".map"),
+                                              pginfo);
+                    }
                 }
             }
+            delete m2f;
         }
-        delete m2f;
     }
 
     if (result == REENCODE_OK)
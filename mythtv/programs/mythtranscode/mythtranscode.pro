@@ -21,11 +21,12 @@ macx: QMAKE_CFLAGS -= -O3 -O2 -O1 -Os
 # Input
 SOURCES += main.cpp transcode.cpp mpeg2fix.cpp helper.c
 SOURCES += audioreencodebuffer.cpp cutter.cpp videodecodebuffer.cpp
-SOURCES += commandlineparser.cpp
+SOURCES += commandlineparser.cpp hlsrendition.cpp tsstreamcutter.cpp
 SOURCES += replex/element.c replex/mpg_common.c replex/multiplex.c \
            replex/pes.c     replex/ringbuffer.c replex/ts.c
 HEADERS += mpeg2fix.h transcodedefs.h commandlineparser.h
-HEADERS += audioreencodebuffer.h cutter.h videodecodebuffer.h
+HEADERS += audioreencodebuffer.h cutter.h videodecodebuffer.h hlsrendition.h
+HEADERS += tsstreamcutter.h
 HEADERS += replex/element.h replex/mpg_common.h replex/multiplex.h \
            replex/pes.h     replex/ringbuffer.h replex/ts.h
 
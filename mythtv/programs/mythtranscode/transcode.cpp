@@ -31,6 +31,7 @@
 #include "HLS/httplivestream.h"
 
 #include "videodecodebuffer.h"
+#include "hlsrendition.h"
 #include "cutter.h"
 #include "audioreencodebuffer.h"
 
@@ -43,6 +44,53 @@ using namespace std;
 
 #define LOC QString("Transcode: ")
 
+static QString GetHLSAudioCodec(void)
+{
+    if (!gCoreContext->GetSetting("HLSAUDIO").isEmpty())
+        return gCoreContext->GetSetting("HLSAUDIO");
+
+#if CONFIG_LIBFAAC_ENCODER
+    return "libfaac";
+#else
+# if CONFIG_LIBMP3LAME_ENCODER
+    return "libmp3lame";
+# else
+    return "aac";
+# endif
+#endif
+}
+
+static void FinishHLSRenditions(QList<HLSRendition*> &renditions,
+                                HTTPLiveStreamStatus status,
+                                const QString &message)
+{
+    // The renditions keep encoding in parallel while we wait on each one
+    QList<HLSRendition*>::iterator it = renditions.begin();
+    for (; it != renditions.end(); ++it)
+        (*it)->Finish();
+
+    while (!renditions.isEmpty())
+    {
+        HLSRendition *rendition = renditions.takeFirst();
+        HTTPLiveStream *stream = rendition->GetStream();
+
+        if (rendition->IsErrored())
+        {
+            stream->UpdateStatus(kHLSStatusErrored);
+            stream->UpdateStatusMessage("Transcoding Errored");
+        }
+        else
+        {
+            stream->UpdateStatus(status);
+            stream->UpdateStatusMessage(message);
+            if (status == kHLSStatusCompleted)
+                stream->UpdatePercentComplete(100);
+        }
+
+        delete rendition;
+    }
+}
+
 Transcode::Transcode(ProgramInfo *pginfo) :
     m_proginfo(pginfo),
     m_recProfile(new RecordingProfile("Transcoders")),
@@ -162,6 +210,102 @@ void Transcode::SetPlayerContext(PlayerContext *player_ctx)
     ctx = player_ctx;
 }
 
+/** \brief Adds another bitrate to be encoded from the same decode in HLS
+ *         mode.
+ *
+ *  A width or height of 0 is calculated from the source aspect ratio.
+ *  \param bitrate Video bitrate in bits/sec
+ */
+void Transcode::AddHLSRendition(int width, int height, int bitrate)
+{
+    HLSRenditionInfo info;
+    info.width   = width;
+    info.height  = height;
+    info.bitrate = bitrate;
+    hlsRenditions.push_back(info);
+}
+
+HLSRendition *Transcode::CreateHLSRendition(const HLSRenditionInfo &info,
+                                            const QString &sourceFile,
+                                            AudioReencodeBuffer *arb,
+                                            float aspect, double frameRate,
+                                            int segmentSize, int segmentFrames,
+                                            int srcWidth, int srcHeight)
+{
+    int width = info.width;
+    int height = info.height;
+
+    if (height == 0 && width > 0)
+        height = (int)(1.0 * width / aspect);
+    else if (width == 0 && height > 0)
+        width = (int)(1.0 * height * aspect);
+    else if (width == 0 && height == 0)
+        return NULL;
+
+    // make sure dimensions are valid for MPEG codecs
+    height = (height + 15) & ~0xF;
+    width  = (width  + 15) & ~0xF;
+
+    HTTPLiveStream *hls = new HTTPLiveStream(sourceFile, width, height,
+                                             info.bitrate, cmdAudioBitrate,
+                                             hlsMaxSegments, segmentSize);
+    if (hls->GetStreamID() == -1)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to create %1x%2 HLS rendition")
+                .arg(width).arg(height));
+        delete hls;
+        return NULL;
+    }
+
+    // The main stream already carries the audio-only variant
+    hls->DisableAudioOnly();
+    hls->UpdateStatus(kHLSStatusStarting);
+    hls->UpdateSizeInfo(width, height, srcWidth, srcHeight);
+
+    if (!hls->InitForWrite())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("InitForWrite() failed for %1x%2 HLS rendition")
+                .arg(width).arg(height));
+        hls->UpdateStatus(kHLSStatusErrored);
+        delete hls;
+        return NULL;
+    }
+
+    AVFormatWriter *avfw = new AVFormatWriter();
+    avfw->SetContainer("mpegts");
+    avfw->SetVideoCodec("libx264");
+    avfw->SetAudioCodec(GetHLSAudioCodec());
+    avfw->SetVideoBitrate(info.bitrate);
+    avfw->SetHeight(height);
+    avfw->SetWidth(width);
+    avfw->SetAspect(aspect);
+    avfw->SetAudioBitrate(cmdAudioBitrate);
+    avfw->SetAudioChannels(arb->m_channels);
+    avfw->SetAudioFrameRate(arb->m_eff_audiorate);
+    avfw->SetAudioFormat(FORMAT_S16);
+    avfw->SetFramerate(frameRate);
+    avfw->SetKeyFrameDist(30);
+    avfw->SetThreadCount(1);
+
+    hls->AddSegment();
+    avfw->SetFilename(hls->GetCurrentFilename());
+
+    if (!avfw->Init() || !avfw->OpenFile())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC +
+            QString("Unable to open writer for %1x%2 HLS rendition")
+                .arg(width).arg(height));
+        hls->UpdateStatus(kHLSStatusErrored);
+        delete avfw;
+        delete hls;
+        return NULL;
+    }
+
+    return new HLSRendition(hls, avfw, width, height, segmentFrames);
+}
+
 static QString get_str_option(RecordingProfile *profile, const QString &name)
 {
     const Setting *setting = profile->byName(name);
@@ -216,6 +360,7 @@ int Transcode::TranscodeFile(const QString &inputname,
     AVFormatWriter *avfw = NULL;
     AVFormatWriter *avfw2 = NULL;
     HTTPLiveStream *hls = NULL;
+    QList<HLSRendition*> renditions;
     int hlsSegmentSize = 0;
     int hlsSegmentFrames = 0;
 
@@ -448,18 +593,7 @@ int Transcode::TranscodeFile(const QString &inputname,
 
                 avfw2->SetContainer("mpegts");
 
-                if (!gCoreContext->GetSetting("HLSAUDIO").isEmpty())
-                    avfw2->SetAudioCodec(gCoreContext->GetSetting("HLSAUDIO"));
-                else
-#if CONFIG_LIBFAAC_ENCODER
-                avfw2->SetAudioCodec("libfaac");
-#else
-# if CONFIG_LIBMP3LAME_ENCODER
-                avfw2->SetAudioCodec("libmp3lame");
-# else
-                avfw2->SetAudioCodec("aac");
-# endif
-#endif
+                avfw2->SetAudioCodec(GetHLSAudioCodec());
 
                 avfw2->SetAudioBitrate(audioOnlyBitrate);
                 avfw2->SetAudioChannels(arb->m_channels);
@@ -469,19 +603,7 @@ int Transcode::TranscodeFile(const QString &inputname,
 
             avfw->SetContainer("mpegts");
             avfw->SetVideoCodec("libx264");
-
-            if (!gCoreContext->GetSetting("HLSAUDIO").isEmpty())
-                avfw->SetAudioCodec(gCoreContext->GetSetting("HLSAUDIO"));
-            else
-#if CONFIG_LIBFAAC_ENCODER
-                avfw->SetAudioCodec("libfaac");
-#else
-# if CONFIG_LIBMP3LAME_ENCODER
-                avfw->SetAudioCodec("libmp3lame");
-# else
-                avfw->SetAudioCodec("aac");
-# endif
-#endif
+            avfw->SetAudioCodec(GetHLSAudioCodec());
 
             if (hlsStreamID == -1)
             {
@@ -608,6 +730,31 @@ int Transcode::TranscodeFile(const QString &inputname,
             return REENCODE_ERROR;
         }
 
+        if (hls)
+        {
+            double hlsFrameRate =
+                halfFramerate ? video_frame_rate / 2 : video_frame_rate;
+
+            QList<HLSRenditionInfo>::const_iterator rit =
+                hlsRenditions.begin();
+            for (; rit != hlsRenditions.end(); ++rit)
+            {
+                HLSRendition *rendition = CreateHLSRendition(
+                    *rit, hls->GetSourceFile(), arb, video_aspect,
+                    hlsFrameRate, hls->GetSegmentSize(), hlsSegmentSize,
+                    video_width, video_height);
+                if (!rendition)
+                    continue;
+
+                hls->AddVariant(*rendition->GetStream());
+                rendition->Start();
+                renditions.push_back(rendition);
+            }
+
+            if (!renditions.isEmpty())
+                hls->WriteMetaPlaylist();
+        }
+
         arb->m_audioFrameSize = avfw->GetAudioFrameSize() * arb->m_channels * 2;
 
         GetPlayer()->SetVideoFilters(
@@ -857,6 +1004,8 @@ int Transcode::TranscodeFile(const QString &inputname,
         LOG(VB_GENERAL, LOG_ERR,
             "Unable to initialize MythPlayer for Transcode");
         SetPlayerContext(NULL);
+        FinishHLSRenditions(renditions, kHLSStatusErrored,
+                            "Transcoding Errored");
         if (hls)
             delete hls;
         if (avfw)
@@ -1357,6 +1506,13 @@ int Transcode::TranscodeFile(const QString &inputname,
                             avfw2->WriteAudioFrame(buf, audioFrame, tc);
                         }
 
+                        QList<HLSRendition*>::iterator rit = renditions.begin();
+                        for (; rit != renditions.end(); ++rit)
+                        {
+                            (*rit)->AddAudioFrame(buf, ab->size(), audioFrame,
+                                                  ab->m_time - timecodeOffset);
+                        }
+
                         ++audioFrame;
                     }
                 }
@@ -1415,6 +1571,20 @@ int Transcode::TranscodeFile(const QString &inputname,
                         hlsSegmentFrames = 0;
                     }
 
+                    if (!renditions.isEmpty())
+                    {
+                        HLSSourceFrame *src = new HLSSourceFrame(
+                            lastDecode->buf, video_width, video_height,
+                            frame.timecode, frame.frameNumber);
+
+                        QList<HLSRendition*>::iterator rit =
+                            renditions.begin();
+                        for (; rit != renditions.end(); ++rit)
+                            (*rit)->AddVideoFrame(src);
+
+                        src->DecrRef();
+                    }
+
                     if (avfw->WriteVideoFrame(&frame) > 0)
                     {
                         lastWrittenTime = frame.timecode;
@@ -1474,6 +1644,9 @@ int Transcode::TranscodeFile(const QString &inputname,
                     LOG(VB_GENERAL, LOG_NOTICE,
                         "Transcoding STOPped by JobQueue");
 
+                    FinishHLSRenditions(renditions, kHLSStatusStopped,
+                                        "Transcoding Stopped");
+
                     unlink(outputname.toLocal8Bit().constData());
                     av_free(newFrame);
                     SetPlayerContext(NULL);
@@ -1493,6 +1666,26 @@ int Transcode::TranscodeFile(const QString &inputname,
                 if (hls)
                     hls->UpdatePercentComplete(percentage);
 
+                if (!renditions.isEmpty())
+                {
+                    QString status = QString("Transcoding: %1x%2 @ %3 fps")
+                        .arg(newWidth).arg(newHeight).arg(flagFPS);
+
+                    QList<HLSRendition*>::iterator rit = renditions.begin();
+                    for (; rit != renditions.end(); ++rit)
+                    {
+                        HTTPLiveStream *stream = (*rit)->GetStream();
+                        stream->UpdatePercentComplete(
+                            (*rit)->GetFramesEncoded() * 100 /
+                            total_frame_count);
+                        status += QString(", %1x%2 @ %3 fps")
+                            .arg(stream->GetWidth()).arg(stream->GetHeight())
+                            .arg((*rit)->GetEncodeFPS());
+                    }
+
+                    hls->UpdateStatusMessage(status);
+                }
+
                 if (jobID >= 0)
                     JobQueue::ChangeJobComment(jobID,
                               QObject::tr("%1% Completed @ %2 fps.")
@@ -1549,6 +1742,13 @@ int Transcode::TranscodeFile(const QString &inputname,
     if (avfw2)
         delete avfw2;
 
+    if (!stopSignalled)
+        FinishHLSRenditions(renditions, kHLSStatusCompleted,
+                            "Transcoding Completed");
+    else
+        FinishHLSRenditions(renditions, kHLSStatusStopped,
+                            "Transcoding Stopped");
+
     if (hls)
     {
         if (!stopSignalled)
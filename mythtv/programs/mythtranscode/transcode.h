@@ -3,11 +3,13 @@
 #include "transcodedefs.h"
 #include "programtypes.h"
 #include "playercontext.h"
+#include "hlsrendition.h"
 
 class ProgramInfo;
 class NuppelVideoRecorder;
 class MythPlayer;
 class RingBuffer;
+class AudioReencodeBuffer;
 
 typedef vector<struct kfatable_entry> KFATable;
 
@@ -37,11 +39,18 @@ class Transcode : public QObject
     void SetCMDBitrate(int bitrate) { cmdBitrate = bitrate; }
     void SetCMDAudioBitrate(int bitrate) { cmdAudioBitrate = bitrate; }
     void DisableAudioOnlyHLS(void) { hlsDisableAudioOnly = true; }
+    void AddHLSRendition(int width, int height, int bitrate);
 
   private:
     bool GetProfile(QString profileName, QString encodingType, int height,
                     int frameRate);
     void ReencoderAddKFA(long curframe, long lastkey, long num_keyframes);
+    HLSRendition *CreateHLSRendition(const HLSRenditionInfo &info,
+                                     const QString &sourceFile,
+                                     AudioReencodeBuffer *arb,
+                                     float aspect, double frameRate,
+                                     int segmentSize, int segmentFrames,
+                                     int srcWidth, int srcHeight);
     void SetPlayerContext(PlayerContext*);
     PlayerContext *GetPlayerContext(void) { return ctx; }
     MythPlayer *GetPlayer(void) { return (ctx) ? ctx->player : NULL; }
@@ -62,6 +71,7 @@ class Transcode : public QObject
     int                     hlsStreamID;
     bool                    hlsDisableAudioOnly;
     int                     hlsMaxSegments;
+    QList<HLSRenditionInfo> hlsRenditions;
     QString                 cmdContainer;
     QString                 cmdAudioCodec;
     QString                 cmdVideoCodec;
@@ -0,0 +1,1238 @@
+// C
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// C++
+#include <algorithm>
+using namespace std;
+
+// MythTV
+#include "tsstreamcutter.h"
+#include "mythcorecontext.h"
+#include "mythlogging.h"
+#include "tspacket.h"
+#include "H264Parser.h"
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavutil/opt.h"
+}
+
+#ifndef O_LARGEFILE
+#define O_LARGEFILE 0
+#endif
+
+#define LOC QString("TSCutter: ")
+
+/// PTS, DTS and PCR base values are 33 bit counters
+static const int64_t kTSMask      = 0x1ffffffffLL;
+/// Number of packets read and written per system call
+static const int     kBlockPackets = 2048;
+/// How far into a GOP to look for the first picture or PTS
+static const int64_t kProbeBytes  = 2 * 1024 * 1024;
+/// How many key frames to step back looking for an IDR picture
+static const int     kMaxIDRSteps = 1;
+/// Frame number used for "until the end of the recording"
+static const uint64_t kToEnd      = ~0ULL;
+
+static int64_t read_pes_ts(const uint8_t *p)
+{
+    return ((int64_t)(p[0] & 0x0e) << 29) | ((int64_t)p[1] << 22) |
+           ((int64_t)(p[2] & 0xfe) << 14) | ((int64_t)p[3] << 7) |
+           ((int64_t)p[4] >> 1);
+}
+
+static void write_pes_ts(uint8_t *p, int64_t ts)
+{
+    p[0] = (p[0] & 0xf1) | ((ts >> 29) & 0x0e);
+    p[1] = (ts >> 22) & 0xff;
+    p[2] = ((ts >> 14) & 0xfe) | 0x01;
+    p[3] = (ts >> 7) & 0xff;
+    p[4] = ((ts << 1) & 0xfe) | 0x01;
+}
+
+/// Returns true if timestamp a is later than b, allowing for wrap around
+static bool ts_after(int64_t a, int64_t b)
+{
+    int64_t diff = (a - b) & kTSMask;
+    return diff && diff < (kTSMask >> 1);
+}
+
+/// Returns a pointer to the PTS/DTS flags byte of the PES header starting
+/// in this packet, or NULL if there is no such header or the timestamps
+/// it flags do not fit in the header and the packet.
+static uint8_t *find_pes_header(uint8_t *pkt)
+{
+    const TSPacket *tspacket = reinterpret_cast<const TSPacket*>(pkt);
+    if (!tspacket->PayloadStart() || !tspacket->HasPayload())
+        return NULL;
+
+    uint off = tspacket->AFCOffset();
+    if (off + 9 > TSPacket::kSize)
+        return NULL;
+
+    uint8_t *pes = pkt + off;
+    if (pes[0] != 0x00 || pes[1] != 0x00 || pes[2] != 0x01)
+        return NULL;
+
+    // Stream types without the optional PES header
+    uint8_t sid = pes[3];
+    if (sid == 0xbc || sid == 0xbe || sid == 0xbf ||
+        (sid >= 0xf0 && sid <= 0xf2) || sid == 0xf8 || sid == 0xff)
+        return NULL;
+
+    // PTS_DTS_flags '10' is followed by a PTS, '11' by a PTS and a DTS
+    uint tslen = ((pes[7] & 0xc0) == 0xc0) ? 10 :
+                 ((pes[7] & 0xc0) == 0x80) ? 5 : 0;
+    if ((pes[8] < tslen) || (off + 9 + tslen > TSPacket::kSize))
+        return NULL;
+
+    return pes + 7;
+}
+
+/// Returns the start of the packet that holds byte pos
+static int64_t packet_start(int64_t pos)
+{
+    return (pos / TSPacket::kSize) * TSPacket::kSize;
+}
+
+/** \class SectionEncoder
+ *  \brief Decodes the H.264 video of a section of the transport stream
+ *         and encodes some of its frames again, as transport stream
+ *         packets on the same PID.
+ *
+ *  The section must start on an IDR picture. The frames are counted in
+ *  display order, and they keep their PTS. There are no B-frames in the
+ *  output, so every DTS is its PTS less the delay the section starts
+ *  with, which keeps it before the DTS of whatever is copied after it.
+ */
+class SectionEncoder
+{
+  public:
+    SectionEncoder(uint pid, uint64_t skip, uint64_t count)
+      : firstPTS(-1),      lastPTS(-1),
+        frames(0),         videoPackets(0),
+        m_pid(pid),        m_skip(skip),
+        m_count(count),    m_decoded(0),
+        m_streamID(0xe0),  m_basePTS(-1),
+        m_ptsDelay(-1),    m_dec(NULL),
+        m_enc(NULL),       m_frame(NULL),
+        m_error(false)
+    {
+    }
+
+   ~SectionEncoder()
+    {
+        QMutexLocker locker(avcodeclock);
+        if (m_dec)
+        {
+            avcodec_close(m_dec);
+            av_freep(&m_dec);
+        }
+        if (m_enc)
+        {
+            avcodec_close(m_enc);
+            av_freep(&m_enc);
+        }
+        if (m_frame)
+            avcodec_free_frame(&m_frame);
+    }
+
+    static bool IsAvailable(void)
+    {
+        return avcodec_find_decoder(AV_CODEC_ID_H264) &&
+               avcodec_find_encoder(AV_CODEC_ID_H264);
+    }
+
+    bool Run(QByteArray &in);
+
+    QByteArray packets;         ///< the encoded video
+    int64_t    firstPTS;        ///< of the first frame encoded
+    int64_t    lastPTS;         ///< of the last frame encoded
+    uint64_t   frames;          ///< number of frames encoded
+    int        videoPackets;    ///< video packets in the section
+
+  private:
+    bool Decode(uint8_t *data, int size, int64_t pts, int64_t dts);
+    bool OpenEncoder(void);
+    bool Encode(AVFrame *frame);
+    void Packetize(const AVPacket &pkt);
+
+    uint            m_pid;
+    uint64_t        m_skip;
+    uint64_t        m_count;
+    uint64_t        m_decoded;
+    uint8_t         m_streamID;
+    int64_t         m_basePTS;
+    int64_t         m_ptsDelay;
+    AVCodecContext *m_dec;
+    AVCodecContext *m_enc;
+    AVFrame        *m_frame;
+    bool            m_error;
+};
+
+/// Encodes the wanted frames of the section in 'in'. Returns false if
+/// that isn't possible, nothing has been written then.
+bool SectionEncoder::Run(QByteArray &in)
+{
+    AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+    if (!codec)
+        return false;
+
+    m_dec   = avcodec_alloc_context3(codec);
+    m_frame = avcodec_alloc_frame();
+    {
+        QMutexLocker locker(avcodeclock);
+        if (!m_dec || !m_frame || avcodec_open2(m_dec, codec, NULL) < 0)
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + "Could not open H.264 decoder");
+            return false;
+        }
+    }
+
+    // Reassemble the video PES packets and decode them as they complete
+    QByteArray pes;
+    int64_t pts = AV_NOPTS_VALUE;
+    int64_t dts = AV_NOPTS_VALUE;
+    bool synced = false;
+
+    for (int off = 0; off + (int)TSPacket::kSize <= in.size() && !m_error;
+         off += TSPacket::kSize)
+    {
+        uint8_t *buf = reinterpret_cast<uint8_t*>(in.data()) + off;
+        const TSPacket *pkt = reinterpret_cast<const TSPacket*>(buf);
+        if (pkt->PID() != m_pid || !pkt->HasPayload())
+            continue;
+        ++videoPackets;
+
+        uint i = pkt->AFCOffset();
+        if (pkt->PayloadStart())
+        {
+            if (synced && !pes.isEmpty())
+                Decode(reinterpret_cast<uint8_t*>(pes.data()), pes.size(),
+                       pts, dts);
+            pes.clear();
+
+            uint8_t *flags = find_pes_header(buf);
+            synced = flags && (flags[0] & 0x80);
+            if (!synced)
+                continue;
+
+            pts = read_pes_ts(flags + 2);
+            dts = ((flags[0] & 0xc0) == 0xc0) ? read_pes_ts(flags + 7) : pts;
+            if (m_ptsDelay < 0)
+            {
+                m_streamID = flags[-4];
+                m_ptsDelay = (pts - dts) & kTSMask;
+            }
+            i = (flags - buf) + 2 + flags[1];
+        }
+        if (synced && i < TSPacket::kSize)
+            pes.append(reinterpret_cast<const char*>(buf) + i,
+                       TSPacket::kSize - i);
+    }
+
+    if (synced && !pes.isEmpty() && !m_error)
+        Decode(reinterpret_cast<uint8_t*>(pes.data()), pes.size(), pts, dts);
+
+    // Drain the decoder and then the encoder
+    while (!m_error && Decode(NULL, 0, AV_NOPTS_VALUE, AV_NOPTS_VALUE))
+        ;
+    while (!m_error && m_enc && Encode(NULL))
+        ;
+
+    return !m_error && frames > 0;
+}
+
+/// Decodes one PES packet, or drains the decoder if data is NULL, and
+/// encodes the frame that comes out if it is wanted. Returns true if a
+/// frame came out.
+bool SectionEncoder::Decode(uint8_t *data, int size, int64_t pts, int64_t dts)
+{
+    QByteArray padded;
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+    pkt.pts  = pts;
+    pkt.dts  = dts;
+
+    if (data)
+    {
+        padded.resize(size + FF_INPUT_BUFFER_PADDING_SIZE);
+        memcpy(padded.data(), data, size);
+        memset(padded.data() + size, 0, FF_INPUT_BUFFER_PADDING_SIZE);
+        pkt.data = reinterpret_cast<uint8_t*>(padded.data());
+        pkt.size = size;
+    }
+
+    int got = 0;
+    if (avcodec_decode_video2(m_dec, m_frame, &got, &pkt) < 0)
+    {
+        // A broken picture is left out, like a player would
+        LOG(VB_GENERAL, LOG_WARNING, LOC + "Error decoding boundary GOP");
+        return data != NULL;
+    }
+    if (!got)
+        return false;
+
+    uint64_t index = m_decoded++;
+    if (index < m_skip || index - m_skip >= m_count)
+        return true;
+
+    int64_t framePTS = av_frame_get_best_effort_timestamp(m_frame);
+    if (framePTS == AV_NOPTS_VALUE)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Boundary GOP frame has no PTS");
+        m_error = true;
+        return false;
+    }
+    framePTS &= kTSMask;
+
+    if (!m_enc && !OpenEncoder())
+    {
+        m_error = true;
+        return false;
+    }
+
+    // Count from the first frame, x264 wants increasing timestamps
+    if (m_basePTS < 0)
+        m_basePTS = framePTS;
+    if (firstPTS < 0)
+        firstPTS = framePTS;
+    lastPTS = framePTS;
+
+    m_frame->pts       = (framePTS - m_basePTS) & kTSMask;
+    m_frame->pict_type = AV_PICTURE_TYPE_NONE;
+    if (!Encode(m_frame))
+        m_error = true;
+    ++frames;
+
+    return true;
+}
+
+bool SectionEncoder::OpenEncoder(void)
+{
+    AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    if (!codec || m_dec->pix_fmt != PIX_FMT_YUV420P)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Can't encode H.264 for this stream");
+        return false;
+    }
+
+    m_enc = avcodec_alloc_context3(codec);
+    if (!m_enc)
+        return false;
+
+    m_enc->width               = m_dec->width;
+    m_enc->height              = m_dec->height;
+    m_enc->pix_fmt             = m_dec->pix_fmt;
+    m_enc->sample_aspect_ratio = m_dec->sample_aspect_ratio;
+    m_enc->level               = m_dec->level;
+    m_enc->time_base.num       = 1;
+    m_enc->time_base.den       = 90000;
+
+    // One IDR picture for the whole section, and no reordering
+    m_enc->gop_size            = (int)min(m_count + 1, (uint64_t)1000);
+    m_enc->max_b_frames        = 0;
+
+    if (m_frame->interlaced_frame)
+        m_enc->flags |= CODEC_FLAG_INTERLACED_DCT | CODEC_FLAG_INTERLACED_ME;
+
+    av_opt_set(m_enc->priv_data, "preset", "fast", 0);
+    av_opt_set(m_enc->priv_data, "crf", "18", 0);
+
+    QMutexLocker locker(avcodeclock);
+    if (avcodec_open2(m_enc, codec, NULL) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Could not open H.264 encoder");
+        return false;
+    }
+    return true;
+}
+
+/// Encodes a frame, or drains the encoder if frame is NULL. Returns true
+/// if a packet came out, or for a frame if it was accepted.
+bool SectionEncoder::Encode(AVFrame *frame)
+{
+    AVPacket pkt;
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+
+    int got = 0;
+    if (avcodec_encode_video2(m_enc, &pkt, frame, &got) < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Error encoding boundary GOP");
+        m_error = true;
+        return false;
+    }
+    if (!got)
+        return frame != NULL;
+
+    Packetize(pkt);
+    av_free_packet(&pkt);
+    return true;
+}
+
+/// Wraps an encoded picture in a PES packet and that in TS packets. The
+/// continuity counters are left for ProcessPacket() to fill in.
+void SectionEncoder::Packetize(const AVPacket &pkt)
+{
+    int64_t pts = (pkt.pts + m_basePTS) & kTSMask;
+    int64_t dts = (pts - m_ptsDelay) & kTSMask;
+
+    uint8_t header[19] =
+    {
+        0x00, 0x00, 0x01, m_streamID, 0x00, 0x00, // unbounded length
+        0x84, 0xc0, 10,                           // aligned, PTS and DTS
+        0x31, 0, 0, 0, 0,
+        0x11, 0, 0, 0, 0,
+    };
+    write_pes_ts(header + 9, pts);
+    write_pes_ts(header + 14, dts);
+
+    QByteArray pes(reinterpret_cast<const char*>(header), sizeof(header));
+    pes.append(reinterpret_cast<const char*>(pkt.data), pkt.size);
+
+    uint8_t ts[TSPacket::kSize];
+    const int kPayload = TSPacket::kSize - 4;
+    for (int off = 0; off < pes.size(); )
+    {
+        int len = min(pes.size() - off, kPayload);
+        int hdr = 4;
+
+        ts[0] = 0x47;
+        ts[1] = ((off == 0) ? 0x40 : 0x00) | ((m_pid >> 8) & 0x1f);
+        ts[2] = m_pid & 0xff;
+        ts[3] = 0x10;
+        if (len < kPayload)
+        {
+            // Stuff the last packet with an adaptation field
+            int aflen = kPayload - len - 1;
+            ts[3] = 0x30;
+            ts[4] = aflen;
+            if (aflen > 0)
+            {
+                ts[5] = 0x00;
+                memset(ts + 6, 0xff, aflen - 1);
+            }
+            hdr = 5 + aflen;
+        }
+
+        memcpy(ts + hdr, pes.constData() + off, len);
+        packets.append(reinterpret_cast<const char*>(ts), TSPacket::kSize);
+        off += len;
+    }
+}
+
+TSStreamCutter::TSStreamCutter(const QString &inf, const QString &outf,
+                               const frm_dir_map_t &deleteMap,
+                               const frm_pos_map_t &posMap,
+                               bool showprog, void (*update_func)(float),
+                               int (*check_func)())
+  : infile(inf),              outfile(outf),
+    delMap(deleteMap),        inPosMap(posMap),
+    fd_in(-1),                fd_out(-1),
+    videoPID(0),              videoStreamType(0),
+    canReencode(false),
+    ptsOffset(0),             lastVideoPTS(-1),
+    frameDuration(3003),
+    bytesTotal(0),            bytesDone(0),
+    outBytes(0),              lastPercent(-1),
+    showprogress(showprog),   update_status(update_func),
+    check_abort(check_func)
+{
+}
+
+TSStreamCutter::~TSStreamCutter()
+{
+    if (fd_in >= 0)
+        close(fd_in);
+    if (fd_out >= 0)
+        close(fd_out);
+}
+
+/** \brief Returns true if the file is a transport stream whose first
+ *         program carries H.264 video.
+ */
+bool TSStreamCutter::IsH264TS(const QString &filename)
+{
+    int fd = open(filename.toLocal8Bit().constData(), O_RDONLY | O_LARGEFILE);
+    if (fd < 0)
+        return false;
+
+    TSStreamCutter probe(filename, QString(), frm_dir_map_t(),
+                         frm_pos_map_t(), false, NULL, NULL);
+    bool found = probe.FindStreams(fd);
+    close(fd);
+
+    return found && probe.videoStreamType == 0x1b;
+}
+
+/** \brief Scans the start of the file for the PAT and first PMT and
+ *         records the video PID and its stream type.
+ */
+bool TSStreamCutter::FindStreams(int fd)
+{
+    uint8_t buf[TSPacket::kSize];
+    int pmtPID = -1;
+
+    lseek(fd, 0, SEEK_SET);
+    for (int64_t n = 0; n < kProbeBytes / TSPacket::kSize; ++n)
+    {
+        if (read(fd, buf, TSPacket::kSize) != (ssize_t)TSPacket::kSize)
+            break;
+
+        const TSPacket *pkt = reinterpret_cast<const TSPacket*>(buf);
+        if (!pkt->HasSync())
+        {
+            LOG(VB_GENERAL, LOG_ERR, LOC + "Input is not a transport stream");
+            return false;
+        }
+        if (!pkt->PayloadStart() || !pkt->HasPayload())
+            continue;
+
+        uint off = pkt->AFCOffset();
+        off += 1 + buf[off];            // pointer field
+        if (off + 8 >= TSPacket::kSize)
+            continue;
+
+        const uint8_t *sec = buf + off;
+        uint seclen = ((sec[1] & 0x0f) << 8) | sec[2];
+        uint secend = min(off + 3 + seclen - 4, TSPacket::kSize);
+
+        if (pkt->PID() == 0 && sec[0] == 0x00 && pmtPID < 0)
+        {
+            for (uint i = off + 8; i + 4 <= secend; i += 4)
+            {
+                uint pnum = (buf[i] << 8) | buf[i + 1];
+                if (pnum)
+                {
+                    pmtPID = ((buf[i + 2] & 0x1f) << 8) | buf[i + 3];
+                    break;
+                }
+            }
+        }
+        else if ((int)pkt->PID() == pmtPID && sec[0] == 0x02)
+        {
+            if (off + 12 >= TSPacket::kSize)
+                continue;
+            uint pinfolen = ((sec[10] & 0x0f) << 8) | sec[11];
+            for (uint i = off + 12 + pinfolen; i + 5 <= secend; )
+            {
+                uint type = buf[i];
+                uint pid  = ((buf[i + 1] & 0x1f) << 8) | buf[i + 2];
+                uint len  = ((buf[i + 3] & 0x0f) << 8) | buf[i + 4];
+                if (type == 0x01 || type == 0x02 || type == 0x1b)
+                {
+                    videoPID = pid;
+                    videoStreamType = type;
+                    return true;
+                }
+                i += 5 + len;
+            }
+            return false;
+        }
+    }
+
+    return false;
+}
+
+/** \brief Converts the cutlist into byte ranges to keep.
+ *
+ *  Every kept section is read from an IDR key frame at or before the
+ *  first wanted frame to the key frame at or after the first unwanted
+ *  frame. The GOPs at either end that are only partly wanted are marked
+ *  to be encoded again when they can be, otherwise they are copied
+ *  whole so that the output decodes without references to pictures that
+ *  were cut away.
+ */
+bool TSStreamCutter::BuildRanges(void)
+{
+    if (inPosMap.isEmpty())
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "Recording has no seek table");
+        return false;
+    }
+
+    canReencode = SectionEncoder::IsAvailable();
+    if (!canReencode)
+        LOG(VB_GENERAL, LOG_WARNING, LOC + "No H.264 encoder available, "
+            "cuts will be snapped to key frames");
+
+    // Collect the kept frame intervals [start, end) from the cutlist,
+    // with kToEnd meaning "until the end of the file".
+    QList<QPair<uint64_t, uint64_t> > keep;
+    uint64_t keepStart = 0;
+    bool inCut = false;
+    frm_dir_map_t::const_iterator it = delMap.begin();
+    for (; it != delMap.end(); ++it)
+    {
+        if (*it == MARK_CUT_START && !inCut)
+        {
+            if (it.key() > keepStart)
+                keep.push_back(qMakePair(keepStart, it.key()));
+            inCut = true;
+        }
+        else if (*it == MARK_CUT_END)
+        {
+            keepStart = it.key() + 1;
+            inCut = false;
+        }
+    }
+    if (!inCut)
+        keep.push_back(qMakePair(keepStart, kToEnd));
+
+    for (int i = 0; i < keep.size(); ++i)
+    {
+        KeptRange range;
+        bool startsOnIDR = true;
+
+        // Snap the start back to an IDR key frame
+        frm_pos_map_t::const_iterator sit = inPosMap.upperBound(keep[i].first);
+        if (keep[i].first == 0 || sit == inPosMap.begin())
+        {
+            range.startFrame = 0;
+            range.startPos   = 0;
+            startsOnIDR      = false;
+        }
+        else
+        {
+            // Look back at most kMaxIDRSteps key frames, in streams with
+            // only recovery point I-frames there may be no IDR at all.
+            --sit;
+            frm_pos_map_t::const_iterator kit = sit;
+            int steps = 0;
+            while (!IsIDR(packet_start(*sit)))
+            {
+                if (sit == inPosMap.begin() || steps >= kMaxIDRSteps)
+                {
+                    LOG(VB_GENERAL, LOG_WARNING, LOC +
+                        QString("No IDR picture near frame %1, starting "
+                                "on the key frame at %2, which may not "
+                                "decode cleanly")
+                            .arg(keep[i].first).arg(kit.key()));
+                    sit = kit;
+                    startsOnIDR = false;
+                    break;
+                }
+                LOG(VB_GENERAL, LOG_INFO, LOC +
+                    QString("Key frame %1 is not an IDR picture, "
+                            "stepping back").arg(sit.key()));
+                --sit;
+                ++steps;
+            }
+            range.startFrame = sit.key();
+            range.startPos   = packet_start(*sit);
+        }
+
+        // Snap the end forward to the next key frame
+        frm_pos_map_t::const_iterator eit = inPosMap.lowerBound(keep[i].second);
+        if (keep[i].second == kToEnd || eit == inPosMap.end())
+        {
+            range.endFrame = kToEnd;
+            range.endPos   = bytesTotal;
+        }
+        else
+        {
+            range.endFrame = eit.key();
+            range.endPos   = packet_start(*eit);
+        }
+
+        if (range.endPos <= range.startPos)
+            continue;
+
+        range.firstFrame = range.startFrame;
+        range.lastFrame  = range.endFrame;
+        range.headEndPos = -1;
+        range.tailPos    = -1;
+
+        // Encode the wanted part of the first GOP again, if it starts on
+        // an IDR picture and the GOP after it does too, so that nothing
+        // copied after it refers to the pictures that were left out
+        frm_pos_map_t::const_iterator hit = inPosMap.upperBound(keep[i].first);
+        if (canReencode && startsOnIDR && keep[i].first > range.startFrame &&
+            hit != inPosMap.end() && hit.key() <= range.endFrame &&
+            IsIDR(packet_start(*hit)))
+        {
+            range.firstFrame   = keep[i].first;
+            range.headEndFrame = hit.key();
+            range.headEndPos   = packet_start(*hit);
+
+            if (keep[i].second < range.headEndFrame)
+                range.lastFrame = keep[i].second;
+        }
+
+        // and the wanted part of the last GOP, if it starts on one
+        if (canReencode && range.endFrame != kToEnd &&
+            keep[i].second < range.endFrame && eit != inPosMap.begin() &&
+            range.lastFrame == range.endFrame)
+        {
+            frm_pos_map_t::const_iterator tit = eit - 1;
+            uint64_t after = (range.headEndPos >= 0) ?
+                range.headEndFrame : range.startFrame;
+            if (tit.key() >= after && IsIDR(packet_start(*tit)))
+            {
+                range.lastFrame = keep[i].second;
+                range.tailFrame = tit.key();
+                range.tailPos   = packet_start(*tit);
+            }
+        }
+
+        // Merge with the previous range if they share a GOP that isn't
+        // split between them by encoding it again
+        if (!ranges.isEmpty())
+        {
+            KeptRange &prev = ranges.back();
+            bool overlap = prev.endPos > range.startPos ||
+                (prev.endPos == range.startPos &&
+                 prev.tailPos < 0 && range.headEndPos < 0);
+            bool split = prev.tailPos >= 0 && range.headEndPos >= 0;
+            if (overlap && !split)
+            {
+                if (range.endPos >= prev.endPos)
+                {
+                    prev.endFrame  = range.endFrame;
+                    prev.endPos    = range.endPos;
+                    prev.lastFrame = (range.tailPos >= 0) ?
+                        range.lastFrame : range.endFrame;
+                    prev.tailFrame = range.tailFrame;
+                    prev.tailPos   = range.tailPos;
+                }
+                else if (prev.tailPos >= 0)
+                {
+                    prev.lastFrame = prev.endFrame;
+                    prev.tailPos   = -1;
+                }
+                continue;
+            }
+        }
+
+        ranges.push_back(range);
+    }
+
+    // Estimate the frame duration from the first two key frames
+    if (inPosMap.size() >= 2)
+    {
+        frm_pos_map_t::const_iterator k1 = inPosMap.begin();
+        frm_pos_map_t::const_iterator k2 = k1 + 1;
+        int64_t pts1, pts2;
+        if (FindFirstVideoPTS(*k1, *k2, pts1) &&
+            FindFirstVideoPTS(*k2, bytesTotal, pts2) &&
+            k2.key() > k1.key())
+        {
+            int64_t dur = ((pts2 - pts1) & kTSMask) / (k2.key() - k1.key());
+            if (dur > 0 && dur < 90000)
+                frameDuration = dur;
+        }
+    }
+
+    return !ranges.isEmpty();
+}
+
+/// Returns true if the first picture starting at pos is an IDR picture
+bool TSStreamCutter::IsIDR(int64_t pos)
+{
+    H264Parser parser;
+    uint8_t buf[TSPacket::kSize];
+    bool synced = false;
+
+    for (int64_t n = 0; n < kProbeBytes; n += TSPacket::kSize)
+    {
+        if (pread(fd_in, buf, TSPacket::kSize, pos + n) !=
+            (ssize_t)TSPacket::kSize)
+            return false;
+
+        const TSPacket *pkt = reinterpret_cast<const TSPacket*>(buf);
+        if (pkt->PID() != videoPID || !pkt->HasPayload())
+            continue;
+
+        uint i = pkt->AFCOffset();
+        if (pkt->PayloadStart())
+        {
+            uint8_t *flags = find_pes_header(buf);
+            if (!flags)
+                continue;
+            i = (flags - buf) + 2 + flags[1];
+            synced = true;
+        }
+        if (!synced)
+            continue;
+
+        while (i < TSPacket::kSize)
+        {
+            uint32_t used = parser.addBytes(buf + i, TSPacket::kSize - i,
+                                            pos + n + i);
+            if (!used)
+                break;
+            i += used;
+            if (parser.stateChanged() && parser.onFrameStart())
+                return parser.lastNALtype() == H264Parser::SLICE_IDR;
+        }
+    }
+
+    return false;
+}
+
+bool TSStreamCutter::FindFirstVideoPTS(int64_t start, int64_t end,
+                                       int64_t &pts)
+{
+    uint8_t buf[TSPacket::kSize];
+    end = min(end, start + kProbeBytes);
+
+    for (int64_t pos = start; pos + TSPacket::kSize <= end;
+         pos += TSPacket::kSize)
+    {
+        if (pread(fd_in, buf, TSPacket::kSize, pos) != (ssize_t)TSPacket::kSize)
+            return false;
+
+        const TSPacket *pkt = reinterpret_cast<const TSPacket*>(buf);
+        if (pkt->PID() != videoPID)
+            continue;
+
+        uint8_t *flags = find_pes_header(buf);
+        if (flags && (flags[0] & 0x80))
+        {
+            pts = read_pes_ts(flags + 2);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/** \brief Cuts the recording.
+ *  \return REENCODE_OK on success, REENCODE_STOPPED if aborted and
+ *          REENCODE_ERROR on failure.
+ */
+int TSStreamCutter::Start(void)
+{
+    fd_in = open(infile.toLocal8Bit().constData(), O_RDONLY | O_LARGEFILE);
+    if (fd_in < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + QString("Could not open '%1'")
+                .arg(infile) + ENO);
+        return REENCODE_ERROR;
+    }
+
+    struct stat st;
+    if (fstat(fd_in, &st) < 0)
+        return REENCODE_ERROR;
+    bytesTotal = (st.st_size / TSPacket::kSize) * TSPacket::kSize;
+
+    if (!FindStreams(fd_in) || videoStreamType != 0x1b)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + "No H.264 video stream found");
+        return REENCODE_ERROR;
+    }
+
+    if (!BuildRanges())
+        return REENCODE_ERROR;
+
+    fd_out = open(outfile.toLocal8Bit().constData(),
+                  O_WRONLY | O_CREAT | O_TRUNC | O_LARGEFILE, 0644);
+    if (fd_out < 0)
+    {
+        LOG(VB_GENERAL, LOG_ERR, LOC + QString("Could not create '%1'")
+                .arg(outfile) + ENO);
+        return REENCODE_ERROR;
+    }
+
+    int64_t keptBytes = 0;
+    for (int i = 0; i < ranges.size(); ++i)
+        keptBytes += ranges[i].endPos - ranges[i].startPos;
+
+    LOG(VB_GENERAL, LOG_INFO, LOC +
+        QString("Copying %1 sections, %2 of %3 MB")
+            .arg(ranges.size()).arg(keptBytes >> 20).arg(bytesTotal >> 20));
+
+    bytesTotal = keptBytes;
+    uint64_t outFrame = 0;
+    for (int i = 0; i < ranges.size(); ++i)
+    {
+        int ret = CopyRange(ranges[i], outFrame);
+        if (ret != REENCODE_OK)
+            return ret;
+
+        if (ranges[i].lastFrame != kToEnd)
+            outFrame += ranges[i].lastFrame - ranges[i].firstFrame;
+    }
+
+    if (fsync(fd_out) < 0)
+        LOG(VB_GENERAL, LOG_WARNING, LOC + "fsync failed" + ENO);
+
+    UpdateProgress(bytesTotal);
+    return REENCODE_OK;
+}
+
+/** \brief Writes one kept section.
+ *
+ *  The GOPs at either end marked for encoding are done first, and if that
+ *  fails they are copied whole instead, which range is updated for.
+ */
+int TSStreamCutter::CopyRange(KeptRange &range, uint64_t outFrameBase)
+{
+    QByteArray headIn, tailIn;
+    SectionEncoder *head = NULL;
+    SectionEncoder *tail = NULL;
+
+    if (range.headEndPos >= 0)
+    {
+        head = new SectionEncoder(videoPID, range.firstFrame - range.startFrame,
+                                  range.lastFrame - range.firstFrame);
+        if (!ReadSection(range.startPos, range.headEndPos, headIn) ||
+            !head->Run(headIn))
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                QString("Could not encode the GOP at frame %1 again, "
+                        "keeping all of it").arg(range.startFrame));
+            delete head;
+            head = NULL;
+            range.firstFrame = range.startFrame;
+            range.headEndPos = -1;
+            if (range.tailPos < 0)
+                range.lastFrame = range.endFrame;
+        }
+    }
+
+    if (range.tailPos >= 0)
+    {
+        tail = new SectionEncoder(videoPID, 0,
+                                  range.lastFrame - range.tailFrame);
+        if (!ReadSection(range.tailPos, range.endPos, tailIn) ||
+            !tail->Run(tailIn))
+        {
+            LOG(VB_GENERAL, LOG_WARNING, LOC +
+                QString("Could not encode the GOP at frame %1 again, "
+                        "keeping all of it").arg(range.tailFrame));
+            delete tail;
+            tail = NULL;
+            range.lastFrame = range.endFrame;
+            range.tailPos   = -1;
+        }
+    }
+
+    // Line this section's video up to follow the last frame written
+    int64_t firstPTS = head ? head->firstPTS : -1;
+    if (head || FindFirstVideoPTS(range.startPos, range.endPos, firstPTS))
+    {
+        if (lastVideoPTS >= 0)
+        {
+            int64_t expected = (lastVideoPTS + frameDuration) & kTSMask;
+            ptsOffset = (firstPTS - expected) & kTSMask;
+        }
+        LOG(VB_GENERAL, LOG_INFO, LOC +
+            QString("Section at frame %1: shifting timestamps by %2 ms")
+                .arg(range.firstFrame).arg(ptsOffset / 90));
+    }
+
+    int64_t copyStart = (range.headEndPos >= 0) ? range.headEndPos :
+                                                  range.startPos;
+    int64_t copyEnd   = (range.tailPos >= 0) ? range.tailPos : range.endPos;
+    int ret = REENCODE_OK;
+
+    if (head)
+    {
+        outPosMap[outFrameBase] = outBytes;
+        outDurMap[outFrameBase] = (outFrameBase * frameDuration) / 90;
+
+        int64_t toPTS = (range.lastFrame <= range.headEndFrame) ?
+            ((head->lastPTS + frameDuration) & kTSMask) : -1;
+        if (!WriteSection(headIn, *head, head->firstPTS, toPTS))
+            ret = REENCODE_ERROR;
+        UpdateProgress(bytesDone + headIn.size());
+    }
+
+    if (ret == REENCODE_OK && copyStart < copyEnd)
+    {
+        // Key frames in the copied part, renumbered for the output file
+        int64_t base = outBytes;
+        frm_pos_map_t::const_iterator it =
+            inPosMap.lowerBound(range.firstFrame);
+        for (; it != inPosMap.end() && it.key() < range.lastFrame; ++it)
+        {
+            if (*it >= copyEnd)
+                break;
+            if (*it < copyStart)
+                continue;
+            uint64_t frame = outFrameBase + (it.key() - range.firstFrame);
+            outPosMap[frame] = base + (*it - copyStart);
+            outDurMap[frame] = (frame * frameDuration) / 90;
+        }
+
+        ret = CopyBytes(copyStart, copyEnd);
+    }
+
+    if (ret == REENCODE_OK && tail)
+    {
+        uint64_t frame = outFrameBase + (range.tailFrame - range.firstFrame);
+        outPosMap[frame] = outBytes;
+        outDurMap[frame] = (frame * frameDuration) / 90;
+
+        if (!WriteSection(tailIn, *tail, -1,
+                          (tail->lastPTS + frameDuration) & kTSMask))
+            ret = REENCODE_ERROR;
+        UpdateProgress(bytesDone + tailIn.size());
+    }
+
+    delete head;
+    delete tail;
+    return ret;
+}
+
+/// Copies the packets from start to end, fixing them up on the way
+int TSStreamCutter::CopyBytes(int64_t start, int64_t end)
+{
+    uint8_t *buf = new uint8_t[kBlockPackets * TSPacket::kSize];
+    int64_t pos = start;
+    int ret = REENCODE_OK;
+
+    while (pos < end)
+    {
+        if (check_abort && check_abort())
+        {
+            ret = REENCODE_STOPPED;
+            break;
+        }
+
+        int64_t want = min((int64_t)kBlockPackets * TSPacket::kSize,
+                           end - pos);
+        ssize_t got = pread(fd_in, buf, want, pos);
+        if (got <= 0)
+        {
+            if (got < 0)
+            {
+                LOG(VB_GENERAL, LOG_ERR, LOC + "Read failed" + ENO);
+                ret = REENCODE_ERROR;
+            }
+            break;
+        }
+        got = (got / TSPacket::kSize) * TSPacket::kSize;
+        if (!got)
+            break;
+
+        for (ssize_t off = 0; off < got; off += TSPacket::kSize)
+            ProcessPacket(buf + off);
+
+        if (!WriteAll(buf, got))
+        {
+            ret = REENCODE_ERROR;
+            break;
+        }
+
+        pos += got;
+        UpdateProgress(bytesDone + got);
+    }
+
+    delete [] buf;
+    return ret;
+}
+
+bool TSStreamCutter::ReadSection(int64_t start, int64_t end, QByteArray &buf)
+{
+    buf.resize(end - start);
+    int64_t done = 0;
+    while (done < buf.size())
+    {
+        ssize_t got = pread(fd_in, buf.data() + done, buf.size() - done,
+                            start + done);
+        if (got <= 0)
+        {
+            if (got < 0)
+                LOG(VB_GENERAL, LOG_ERR, LOC + "Read failed" + ENO);
+            break;
+        }
+        done += got;
+    }
+    buf.resize(packet_start(done));
+    return !buf.isEmpty();
+}
+
+/** \brief Writes a section with its video replaced by what enc encoded.
+ *
+ *  The new video packets are spread over the places the old ones were,
+ *  and the PCRs the old ones carried are kept in packets of their own.
+ *  Other streams are kept from fromPTS up to toPTS, -1 for no limit.
+ */
+bool TSStreamCutter::WriteSection(QByteArray &in, SectionEncoder &enc,
+                                  int64_t fromPTS, int64_t toPTS)
+{
+    QByteArray out;
+    QMap<uint, bool> dropping;
+    uint8_t *video = reinterpret_cast<uint8_t*>(enc.packets.data());
+    int newPackets = enc.packets.size() / TSPacket::kSize;
+    int oldPackets = max(enc.videoPackets, 1);
+    int written = 0;
+    int seen = 0;
+
+    for (int off = 0; off + (int)TSPacket::kSize <= in.size();
+         off += TSPacket::kSize)
+    {
+        uint8_t *pkt = reinterpret_cast<uint8_t*>(in.data()) + off;
+        const TSPacket *tspacket = reinterpret_cast<const TSPacket*>(pkt);
+        uint pid = tspacket->PID();
+
+        if (pid == videoPID)
+        {
+            if (tspacket->HasAdaptationField() && pkt[4] >= 7 &&
+                (pkt[5] & 0x10))
+            {
+                // Keep the PCR, without the payload
+                uint8_t pcr[TSPacket::kSize];
+                memcpy(pcr, pkt, 12);
+                memset(pcr + 12, 0xff, TSPacket::kSize - 12);
+                pcr[1] &= ~0x40;
+                pcr[3]  = 0x20 | ((nextCC.value(pid, 0) - 1) & 0xf);
+                pcr[4]  = TSPacket::kSize - 5;
+                pcr[5]  = 0x10;
+                ProcessPacket(pcr);
+                out.append(reinterpret_cast<const char*>(pcr),
+                           TSPacket::kSize);
+            }
+
+            if (!tspacket->HasPayload())
+                continue;
+
+            int upto = (int)((int64_t)++seen * newPackets / oldPackets);
+            for (; written < upto && written < newPackets; ++written)
+            {
+                uint8_t *p = video + written * TSPacket::kSize;
+                ProcessPacket(p);
+                out.append(reinterpret_cast<const char*>(p), TSPacket::kSize);
+            }
+            continue;
+        }
+
+        if (tspacket->PayloadStart())
+        {
+            uint8_t *flags = find_pes_header(pkt);
+            bool drop = false;
+            if (flags && (flags[0] & 0x80))
+            {
+                int64_t pts = read_pes_ts(flags + 2);
+                drop = (fromPTS >= 0 && ts_after(fromPTS, pts)) ||
+                       (toPTS >= 0 && !ts_after(toPTS, pts));
+            }
+            dropping[pid] = drop;
+        }
+
+        // What started before the section is only wanted if it goes on
+        if (dropping.value(pid, fromPTS >= 0))
+            continue;
+
+        ProcessPacket(pkt);
+        out.append(reinterpret_cast<const char*>(pkt), TSPacket::kSize);
+    }
+
+    for (; written < newPackets; ++written)
+    {
+        uint8_t *p = video + written * TSPacket::kSize;
+        ProcessPacket(p);
+        out.append(reinterpret_cast<const char*>(p), TSPacket::kSize);
+    }
+
+    return WriteAll(reinterpret_cast<const uint8_t*>(out.constData()),
+                    out.size());
+}
+
+/// Renumbers the continuity counter and shifts the timestamps of a packet
+void TSStreamCutter::ProcessPacket(uint8_t *pkt)
+{
+    TSPacket *tspacket = reinterpret_cast<TSPacket*>(pkt);
+    if (!tspacket->HasSync())
+        return;
+
+    uint pid = tspacket->PID();
+    if (pid == 0x1fff)
+        return;
+
+    if (tspacket->HasPayload())
+    {
+        uint cc = nextCC.value(pid, tspacket->ContinuityCounter());
+        tspacket->SetContinuityCounter(cc);
+        nextCC[pid] = (cc + 1) & 0xf;
+    }
+
+    // PCR in the adaptation field
+    if (tspacket->HasAdaptationField() && pkt[4] >= 7 && (pkt[5] & 0x10))
+    {
+        uint8_t *p = pkt + 6;
+        int64_t base = ((int64_t)p[0] << 25) | ((int64_t)p[1] << 17) |
+                       ((int64_t)p[2] << 9)  | ((int64_t)p[3] << 1) |
+                       ((int64_t)p[4] >> 7);
+        base = (base - ptsOffset) & kTSMask;
+        p[0] = (base >> 25) & 0xff;
+        p[1] = (base >> 17) & 0xff;
+        p[2] = (base >> 9)  & 0xff;
+        p[3] = (base >> 1)  & 0xff;
+        p[4] = ((base & 0x01) << 7) | (p[4] & 0x7f);
+    }
+
+    // PTS and DTS in the PES header
+    uint8_t *flags = find_pes_header(pkt);
+    if (!flags)
+        return;
+
+    if (flags[0] & 0x80)
+    {
+        int64_t pts = (read_pes_ts(flags + 2) - ptsOffset) & kTSMask;
+        write_pes_ts(flags + 2, pts);
+        if (pid == videoPID && (lastVideoPTS < 0 || ts_after(pts, lastVideoPTS)))
+            lastVideoPTS = pts;
+    }
+    if ((flags[0] & 0xc0) == 0xc0)
+    {
+        int64_t dts = (read_pes_ts(flags + 7) - ptsOffset) & kTSMask;
+        write_pes_ts(flags + 7, dts);
+    }
+}
+
+bool TSStreamCutter::WriteAll(const uint8_t *buf, int len)
+{
+    while (len > 0)
+    {
+        ssize_t ret = write(fd_out, buf, len);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LOG(VB_GENERAL, LOG_ERR, LOC + "Write failed" + ENO);
+            return false;
+        }
+        buf      += ret;
+        len      -= ret;
+        outBytes += ret;
+    }
+    return true;
+}
+
+void TSStreamCutter::UpdateProgress(int64_t done)
+{
+    bytesDone = done;
+    if (!bytesTotal)
+        return;
+
+    int percent = (int)(bytesDone * 100 / bytesTotal);
+    if (percent == lastPercent)
+        return;
+    lastPercent = percent;
+
+    if (update_status)
+        update_status(percent);
+    else if (showprogress)
+        LOG(VB_GENERAL, LOG_INFO, QString("%1% done").arg(percent));
+}
+
+/// Returns the seek table and duration map of the output file
+void TSStreamCutter::GetOutputMaps(frm_pos_map_t &posMap,
+                                   frm_pos_map_t &durMap) const
+{
+    posMap = outPosMap;
+    durMap = outDurMap;
+}
+
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -0,0 +1,110 @@
+#ifndef TSSTREAMCUTTER_H
+#define TSSTREAMCUTTER_H
+
+// C
+#include <stdint.h>
+
+// Qt
+#include <QByteArray>
+#include <QString>
+#include <QList>
+#include <QMap>
+
+// MythTV
+#include "transcodedefs.h"
+#include "programtypes.h"
+
+class SectionEncoder;
+
+/** \class TSStreamCutter
+ *  \brief Lossless cutter for MPEG-TS recordings that copies packets
+ *         instead of decoding them.
+ *
+ *  The kept sections are copied packet by packet between the key frames
+ *  in the recording's seek table. A GOP that is only partly kept is
+ *  decoded and its wanted frames are encoded again as a GOP of its own,
+ *  which needs it to start on an H.264 IDR picture (checked with
+ *  H264Parser) and, at the start of a section, to be followed by one.
+ *  Where that isn't possible the cut is snapped outwards to the key
+ *  frames instead, keeping up to one GOP of unwanted frames.
+ *
+ *  At each splice the PTS, DTS and PCR values are shifted so that the
+ *  output plays back with continuous timestamps, and continuity counters
+ *  are renumbered per PID. Apart from the boundary GOPs nothing is
+ *  decoded, so cutting a long recording is limited by disk throughput.
+ */
+class TSStreamCutter
+{
+  public:
+    TSStreamCutter(const QString &inf, const QString &outf,
+                   const frm_dir_map_t &deleteMap,
+                   const frm_pos_map_t &posMap,
+                   bool showprog, void (*update_func)(float),
+                   int (*check_func)());
+   ~TSStreamCutter();
+
+    static bool IsH264TS(const QString &filename);
+
+    int  Start(void);
+    void GetOutputMaps(frm_pos_map_t &posMap, frm_pos_map_t &durMap) const;
+
+  private:
+    typedef struct keptRange
+    {
+        uint64_t startFrame;    ///< key frame reading starts at
+        uint64_t endFrame;      ///< key frame reading stops at
+        int64_t  startPos;
+        int64_t  endPos;
+        uint64_t firstFrame;    ///< first frame written
+        uint64_t lastFrame;     ///< frame after the last one written
+        uint64_t headEndFrame;  ///< key frame after the re-encoded head
+        int64_t  headEndPos;    ///< -1 if the first GOP is copied
+        uint64_t tailFrame;     ///< key frame the re-encoded tail starts at
+        int64_t  tailPos;       ///< -1 if the last GOP is copied
+    } KeptRange;
+
+    bool FindStreams(int fd);
+    bool BuildRanges(void);
+    bool IsIDR(int64_t pos);
+    bool FindFirstVideoPTS(int64_t start, int64_t end, int64_t &pts);
+    int  CopyRange(KeptRange &range, uint64_t outFrameBase);
+    int  CopyBytes(int64_t start, int64_t end);
+    bool ReadSection(int64_t start, int64_t end, QByteArray &buf);
+    bool WriteSection(QByteArray &in, SectionEncoder &enc,
+                      int64_t fromPTS, int64_t toPTS);
+    void ProcessPacket(uint8_t *pkt);
+    bool WriteAll(const uint8_t *buf, int len);
+    void UpdateProgress(int64_t done);
+
+    QString                 infile;
+    QString                 outfile;
+    frm_dir_map_t           delMap;
+    frm_pos_map_t           inPosMap;
+    frm_pos_map_t           outPosMap;
+    frm_pos_map_t           outDurMap;
+    QList<KeptRange>        ranges;
+
+    int                     fd_in;
+    int                     fd_out;
+
+    uint                    videoPID;
+    uint                    videoStreamType;
+    bool                    canReencode;
+    QMap<uint, uint>        nextCC;
+
+    int64_t                 ptsOffset;
+    int64_t                 lastVideoPTS;
+    int64_t                 frameDuration;
+
+    int64_t                 bytesTotal;
+    int64_t                 bytesDone;
+    int64_t                 outBytes;
+    int                     lastPercent;
+
+    bool                    showprogress;
+    void                    (*update_status)(float percent_done);
+    int                     (*check_abort)();
+};
+
+#endif
+/* vim: set expandtab tabstop=4 shiftwidth=4: */
@@ -490,10 +490,12 @@ static GlobalLineEdit *startupCommand()
 
 static HostSpinBox *JobQueueMaxSimultaneousJobs()
 {
-    HostSpinBox *gc = new HostSpinBox("JobQueueMaxSimultaneousJobs", 1, 10, 1);
+    HostSpinBox *gc = new HostSpinBox("JobQueueMaxSimultaneousJobs", 0, 32, 1);
     gc->setLabel(QObject::tr("Maximum simultaneous jobs on this backend"));
     gc->setHelpText(QObject::tr("The Job Queue will be limited to running "
-                    "this many simultaneous jobs on this backend."));
+                    "this many simultaneous jobs on this backend. Set to 0 "
+                    "to allow one per CPU. Jobs beyond the first only start "
+                    "while there is a CPU, memory and disk time to spare."));
     gc->setValue(1);
     return gc;
 };
@@ -599,6 +601,19 @@ static GlobalLineEdit *UserJobDesc(uint job_num)
     return gc;
 };
 
+static HostCheckBox *VideoScanWatchDirs()
+{
+    HostCheckBox *hc = new HostCheckBox("VideoScanWatchDirs");
+    hc->setLabel(QObject::tr("Rescan videos when they change"));
+    hc->setHelpText(
+        QObject::tr(
+            "If enabled, this backend watches the video directories it "
+            "last scanned and rescans them shortly after files are added, "
+            "moved or removed."));
+    hc->setValue(false);
+    return hc;
+}
+
 static HostCheckBox *JobAllowMetadata()
 {
     HostCheckBox *gc = new HostCheckBox("JobAllowMetadata");
@@ -861,6 +876,7 @@ BackendSettings::BackendSettings() {
     group2->addChild(MiscStatusScript());
     group2->addChild(DisableAutomaticBackup());
     group2->addChild(DisableFirewireReset());
+    group2->addChild(VideoScanWatchDirs());
     addChild(group2);
 
     VerticalConfigurationGroup* group2a1 = new VerticalConfigurationGroup(false);